@@ -1103,6 +1103,9 @@ static bool StartupOBS(const char *locale, profiler_name_store_t *store)
 {
 	char path[512];
 
+	if (GetAppConfigPath(path, sizeof(path), "obs-studio/graphics_cache") > 0)
+		gs_set_cache_path(path);
+
 	if (GetAppConfigPath(path, sizeof(path), "obs-studio/plugin_config") <= 0)
 		return false;
 
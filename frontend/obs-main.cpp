@@ -45,6 +45,7 @@
 #include <signal.h>
 #endif
 
+#include <cinttypes>
 #include <fstream>
 #include <iostream>
 #include <sstream>
@@ -64,6 +65,7 @@ static bool unclean_shutdown = false;
 bool multi = false;
 static bool log_verbose = false;
 static bool unfiltered_log = false;
+static bool profiler_trace = false;
 bool opt_start_streaming = false;
 bool opt_start_recording = false;
 bool opt_studio_mode = false;
@@ -459,12 +461,20 @@ static void SaveProfilerData(const ProfilerSnapshot &snap)
 	ostringstream dst;
 	dst.write(LITERAL_SIZE("obs-studio/profiler_data/"));
 	dst.write(currentLogFile.c_str(), pos);
-	dst.write(LITERAL_SIZE(".csv.gz"));
 #undef LITERAL_SIZE
 
-	BPtr<char> path = GetAppConfigPathPtr(dst.str().c_str());
+	string base = dst.str();
+
+	BPtr<char> path = GetAppConfigPathPtr((base + ".csv.gz").c_str());
 	if (!profiler_snapshot_dump_csv_gz(snap.get(), path))
 		blog(LOG_WARNING, "Could not save profiler data to '%s'", static_cast<const char *>(path));
+
+	if (profiler_trace) {
+		BPtr<char> tracePath = GetAppConfigPathPtr((base + ".json").c_str());
+		if (!profiler_trace_dump_json(tracePath))
+			blog(LOG_WARNING, "Could not save profiler trace to '%s'",
+			     static_cast<const char *>(tracePath));
+	}
 }
 
 static auto ProfilerFree = [](void *) {
@@ -488,7 +498,30 @@ QAccessibleInterface *accessibleFactory(const QString &classname, QObject *objec
 	return nullptr;
 }
 
+static void LogMemoryPoolStats()
+{
+	if (!bmem_pool_enabled())
+		return;
+
+	auto log_stats = [](void *, const bmem_pool_stats *stats) {
+		blog(LOG_INFO,
+		     "Memory pool: %s: %" PRIu64 " allocs, %" PRIu64 " frees, %" PRIu64 " bytes requested, %" PRIu64
+		     " bytes allocated",
+		     stats->name, stats->allocs, stats->frees, stats->bytes_requested, stats->bytes_allocated);
+		return true;
+	};
+
+	size_t reserved, in_use;
+	bmem_pool_enum_stats(log_stats, nullptr);
+	bmem_pool_get_memory(&reserved, &in_use);
+	blog(LOG_INFO, "Memory pool: %zu bytes reserved, %zu bytes in use", reserved, in_use);
+}
+
 static const char *run_program_init = "run_program_init";
+
+/* roughly the last few seconds of calls, about 10 MB */
+#define PROFILER_TRACE_RECORDS (256 * 1024)
+
 static int run_program(fstream &logFile, int argc, char *argv[])
 {
 	int ret = -1;
@@ -931,6 +964,9 @@ int main(int argc, char *argv[])
 		} else if (arg_is(argv[i], "--unfiltered_log", nullptr)) {
 			unfiltered_log = true;
 
+		} else if (arg_is(argv[i], "--profiler-trace", nullptr)) {
+			profiler_trace = true;
+
 		} else if (arg_is(argv[i], "--startstreaming", nullptr)) {
 			opt_start_streaming = true;
 
@@ -995,6 +1031,8 @@ int main(int argc, char *argv[])
 				"--verbose: Make log more verbose.\n"
 				"--always-on-top: Start in 'always on top' mode.\n\n"
 				"--unfiltered_log: Make log unfiltered.\n\n"
+				"--profiler-trace: Save a trace of the most recent profiler calls on exit,\n"
+				"                  viewable in Perfetto or chrome://tracing.\n\n"
 				"--disable-updater: Disable built-in updater (Windows/Mac only)\n\n"
 				"--disable-missing-files-check: Disable the missing files dialog which can appear on startup.\n\n";
 
@@ -1011,6 +1049,9 @@ int main(int argc, char *argv[])
 		}
 	}
 
+	if (profiler_trace)
+		profiler_trace_start(PROFILER_TRACE_RECORDS);
+
 #if ALLOW_PORTABLE_MODE
 	if (!portable_mode) {
 		portable_mode = os_file_exists(BASE_PATH "/portable_mode") ||
@@ -1046,6 +1087,7 @@ int main(int argc, char *argv[])
 	log_blocked_dlls();
 #endif
 
+	LogMemoryPoolStats();
 	blog(LOG_INFO, "Number of memory leaks: %ld", bnum_allocs());
 	base_set_log_handler(nullptr, nullptr);
 
@@ -0,0 +1,258 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include "SceneCollectionSaver.hpp"
+
+#include <util/platform.h>
+#include <util/profiler.hpp>
+#include <util/threading.h>
+
+#include <cinttypes>
+
+/* ------------------------------------------------------------------------- */
+/* obs_data helpers, only looking at user values like the JSON writer does  */
+
+static obs_data_t *CloneData(obs_data_t *data)
+{
+	obs_data_t *copy = obs_data_create();
+
+	for (obs_data_item_t *item = obs_data_first(data); item; obs_data_item_next(&item)) {
+		if (!obs_data_item_has_user_value(item))
+			continue;
+
+		const char *name = obs_data_item_get_name(item);
+
+		switch (obs_data_item_gettype(item)) {
+		case OBS_DATA_NULL:
+			break;
+		case OBS_DATA_STRING:
+			obs_data_set_string(copy, name, obs_data_item_get_string(item));
+			break;
+		case OBS_DATA_NUMBER:
+			if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+				obs_data_set_int(copy, name, obs_data_item_get_int(item));
+			else
+				obs_data_set_double(copy, name, obs_data_item_get_double(item));
+			break;
+		case OBS_DATA_BOOLEAN:
+			obs_data_set_bool(copy, name, obs_data_item_get_bool(item));
+			break;
+		case OBS_DATA_OBJECT: {
+			OBSDataAutoRelease obj = obs_data_item_get_obj(item);
+			OBSDataAutoRelease objCopy = CloneData(obj);
+			obs_data_set_obj(copy, name, objCopy);
+			break;
+		}
+		case OBS_DATA_ARRAY: {
+			OBSDataArrayAutoRelease array = obs_data_item_get_array(item);
+			OBSDataArrayAutoRelease arrayCopy = obs_data_array_create();
+			size_t count = obs_data_array_count(array);
+			for (size_t i = 0; i < count; i++) {
+				OBSDataAutoRelease obj = obs_data_array_item(array, i);
+				OBSDataAutoRelease objCopy = CloneData(obj);
+				obs_data_array_push_back(arrayCopy, objCopy);
+			}
+			obs_data_set_array(copy, name, arrayCopy);
+			break;
+		}
+		}
+	}
+
+	return copy;
+}
+
+/* appends pretty printed JSON of a nested value, indenting every line */
+static void AppendIndented(std::string &out, const std::string &json, size_t indent)
+{
+	size_t start = 0;
+
+	while (start < json.size()) {
+		size_t end = json.find('\n', start);
+		if (end == std::string::npos)
+			end = json.size();
+		else
+			end++;
+
+		out.append(indent, ' ');
+		out.append(json, start, end - start);
+		start = end;
+	}
+}
+
+/* ------------------------------------------------------------------------- */
+
+SceneCollectionSaver::SceneCollectionSaver()
+{
+	thread = std::thread(&SceneCollectionSaver::Thread, this);
+}
+
+SceneCollectionSaver::~SceneCollectionSaver()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+
+	cv.notify_all();
+	thread.join();
+}
+
+void SceneCollectionSaver::SplitSources(obs_data_array_t *array, std::vector<SourceEntry> &entries, size_t &reused)
+{
+	size_t count = obs_data_array_count(array);
+	entries.resize(count);
+
+	for (size_t i = 0; i < count; i++) {
+		SourceEntry &entry = entries[i];
+		OBSDataAutoRelease data = obs_data_array_item(array, i);
+
+		entry.uuid = obs_data_get_string(data, "uuid");
+		entry.fingerprint = obs_data_get_hash(data);
+
+		if (!entry.uuid.empty()) {
+			std::lock_guard<std::mutex> lock(mutex);
+			auto it = cache.find(entry.uuid);
+			if (it != cache.end() && it->second.fingerprint == entry.fingerprint)
+				entry.json = it->second.json;
+		}
+
+		if (entry.json)
+			reused++;
+		else
+			entry.data = CloneData(data);
+	}
+}
+
+void SceneCollectionSaver::Queue(obs_data_t *data, const std::string &path)
+{
+	ProfileScope("SceneCollectionSaver::Queue");
+
+	auto job = std::make_unique<SaveJob>();
+	job->path = path;
+	job->queued_ns = os_gettime_ns();
+
+	OBSDataArrayAutoRelease sources = obs_data_get_array(data, "sources");
+	OBSDataArrayAutoRelease groups = obs_data_get_array(data, "groups");
+	SplitSources(sources, job->sources, job->reused);
+	SplitSources(groups, job->groups, job->reused);
+
+	obs_data_erase(data, "sources");
+	obs_data_erase(data, "groups");
+	job->data = CloneData(data);
+
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		pending = std::move(job);
+	}
+
+	cv.notify_all();
+}
+
+void SceneCollectionSaver::Flush()
+{
+	std::unique_lock<std::mutex> lock(mutex);
+	cv.wait(lock, [this] { return !pending && !writing; });
+}
+
+std::string SceneCollectionSaver::Serialize(SaveJob &job)
+{
+	std::unordered_map<std::string, CachedSource> newCache;
+
+	auto appendArray = [&](std::string &out, const char *name, std::vector<SourceEntry> &entries) {
+		out += ",\n    \"";
+		out += name;
+		out += "\": [";
+
+		for (size_t i = 0; i < entries.size(); i++) {
+			SourceEntry &entry = entries[i];
+
+			if (!entry.json)
+				entry.json = std::make_shared<const std::string>(obs_data_get_json_pretty(entry.data));
+			if (!entry.uuid.empty())
+				newCache[entry.uuid] = {entry.fingerprint, entry.json};
+
+			out += i ? ",\n" : "\n";
+			AppendIndented(out, *entry.json, 8);
+		}
+
+		out += entries.empty() ? "]" : "\n    ]";
+	};
+
+	/* the rest of the collection is never empty, it always has at least
+	 * the current scene and transition */
+	std::string json = obs_data_get_json_pretty(job.data);
+	size_t end = json.rfind('}');
+	json.erase(end == std::string::npos ? 0 : end);
+	while (!json.empty() && json.back() == '\n')
+		json.pop_back();
+
+	appendArray(json, "sources", job.sources);
+	appendArray(json, "groups", job.groups);
+	json += "\n}";
+
+	/* drop removed sources from the cache */
+	std::lock_guard<std::mutex> lock(mutex);
+	cache = std::move(newCache);
+
+	return json;
+}
+
+void SceneCollectionSaver::Write(SaveJob &job)
+{
+	ProfileScope("SceneCollectionSaver::Write");
+
+	uint64_t start = os_gettime_ns();
+	std::string json = Serialize(job);
+	bool success =
+		os_quick_write_utf8_file_safe(job.path.c_str(), json.c_str(), json.size(), false, "tmp", "bak");
+	uint64_t end = os_gettime_ns();
+
+	if (!success) {
+		blog(LOG_ERROR, "Could not save scene data to %s", job.path.c_str());
+		return;
+	}
+
+	blog(LOG_DEBUG,
+	     "Saved scene collection in %.2f ms (%.2f ms since queued), "
+	     "reused %zu of %zu sources",
+	     (double)(end - start) / 1000000.0, (double)(end - job.queued_ns) / 1000000.0, job.reused,
+	     job.sources.size() + job.groups.size());
+}
+
+void SceneCollectionSaver::Thread()
+{
+	os_set_thread_name("scene collection saver");
+
+	std::unique_lock<std::mutex> lock(mutex);
+
+	for (;;) {
+		cv.wait(lock, [this] { return pending || stopping; });
+		if (!pending && stopping)
+			break;
+
+		std::unique_ptr<SaveJob> job = std::move(pending);
+		writing = true;
+		lock.unlock();
+
+		Write(*job);
+		job.reset();
+
+		lock.lock();
+		writing = false;
+		cv.notify_all();
+	}
+}
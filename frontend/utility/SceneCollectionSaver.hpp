@@ -0,0 +1,85 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include <obs.hpp>
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+/* Writes scene collection files on a background thread.
+ *
+ * Queue() takes the collection data built on the UI thread.  The "sources"
+ * and "groups" arrays are split into per-source entries: a source whose
+ * saved data has the same fingerprint as in the previous save reuses its
+ * serialized JSON, other sources (and the rest of the collection) are deep
+ * copied so the background thread never touches data shared with live
+ * sources.  Serialization and the file write happen on the background
+ * thread, and only the newest pending save is written. */
+class SceneCollectionSaver {
+public:
+	SceneCollectionSaver();
+	~SceneCollectionSaver();
+
+	/* Takes the collection data, which is modified and must not be used
+	 * afterwards */
+	void Queue(obs_data_t *data, const std::string &path);
+
+	/* Blocks until all queued saves have been written */
+	void Flush();
+
+private:
+	struct SourceEntry {
+		std::string uuid;
+		uint64_t fingerprint = 0;
+		std::shared_ptr<const std::string> json;
+		OBSDataAutoRelease data;
+	};
+
+	struct SaveJob {
+		std::string path;
+		OBSDataAutoRelease data;
+		std::vector<SourceEntry> sources;
+		std::vector<SourceEntry> groups;
+		uint64_t queued_ns = 0;
+		size_t reused = 0;
+	};
+
+	struct CachedSource {
+		uint64_t fingerprint;
+		std::shared_ptr<const std::string> json;
+	};
+
+	std::mutex mutex;
+	std::condition_variable cv;
+	std::unique_ptr<SaveJob> pending;
+	bool writing = false;
+	bool stopping = false;
+	std::unordered_map<std::string, CachedSource> cache;
+	std::thread thread;
+
+	void SplitSources(obs_data_array_t *array, std::vector<SourceEntry> &entries, size_t &reused);
+	std::string Serialize(SaveJob &job);
+	void Write(SaveJob &job);
+	void Thread();
+};
@@ -24,6 +24,7 @@
 #include <oauth/Auth.hpp>
 #include <utility/BasicOutputHandler.hpp>
 #include <utility/OBSCanvas.hpp>
+#include <utility/SceneCollectionSaver.hpp>
 #include <utility/VCamConfig.hpp>
 #include <utility/platform.hpp>
 #include <utility/undo_stack.hpp>
@@ -1056,6 +1057,7 @@ private:
 	OBSDataAutoRelease collectionModuleData;
 	long disableSaving = 1;
 	bool projectChanged = false;
+	SceneCollectionSaver collectionSaver;
 	bool clearingFailed = false;
 
 	QPointer<OBSMissingFiles> missDialog;
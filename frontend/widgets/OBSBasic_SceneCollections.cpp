@@ -950,11 +950,7 @@ void OBSBasic::Save(SceneCollection &collection)
 	}
 
 	const std::string collectionFileName = collection.getFilePathString();
-	bool success = obs_data_save_json_pretty_safe(saveData, collectionFileName.c_str(), "tmp", "bak");
-
-	if (!success) {
-		blog(LOG_ERROR, "Could not save scene data to %s", collectionFileName.c_str());
-	}
+	collectionSaver.Queue(saveData, collectionFileName);
 }
 
 void OBSBasic::DeferSaveBegin()
@@ -1141,6 +1137,8 @@ static inline void AddMissingFiles(void *data, obs_source_t *source)
 
 void OBSBasic::LoadData(obs_data_t *data, SceneCollection &collection)
 {
+	uint64_t loadStart = os_gettime_ns();
+
 	ClearSceneData();
 	ClearContextBar();
 
@@ -1290,7 +1288,9 @@ void OBSBasic::LoadData(obs_data_t *data, SceneCollection &collection)
 	updateRemigrationMenuItem(collection.getCoordinateMode(), ui->actionRemigrateSceneCollection);
 
 	obs_missing_files_t *files = obs_missing_files_create();
+	uint64_t sourcesStart = os_gettime_ns();
 	obs_load_sources(sources, AddMissingFiles, files);
+	uint64_t sourcesEnd = os_gettime_ns();
 
 	if (resetVideo)
 		ResetVideo();
@@ -1437,6 +1437,9 @@ retryScene:
 
 	LogScenes();
 
+	blog(LOG_INFO, "Loaded scene collection in %.1f ms (sources: %.1f ms)",
+	     (double)(os_gettime_ns() - loadStart) / 1000000.0, (double)(sourcesEnd - sourcesStart) / 1000000.0);
+
 	if (!App()->IsMissingFilesCheckDisabled())
 		ShowMissingFilesDialog(files);
 
@@ -1451,11 +1454,13 @@ retryScene:
 
 void OBSBasic::SaveProjectNow()
 {
-	if (disableSaving)
-		return;
+	if (!disableSaving) {
+		projectChanged = true;
+		SaveProjectDeferred();
+	}
 
-	projectChanged = true;
-	SaveProjectDeferred();
+	/* callers rely on the collection file being up to date */
+	collectionSaver.Flush();
 }
 
 void OBSBasic::SaveProject()
@@ -0,0 +1,263 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <stdlib.h>
+
+#include <obs-config.h>
+#include <util/dstr.h>
+#include <util/platform.h>
+#include <util/serializer.h>
+#include <util/file-serializer.h>
+#include <util/fnv1a.h>
+#include "gl-subsystem.h"
+
+/*
+ * Linked programs are stored with glGetProgramBinary in a directory specific
+ * to the driver, so a driver update starts with an empty cache.  The hashes of
+ * shaders that have compiled successfully are kept in an index file; such
+ * shaders are only compiled when their program is not in the cache.
+ *
+ * Program file layout (little endian): magic, binary format, binary length,
+ * binary data, checksum of the binary data.
+ */
+
+#define PROGRAM_CACHE_MAGIC 0x4E42474F /* "OGBN" */
+#define SHADER_INDEX_FILE "shaders.idx"
+
+static int cmp_hash(const void *a, const void *b)
+{
+	uint64_t val1 = *(const uint64_t *)a;
+	uint64_t val2 = *(const uint64_t *)b;
+	return val1 < val2 ? -1 : (val1 > val2 ? 1 : 0);
+}
+
+static uint8_t *read_file(const char *path, size_t *size)
+{
+	FILE *f = os_fopen(path, "rb");
+	if (!f)
+		return NULL;
+
+	int64_t file_size = os_fgetsize(f);
+	uint8_t *data = NULL;
+
+	if (file_size > 0) {
+		data = bmalloc((size_t)file_size);
+		if (fread(data, 1, (size_t)file_size, f) != (size_t)file_size) {
+			bfree(data);
+			data = NULL;
+		}
+	}
+
+	fclose(f);
+	*size = data ? (size_t)file_size : 0;
+	return data;
+}
+
+static void load_shader_index(struct gs_device *device)
+{
+	struct dstr path = {0};
+	size_t size = 0;
+
+	dstr_printf(&path, "%s/" SHADER_INDEX_FILE, device->program_cache_path);
+	uint8_t *data = read_file(path.array, &size);
+	dstr_free(&path);
+
+	if (!data)
+		return;
+
+	/* ignore a partially written last entry */
+	size_t count = size / sizeof(uint64_t);
+	da_push_back_array(device->compiled_shaders, (uint64_t *)data, count);
+	qsort(device->compiled_shaders.array, count, sizeof(uint64_t), cmp_hash);
+	bfree(data);
+}
+
+void gl_program_cache_init(struct gs_device *device)
+{
+	GLint formats = 0;
+
+	if (!GLAD_GL_VERSION_4_1 && !GLAD_GL_ARB_get_program_binary)
+		return;
+
+	glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+	if (!gl_success("glGetIntegerv") || formats <= 0)
+		return;
+
+	char *dir = gs_get_cache_path(NULL);
+	if (!dir)
+		return;
+
+	const char *vendor = (const char *)glGetString(GL_VENDOR);
+	const char *renderer = (const char *)glGetString(GL_RENDERER);
+	const char *version = (const char *)glGetString(GL_VERSION);
+	struct dstr driver = {0};
+
+	dstr_printf(&driver, "%u %s %s %s", (unsigned)LIBOBS_API_VER, vendor ? vendor : "", renderer ? renderer : "",
+		    version ? version : "");
+
+	struct dstr path = {0};
+	dstr_printf(&path, "%s/gl-%016llx", dir, (unsigned long long)fnv1a_64_str(driver.array));
+	dstr_free(&driver);
+	bfree(dir);
+
+	if (os_mkdirs(path.array) == MKDIR_ERROR) {
+		blog(LOG_WARNING, "Failed to create program cache directory '%s'", path.array);
+		dstr_free(&path);
+		return;
+	}
+
+	device->program_cache_path = path.array;
+	load_shader_index(device);
+
+	blog(LOG_INFO, "OpenGL program cache: %s (%zu known shaders)", device->program_cache_path,
+	     device->compiled_shaders.num);
+}
+
+void gl_program_cache_free(struct gs_device *device)
+{
+	da_free(device->compiled_shaders);
+	bfree(device->program_cache_path);
+	device->program_cache_path = NULL;
+}
+
+bool gl_program_cache_shader_compiled(struct gs_device *device, uint64_t hash)
+{
+	if (!device->program_cache_path || !device->compiled_shaders.num)
+		return false;
+
+	return bsearch(&hash, device->compiled_shaders.array, device->compiled_shaders.num, sizeof(uint64_t),
+		       cmp_hash) != NULL;
+}
+
+void gl_program_cache_add_shader(struct gs_device *device, uint64_t hash)
+{
+	if (!device->program_cache_path || gl_program_cache_shader_compiled(device, hash))
+		return;
+
+	size_t idx = 0;
+	while (idx < device->compiled_shaders.num && device->compiled_shaders.array[idx] < hash)
+		idx++;
+	da_insert(device->compiled_shaders, idx, &hash);
+
+	struct dstr path = {0};
+	dstr_printf(&path, "%s/" SHADER_INDEX_FILE, device->program_cache_path);
+
+	FILE *f = os_fopen(path.array, "ab");
+	if (f) {
+		fwrite(&hash, sizeof(hash), 1, f);
+		fclose(f);
+	}
+
+	dstr_free(&path);
+}
+
+static char *get_program_file(const struct gs_program *program)
+{
+	uint64_t hash = FNV1A_64_INIT;
+	hash = fnv1a_64(hash, &program->vertex_shader->hash, sizeof(uint64_t));
+	hash = fnv1a_64(hash, &program->pixel_shader->hash, sizeof(uint64_t));
+
+	struct dstr path = {0};
+	dstr_printf(&path, "%s/%016llx.bin", program->device->program_cache_path, (unsigned long long)hash);
+	return path.array;
+}
+
+static inline uint32_t read_u32(const uint8_t *data)
+{
+	return (uint32_t)data[0] | ((uint32_t)data[1] << 8) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static inline uint64_t read_u64(const uint8_t *data)
+{
+	return (uint64_t)read_u32(data) | ((uint64_t)read_u32(data + 4) << 32);
+}
+
+bool gl_program_cache_load(struct gs_program *program)
+{
+	const size_t header_size = sizeof(uint32_t) * 3;
+	int linked = false;
+
+	if (!program->device->program_cache_path)
+		return false;
+
+	char *path = get_program_file(program);
+	size_t size = 0;
+	uint8_t *data = read_file(path, &size);
+	bfree(path);
+
+	if (!data)
+		return false;
+
+	if (size < header_size + sizeof(uint64_t) || read_u32(data) != PROGRAM_CACHE_MAGIC)
+		goto fail;
+
+	GLenum format = read_u32(data + 4);
+	uint32_t length = read_u32(data + 8);
+	const uint8_t *binary = data + header_size;
+
+	if (size != header_size + length + sizeof(uint64_t))
+		goto fail;
+	if (read_u64(binary + length) != fnv1a_64(FNV1A_64_INIT, binary, length))
+		goto fail;
+
+	glProgramBinary(program->obj, format, binary, (GLsizei)length);
+	if (!gl_success("glProgramBinary"))
+		goto fail;
+
+	/* drivers reject binaries they can no longer use */
+	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
+	if (!gl_success("glGetProgramiv"))
+		linked = false;
+
+fail:
+	bfree(data);
+	return linked != GL_FALSE;
+}
+
+void gl_program_cache_save(struct gs_program *program)
+{
+	struct serializer s;
+	GLint length = 0;
+	GLenum format = 0;
+
+	if (!program->device->program_cache_path)
+		return;
+
+	glGetProgramiv(program->obj, GL_PROGRAM_BINARY_LENGTH, &length);
+	if (!gl_success("glGetProgramiv") || length <= 0)
+		return;
+
+	uint8_t *binary = bmalloc((size_t)length);
+	glGetProgramBinary(program->obj, length, &length, &format, binary);
+	if (!gl_success("glGetProgramBinary") || length <= 0) {
+		bfree(binary);
+		return;
+	}
+
+	char *path = get_program_file(program);
+	if (file_output_serializer_init_safe(&s, path, "tmp")) {
+		s_wl32(&s, PROGRAM_CACHE_MAGIC);
+		s_wl32(&s, format);
+		s_wl32(&s, (uint32_t)length);
+		s_write(&s, binary, (size_t)length);
+		s_wl64(&s, fnv1a_64(FNV1A_64_INIT, binary, (size_t)length));
+		file_output_serializer_free(&s);
+	}
+
+	bfree(path);
+	bfree(binary);
+}
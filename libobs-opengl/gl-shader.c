@@ -17,6 +17,7 @@
 
 #include <assert.h>
 
+#include <util/fnv1a.h>
 #include <graphics/vec2.h>
 #include <graphics/vec3.h>
 #include <graphics/vec4.h>
@@ -174,36 +175,37 @@ static inline bool gl_process_attribs(struct gs_shader *shader, struct gl_shader
 	return true;
 }
 
-static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *glsp, const char *file,
-			   char **error_string)
+static bool gl_shader_compile(struct gs_shader *shader, char **error_string)
 {
 	GLenum type = convert_shader_type(shader->type);
 	int compiled = 0;
 	bool success = true;
 
 	shader->obj = glCreateShader(type);
-	if (!gl_success("glCreateShader") || !shader->obj)
+	if (!gl_success("glCreateShader") || !shader->obj) {
+		shader->obj = 0;
 		return false;
+	}
 
-	glShaderSource(shader->obj, 1, (const GLchar **)&glsp->gl_string.array, 0);
+	glShaderSource(shader->obj, 1, (const GLchar **)&shader->gl_string, 0);
 	if (!gl_success("glShaderSource"))
-		return false;
+		goto fail;
 
 	glCompileShader(shader->obj);
 	if (!gl_success("glCompileShader"))
-		return false;
+		goto fail;
 
 #if 0
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
-	blog(LOG_DEBUG, "  GL shader string for: %s", file);
+	blog(LOG_DEBUG, "  GL shader string for: %s", shader->file);
 	blog(LOG_DEBUG, "-----------------------------------");
-	blog(LOG_DEBUG, "%s", glsp->gl_string.array);
+	blog(LOG_DEBUG, "%s", shader->gl_string);
 	blog(LOG_DEBUG, "+++++++++++++++++++++++++++++++++++");
 #endif
 
 	glGetShaderiv(shader->obj, GL_COMPILE_STATUS, &compiled);
 	if (!gl_success("glGetShaderiv"))
-		return false;
+		goto fail;
 
 	if (!compiled) {
 		GLint infoLength = 0;
@@ -222,7 +224,39 @@ static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *gl
 		success = false;
 	}
 
-	gl_get_shader_info(shader->obj, file, error_string);
+	gl_get_shader_info(shader->obj, shader->file, error_string);
+
+	if (!success)
+		goto fail;
+
+	gl_program_cache_add_shader(shader->device, shader->hash);
+
+	bfree(shader->gl_string);
+	shader->gl_string = NULL;
+	return true;
+
+fail:
+	/* a deferred compile is retried by the next program using the shader,
+	 * which checks for a zero object */
+	glDeleteShader(shader->obj);
+	gl_success("glDeleteShader");
+	shader->obj = 0;
+	return false;
+}
+
+static bool gl_shader_init(struct gs_shader *shader, struct gl_shader_parser *glsp, const char *file,
+			   char **error_string)
+{
+	bool success = true;
+
+	shader->gl_string = bstrdup(glsp->gl_string.array);
+	shader->file = bstrdup(file ? file : "(string)");
+	shader->hash = fnv1a_64_str(shader->gl_string);
+
+	/* shaders known to compile are compiled when their program is
+	 * created, which is skipped if the program is in the cache */
+	if (!gl_program_cache_shader_compiled(shader->device, shader->hash))
+		success = gl_shader_compile(shader, error_string);
 
 	if (success)
 		success = gl_add_params(shader, glsp);
@@ -325,6 +359,8 @@ void gs_shader_destroy(gs_shader_t *shader)
 	da_free(shader->samplers);
 	da_free(shader->params);
 	da_free(shader->attribs);
+	bfree(shader->gl_string);
+	bfree(shader->file);
 	bfree(shader);
 }
 
@@ -598,38 +634,68 @@ static inline bool assign_program_params(struct gs_program *program)
 	return true;
 }
 
-struct gs_program *gs_program_create(struct gs_device *device)
+static bool link_program(struct gs_program *program)
 {
-	struct gs_program *program = bzalloc(sizeof(*program));
+	struct gs_shader *vs = program->vertex_shader;
+	struct gs_shader *ps = program->pixel_shader;
 	int linked = false;
 
-	program->device = device;
-	program->vertex_shader = device->cur_vertex_shader;
-	program->pixel_shader = device->cur_pixel_shader;
+	if (!vs->obj && !gl_shader_compile(vs, NULL))
+		return false;
+	if (!ps->obj && !gl_shader_compile(ps, NULL))
+		return false;
 
-	program->obj = glCreateProgram();
-	if (!gl_success("glCreateProgram"))
-		goto error_detach_neither;
+	if (program->device->program_cache_path) {
+		glProgramParameteri(program->obj, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		gl_success("glProgramParameteri");
+	}
 
-	glAttachShader(program->obj, program->vertex_shader->obj);
+	glAttachShader(program->obj, vs->obj);
 	if (!gl_success("glAttachShader (vertex)"))
-		goto error_detach_neither;
+		return false;
 
-	glAttachShader(program->obj, program->pixel_shader->obj);
+	glAttachShader(program->obj, ps->obj);
 	if (!gl_success("glAttachShader (pixel)"))
-		goto error_detach_vertex;
+		goto detach_vertex;
 
 	glLinkProgram(program->obj);
 	if (!gl_success("glLinkProgram"))
-		goto error;
+		goto detach;
 
 	glGetProgramiv(program->obj, GL_LINK_STATUS, &linked);
 	if (!gl_success("glGetProgramiv"))
-		goto error;
-
-	if (linked == GL_FALSE) {
+		linked = false;
+	else if (linked == GL_FALSE)
 		print_link_errors(program->obj);
+
+detach:
+	glDetachShader(program->obj, ps->obj);
+	gl_success("glDetachShader (pixel)");
+
+detach_vertex:
+	glDetachShader(program->obj, vs->obj);
+	gl_success("glDetachShader (vertex)");
+
+	return linked != GL_FALSE;
+}
+
+struct gs_program *gs_program_create(struct gs_device *device)
+{
+	struct gs_program *program = bzalloc(sizeof(*program));
+
+	program->device = device;
+	program->vertex_shader = device->cur_vertex_shader;
+	program->pixel_shader = device->cur_pixel_shader;
+
+	program->obj = glCreateProgram();
+	if (!gl_success("glCreateProgram"))
 		goto error;
+
+	if (!gl_program_cache_load(program)) {
+		if (!link_program(program))
+			goto error;
+
+		gl_program_cache_save(program);
 	}
 
 	if (!assign_program_attribs(program))
@@ -637,12 +703,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	if (!assign_program_params(program))
 		goto error;
 
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
 	program->next = device->first_program;
 	program->prev_next = &device->first_program;
 	device->first_program = program;
@@ -652,14 +712,6 @@ struct gs_program *gs_program_create(struct gs_device *device)
 	return program;
 
 error:
-	glDetachShader(program->obj, program->pixel_shader->obj);
-	gl_success("glDetachShader (pixel)");
-
-error_detach_vertex:
-	glDetachShader(program->obj, program->vertex_shader->obj);
-	gl_success("glDetachShader (vertex)");
-
-error_detach_neither:
 	gs_program_destroy(program);
 	return NULL;
 }
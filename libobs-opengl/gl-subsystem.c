@@ -290,6 +290,8 @@ int device_create(gs_device_t **p_device, uint32_t adapter)
 	     "language %s",
 	     glVersion, glShadingLanguage);
 
+	gl_program_cache_init(device);
+
 	gl_enable(GL_CULL_FACE);
 	gl_gen_vertex_arrays(1, &device->empty_vao);
 
@@ -334,6 +336,7 @@ void device_destroy(gs_device_t *device)
 		gl_delete_vertex_arrays(1, &device->empty_vao);
 
 		da_free(device->proj_stack);
+		gl_program_cache_free(device);
 		gl_platform_destroy(device->plat);
 		bfree(device);
 	}
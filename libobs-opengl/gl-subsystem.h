@@ -472,6 +472,12 @@ struct gs_shader {
 	enum gs_shader_type type;
 	GLuint obj;
 
+	/* GLSL is kept until the shader is compiled, which is deferred for
+	 * shaders that compiled before when the program cache is enabled */
+	char *gl_string;
+	char *file;
+	uint64_t hash;
+
 	struct gs_shader_param *viewproj;
 	struct gs_shader_param *world;
 
@@ -502,6 +508,13 @@ extern struct gs_program *gs_program_create(struct gs_device *device);
 extern void gs_program_destroy(struct gs_program *program);
 extern void program_update_params(struct gs_program *shader);
 
+extern void gl_program_cache_init(struct gs_device *device);
+extern void gl_program_cache_free(struct gs_device *device);
+extern bool gl_program_cache_shader_compiled(struct gs_device *device, uint64_t hash);
+extern void gl_program_cache_add_shader(struct gs_device *device, uint64_t hash);
+extern bool gl_program_cache_load(struct gs_program *program);
+extern void gl_program_cache_save(struct gs_program *program);
+
 struct gs_vertex_buffer {
 	GLuint vao;
 	GLuint vertex_buffer;
@@ -646,6 +659,9 @@ struct gs_device {
 
 	struct gs_program *first_program;
 
+	char *program_cache_path;
+	DARRAY(uint64_t) compiled_shaders;
+
 	enum gs_cull_mode cur_cull_mode;
 	struct gs_rect cur_viewport;
 
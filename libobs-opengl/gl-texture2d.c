@@ -255,6 +255,51 @@ bool gs_texture_is_rect(const gs_texture_t *tex)
 	return tex2d->base.gl_target == GL_TEXTURE_RECTANGLE;
 }
 
+void gs_texture_set_image_rects(gs_texture_t *tex, const uint8_t *data, uint32_t linesize,
+				const struct gs_rect *rects, size_t num_rects)
+{
+	struct gs_texture_2d *tex2d = (struct gs_texture_2d *)tex;
+	uint32_t bytes_per_pixel;
+
+	if (!is_texture_2d(tex, "gs_texture_set_image_rects"))
+		goto fail;
+	if (gs_is_compressed_format(tex->format))
+		goto fail;
+
+	bytes_per_pixel = gs_get_format_bpp(tex->format) / 8;
+	if (!bytes_per_pixel || linesize % bytes_per_pixel != 0)
+		goto fail;
+
+	if (!gl_bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0))
+		goto fail;
+	if (!gl_bind_texture(tex2d->base.gl_target, tex2d->base.texture))
+		goto fail;
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, linesize / bytes_per_pixel);
+
+	for (size_t i = 0; i < num_rects; i++) {
+		const struct gs_rect *rect = &rects[i];
+
+		if (rect->x < 0 || rect->y < 0 || rect->cx <= 0 || rect->cy <= 0 ||
+		    (uint32_t)(rect->x + rect->cx) > tex2d->width || (uint32_t)(rect->y + rect->cy) > tex2d->height)
+			continue;
+
+		const uint8_t *ptr = data + (size_t)rect->y * linesize + (size_t)rect->x * bytes_per_pixel;
+		glTexSubImage2D(tex2d->base.gl_target, 0, rect->x, rect->y, rect->cx, rect->cy, tex->gl_format,
+				tex->gl_type, ptr);
+	}
+
+	glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+
+	bool success = gl_success("glTexSubImage2D");
+	gl_bind_texture(tex2d->base.gl_target, 0);
+	if (success)
+		return;
+
+fail:
+	blog(LOG_ERROR, "gs_texture_set_image_rects (GL) failed");
+}
+
 void *gs_texture_get_obj(gs_texture_t *tex)
 {
 	struct gs_texture_2d *tex2d = (struct gs_texture_2d *)tex;
@@ -26,3 +26,9 @@ void audio_monitor_destroy(struct audio_monitor *monitor)
 {
 	UNUSED_PARAMETER(monitor);
 }
+
+bool audio_monitor_get_stats(struct obs_audio_monitoring_stats *stats)
+{
+	UNUSED_PARAMETER(stats);
+	return false;
+}
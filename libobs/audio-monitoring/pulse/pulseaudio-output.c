@@ -1,13 +1,27 @@
 #include "obs-internal.h"
 #include "pulseaudio-wrapper.h"
 
-#define PULSE_DATA(voidptr) struct audio_monitor *data = voidptr;
+#define PULSE_DATA(voidptr) struct monitor_bus *data = voidptr;
 #define blog(level, msg, ...) blog(level, "pulse-am: " msg, ##__VA_ARGS__)
 
-struct audio_monitor {
-	obs_source_t *source;
+/*
+ * All monitored sources are mixed into a single bus which is played through
+ * one stream.  Each source has a small jitter buffer of float planar audio at
+ * the OBS sample rate; the stream's write callback mixes the buffers that
+ * have filled up, and resamples the mix once to the device format.
+ *
+ * A source only contributes to the mix once it has buffered half the target
+ * latency, and goes back to buffering if it runs dry.  Audio that exceeds
+ * twice the target latency is dropped to compensate for clock drift between
+ * the source and the device.
+ */
+
+#define MIX_FRAMES AUDIO_OUTPUT_FRAMES
+
+struct monitor_bus {
 	pa_stream *stream;
 	char *device;
+	char *device_id;
 	pa_buffer_attr attr;
 	enum speaker_layout speakers;
 	pa_sample_format_t format;
@@ -15,16 +29,41 @@ struct audio_monitor {
 	uint_fast32_t bytes_per_frame;
 	uint_fast8_t channels;
 
-	uint_fast32_t packets;
-	uint_fast64_t frames;
-
-	struct deque new_data;
 	audio_resampler_t *resampler;
+	size_t planes;
+	uint32_t obs_sample_rate;
+	uint32_t latency_ms;
+	size_t start_frames;
+	size_t max_frames;
+
+	long refs;
+
+	/* protects everything below, taken inside the PulseAudio lock */
+	pthread_mutex_t mutex;
+	DARRAY(struct audio_monitor *) inputs;
+	struct deque pending;
+	float mix[MAX_AUDIO_CHANNELS][MIX_FRAMES];
+
+	uint64_t source_underruns;
+	uint64_t dropped_frames;
+	uint64_t device_underflows;
+	uint64_t frames;
+};
+
+struct audio_monitor {
+	obs_source_t *source;
+	struct monitor_bus *bus;
+
+	/* protected by bus->mutex */
+	struct deque buffer[MAX_AUDIO_CHANNELS];
+	bool ready;
 
 	bool ignore;
-	pthread_mutex_t playback_mutex;
 };
 
+static pthread_mutex_t bus_mutex = PTHREAD_MUTEX_INITIALIZER;
+static struct monitor_bus *cur_bus = NULL;
+
 static enum speaker_layout pulseaudio_channels_to_obs_speakers(uint_fast32_t channels)
 {
 	switch (channels) {
@@ -120,153 +159,145 @@ static pa_channel_map pulseaudio_channel_map(enum speaker_layout layout)
 	return ret;
 }
 
-static void process_byte(void *p, size_t frames, size_t channels, float vol)
+static inline size_t buffered_frames(const struct audio_monitor *monitor)
 {
-	register uint8_t *cur = (uint8_t *)p;
-	register uint8_t *end = cur + frames * channels;
-
-	for (; cur < end; cur++)
-		*cur = ((int)*cur - 128) * vol + 128;
+	return monitor->buffer[0].size / sizeof(float);
 }
 
-static void process_s16(void *p, size_t frames, size_t channels, float vol)
+static void bus_mix(struct monitor_bus *bus)
 {
-	register int16_t *cur = (int16_t *)p;
-	register int16_t *end = cur + frames * channels;
+	float in[MIX_FRAMES];
+	const uint8_t *mix_data[MAX_AV_PLANES] = {0};
+	uint8_t *resample_data[MAX_AV_PLANES];
+	uint32_t resample_frames;
+	uint64_t ts_offset;
 
-	while (cur < end)
-		*(cur++) *= vol;
-}
+	for (size_t ch = 0; ch < bus->planes; ch++) {
+		memset(bus->mix[ch], 0, sizeof(bus->mix[ch]));
+		mix_data[ch] = (const uint8_t *)bus->mix[ch];
+	}
 
-static void process_s32(void *p, size_t frames, size_t channels, float vol)
-{
-	register int32_t *cur = (int32_t *)p;
-	register int32_t *end = cur + frames * channels;
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		struct audio_monitor *monitor = bus->inputs.array[i];
+		size_t frames = buffered_frames(monitor);
 
-	while (cur < end)
-		*(cur++) *= vol;
-}
+		if (!monitor->ready) {
+			if (frames < bus->start_frames)
+				continue;
+			monitor->ready = true;
+		}
 
-static void process_float(void *p, size_t frames, size_t channels, float vol)
-{
-	register float *cur = (float *)p;
-	register float *end = cur + frames * channels;
+		if (frames < MIX_FRAMES) {
+			monitor->ready = false;
+			bus->source_underruns++;
+		} else {
+			frames = MIX_FRAMES;
+		}
 
-	while (cur < end)
-		*(cur++) *= vol;
-}
+		for (size_t ch = 0; ch < bus->planes; ch++) {
+			deque_pop_front(&monitor->buffer[ch], in, frames * sizeof(float));
 
-void process_volume(const struct audio_monitor *monitor, float vol, uint8_t *const *resample_data,
-		    uint32_t resample_frames)
-{
-	switch (monitor->format) {
-	case PA_SAMPLE_U8:
-		process_byte(resample_data[0], resample_frames, monitor->channels, vol);
-		break;
-	case PA_SAMPLE_S16LE:
-		process_s16(resample_data[0], resample_frames, monitor->channels, vol);
-		break;
-	case PA_SAMPLE_S32LE:
-		process_s32(resample_data[0], resample_frames, monitor->channels, vol);
-		break;
-	case PA_SAMPLE_FLOAT32LE:
-		process_float(resample_data[0], resample_frames, monitor->channels, vol);
-		break;
-	default:
-		// just ignore
-		break;
+			for (size_t j = 0; j < frames; j++)
+				bus->mix[ch][j] += in[j];
+		}
 	}
+
+	if (!audio_resampler_resample(bus->resampler, resample_data, &resample_frames, &ts_offset, mix_data,
+				      MIX_FRAMES))
+		return;
+
+	deque_push_back(&bus->pending, resample_data[0], resample_frames * bus->bytes_per_frame);
+	bus->frames += MIX_FRAMES;
 }
 
-static void do_stream_write(void *param)
+static void bus_write(pa_stream *s, size_t nbytes, void *param)
 {
 	PULSE_DATA(param);
 	uint8_t *buffer = NULL;
 
-	pulseaudio_lock();
-	pthread_mutex_lock(&data->playback_mutex);
-
-	// If we have grown a large buffer internally, grow the pulse buffer to match so we can write our data out.
-	if (data->new_data.size > data->attr.tlength * 2) {
-		data->attr.fragsize = (uint32_t)-1;
-		data->attr.maxlength = (uint32_t)-1;
-		data->attr.prebuf = (uint32_t)-1;
-		data->attr.minreq = (uint32_t)-1;
-		data->attr.tlength = data->new_data.size;
-		pa_stream_set_buffer_attr(data->stream, &data->attr, NULL, NULL);
-	}
+	pthread_mutex_lock(&data->mutex);
 
-	// Buffer up enough data before we start playing.
-	if (pa_stream_is_corked(data->stream)) {
-		if (data->new_data.size >= data->attr.tlength) {
-			pa_stream_cork(data->stream, 0, NULL, NULL);
-		} else {
-			goto finish;
-		}
+	/* the device clock drives the bus; sources that are not ready yet
+	 * are mixed in as silence */
+	for (int i = 0; data->pending.size < nbytes && i < 64; i++)
+		bus_mix(data);
+
+	while (nbytes > 0 && data->pending.size > 0) {
+		size_t bytes = nbytes < data->pending.size ? nbytes : data->pending.size;
+		if (pa_stream_begin_write(s, (void **)&buffer, &bytes) || !bytes)
+			break;
+
+		if (bytes > data->pending.size)
+			bytes = data->pending.size;
+		if (bytes > nbytes)
+			bytes = nbytes;
+
+		deque_pop_front(&data->pending, buffer, bytes);
+		pa_stream_write(s, buffer, bytes, NULL, 0LL, PA_SEEK_RELATIVE);
+		nbytes -= bytes;
 	}
 
-	while (data->new_data.size > 0) {
-		size_t bytesToFill = data->new_data.size;
-		if (pa_stream_begin_write(data->stream, (void **)&buffer, &bytesToFill))
-			goto finish;
+	pthread_mutex_unlock(&data->mutex);
+}
 
-		// PA may request we submit more or less data than we have.
-		// Wait for more data if we cannot perform a full write.
-		if (bytesToFill > data->new_data.size) {
-			pa_stream_cancel_write(data->stream);
-			goto finish;
-		}
+static void bus_underflow(pa_stream *s, void *param)
+{
+	UNUSED_PARAMETER(s);
+	PULSE_DATA(param);
+
+	pthread_mutex_lock(&data->mutex);
+	data->device_underflows++;
+	pthread_mutex_unlock(&data->mutex);
+}
 
-		deque_pop_front(&data->new_data, buffer, bytesToFill);
+static void push_plane(struct deque *buf, const float *src, size_t frames, float vol, bool muted)
+{
+	float out[MIX_FRAMES];
 
-		pa_stream_write(data->stream, buffer, bytesToFill, NULL, 0LL, PA_SEEK_RELATIVE);
+	if (muted) {
+		deque_push_back_zero(buf, frames * sizeof(float));
+		return;
+	}
+	if (close_float(vol, 1.0f, EPSILON)) {
+		deque_push_back(buf, src, frames * sizeof(float));
+		return;
 	}
 
-finish:
-	pthread_mutex_unlock(&data->playback_mutex);
-	pulseaudio_unlock();
+	while (frames > 0) {
+		size_t count = frames < MIX_FRAMES ? frames : MIX_FRAMES;
+		for (size_t i = 0; i < count; i++)
+			out[i] = src[i] * vol;
+
+		deque_push_back(buf, out, count * sizeof(float));
+		src += count;
+		frames -= count;
+	}
 }
 
 static void on_audio_playback(void *param, obs_source_t *source, const struct audio_data *audio_data, bool muted)
 {
 	struct audio_monitor *monitor = param;
+	struct monitor_bus *bus = monitor->bus;
 	float vol = source->user_volume;
-	size_t bytes;
-
-	uint8_t *resample_data[MAX_AV_PLANES];
-	uint32_t resample_frames;
-	uint64_t ts_offset;
-	bool success;
-
-	if (pthread_mutex_trylock(&monitor->playback_mutex) != 0)
-		return;
 
 	if (os_atomic_load_long(&source->activate_refs) == 0)
-		goto unlock;
+		return;
 
-	success = audio_resampler_resample(monitor->resampler, resample_data, &resample_frames, &ts_offset,
-					   (const uint8_t *const *)audio_data->data, (uint32_t)audio_data->frames);
+	pthread_mutex_lock(&bus->mutex);
 
-	if (!success)
-		goto unlock;
+	for (size_t ch = 0; ch < bus->planes; ch++)
+		push_plane(&monitor->buffer[ch], (const float *)audio_data->data[ch], audio_data->frames, vol, muted);
 
-	bytes = monitor->bytes_per_frame * resample_frames;
+	size_t frames = buffered_frames(monitor);
+	if (frames > bus->max_frames) {
+		size_t drop = frames - bus->start_frames;
 
-	if (muted) {
-		memset(resample_data[0], 0, bytes);
-	} else {
-		if (!close_float(vol, 1.0f, EPSILON)) {
-			process_volume(monitor, vol, resample_data, resample_frames);
-		}
+		for (size_t ch = 0; ch < bus->planes; ch++)
+			deque_pop_front(&monitor->buffer[ch], NULL, drop * sizeof(float));
+		bus->dropped_frames += drop;
 	}
 
-	deque_push_back(&monitor->new_data, resample_data[0], bytes);
-	monitor->packets++;
-	monitor->frames += resample_frames;
-
-unlock:
-	pthread_mutex_unlock(&monitor->playback_mutex);
-	do_stream_write(param);
+	pthread_mutex_unlock(&bus->mutex);
 }
 
 static void pulseaudio_server_info(pa_context *c, const pa_server_info *i, void *userdata)
@@ -322,87 +353,90 @@ skip:
 	pulseaudio_signal(0);
 }
 
-static void pulseaudio_stop_playback(struct audio_monitor *monitor)
+static void pulseaudio_stop_playback(struct monitor_bus *bus)
 {
-	if (monitor->stream) {
-		/* Stop the stream */
+	if (bus->stream) {
+		/* Remove the callbacks and stop the stream.  No callback can
+		 * be running while the PulseAudio lock is held. */
 		pulseaudio_lock();
-		pa_stream_disconnect(monitor->stream);
-		pulseaudio_unlock();
-
-		/* Remove the callbacks, to ensure we no longer try to do anything
-		 * with this stream object */
-		pulseaudio_write_callback(monitor->stream, NULL, NULL);
+		pa_stream_set_write_callback(bus->stream, NULL, NULL);
+		pa_stream_set_underflow_callback(bus->stream, NULL, NULL);
+		pa_stream_disconnect(bus->stream);
 
 		/* Unreference the stream and drop it. PA will free it when it can. */
-		pulseaudio_lock();
-		pa_stream_unref(monitor->stream);
+		pa_stream_unref(bus->stream);
 		pulseaudio_unlock();
-		monitor->stream = NULL;
+		bus->stream = NULL;
 	}
 
-	blog(LOG_INFO, "Stopped Monitoring in '%s'", monitor->device);
-	blog(LOG_INFO, "Got %" PRIuFAST32 " packets with %" PRIuFAST64 " frames", monitor->packets, monitor->frames);
-
-	monitor->packets = 0;
-	monitor->frames = 0;
+	blog(LOG_INFO, "Stopped Monitoring in '%s'", bus->device);
+	blog(LOG_INFO,
+	     "Mixed %" PRIu64 " frames, %" PRIu64 " source underruns, %" PRIu64 " dropped frames, %" PRIu64
+	     " device underflows",
+	     bus->frames, bus->source_underruns, bus->dropped_frames, bus->device_underflows);
 }
 
-static bool audio_monitor_init(struct audio_monitor *monitor, obs_source_t *source)
+static void bus_destroy(struct monitor_bus *bus)
 {
-	pthread_mutex_init_value(&monitor->playback_mutex);
-
-	monitor->source = source;
+	if (bus->stream)
+		pulseaudio_stop_playback(bus);
+	pulseaudio_unref();
 
-	const char *id = obs->audio.monitoring_device_id;
-	if (!id)
-		return false;
+	audio_resampler_destroy(bus->resampler);
+	deque_free(&bus->pending);
+	da_free(bus->inputs);
+	pthread_mutex_destroy(&bus->mutex);
+	bfree(bus->device_id);
+	bfree(bus->device);
+	bfree(bus);
+}
 
-	if (source->info.output_flags & OBS_SOURCE_DO_NOT_SELF_MONITOR) {
-		obs_data_t *s = obs_source_get_settings(source);
-		const char *s_dev_id = obs_data_get_string(s, "device_id");
-		bool match = devices_match(s_dev_id, id);
-		obs_data_release(s);
+static struct monitor_bus *bus_create(const char *id)
+{
+	struct monitor_bus *bus = bzalloc(sizeof(*bus));
 
-		if (match) {
-			monitor->ignore = true;
-			blog(LOG_INFO, "Prevented feedback-loop in '%s'", s_dev_id);
-			return true;
-		}
+	pthread_mutex_init_value(&bus->mutex);
+	if (pthread_mutex_init(&bus->mutex, NULL) != 0) {
+		bfree(bus);
+		return NULL;
 	}
 
 	pulseaudio_init();
 
+	bus->refs = 1;
+	bus->device_id = bstrdup(id);
+	bus->latency_ms = obs->audio.monitoring_latency_ms;
+
 	if (strcmp(id, "default") == 0)
-		get_default_id(&monitor->device);
+		get_default_id(&bus->device);
 	else
-		monitor->device = bstrdup(id);
+		bus->device = bstrdup(id);
 
-	if (!monitor->device)
-		return false;
+	if (!bus->device)
+		goto fail;
 
-	if (pulseaudio_get_server_info(pulseaudio_server_info, (void *)monitor) < 0) {
+	if (pulseaudio_get_server_info(pulseaudio_server_info, (void *)bus) < 0) {
 		blog(LOG_ERROR, "Unable to get server info !");
-		return false;
+		goto fail;
 	}
 
-	if (pulseaudio_get_sink_info(pulseaudio_sink_info, monitor->device, (void *)monitor) < 0) {
+	if (pulseaudio_get_sink_info(pulseaudio_sink_info, bus->device, (void *)bus) < 0) {
 		blog(LOG_ERROR, "Unable to get sink info !");
-		return false;
+		goto fail;
 	}
-	if (monitor->format == PA_SAMPLE_INVALID) {
+	if (bus->format == PA_SAMPLE_INVALID) {
 		blog(LOG_ERROR, "An error occurred while getting the source info!");
-		return false;
+		goto fail;
 	}
 
 	pa_sample_spec spec;
-	spec.format = monitor->format;
-	spec.rate = (uint32_t)monitor->samples_per_sec;
-	spec.channels = monitor->channels;
+	spec.format = bus->format;
+	spec.rate = (uint32_t)bus->samples_per_sec;
+	spec.channels = bus->channels;
 
 	if (!pa_sample_spec_valid(&spec)) {
 		blog(LOG_ERROR, "Sample spec is not valid");
-		return false;
+		goto fail;
 	}
 
 	const struct audio_output_info *info = audio_output_get_info(obs->audio.audio);
@@ -410,70 +444,169 @@ static bool audio_monitor_init(struct audio_monitor *monitor, obs_source_t *sour
 	struct resample_info from = {.samples_per_sec = info->samples_per_sec,
 				     .speakers = info->speakers,
 				     .format = AUDIO_FORMAT_FLOAT_PLANAR};
-	struct resample_info to = {.samples_per_sec = (uint32_t)monitor->samples_per_sec,
-				   .speakers = pulseaudio_channels_to_obs_speakers(monitor->channels),
-				   .format = pulseaudio_to_obs_audio_format(monitor->format)};
+	struct resample_info to = {.samples_per_sec = (uint32_t)bus->samples_per_sec,
+				   .speakers = pulseaudio_channels_to_obs_speakers(bus->channels),
+				   .format = pulseaudio_to_obs_audio_format(bus->format)};
 
-	monitor->resampler = audio_resampler_create(&to, &from);
-	if (!monitor->resampler) {
+	bus->resampler = audio_resampler_create(&to, &from);
+	if (!bus->resampler) {
 		blog(LOG_WARNING, "%s: %s", __FUNCTION__, "Failed to create resampler");
-		return false;
+		goto fail;
 	}
 
-	monitor->speakers = pulseaudio_channels_to_obs_speakers(spec.channels);
-	monitor->bytes_per_frame = pa_frame_size(&spec);
+	bus->planes = get_audio_channels(info->speakers);
+	bus->obs_sample_rate = info->samples_per_sec;
+	bus->speakers = pulseaudio_channels_to_obs_speakers(spec.channels);
+	bus->bytes_per_frame = pa_frame_size(&spec);
+
+	/* half of the target latency is spent in the source buffers, the
+	 * other half in the stream */
+	uint64_t half_latency_us = (uint64_t)bus->latency_ms * 500;
+	bus->start_frames = (size_t)util_mul_div64(half_latency_us, info->samples_per_sec, 1000000);
+	if (bus->start_frames < MIX_FRAMES)
+		bus->start_frames = MIX_FRAMES;
+	bus->max_frames = bus->start_frames * 4;
 
-	pa_channel_map channel_map = pulseaudio_channel_map(monitor->speakers);
+	pa_channel_map channel_map = pulseaudio_channel_map(bus->speakers);
 
-	monitor->stream = pulseaudio_stream_new(obs_source_get_name(monitor->source), &spec, &channel_map);
-	if (!monitor->stream) {
+	bus->stream = pulseaudio_stream_new("OBS Monitoring", &spec, &channel_map);
+	if (!bus->stream) {
 		blog(LOG_ERROR, "Unable to create stream");
-		return false;
+		goto fail;
 	}
 
-	monitor->attr.fragsize = (uint32_t)-1;
-	monitor->attr.maxlength = (uint32_t)-1;
-	monitor->attr.minreq = (uint32_t)-1;
-	monitor->attr.prebuf = (uint32_t)-1;
-	monitor->attr.tlength = pa_usec_to_bytes(25000, &spec);
+	bus->attr.fragsize = (uint32_t)-1;
+	bus->attr.maxlength = (uint32_t)-1;
+	bus->attr.minreq = (uint32_t)-1;
+	bus->attr.prebuf = (uint32_t)-1;
+	bus->attr.tlength = pa_usec_to_bytes(half_latency_us, &spec);
+
+	pulseaudio_write_callback(bus->stream, bus_write, bus);
+	pulseaudio_set_underflow_callback(bus->stream, bus_underflow, bus);
 
-	pa_stream_flags_t flags = PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE | PA_STREAM_START_CORKED;
+	pa_stream_flags_t flags = PA_STREAM_INTERPOLATE_TIMING | PA_STREAM_AUTO_TIMING_UPDATE |
+				  PA_STREAM_ADJUST_LATENCY;
 
-	int_fast32_t ret = pulseaudio_connect_playback(monitor->stream, monitor->device, &monitor->attr, flags);
+	int_fast32_t ret = pulseaudio_connect_playback(bus->stream, bus->device, &bus->attr, flags);
 	if (ret < 0) {
-		pulseaudio_stop_playback(monitor);
 		blog(LOG_ERROR, "Unable to connect to stream");
+		goto fail;
+	}
+
+	blog(LOG_INFO, "Started Monitoring in '%s' with %" PRIu32 " ms target latency", bus->device,
+	     bus->latency_ms);
+	return bus;
+
+fail:
+	bus_destroy(bus);
+	return NULL;
+}
+
+/* returns the bus for the current monitoring device, creating it if needed */
+static struct monitor_bus *bus_acquire(const char *id)
+{
+	struct monitor_bus *bus;
+
+	pthread_mutex_lock(&bus_mutex);
+
+	if (cur_bus && (strcmp(cur_bus->device_id, id) != 0 ||
+			cur_bus->latency_ms != obs->audio.monitoring_latency_ms))
+		cur_bus = NULL;
+
+	if (cur_bus) {
+		bus = cur_bus;
+		bus->refs++;
+	} else {
+		bus = cur_bus = bus_create(id);
+	}
+
+	pthread_mutex_unlock(&bus_mutex);
+	return bus;
+}
+
+static void bus_release(struct monitor_bus *bus)
+{
+	bool destroy;
+
+	if (!bus)
+		return;
+
+	pthread_mutex_lock(&bus_mutex);
+	destroy = --bus->refs == 0;
+	if (destroy && cur_bus == bus)
+		cur_bus = NULL;
+	pthread_mutex_unlock(&bus_mutex);
+
+	if (destroy)
+		bus_destroy(bus);
+}
+
+/* makes the next monitor that is created or reset open a new bus */
+static void bus_detach(struct monitor_bus *bus)
+{
+	pthread_mutex_lock(&bus_mutex);
+	if (cur_bus == bus)
+		cur_bus = NULL;
+	pthread_mutex_unlock(&bus_mutex);
+}
+
+static bool audio_monitor_init(struct audio_monitor *monitor, obs_source_t *source)
+{
+	monitor->source = source;
+
+	const char *id = obs->audio.monitoring_device_id;
+	if (!id)
 		return false;
+
+	if (source->info.output_flags & OBS_SOURCE_DO_NOT_SELF_MONITOR) {
+		obs_data_t *s = obs_source_get_settings(source);
+		const char *s_dev_id = obs_data_get_string(s, "device_id");
+		bool match = devices_match(s_dev_id, id);
+		obs_data_release(s);
+
+		if (match) {
+			monitor->ignore = true;
+			blog(LOG_INFO, "Prevented feedback-loop in '%s'", s_dev_id);
+			return true;
+		}
 	}
 
-	blog(LOG_INFO, "Started Monitoring in '%s'", monitor->device);
-	return true;
+	monitor->bus = bus_acquire(id);
+	return monitor->bus != NULL;
 }
 
 static void audio_monitor_init_final(struct audio_monitor *monitor)
 {
+	struct monitor_bus *bus = monitor->bus;
+
 	if (monitor->ignore)
 		return;
 
+	pthread_mutex_lock(&bus->mutex);
+	da_push_back(bus->inputs, &monitor);
+	pthread_mutex_unlock(&bus->mutex);
+
 	obs_source_add_audio_capture_callback(monitor->source, on_audio_playback, monitor);
 }
 
 static inline void audio_monitor_free(struct audio_monitor *monitor)
 {
-	if (monitor->ignore)
+	struct monitor_bus *bus = monitor->bus;
+
+	if (monitor->ignore || !bus)
 		return;
 
 	if (monitor->source)
 		obs_source_remove_audio_capture_callback(monitor->source, on_audio_playback, monitor);
 
-	audio_resampler_destroy(monitor->resampler);
-	deque_free(&monitor->new_data);
+	pthread_mutex_lock(&bus->mutex);
+	da_erase_item(bus->inputs, &monitor);
+	for (size_t ch = 0; ch < MAX_AUDIO_CHANNELS; ch++)
+		deque_free(&monitor->buffer[ch]);
+	pthread_mutex_unlock(&bus->mutex);
 
-	if (monitor->stream)
-		pulseaudio_stop_playback(monitor);
-	pulseaudio_unref();
-
-	bfree(monitor->device);
+	bus_release(bus);
+	monitor->bus = NULL;
 }
 
 struct audio_monitor *audio_monitor_create(obs_source_t *source)
@@ -494,25 +627,26 @@ struct audio_monitor *audio_monitor_create(obs_source_t *source)
 	return out;
 
 fail:
-	audio_monitor_free(&monitor);
+	bus_release(monitor.bus);
 	return NULL;
 }
 
 void audio_monitor_reset(struct audio_monitor *monitor)
 {
 	struct audio_monitor new_monitor = {0};
-	bool success;
-	audio_monitor_free(monitor);
+	obs_source_t *source = monitor->source;
 
-	pthread_mutex_lock(&monitor->playback_mutex);
-	success = audio_monitor_init(&new_monitor, monitor->source);
-	pthread_mutex_unlock(&monitor->playback_mutex);
+	/* the first monitor to be reset opens a new bus, the others follow */
+	bus_detach(monitor->bus);
+	audio_monitor_free(monitor);
+	memset(monitor, 0, sizeof(*monitor));
+	monitor->source = source;
 
-	if (success) {
+	if (audio_monitor_init(&new_monitor, source)) {
 		*monitor = new_monitor;
 		audio_monitor_init_final(monitor);
 	} else {
-		audio_monitor_free(&new_monitor);
+		bus_release(new_monitor.bus);
 	}
 }
 
@@ -528,3 +662,50 @@ void audio_monitor_destroy(struct audio_monitor *monitor)
 		bfree(monitor);
 	}
 }
+
+bool audio_monitor_get_stats(struct obs_audio_monitoring_stats *stats)
+{
+	struct monitor_bus *bus;
+	pa_usec_t latency = 0;
+	int negative = 0;
+
+	pthread_mutex_lock(&bus_mutex);
+	bus = cur_bus;
+	if (bus)
+		bus->refs++;
+	pthread_mutex_unlock(&bus_mutex);
+
+	if (!bus)
+		return false;
+
+	memset(stats, 0, sizeof(*stats));
+
+	pulseaudio_lock();
+	if (pa_stream_get_latency(bus->stream, &latency, &negative) < 0 || negative)
+		latency = 0;
+	pulseaudio_unlock();
+
+	pthread_mutex_lock(&bus->mutex);
+
+	stats->target_latency_ms = bus->latency_ms;
+	stats->device_latency_ms = (uint32_t)(latency / 1000);
+	stats->sources = (uint32_t)bus->inputs.num;
+	stats->source_underruns = bus->source_underruns;
+	stats->dropped_frames = bus->dropped_frames;
+	stats->device_underflows = bus->device_underflows;
+
+	for (size_t i = 0; i < bus->inputs.num; i++) {
+		size_t frames = buffered_frames(bus->inputs.array[i]);
+		uint32_t ms = (uint32_t)util_mul_div64(frames, 1000, bus->obs_sample_rate);
+
+		if (i == 0 || ms < stats->min_buffered_ms)
+			stats->min_buffered_ms = ms;
+		if (ms > stats->max_buffered_ms)
+			stats->max_buffered_ms = ms;
+	}
+
+	pthread_mutex_unlock(&bus->mutex);
+
+	bus_release(bus);
+	return true;
+}
@@ -37,6 +37,7 @@ target_compile_definitions(
     OBS_INSTALL_PREFIX="${OBS_INSTALL_PREFIX}"
     $<$<COMPILE_LANG_AND_ID:C,GNU>:ENABLE_DARRAY_TYPE_TEST>
     $<$<COMPILE_LANG_AND_ID:CXX,GNU>:ENABLE_DARRAY_TYPE_TEST>
+    $<$<TARGET_EXISTS:XCB::XINPUT>:XCB_XINPUT_FOUND>
 )
 
 target_link_libraries(
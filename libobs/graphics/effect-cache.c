@@ -0,0 +1,584 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <sys/stat.h>
+#include <time.h>
+
+#include "../obs-config.h"
+#include "../util/array-serializer.h"
+#include "../util/file-serializer.h"
+#include "../util/fnv1a.h"
+#include "../util/platform.h"
+#include "../util/threading.h"
+#include "effect-cache.h"
+#include "graphics-internal.h"
+
+extern const char *gs_preprocessor_name(void);
+
+/*
+ * Cache file layout (little endian, strings are a 32 bit length followed by
+ * the characters without a terminator, or UINT32_MAX for NULL):
+ *
+ *   magic, version, environment string
+ *   included files: count, then path and content hash of each
+ *   parameters: count, then name, type, default value and annotations
+ *   techniques: count, then name and passes of each
+ *   passes: count, then name, vertex shader and pixel shader of each
+ *   shaders: source, then count and names of the effect parameters used
+ *   checksum of everything before it
+ */
+
+#define EFFECT_CACHE_MAGIC 0x5846424F /* "OBFX" */
+/* Increment if the on-disk format changes */
+#define EFFECT_CACHE_VERSION 1
+
+static pthread_mutex_t cache_path_mutex = PTHREAD_MUTEX_INITIALIZER;
+static char *cache_path = NULL;
+
+void gs_set_cache_path(const char *path)
+{
+	pthread_mutex_lock(&cache_path_mutex);
+	bfree(cache_path);
+	cache_path = (path && *path) ? bstrdup(path) : NULL;
+	pthread_mutex_unlock(&cache_path_mutex);
+}
+
+char *gs_get_cache_path(const char *subdir)
+{
+	struct dstr path = {0};
+
+	pthread_mutex_lock(&cache_path_mutex);
+	if (cache_path) {
+		dstr_copy(&path, cache_path);
+		if (subdir && *subdir) {
+			dstr_cat_ch(&path, '/');
+			dstr_cat(&path, subdir);
+		}
+	}
+	pthread_mutex_unlock(&cache_path_mutex);
+
+	return path.array;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Pruning */
+
+/* When the cache grows past the limit, the files written least recently are
+ * removed until it is back to 3/4 of the limit.  Runtime-generated effects
+ * would otherwise grow the cache without bound. */
+#define GRAPHICS_CACHE_MAX_SIZE (128LL * 1024 * 1024)
+
+struct cache_file {
+	char *path;
+	int64_t size;
+	time_t mtime;
+};
+
+typedef DARRAY(struct cache_file) cache_files_t;
+
+static int cmp_cache_file(const void *a, const void *b)
+{
+	const struct cache_file *file1 = a;
+	const struct cache_file *file2 = b;
+	return file1->mtime < file2->mtime ? -1 : (file1->mtime > file2->mtime ? 1 : 0);
+}
+
+/* collects the files of the cache directory and of its subdirectories */
+static void enum_cache_files(const char *dir, bool recurse, cache_files_t *files, int64_t *total)
+{
+	os_dir_t *d = os_opendir(dir);
+	struct os_dirent *ent;
+
+	if (!d)
+		return;
+
+	while ((ent = os_readdir(d)) != NULL) {
+		struct dstr path = {0};
+		struct stat st;
+
+		if (strcmp(ent->d_name, ".") == 0 || strcmp(ent->d_name, "..") == 0)
+			continue;
+
+		dstr_printf(&path, "%s/%s", dir, ent->d_name);
+
+		if (ent->directory) {
+			if (recurse)
+				enum_cache_files(path.array, false, files, total);
+			dstr_free(&path);
+
+		} else if (os_stat(path.array, &st) == 0) {
+			struct cache_file *file = da_push_back_new(*files);
+			file->path = path.array;
+			file->size = (int64_t)st.st_size;
+			file->mtime = st.st_mtime;
+			*total += file->size;
+
+		} else {
+			dstr_free(&path);
+		}
+	}
+
+	os_closedir(d);
+}
+
+void gs_cache_prune(void)
+{
+	char *dir = gs_get_cache_path(NULL);
+	cache_files_t files;
+	int64_t total = 0;
+	size_t removed = 0;
+
+	if (!dir)
+		return;
+
+	da_init(files);
+	enum_cache_files(dir, true, &files, &total);
+
+	if (total > GRAPHICS_CACHE_MAX_SIZE) {
+		qsort(files.array, files.num, sizeof(struct cache_file), cmp_cache_file);
+
+		for (size_t i = 0; i < files.num && total > GRAPHICS_CACHE_MAX_SIZE / 4 * 3; i++) {
+			if (os_unlink(files.array[i].path) == 0) {
+				total -= files.array[i].size;
+				removed++;
+			}
+		}
+
+		blog(LOG_INFO, "Removed %zu old files from the graphics cache", removed);
+	}
+
+	for (size_t i = 0; i < files.num; i++)
+		bfree(files.array[i].path);
+	da_free(files);
+	bfree(dir);
+}
+
+static char *get_cache_file(const char *effect_string)
+{
+	char *dir = gs_get_cache_path("effects");
+	if (!dir)
+		return NULL;
+
+	/* effects contain preprocessor blocks specific to the device */
+	const char *preprocessor = gs_preprocessor_name();
+	uint64_t hash = fnv1a_64_str(effect_string);
+	if (preprocessor)
+		hash = fnv1a_64(hash, preprocessor, strlen(preprocessor));
+
+	struct dstr path = {0};
+	dstr_printf(&path, "%s/%016llx.effect", dir, (unsigned long long)hash);
+	bfree(dir);
+	return path.array;
+}
+
+static void get_environment(struct dstr *env)
+{
+	const char *device = gs_get_device_name();
+	dstr_printf(env, "%u %s", (unsigned)LIBOBS_API_VER, device ? device : "");
+}
+
+/* ------------------------------------------------------------------------- */
+/* Writing */
+
+static void write_string(struct serializer *s, const char *str)
+{
+	if (!str) {
+		s_wl32(s, UINT32_MAX);
+		return;
+	}
+
+	uint32_t len = (uint32_t)strlen(str);
+	s_wl32(s, len);
+	s_write(s, str, len);
+}
+
+static void write_param(struct serializer *s, const struct gs_effect_param *param)
+{
+	write_string(s, param->name);
+	s_wl32(s, (uint32_t)param->type);
+	s_wl32(s, (uint32_t)param->default_val.num);
+	s_write(s, param->default_val.array, param->default_val.num);
+
+	s_wl32(s, (uint32_t)param->annotations.num);
+	for (size_t i = 0; i < param->annotations.num; i++) {
+		const struct gs_effect_param *annotation = param->annotations.array + i;
+		write_string(s, annotation->name);
+		s_wl32(s, (uint32_t)annotation->type);
+		s_wl32(s, (uint32_t)annotation->default_val.num);
+		s_write(s, annotation->default_val.array, annotation->default_val.num);
+	}
+}
+
+static void write_shader(struct serializer *s, const struct ep_shader *shader)
+{
+	write_string(s, shader->source.array);
+	s_wl32(s, (uint32_t)shader->used_params.num);
+	for (size_t i = 0; i < shader->used_params.num; i++)
+		write_string(s, shader->used_params.array[i].array);
+}
+
+void effect_cache_save(const struct effect_parser *ep, const gs_effect_t *effect, const char *effect_string)
+{
+	struct array_output_data data;
+	struct serializer s;
+	struct dstr env = {0};
+	size_t shader_idx = 0;
+
+	char *file = get_cache_file(effect_string);
+	if (!file)
+		return;
+
+	array_output_serializer_init(&s, &data);
+
+	s_wl32(&s, EFFECT_CACHE_MAGIC);
+	s_wl32(&s, EFFECT_CACHE_VERSION);
+	get_environment(&env);
+	write_string(&s, env.array);
+
+	const struct cf_preprocessor *pp = &ep->cfp.pp;
+	s_wl32(&s, (uint32_t)pp->dependencies.num);
+	for (size_t i = 0; i < pp->dependencies.num; i++) {
+		const struct cf_lexer *dep = pp->dependencies.array + i;
+		write_string(&s, dep->file);
+		s_wl64(&s, fnv1a_64_str(dep->base_lexer.text ? dep->base_lexer.text : ""));
+	}
+
+	s_wl32(&s, (uint32_t)effect->params.num);
+	for (size_t i = 0; i < effect->params.num; i++)
+		write_param(&s, effect->params.array + i);
+
+	s_wl32(&s, (uint32_t)effect->techniques.num);
+	for (size_t i = 0; i < effect->techniques.num; i++) {
+		const struct gs_effect_technique *tech = effect->techniques.array + i;
+
+		write_string(&s, tech->name);
+		s_wl32(&s, (uint32_t)tech->passes.num);
+		for (size_t j = 0; j < tech->passes.num; j++) {
+			write_string(&s, tech->passes.array[j].name);
+			write_shader(&s, ep->shaders.array + shader_idx++);
+			write_shader(&s, ep->shaders.array + shader_idx++);
+		}
+	}
+
+	s_wl64(&s, fnv1a_64(FNV1A_64_INIT, data.bytes.array, data.bytes.num));
+
+	struct serializer file_s;
+	char *dir = gs_get_cache_path("effects");
+	if (dir && os_mkdirs(dir) != MKDIR_ERROR && file_output_serializer_init_safe(&file_s, file, "tmp")) {
+		s_write(&file_s, data.bytes.array, data.bytes.num);
+		file_output_serializer_free(&file_s);
+	}
+
+	bfree(dir);
+	dstr_free(&env);
+	array_output_serializer_free(&data);
+	bfree(file);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Reading */
+
+struct cache_reader {
+	const uint8_t *data;
+	size_t size;
+	size_t pos;
+	bool error;
+};
+
+static const void *read_data(struct cache_reader *r, size_t size)
+{
+	if (r->error || size > r->size - r->pos) {
+		r->error = true;
+		return NULL;
+	}
+
+	const void *data = r->data + r->pos;
+	r->pos += size;
+	return data;
+}
+
+static uint32_t read_u32(struct cache_reader *r)
+{
+	const uint8_t *p = read_data(r, 4);
+	return p ? (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24) : 0;
+}
+
+static uint64_t read_u64(struct cache_reader *r)
+{
+	uint64_t low = read_u32(r);
+	uint64_t high = read_u32(r);
+	return low | (high << 32);
+}
+
+static char *read_string(struct cache_reader *r)
+{
+	uint32_t len = read_u32(r);
+	if (len == UINT32_MAX)
+		return NULL;
+
+	const char *str = read_data(r, len);
+	return str ? bstrdup_n(str, len) : NULL;
+}
+
+static bool read_bytes(struct cache_reader *r, void *array_ptr)
+{
+	DARRAY(uint8_t) *array = array_ptr;
+	uint32_t len = read_u32(r);
+	const uint8_t *bytes = read_data(r, len);
+	if (!bytes)
+		return false;
+
+	da_push_back_array(*array, bytes, len);
+	return true;
+}
+
+static bool dependencies_unchanged(struct cache_reader *r)
+{
+	uint32_t count = read_u32(r);
+
+	for (uint32_t i = 0; i < count && !r->error; i++) {
+		char *path = read_string(r);
+		uint64_t hash = read_u64(r);
+		if (!path)
+			return false;
+
+		char *text = os_quick_read_utf8_file(path);
+		bool unchanged = text && fnv1a_64_str(text) == hash;
+		bfree(text);
+		bfree(path);
+
+		if (!unchanged)
+			return false;
+	}
+
+	return !r->error;
+}
+
+static bool read_param(struct cache_reader *r, gs_effect_t *effect, struct gs_effect_param *param)
+{
+	param->name = read_string(r);
+	param->section = EFFECT_PARAM;
+	param->effect = effect;
+	param->type = (enum gs_shader_param_type)read_u32(r);
+	if (!param->name || !read_bytes(r, &param->default_val))
+		return false;
+
+	uint32_t count = read_u32(r);
+	if (r->error)
+		return false;
+
+	da_resize(param->annotations, count);
+	for (uint32_t i = 0; i < count; i++) {
+		struct gs_effect_param *annotation = param->annotations.array + i;
+
+		annotation->name = read_string(r);
+		annotation->section = EFFECT_ANNOTATION;
+		annotation->effect = effect;
+		annotation->type = (enum gs_shader_param_type)read_u32(r);
+		if (!annotation->name || !read_bytes(r, &annotation->default_val))
+			return false;
+	}
+
+	if (strcmp(param->name, "ViewProj") == 0)
+		effect->view_proj = param;
+	else if (strcmp(param->name, "World") == 0)
+		effect->world = param;
+
+	return true;
+}
+
+static bool read_shader(struct cache_reader *r, gs_effect_t *effect, struct gs_effect_pass *pass,
+			enum gs_shader_type type, const char *location)
+{
+	char *source = read_string(r);
+	uint32_t count = read_u32(r);
+	gs_shader_t *shader = NULL;
+	pass_shaderparam_array_t *params;
+
+	if (!source)
+		return false;
+
+	if (type == GS_SHADER_VERTEX) {
+		shader = pass->vertshader = gs_vertexshader_create(source, location, NULL);
+		params = &pass->vertshader_params;
+	} else {
+		shader = pass->pixelshader = gs_pixelshader_create(source, location, NULL);
+		params = &pass->pixelshader_params;
+	}
+
+	bfree(source);
+	if (!shader || r->error)
+		return false;
+
+	da_resize(*params, count);
+	for (uint32_t i = 0; i < count; i++) {
+		struct pass_shaderparam *param = params->array + i;
+		char *name = read_string(r);
+		if (!name)
+			return false;
+
+		param->eparam = gs_effect_get_param_by_name(effect, name);
+		param->sparam = gs_shader_get_param_by_name(shader, name);
+		bfree(name);
+
+		if (!param->sparam)
+			return false;
+	}
+
+	return true;
+}
+
+static bool read_technique(struct cache_reader *r, gs_effect_t *effect, struct gs_effect_technique *tech,
+			   const char *file)
+{
+	struct dstr location = {0};
+	bool success = true;
+
+	tech->name = read_string(r);
+	tech->section = EFFECT_TECHNIQUE;
+	tech->effect = effect;
+
+	uint32_t count = read_u32(r);
+	if (!tech->name || r->error)
+		return false;
+
+	da_resize(tech->passes, count);
+	for (uint32_t i = 0; i < count && success; i++) {
+		struct gs_effect_pass *pass = tech->passes.array + i;
+
+		pass->name = read_string(r);
+		pass->section = EFFECT_PASS;
+
+		dstr_printf(&location, "%s (Vertex shader, technique %s, pass %u)", file ? file : "", tech->name,
+			    (unsigned)i);
+		success = read_shader(r, effect, pass, GS_SHADER_VERTEX, location.array);
+
+		dstr_printf(&location, "%s (Pixel shader, technique %s, pass %u)", file ? file : "", tech->name,
+			    (unsigned)i);
+		success = success && read_shader(r, effect, pass, GS_SHADER_PIXEL, location.array);
+	}
+
+	dstr_free(&location);
+	return success;
+}
+
+static bool read_effect(struct cache_reader *r, gs_effect_t *effect, const char *file)
+{
+	struct dstr env = {0};
+	bool success = false;
+
+	if (read_u32(r) != EFFECT_CACHE_MAGIC || read_u32(r) != EFFECT_CACHE_VERSION)
+		return false;
+
+	char *cached_env = read_string(r);
+	get_environment(&env);
+	success = cached_env && strcmp(cached_env, env.array) == 0;
+	bfree(cached_env);
+	dstr_free(&env);
+
+	if (!success || !dependencies_unchanged(r))
+		return false;
+
+	uint32_t count = read_u32(r);
+	if (r->error)
+		return false;
+
+	da_resize(effect->params, count);
+	for (uint32_t i = 0; i < count; i++) {
+		if (!read_param(r, effect, effect->params.array + i))
+			return false;
+	}
+
+	count = read_u32(r);
+	if (r->error)
+		return false;
+
+	da_resize(effect->techniques, count);
+	for (uint32_t i = 0; i < count; i++) {
+		if (!read_technique(r, effect, effect->techniques.array + i, file))
+			return false;
+	}
+
+	return !r->error;
+}
+
+static void reset_effect(gs_effect_t *effect)
+{
+	for (size_t i = 0; i < effect->params.num; i++)
+		effect_param_free(effect->params.array + i);
+	for (size_t i = 0; i < effect->techniques.num; i++)
+		effect_technique_free(effect->techniques.array + i);
+
+	da_free(effect->params);
+	da_free(effect->techniques);
+	effect->view_proj = NULL;
+	effect->world = NULL;
+}
+
+static uint8_t *read_cache_file(const char *path, size_t *size)
+{
+	FILE *f = os_fopen(path, "rb");
+	if (!f)
+		return NULL;
+
+	int64_t file_size = os_fgetsize(f);
+	uint8_t *data = NULL;
+
+	if (file_size > (int64_t)sizeof(uint64_t)) {
+		data = bmalloc((size_t)file_size);
+		if (fread(data, 1, (size_t)file_size, f) != (size_t)file_size) {
+			bfree(data);
+			data = NULL;
+		}
+	}
+
+	fclose(f);
+	*size = (size_t)file_size;
+	return data;
+}
+
+bool effect_cache_load(gs_effect_t *effect, const char *effect_string, const char *file)
+{
+	char *path = get_cache_file(effect_string);
+	if (!path)
+		return false;
+
+	size_t size = 0;
+	uint8_t *data = read_cache_file(path, &size);
+	bool success = false;
+
+	if (data) {
+		/* the checksum is the last field */
+		struct cache_reader checksum_reader = {data + size - sizeof(uint64_t), sizeof(uint64_t), 0, false};
+		uint64_t checksum = read_u64(&checksum_reader);
+		size -= sizeof(uint64_t);
+
+		if (checksum == fnv1a_64(FNV1A_64_INIT, data, size)) {
+			struct cache_reader r = {data, size, 0, false};
+			success = read_effect(&r, effect, file);
+		} else {
+			blog(LOG_WARNING, "Effect cache file for '%s' is corrupted", file ? file : "(string)");
+		}
+
+		if (!success)
+			reset_effect(effect);
+	}
+
+	bfree(data);
+	bfree(path);
+	return success;
+}
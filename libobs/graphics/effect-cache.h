@@ -0,0 +1,45 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "effect.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * On-disk cache of parsed effects.  Stores the parameters of an effect and
+ * the generated shaders of each pass, keyed by a hash of the effect text, so
+ * an unchanged effect can be built without running the effect parser.
+ * Effects are only cached if gs_set_cache_path has been called.
+ */
+
+/* builds the effect from the cache, returns false if it is not cached */
+extern bool effect_cache_load(gs_effect_t *effect, const char *effect_string, const char *file);
+
+/* stores an effect that has been successfully parsed */
+extern void effect_cache_save(const struct effect_parser *ep, const gs_effect_t *effect, const char *effect_string);
+
+/* removes the oldest files once the whole graphics cache, including the
+ * program binaries of the device, grows too large */
+extern void gs_cache_prune(void);
+
+#ifdef __cplusplus
+}
+#endif
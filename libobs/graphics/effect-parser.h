@@ -250,6 +250,21 @@ static inline void ep_func_free(struct ep_func *epf)
 
 /* ------------------------------------------------------------------------- */
 
+/* generated shader of a pass, in technique/pass/vertex/pixel order */
+struct ep_shader {
+	struct dstr source;
+	DARRAY(struct dstr) used_params;
+};
+
+static inline void ep_shader_free(struct ep_shader *eps)
+{
+	dstr_free(&eps->source);
+	dstr_array_free(eps->used_params.array, eps->used_params.num);
+	da_free(eps->used_params);
+}
+
+/* ------------------------------------------------------------------------- */
+
 struct effect_parser {
 	gs_effect_t *effect;
 
@@ -258,6 +273,7 @@ struct effect_parser {
 	DARRAY(struct ep_func) funcs;
 	DARRAY(struct ep_sampler) samplers;
 	DARRAY(struct ep_technique) techniques;
+	DARRAY(struct ep_shader) shaders;
 
 	/* internal vars */
 	DARRAY(struct cf_lexer) files;
@@ -274,6 +290,7 @@ static inline void ep_init(struct effect_parser *ep)
 	da_init(ep->funcs);
 	da_init(ep->samplers);
 	da_init(ep->techniques);
+	da_init(ep->shaders);
 	da_init(ep->files);
 	da_init(ep->tokens);
 
@@ -133,6 +133,7 @@ bool load_graphics_imports(struct gs_exports *exports, void *module, const char
 	GRAPHICS_IMPORT(gs_texture_unmap);
 	GRAPHICS_IMPORT_OPTIONAL(gs_texture_is_rect);
 	GRAPHICS_IMPORT(gs_texture_get_obj);
+	GRAPHICS_IMPORT_OPTIONAL(gs_texture_set_image_rects);
 
 	GRAPHICS_IMPORT(gs_cubetexture_destroy);
 	GRAPHICS_IMPORT(gs_cubetexture_get_size);
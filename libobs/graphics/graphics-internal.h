@@ -141,6 +141,8 @@ struct gs_exports {
 	void (*gs_texture_unmap)(gs_texture_t *tex);
 	bool (*gs_texture_is_rect)(const gs_texture_t *tex);
 	void *(*gs_texture_get_obj)(const gs_texture_t *tex);
+	void (*gs_texture_set_image_rects)(gs_texture_t *tex, const uint8_t *data, uint32_t linesize,
+					   const struct gs_rect *rects, size_t num_rects);
 
 	void (*gs_cubetexture_destroy)(gs_texture_t *cubetex);
 	uint32_t (*gs_cubetexture_get_size)(const gs_texture_t *cubetex);
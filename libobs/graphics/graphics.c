@@ -26,6 +26,7 @@
 #include "quat.h"
 #include "axisang.h"
 #include "effect-parser.h"
+#include "effect-cache.h"
 #include "effect.h"
 
 #ifdef near
@@ -212,6 +213,8 @@ int gs_create(graphics_t **pgraphics, const char *module, uint32_t adapter)
 	if (!load_graphics_imports(&graphics->exports, graphics->module, module))
 		goto error;
 
+	gs_cache_prune();
+
 	errcode = graphics->exports.device_create(&graphics->device, adapter);
 	if (errcode != GS_SUCCESS)
 		goto error;
@@ -872,7 +875,13 @@ gs_effect_t *gs_effect_create(const char *effect_string, const char *filename, c
 	effect->effect_path = bstrdup(filename);
 
 	ep_init(&parser);
-	success = ep_parse(&parser, effect, effect_string, filename);
+	success = effect_cache_load(effect, effect_string, filename);
+	if (!success) {
+		success = ep_parse(&parser, effect, effect_string, filename);
+		if (success)
+			effect_cache_save(&parser, effect, effect_string);
+	}
+
 	if (!success) {
 		if (error_string)
 			*error_string = error_data_buildstring(&parser.cfp.error_list);
@@ -2500,6 +2509,22 @@ void *gs_texture_get_obj(gs_texture_t *tex)
 	return graphics->exports.gs_texture_get_obj(tex);
 }
 
+void gs_texture_set_image_rects(gs_texture_t *tex, const uint8_t *data, uint32_t linesize,
+				const struct gs_rect *rects, size_t num_rects)
+{
+	graphics_t *graphics = thread_graphics;
+
+	if (!gs_valid_p2("gs_texture_set_image_rects", tex, data))
+		return;
+	if (!num_rects)
+		return;
+
+	if (graphics->exports.gs_texture_set_image_rects)
+		graphics->exports.gs_texture_set_image_rects(tex, data, linesize, rects, num_rects);
+	else
+		gs_texture_set_image(tex, data, linesize, false);
+}
+
 void gs_cubetexture_destroy(gs_texture_t *cubetex)
 {
 	graphics_t *graphics = thread_graphics;
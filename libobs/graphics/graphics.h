@@ -511,6 +511,12 @@ EXPORT int gs_get_device_type(void);
 EXPORT uint32_t gs_get_adapter_count(void);
 EXPORT void gs_enum_adapters(bool (*callback)(void *param, const char *name, uint32_t id), void *param);
 
+/** Directory used to cache parsed effects and compiled shaders, NULL disables
+ * caching.  Must be set before the graphics device is created. */
+EXPORT void gs_set_cache_path(const char *path);
+/** Returns a subdirectory of the cache directory (bfree it), or NULL */
+EXPORT char *gs_get_cache_path(const char *subdir);
+
 EXPORT int gs_create(graphics_t **graphics, const char *module, uint32_t adapter);
 EXPORT void gs_destroy(graphics_t *graphics);
 
@@ -741,6 +747,13 @@ EXPORT bool gs_texture_is_rect(const gs_texture_t *tex);
  * For example, for GL, this is a GLuint*.  For D3D11, ID3D11Texture2D*.
  */
 EXPORT void *gs_texture_get_obj(gs_texture_t *tex);
+/**
+ * Updates regions of a dynamic texture.  data and linesize describe the full
+ * image, only the given rectangles are uploaded where the graphics subsystem
+ * supports it, otherwise the full image is uploaded.
+ */
+EXPORT void gs_texture_set_image_rects(gs_texture_t *tex, const uint8_t *data, uint32_t linesize,
+				       const struct gs_rect *rects, size_t num_rects);
 
 EXPORT void gs_cubetexture_destroy(gs_texture_t *cubetex);
 EXPORT uint32_t gs_cubetexture_get_size(const gs_texture_t *cubetex);
@@ -19,6 +19,8 @@
 #include "../util/base.h"
 #include "../util/platform.h"
 #include "../util/dstr.h"
+#include "../util/threading.h"
+#include "../util/darray.h"
 #include "vec4.h"
 
 #define blog(level, format, ...) blog(level, "%s: " format, __FUNCTION__, __VA_ARGS__)
@@ -69,12 +71,335 @@ static inline void *alloc_mem(gs_image_file_t *image, uint64_t *mem_usage, size_
 	return bzalloc(size);
 }
 
+/* ------------------------------------------------------------------------- */
+
+/* Animated gifs whose decoded frames fit in the memory limit are decoded once
+ * and kept in memory.  Larger gifs are decoded in order on a worker thread
+ * into a small window of upcoming frames, which is refilled as the animation
+ * advances.  The first frame is always kept so the animation can restart
+ * without waiting for the worker. */
+#define DEFAULT_GIF_MEMORY_LIMIT (64ULL * 1024 * 1024)
+#define MAX_GIF_WINDOW_FRAMES 32
+
+static pthread_mutex_t gif_memory_mutex = PTHREAD_MUTEX_INITIALIZER;
+static uint64_t gif_memory_limit = DEFAULT_GIF_MEMORY_LIMIT;
+static uint64_t gif_memory_usage = 0;
+
+struct gs_gif_window {
+	gs_image_file_t *image;
+	enum gs_image_alpha_mode alpha_mode;
+	size_t frame_size;
+	int frame_count;
+
+	pthread_t thread;
+	bool thread_valid;
+	os_sem_t *sem;
+	volatile bool stop;
+
+	/* playback positions count frames across loops, so the worker can tell
+	 * being ahead of the animation from having fallen a loop behind it */
+	int64_t next_pos;
+
+	/* protected by mutex */
+	pthread_mutex_t mutex;
+	int64_t cur_pos;
+	int64_t shown_pos;
+	int num_slots;
+	int64_t *slot_pos;
+
+	uint8_t *first_frame;
+	uint8_t *slot_data;
+	bool cur_frame_ready;
+};
+
+/* windows of all windowed gifs, protected by gif_memory_mutex; they are kept
+ * here rather than in struct gs_image_file, whose size is part of the ABI as
+ * it is embedded in gs_image_file2/3/4 */
+static DARRAY(struct gs_gif_window *) gif_windows;
+
+void gs_image_file_set_gif_memory_limit(uint64_t limit)
+{
+	pthread_mutex_lock(&gif_memory_mutex);
+	gif_memory_limit = limit;
+	pthread_mutex_unlock(&gif_memory_mutex);
+}
+
+uint64_t gs_image_file_get_gif_memory_limit(void)
+{
+	uint64_t limit;
+
+	pthread_mutex_lock(&gif_memory_mutex);
+	limit = gif_memory_limit;
+	pthread_mutex_unlock(&gif_memory_mutex);
+	return limit;
+}
+
+uint64_t gs_image_file_get_gif_memory_usage(void)
+{
+	uint64_t usage;
+
+	pthread_mutex_lock(&gif_memory_mutex);
+	usage = gif_memory_usage;
+	pthread_mutex_unlock(&gif_memory_mutex);
+	return usage;
+}
+
+static void add_gif_memory_usage(uint64_t size)
+{
+	pthread_mutex_lock(&gif_memory_mutex);
+	gif_memory_usage += size;
+	pthread_mutex_unlock(&gif_memory_mutex);
+}
+
+static void remove_gif_memory_usage(uint64_t size)
+{
+	pthread_mutex_lock(&gif_memory_mutex);
+	gif_memory_usage -= size;
+	pthread_mutex_unlock(&gif_memory_mutex);
+}
+
+static inline uint64_t gif_window_size(const struct gs_gif_window *w)
+{
+	return (uint64_t)w->frame_size * (w->num_slots + 1);
+}
+
+/* fully decoded gifs have a frame cache, windowed gifs do not */
+static struct gs_gif_window *get_gif_window(const gs_image_file_t *image)
+{
+	struct gs_gif_window *window = NULL;
+
+	if (!image->is_animated_gif || image->animation_frame_cache)
+		return NULL;
+
+	pthread_mutex_lock(&gif_memory_mutex);
+	for (size_t i = 0; i < gif_windows.num; i++) {
+		if (gif_windows.array[i]->image == image) {
+			window = gif_windows.array[i];
+			break;
+		}
+	}
+	pthread_mutex_unlock(&gif_memory_mutex);
+
+	return window;
+}
+
+static void premultiply_frame(uint8_t *data, size_t area, enum gs_image_alpha_mode alpha_mode)
+{
+	if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY_SRGB) {
+		gs_premultiply_xyza_srgb_loop(data, area);
+	} else if (alpha_mode == GS_IMAGE_ALPHA_PREMULTIPLY) {
+		gs_premultiply_xyza_loop(data, area);
+	}
+}
+
+static inline int gif_window_cur_frame(struct gs_gif_window *w)
+{
+	return (int)(w->cur_pos % w->frame_count);
+}
+
+/* returns the frame being shown if it has been decoded, or else the latest
+ * decoded frame newer than the one in the texture, call with the mutex locked */
+static uint8_t *gif_window_get_frame(struct gs_gif_window *w, int64_t *pos)
+{
+	int best = -1;
+
+	if (gif_window_cur_frame(w) == 0) {
+		*pos = w->cur_pos;
+		return w->first_frame;
+	}
+
+	for (int i = 0; i < w->num_slots; i++) {
+		int64_t slot_pos = w->slot_pos[i];
+
+		if (slot_pos == w->cur_pos) {
+			best = i;
+			break;
+		}
+		if (slot_pos > w->shown_pos && slot_pos < w->cur_pos && (best == -1 || slot_pos > w->slot_pos[best]))
+			best = i;
+	}
+
+	if (best == -1)
+		return NULL;
+
+	*pos = w->slot_pos[best];
+	return w->slot_data + w->frame_size * best;
+}
+
+static bool gif_window_decode_next(struct gs_gif_window *w)
+{
+	gs_image_file_t *image = w->image;
+	int64_t pos = w->next_pos;
+	int frame = (int)(pos % w->frame_count);
+	int slot = -1;
+
+	pthread_mutex_lock(&w->mutex);
+
+	if (pos - w->cur_pos >= w->num_slots) {
+		pthread_mutex_unlock(&w->mutex);
+		return false;
+	}
+
+	/* every loop decodes the same way, so whole loops can be skipped */
+	if (w->cur_pos - pos >= w->frame_count) {
+		pos += (w->cur_pos - pos) / w->frame_count * w->frame_count;
+		w->next_pos = pos;
+	}
+
+	/* frame 0 is always kept already.  frames behind the animation are
+	 * still kept, they are shown while the worker is catching up */
+	if (frame != 0) {
+		for (int i = 0; i < w->num_slots; i++) {
+			if (w->slot_pos[i] < w->cur_pos && (slot == -1 || w->slot_pos[i] < w->slot_pos[slot]))
+				slot = i;
+		}
+		w->slot_pos[slot] = -1;
+	}
+
+	pthread_mutex_unlock(&w->mutex);
+
+	if (gif_decode_frame(&image->gif, frame) != GIF_OK)
+		blog(LOG_DEBUG, "Couldn't decode frame %d", frame);
+
+	if (slot != -1) {
+		uint8_t *data = w->slot_data + w->frame_size * slot;
+		memcpy(data, image->gif.frame_image, w->frame_size);
+		premultiply_frame(data, w->frame_size / 4, w->alpha_mode);
+
+		pthread_mutex_lock(&w->mutex);
+		w->slot_pos[slot] = pos;
+		pthread_mutex_unlock(&w->mutex);
+	}
+
+	w->next_pos = pos + 1;
+	return true;
+}
+
+static void *gif_window_thread(void *data)
+{
+	struct gs_gif_window *w = data;
+
+	os_set_thread_name("gif-decode");
+
+	while (os_sem_wait(w->sem) == 0) {
+		while (!os_atomic_load_bool(&w->stop) && gif_window_decode_next(w))
+			;
+
+		if (os_atomic_load_bool(&w->stop))
+			break;
+	}
+
+	return NULL;
+}
+
+/* moves the window forward to the frame being shown, wrapping to the next
+ * loop when the frame is before the current one */
+static void gif_window_seek(struct gs_gif_window *w, int frame)
+{
+	pthread_mutex_lock(&w->mutex);
+	w->cur_pos += (frame - gif_window_cur_frame(w) + w->frame_count) % w->frame_count;
+	w->cur_frame_ready = false;
+	pthread_mutex_unlock(&w->mutex);
+
+	os_sem_post(w->sem);
+}
+
+static void gif_window_destroy(struct gs_gif_window *w)
+{
+	if (!w)
+		return;
+
+	pthread_mutex_lock(&gif_memory_mutex);
+	if (da_find(gif_windows, &w, 0) != DARRAY_INVALID) {
+		da_erase_item(gif_windows, &w);
+		gif_memory_usage -= gif_window_size(w);
+	}
+	if (!gif_windows.num)
+		da_free(gif_windows);
+	pthread_mutex_unlock(&gif_memory_mutex);
+
+	if (w->thread_valid) {
+		os_atomic_set_bool(&w->stop, true);
+		os_sem_post(w->sem);
+		pthread_join(w->thread, NULL);
+	}
+
+	os_sem_destroy(w->sem);
+	pthread_mutex_destroy(&w->mutex);
+	bfree(w->slot_pos);
+	bfree(w->slot_data);
+	bfree(w->first_frame);
+	bfree(w);
+}
+
+static struct gs_gif_window *gif_window_create(gs_image_file_t *image, uint64_t limit,
+					       enum gs_image_alpha_mode alpha_mode)
+{
+	struct gs_gif_window *w = bzalloc(sizeof(*w));
+	uint64_t slots;
+
+	pthread_mutex_init_value(&w->mutex);
+	w->image = image;
+	w->alpha_mode = alpha_mode;
+	w->frame_size = (size_t)image->gif.width * image->gif.height * 4;
+	w->frame_count = (int)image->gif.frame_count;
+
+	slots = limit / w->frame_size;
+	slots = slots > 1 ? slots - 1 : 0;
+	if (slots > MAX_GIF_WINDOW_FRAMES)
+		slots = MAX_GIF_WINDOW_FRAMES;
+	if (slots > (uint64_t)w->frame_count - 1)
+		slots = (uint64_t)w->frame_count - 1;
+	if (slots < 2)
+		slots = 2;
+	w->num_slots = (int)slots;
+
+	w->slot_pos = bmalloc(sizeof(int64_t) * w->num_slots);
+	for (int i = 0; i < w->num_slots; i++)
+		w->slot_pos[i] = -1;
+
+	w->first_frame = bmalloc(w->frame_size);
+	w->slot_data = bmalloc(w->frame_size * w->num_slots);
+
+	if (gif_decode_frame(&image->gif, 0) != GIF_OK)
+		blog(LOG_DEBUG, "Couldn't decode the first frame of a %dx%d gif", image->gif.width, image->gif.height);
+
+	memcpy(w->first_frame, image->gif.frame_image, w->frame_size);
+	premultiply_frame(w->first_frame, w->frame_size / 4, alpha_mode);
+	w->next_pos = 1;
+	w->cur_frame_ready = true;
+
+	if (pthread_mutex_init(&w->mutex, NULL) != 0)
+		goto fail;
+	if (os_sem_init(&w->sem, 0) != 0)
+		goto fail;
+	if (pthread_create(&w->thread, NULL, gif_window_thread, w) != 0)
+		goto fail;
+
+	w->thread_valid = true;
+	os_sem_post(w->sem);
+
+	pthread_mutex_lock(&gif_memory_mutex);
+	da_push_back(gif_windows, &w);
+	gif_memory_usage += gif_window_size(w);
+	pthread_mutex_unlock(&gif_memory_mutex);
+	return w;
+
+fail:
+	blog(LOG_WARNING, "Failed to start the decoding thread of a %dx%d gif", image->gif.width, image->gif.height);
+	gif_window_destroy(w);
+	return NULL;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t *mem_usage,
 			      enum gs_image_alpha_mode alpha_mode)
 {
+	struct gs_gif_window *window = NULL;
 	bool is_animated_gif = true;
 	gif_result result;
-	uint64_t max_size;
+	uint64_t max_size, limit;
 	size_t size, size_read;
 	FILE *file;
 
@@ -121,18 +446,40 @@ static bool init_animated_gif(gs_image_file_t *image, const char *path, uint64_t
 	}
 
 	max_size = (uint64_t)image->gif.width * (uint64_t)image->gif.height * (uint64_t)image->gif.frame_count * 4LLU;
-
-	if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
-		blog(LOG_WARNING, "Gif '%s' overflowed maximum pointer size", path);
-		goto fail;
-	}
+	limit = gs_image_file_get_gif_memory_limit();
 
 	image->is_animated_gif = (image->gif.frame_count > 1 && result >= 0);
-	if (image->is_animated_gif) {
+	if (image->is_animated_gif && max_size > limit)
+		window = gif_window_create(image, limit, alpha_mode);
+
+	if (window) {
+		struct gs_gif_window *w = window;
+		uint64_t window_size = gif_window_size(w);
+
+		image->cx = (uint32_t)image->gif.width;
+		image->cy = (uint32_t)image->gif.height;
+		image->format = GS_RGBA;
+
+		if (mem_usage) {
+			*mem_usage += window_size;
+			*mem_usage += w->frame_size;
+			*mem_usage += size;
+		}
+
+		blog(LOG_DEBUG, "Decoding '%s' (%u frames, %.1f MiB decoded) in a window of %d frames", path,
+		     image->gif.frame_count, (double)max_size / (1024.0 * 1024.0), w->num_slots);
+
+	} else if (image->is_animated_gif) {
+		if ((uint64_t)get_full_decoded_gif_size(image) != max_size) {
+			blog(LOG_WARNING, "Gif '%s' overflowed maximum pointer size", path);
+			goto fail;
+		}
+
 		gif_decode_frame(&image->gif, 0);
 
 		image->animation_frame_cache = alloc_mem(image, mem_usage, image->gif.frame_count * sizeof(uint8_t *));
 		image->animation_frame_data = alloc_mem(image, mem_usage, get_full_decoded_gif_size(image));
+		add_gif_memory_usage(max_size);
 
 		for (unsigned int i = 0; i < image->gif.frame_count; i++) {
 			if (gif_decode_frame(&image->gif, i) != GIF_OK)
@@ -224,6 +571,10 @@ void gs_image_file_free(gs_image_file_t *image)
 	if (!image)
 		return;
 
+	gif_window_destroy(get_gif_window(image));
+	if (image->animation_frame_data)
+		remove_gif_memory_usage((uint64_t)get_full_decoded_gif_size(image));
+
 	if (image->loaded) {
 		if (image->is_animated_gif) {
 			gif_finalise(&image->gif);
@@ -264,7 +615,13 @@ void gs_image_file_init_texture(gs_image_file_t *image)
 	if (!image->loaded)
 		return;
 
-	if (image->is_animated_gif) {
+	struct gs_gif_window *window = get_gif_window(image);
+
+	if (window) {
+		image->texture = gs_texture_create(image->cx, image->cy, image->format, 1,
+						   (const uint8_t **)&window->first_frame, GS_DYNAMIC);
+
+	} else if (image->is_animated_gif) {
 		image->texture = gs_texture_create(image->cx, image->cy, image->format, 1,
 						   (const uint8_t **)&image->gif.frame_image, GS_DYNAMIC);
 
@@ -346,11 +703,14 @@ static void decode_new_frame(gs_image_file_t *image, int new_frame, enum gs_imag
 static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed_time_ns,
 					enum gs_image_alpha_mode alpha_mode)
 {
+	struct gs_gif_window *window;
 	int loops;
 
 	if (!image->is_animated_gif || !image->loaded)
 		return false;
 
+	window = get_gif_window(image);
+
 	loops = image->gif.loop_count;
 	if (loops >= 0xFFFF)
 		loops = 0;
@@ -358,12 +718,29 @@ static bool gs_image_file_tick_internal(gs_image_file_t *image, uint64_t elapsed
 	if (!loops || image->cur_loop < loops) {
 		int new_frame = calculate_new_frame(image, elapsed_time_ns, loops);
 
-		if (new_frame != image->cur_frame) {
+		if (new_frame != image->cur_frame && window) {
+			image->cur_frame = new_frame;
+			gif_window_seek(window, new_frame);
+
+		} else if (new_frame != image->cur_frame) {
 			decode_new_frame(image, new_frame, alpha_mode);
 			return true;
 		}
 	}
 
+	/* a frame the worker had not decoded yet becomes ready */
+	if (window && !window->cur_frame_ready) {
+		struct gs_gif_window *w = window;
+		int64_t pos;
+		bool updated;
+
+		pthread_mutex_lock(&w->mutex);
+		updated = gif_window_get_frame(w, &pos) != NULL;
+		pthread_mutex_unlock(&w->mutex);
+
+		return updated;
+	}
+
 	return false;
 }
 
@@ -389,9 +766,31 @@ bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns)
 
 static void gs_image_file_update_texture_internal(gs_image_file_t *image, enum gs_image_alpha_mode alpha_mode)
 {
+	struct gs_gif_window *w;
+
 	if (!image->is_animated_gif || !image->loaded)
 		return;
 
+	w = get_gif_window(image);
+	if (w) {
+		uint8_t *data;
+		int64_t pos;
+
+		/* the frame can be set directly to restart the animation */
+		if (gif_window_cur_frame(w) != image->cur_frame)
+			gif_window_seek(w, image->cur_frame);
+
+		pthread_mutex_lock(&w->mutex);
+		data = gif_window_get_frame(w, &pos);
+		if (data) {
+			gs_texture_set_image(image->texture, data, image->gif.width * 4, false);
+			w->shown_pos = pos;
+			w->cur_frame_ready = pos == w->cur_pos;
+		}
+		pthread_mutex_unlock(&w->mutex);
+		return;
+	}
+
 	if (!image->animation_frame_cache[image->cur_frame])
 		decode_new_frame(image, image->cur_frame, alpha_mode);
 
@@ -88,6 +88,10 @@ EXPORT void gs_image_file4_init(gs_image_file4_t *if4, const char *file, enum gs
 EXPORT bool gs_image_file4_tick(gs_image_file4_t *if4, uint64_t elapsed_time_ns);
 EXPORT void gs_image_file4_update_texture(gs_image_file4_t *if4);
 
+EXPORT void gs_image_file_set_gif_memory_limit(uint64_t limit);
+EXPORT uint64_t gs_image_file_get_gif_memory_limit(void);
+EXPORT uint64_t gs_image_file_get_gif_memory_usage(void);
+
 static inline void gs_image_file2_free(gs_image_file2_t *if2)
 {
 	gs_image_file_free(&if2->image);
@@ -0,0 +1,668 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <math.h>
+
+#include "util/deque.h"
+#include "util/threading.h"
+#include "obs-internal.h"
+#include "obs-bitrate-controller.h"
+
+#define MSEC_TO_NSEC 1000000ULL
+#define SEC_TO_NSEC 1000000000ULL
+
+/* how often the target bitrate is re-evaluated */
+#define UPDATE_INTERVAL_NS (100ULL * MSEC_TO_NSEC)
+/* minimum time between two decreases, so a decrease can take effect */
+#define DECREASE_INTERVAL_NS (500ULL * MSEC_TO_NSEC)
+/* time to hold the bitrate after a decrease before probing up again */
+#define HOLD_TIME_NS (2ULL * SEC_TO_NSEC)
+/* buffered media that is treated as congestion regardless of estimator */
+#define QUEUE_TRIGGER_USEC 200000
+
+#define DECREASE_FACTOR 0.85
+#define INCREASE_FACTOR_PER_SEC 1.08
+/* additive increase near the link capacity, as a fraction of it per second */
+#define ADDITIVE_INCREASE_PER_SEC 0.02
+/* range around the link capacity estimate that is considered "near" */
+#define LINK_CAPACITY_MARGIN 0.15
+#define LINK_CAPACITY_ALPHA 0.2
+#define BITRATE_STEP_KBPS 50
+
+#define CLAMP(x, min, max) ((x) < (min) ? (min) : ((x) > (max) ? (max) : (x)))
+
+struct obs_bitrate_controller {
+	pthread_mutex_t mutex;
+
+	struct obs_bitrate_estimator_info info;
+	void *estimator;
+	obs_weak_encoder_t *encoder;
+
+	uint32_t min_kbps;
+	uint32_t max_kbps;
+	uint32_t overhead_kbps;
+	uint32_t cur_kbps;
+	double target_kbps;
+
+	/* average of the bandwidth estimates at overuse, 0 if unknown */
+	double link_kbps;
+
+	int64_t buffered_usec;
+	int64_t decrease_buffered_usec;
+	uint64_t last_update;
+	uint64_t last_decrease;
+	uint64_t hold_until;
+};
+
+/* ------------------------------------------------------------------------- */
+/* Delivery rate over a sliding window of acknowledged payloads              */
+
+#define RATE_WINDOW_NS (1ULL * SEC_TO_NSEC)
+#define MIN_RATE_SPAN_NS (100ULL * MSEC_TO_NSEC)
+
+struct ack_sample {
+	uint64_t send_ts;
+	uint64_t ack_ts;
+	size_t bytes;
+};
+
+struct rate_window {
+	struct deque samples;
+	uint64_t bytes;
+};
+
+static void rate_window_push(struct rate_window *rw, uint64_t send_ts, uint64_t ack_ts, size_t bytes)
+{
+	struct ack_sample sample = {send_ts, ack_ts, bytes};
+	struct ack_sample front;
+
+	deque_push_back(&rw->samples, &sample, sizeof(sample));
+	rw->bytes += bytes;
+
+	while (rw->samples.size > sizeof(front)) {
+		deque_peek_front(&rw->samples, &front, sizeof(front));
+		if (ack_ts - front.ack_ts <= RATE_WINDOW_NS)
+			break;
+
+		deque_pop_front(&rw->samples, NULL, sizeof(front));
+		rw->bytes -= front.bytes;
+	}
+}
+
+/* returns kbps, or 0 if the window does not cover enough time yet */
+static uint32_t rate_window_kbps(const struct rate_window *rw)
+{
+	struct ack_sample front;
+	struct ack_sample back;
+
+	if (!rw->samples.size)
+		return 0;
+
+	deque_peek_front((struct deque *)&rw->samples, &front, sizeof(front));
+	deque_peek_back((struct deque *)&rw->samples, &back, sizeof(back));
+
+	uint64_t span = back.ack_ts - front.send_ts;
+	if (span < MIN_RATE_SPAN_NS)
+		return 0;
+
+	return (uint32_t)(rw->bytes * 8 * MSEC_TO_NSEC / span);
+}
+
+/* ------------------------------------------------------------------------- */
+/* BBR-like estimator: bottleneck bandwidth is the windowed maximum of the   */
+/* delivery rate, congestion is detected from RTT inflation over min RTT.    */
+
+#define BW_FILTER_BUCKETS 10
+#define MIN_RTT_WINDOW_NS (10ULL * SEC_TO_NSEC)
+#define RTT_INFLATION_NS (20ULL * MSEC_TO_NSEC)
+
+struct delivery_rate {
+	struct rate_window window;
+
+	uint32_t bucket_kbps[BW_FILTER_BUCKETS];
+	uint64_t bucket_sec[BW_FILTER_BUCKETS];
+
+	double srtt;
+	uint64_t min_rtt;
+	uint64_t min_rtt_ts;
+};
+
+static void *delivery_rate_create(void)
+{
+	return bzalloc(sizeof(struct delivery_rate));
+}
+
+static void delivery_rate_destroy(void *data)
+{
+	struct delivery_rate *dr = data;
+	deque_free(&dr->window.samples);
+	bfree(dr);
+}
+
+static void delivery_rate_on_ack(void *data, uint64_t send_ts, uint64_t ack_ts, size_t bytes)
+{
+	struct delivery_rate *dr = data;
+	uint64_t rtt = ack_ts > send_ts ? ack_ts - send_ts : 0;
+
+	rate_window_push(&dr->window, send_ts, ack_ts, bytes);
+
+	uint32_t kbps = rate_window_kbps(&dr->window);
+	uint64_t sec = ack_ts / SEC_TO_NSEC;
+	size_t idx = sec % BW_FILTER_BUCKETS;
+
+	if (dr->bucket_sec[idx] != sec) {
+		dr->bucket_sec[idx] = sec;
+		dr->bucket_kbps[idx] = 0;
+	}
+	if (kbps > dr->bucket_kbps[idx])
+		dr->bucket_kbps[idx] = kbps;
+
+	dr->srtt = dr->srtt ? dr->srtt * 0.875 + (double)rtt * 0.125 : (double)rtt;
+
+	if (!dr->min_rtt_ts || rtt <= dr->min_rtt || ack_ts - dr->min_rtt_ts > MIN_RTT_WINDOW_NS) {
+		dr->min_rtt = rtt;
+		dr->min_rtt_ts = ack_ts;
+	}
+}
+
+static void delivery_rate_get_estimate(void *data, uint64_t now, struct obs_bandwidth_estimate *estimate)
+{
+	struct delivery_rate *dr = data;
+	uint64_t sec = now / SEC_TO_NSEC;
+	uint32_t max_kbps = 0;
+
+	for (size_t i = 0; i < BW_FILTER_BUCKETS; i++) {
+		if (sec - dr->bucket_sec[i] < BW_FILTER_BUCKETS && dr->bucket_kbps[i] > max_kbps)
+			max_kbps = dr->bucket_kbps[i];
+	}
+
+	bool queueing = dr->srtt > (double)(dr->min_rtt * 2 + RTT_INFLATION_NS);
+
+	/* while a queue is building, the bottleneck is what is currently
+	 * being delivered rather than the historical maximum */
+	estimate->usage = queueing ? OBS_BANDWIDTH_OVERUSE : OBS_BANDWIDTH_NORMAL;
+	estimate->bandwidth_kbps = queueing ? rate_window_kbps(&dr->window) : max_kbps;
+}
+
+static const struct obs_bitrate_estimator_info delivery_rate_estimator = {
+	.id = "delivery_rate",
+	.create = delivery_rate_create,
+	.destroy = delivery_rate_destroy,
+	.on_ack = delivery_rate_on_ack,
+	.get_estimate = delivery_rate_get_estimate,
+};
+
+/* ------------------------------------------------------------------------- */
+/* GCC-like estimator: trendline over the accumulated one-way delay          */
+/* variation, compared against an adaptive threshold.                        */
+
+#define TRENDLINE_SAMPLES 20
+#define TRENDLINE_SMOOTHING 0.9
+#define TRENDLINE_GAIN 4.0
+#define THRESHOLD_INIT_MS 12.5
+#define THRESHOLD_MIN_MS 6.0
+#define THRESHOLD_MAX_MS 600.0
+#define THRESHOLD_K_UP 0.0087
+#define THRESHOLD_K_DOWN 0.039
+#define OVERUSE_TIME_MS 10.0
+
+struct delay_gradient {
+	struct rate_window window;
+
+	uint64_t prev_send_ts;
+	uint64_t prev_ack_ts;
+	uint64_t first_ack_ts;
+	bool have_prev;
+
+	double accumulated_ms;
+	double smoothed_ms;
+
+	double x[TRENDLINE_SAMPLES];
+	double y[TRENDLINE_SAMPLES];
+	size_t num_samples;
+	size_t total_samples;
+
+	double threshold_ms;
+	double prev_trend;
+	double overuse_ms;
+	enum obs_bandwidth_usage usage;
+};
+
+static void *delay_gradient_create(void)
+{
+	struct delay_gradient *dg = bzalloc(sizeof(struct delay_gradient));
+	dg->threshold_ms = THRESHOLD_INIT_MS;
+	return dg;
+}
+
+static void delay_gradient_destroy(void *data)
+{
+	struct delay_gradient *dg = data;
+	deque_free(&dg->window.samples);
+	bfree(dg);
+}
+
+static double trendline_slope(const struct delay_gradient *dg)
+{
+	double x_avg = 0.0;
+	double y_avg = 0.0;
+	double num = 0.0;
+	double den = 0.0;
+
+	for (size_t i = 0; i < dg->num_samples; i++) {
+		x_avg += dg->x[i];
+		y_avg += dg->y[i];
+	}
+	x_avg /= (double)dg->num_samples;
+	y_avg /= (double)dg->num_samples;
+
+	for (size_t i = 0; i < dg->num_samples; i++) {
+		num += (dg->x[i] - x_avg) * (dg->y[i] - y_avg);
+		den += (dg->x[i] - x_avg) * (dg->x[i] - x_avg);
+	}
+
+	return den != 0.0 ? num / den : 0.0;
+}
+
+static void delay_gradient_detect(struct delay_gradient *dg, double trend, double delta_ms)
+{
+	double modified = (double)(dg->total_samples < 60 ? dg->total_samples : 60) * trend * TRENDLINE_GAIN;
+
+	if (modified > dg->threshold_ms) {
+		dg->overuse_ms += delta_ms;
+		if (dg->overuse_ms > OVERUSE_TIME_MS && trend >= dg->prev_trend)
+			dg->usage = OBS_BANDWIDTH_OVERUSE;
+	} else if (modified < -dg->threshold_ms) {
+		dg->overuse_ms = 0.0;
+		dg->usage = OBS_BANDWIDTH_UNDERUSE;
+	} else {
+		dg->overuse_ms = 0.0;
+		dg->usage = OBS_BANDWIDTH_NORMAL;
+	}
+
+	dg->prev_trend = trend;
+
+	/* adapt the threshold, ignoring sudden spikes */
+	double abs_modified = fabs(modified);
+	if (abs_modified > dg->threshold_ms + 15.0)
+		return;
+
+	double k = abs_modified < dg->threshold_ms ? THRESHOLD_K_DOWN : THRESHOLD_K_UP;
+	double dt = delta_ms < 100.0 ? delta_ms : 100.0;
+	dg->threshold_ms += k * (abs_modified - dg->threshold_ms) * dt;
+	dg->threshold_ms = CLAMP(dg->threshold_ms, THRESHOLD_MIN_MS, THRESHOLD_MAX_MS);
+}
+
+static void delay_gradient_on_ack(void *data, uint64_t send_ts, uint64_t ack_ts, size_t bytes)
+{
+	struct delay_gradient *dg = data;
+
+	rate_window_push(&dg->window, send_ts, ack_ts, bytes);
+
+	if (!dg->have_prev) {
+		dg->have_prev = true;
+		dg->first_ack_ts = ack_ts;
+		dg->prev_send_ts = send_ts;
+		dg->prev_ack_ts = ack_ts;
+		return;
+	}
+
+	double ack_delta_ms = (double)(int64_t)(ack_ts - dg->prev_ack_ts) / (double)MSEC_TO_NSEC;
+	double send_delta_ms = (double)(int64_t)(send_ts - dg->prev_send_ts) / (double)MSEC_TO_NSEC;
+
+	dg->prev_send_ts = send_ts;
+	dg->prev_ack_ts = ack_ts;
+
+	dg->accumulated_ms += ack_delta_ms - send_delta_ms;
+	dg->smoothed_ms = TRENDLINE_SMOOTHING * dg->smoothed_ms + (1.0 - TRENDLINE_SMOOTHING) * dg->accumulated_ms;
+
+	if (dg->num_samples == TRENDLINE_SAMPLES) {
+		memmove(dg->x, dg->x + 1, sizeof(dg->x) - sizeof(dg->x[0]));
+		memmove(dg->y, dg->y + 1, sizeof(dg->y) - sizeof(dg->y[0]));
+		dg->num_samples--;
+	}
+
+	dg->x[dg->num_samples] = (double)(ack_ts - dg->first_ack_ts) / (double)MSEC_TO_NSEC;
+	dg->y[dg->num_samples] = dg->smoothed_ms;
+	dg->num_samples++;
+	dg->total_samples++;
+
+	if (dg->num_samples == TRENDLINE_SAMPLES)
+		delay_gradient_detect(dg, trendline_slope(dg), ack_delta_ms);
+}
+
+static void delay_gradient_get_estimate(void *data, uint64_t now, struct obs_bandwidth_estimate *estimate)
+{
+	struct delay_gradient *dg = data;
+
+	estimate->usage = dg->usage;
+	estimate->bandwidth_kbps = rate_window_kbps(&dg->window);
+
+	UNUSED_PARAMETER(now);
+}
+
+static const struct obs_bitrate_estimator_info delay_gradient_estimator = {
+	.id = "delay_gradient",
+	.create = delay_gradient_create,
+	.destroy = delay_gradient_destroy,
+	.on_ack = delay_gradient_on_ack,
+	.get_estimate = delay_gradient_get_estimate,
+};
+
+/* ------------------------------------------------------------------------- */
+
+static const struct obs_bitrate_estimator_info *builtin_estimators[] = {
+	&delivery_rate_estimator,
+	&delay_gradient_estimator,
+};
+
+#define NUM_BUILTIN_ESTIMATORS (sizeof(builtin_estimators) / sizeof(builtin_estimators[0]))
+
+static const struct obs_bitrate_estimator_info *find_estimator(const char *id)
+{
+	for (size_t i = 0; i < NUM_BUILTIN_ESTIMATORS; i++) {
+		if (strcmp(builtin_estimators[i]->id, id) == 0)
+			return builtin_estimators[i];
+	}
+
+	if (!obs)
+		return NULL;
+
+	for (size_t i = 0; i < obs->bitrate_estimator_types.num; i++) {
+		const struct obs_bitrate_estimator_info *info = obs->bitrate_estimator_types.array + i;
+		if (strcmp(info->id, id) == 0)
+			return info;
+	}
+
+	return NULL;
+}
+
+void obs_register_bitrate_estimator(const struct obs_bitrate_estimator_info *info)
+{
+	if (!obs || !info || !info->id)
+		return;
+
+	if (find_estimator(info->id)) {
+		blog(LOG_WARNING, "Bitrate estimator id '%s' already exists!  Duplicate library?", info->id);
+		return;
+	}
+
+	if (!info->create || !info->destroy || !info->on_ack || !info->get_estimate) {
+		blog(LOG_ERROR, "Bitrate estimator '%s' is missing required callbacks", info->id);
+		return;
+	}
+
+	da_push_back(obs->bitrate_estimator_types, info);
+}
+
+obs_bitrate_controller_t *obs_bitrate_controller_create(const char *estimator_id, obs_encoder_t *encoder,
+							uint32_t min_kbps, uint32_t max_kbps)
+{
+	const struct obs_bitrate_estimator_info *info;
+
+	if (!estimator_id || !*estimator_id)
+		estimator_id = delivery_rate_estimator.id;
+
+	info = find_estimator(estimator_id);
+	if (!info) {
+		blog(LOG_WARNING, "Bitrate estimator '%s' not found, using '%s'", estimator_id,
+		     delivery_rate_estimator.id);
+		info = &delivery_rate_estimator;
+	}
+
+	struct obs_bitrate_controller *controller = bzalloc(sizeof(struct obs_bitrate_controller));
+	pthread_mutex_init_value(&controller->mutex);
+	if (pthread_mutex_init(&controller->mutex, NULL) != 0) {
+		bfree(controller);
+		return NULL;
+	}
+
+	if (max_kbps < min_kbps)
+		max_kbps = min_kbps;
+
+	controller->info = *info;
+	controller->estimator = info->create();
+	controller->encoder = obs_encoder_get_weak_encoder(encoder);
+	controller->min_kbps = min_kbps;
+	controller->max_kbps = max_kbps;
+	controller->cur_kbps = max_kbps;
+	controller->target_kbps = (double)max_kbps;
+	return controller;
+}
+
+static void set_encoder_bitrate(obs_weak_encoder_t *weak, uint32_t kbps)
+{
+	obs_encoder_t *encoder = obs_weak_encoder_get_encoder(weak);
+	if (!encoder)
+		return;
+
+	obs_data_t *settings = obs_encoder_get_settings(encoder);
+	obs_data_set_int(settings, "bitrate", kbps);
+	obs_encoder_update(encoder, settings);
+
+	obs_data_release(settings);
+	obs_encoder_release(encoder);
+}
+
+void obs_bitrate_controller_destroy(obs_bitrate_controller_t *controller)
+{
+	if (!controller)
+		return;
+
+	controller->info.destroy(controller->estimator);
+	obs_weak_encoder_release(controller->encoder);
+	pthread_mutex_destroy(&controller->mutex);
+	bfree(controller);
+}
+
+void obs_bitrate_controller_set_overhead(obs_bitrate_controller_t *controller, uint32_t kbps)
+{
+	if (!controller)
+		return;
+
+	pthread_mutex_lock(&controller->mutex);
+	controller->overhead_kbps = kbps;
+	pthread_mutex_unlock(&controller->mutex);
+}
+
+void obs_bitrate_controller_on_send(obs_bitrate_controller_t *controller, uint64_t ts, size_t bytes)
+{
+	if (!controller || !controller->info.on_send)
+		return;
+
+	pthread_mutex_lock(&controller->mutex);
+	controller->info.on_send(controller->estimator, ts, bytes);
+	pthread_mutex_unlock(&controller->mutex);
+}
+
+void obs_bitrate_controller_on_ack(obs_bitrate_controller_t *controller, uint64_t send_ts, uint64_t ack_ts,
+				   size_t bytes)
+{
+	if (!controller)
+		return;
+
+	pthread_mutex_lock(&controller->mutex);
+	controller->info.on_ack(controller->estimator, send_ts, ack_ts, bytes);
+	pthread_mutex_unlock(&controller->mutex);
+}
+
+void obs_bitrate_controller_on_queue(obs_bitrate_controller_t *controller, uint64_t ts, int64_t buffered_usec)
+{
+	if (!controller)
+		return;
+
+	pthread_mutex_lock(&controller->mutex);
+	controller->buffered_usec = buffered_usec;
+	pthread_mutex_unlock(&controller->mutex);
+
+	UNUSED_PARAMETER(ts);
+}
+
+static inline uint32_t round_bitrate(double kbps)
+{
+	return (uint32_t)(kbps / BITRATE_STEP_KBPS) * BITRATE_STEP_KBPS;
+}
+
+static void update_target(struct obs_bitrate_controller *controller, uint64_t now, double dt_sec)
+{
+	struct obs_bandwidth_estimate estimate = {0};
+	controller->info.get_estimate(controller->estimator, now, &estimate);
+
+	double available = 0.0;
+	if (estimate.bandwidth_kbps)
+		available = (double)estimate.bandwidth_kbps - (double)controller->overhead_kbps;
+	if (available < 0.0)
+		available = (double)controller->min_kbps;
+
+	bool estimator_overuse = estimate.usage == OBS_BANDWIDTH_OVERUSE;
+	bool queue_overuse = controller->buffered_usec >= QUEUE_TRIGGER_USEC;
+
+	/* while the output queue drains after a decrease it stays above the
+	 * trigger for a while, so only react to it again if it keeps growing */
+	if (queue_overuse && !estimator_overuse && controller->last_decrease &&
+	    controller->buffered_usec <= controller->decrease_buffered_usec)
+		queue_overuse = false;
+
+	if (estimator_overuse || queue_overuse) {
+		if (now - controller->last_decrease < DECREASE_INTERVAL_NS)
+			return;
+
+		double target = controller->target_kbps * DECREASE_FACTOR;
+		if (available > 0.0 && available * DECREASE_FACTOR < target)
+			target = available * DECREASE_FACTOR;
+
+		double sample = available > 0.0 ? available : controller->target_kbps;
+		if (controller->link_kbps > 0.0)
+			controller->link_kbps += LINK_CAPACITY_ALPHA * (sample - controller->link_kbps);
+		else
+			controller->link_kbps = sample;
+
+		controller->target_kbps = target;
+		controller->last_decrease = now;
+		controller->decrease_buffered_usec = controller->buffered_usec;
+		controller->hold_until = now + HOLD_TIME_NS;
+
+	} else if (estimate.usage == OBS_BANDWIDTH_NORMAL && now >= controller->hold_until) {
+		/* additive increase near the capacity the link had at the last
+		 * overuse so that it isn't overshot, multiplicative otherwise */
+		double target = controller->target_kbps;
+		double link = controller->link_kbps;
+
+		if (link > 0.0 && target > link * (1.0 + LINK_CAPACITY_MARGIN))
+			controller->link_kbps = link = 0.0;
+
+		if (link > 0.0 && target > link * (1.0 - LINK_CAPACITY_MARGIN))
+			target += link * ADDITIVE_INCREASE_PER_SEC * dt_sec;
+		else
+			target *= pow(INCREASE_FACTOR_PER_SEC, dt_sec);
+
+		if (available > 0.0 && target > available * 1.5)
+			target = available * 1.5 > controller->target_kbps ? available * 1.5 : controller->target_kbps;
+
+		controller->target_kbps = target;
+		controller->decrease_buffered_usec = 0;
+	}
+
+	controller->target_kbps = CLAMP(controller->target_kbps, (double)controller->min_kbps,
+					(double)controller->max_kbps);
+}
+
+bool obs_bitrate_controller_update(obs_bitrate_controller_t *controller, uint64_t now)
+{
+	uint32_t new_kbps;
+	bool changed = false;
+
+	if (!controller)
+		return false;
+
+	pthread_mutex_lock(&controller->mutex);
+
+	if (!controller->last_update) {
+		controller->last_update = now;
+		pthread_mutex_unlock(&controller->mutex);
+		return false;
+	}
+
+	if (now - controller->last_update < UPDATE_INTERVAL_NS) {
+		pthread_mutex_unlock(&controller->mutex);
+		return false;
+	}
+
+	double dt_sec = (double)(now - controller->last_update) / (double)SEC_TO_NSEC;
+	controller->last_update = now;
+	update_target(controller, now, dt_sec < 1.0 ? dt_sec : 1.0);
+
+	/* only touch the encoder for meaningful steps */
+	new_kbps = round_bitrate(controller->target_kbps);
+	new_kbps = CLAMP(new_kbps, controller->min_kbps, controller->max_kbps);
+	if (controller->target_kbps >= (double)controller->max_kbps)
+		new_kbps = controller->max_kbps;
+
+	uint32_t diff = new_kbps > controller->cur_kbps ? new_kbps - controller->cur_kbps
+							 : controller->cur_kbps - new_kbps;
+	uint32_t min_step = controller->cur_kbps / 20 > BITRATE_STEP_KBPS ? controller->cur_kbps / 20
+									 : BITRATE_STEP_KBPS;
+
+	if (diff >= min_step || (diff && (new_kbps == controller->max_kbps || new_kbps == controller->min_kbps))) {
+		controller->cur_kbps = new_kbps;
+		changed = true;
+	}
+
+	pthread_mutex_unlock(&controller->mutex);
+
+	if (changed && controller->encoder)
+		set_encoder_bitrate(controller->encoder, new_kbps);
+
+	return changed;
+}
+
+void obs_bitrate_controller_reset(obs_bitrate_controller_t *controller)
+{
+	bool changed;
+
+	if (!controller)
+		return;
+
+	pthread_mutex_lock(&controller->mutex);
+	changed = controller->cur_kbps != controller->max_kbps;
+	controller->cur_kbps = controller->max_kbps;
+	controller->target_kbps = (double)controller->max_kbps;
+	controller->link_kbps = 0.0;
+	controller->hold_until = 0;
+	controller->last_decrease = 0;
+	controller->decrease_buffered_usec = 0;
+	pthread_mutex_unlock(&controller->mutex);
+
+	if (changed && controller->encoder)
+		set_encoder_bitrate(controller->encoder, controller->max_kbps);
+}
+
+uint32_t obs_bitrate_controller_get_bitrate(const obs_bitrate_controller_t *controller)
+{
+	return controller ? controller->cur_kbps : 0;
+}
+
+void obs_bitrate_controller_get_estimate(obs_bitrate_controller_t *controller, uint64_t now,
+					 struct obs_bandwidth_estimate *estimate)
+{
+	if (!controller || !estimate)
+		return;
+
+	pthread_mutex_lock(&controller->mutex);
+	controller->info.get_estimate(controller->estimator, now, estimate);
+	pthread_mutex_unlock(&controller->mutex);
+}
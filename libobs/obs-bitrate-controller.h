@@ -0,0 +1,132 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "obs.h"
+
+/**
+ * @file
+ * @brief Congestion-aware bitrate control for network outputs
+ *
+ * Outputs feed send and acknowledgement samples into a controller, which
+ * asks a pluggable bandwidth estimator for the available rate and smoothly
+ * adjusts the bitrate of the video encoder it is attached to.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Bandwidth usage signal reported by an estimator */
+enum obs_bandwidth_usage {
+	OBS_BANDWIDTH_NORMAL,
+	OBS_BANDWIDTH_UNDERUSE,
+	OBS_BANDWIDTH_OVERUSE,
+};
+
+struct obs_bandwidth_estimate {
+	/** Estimated available bandwidth in kbps, 0 if not known yet */
+	uint32_t bandwidth_kbps;
+	enum obs_bandwidth_usage usage;
+};
+
+struct obs_bitrate_estimator_info {
+	/** Unique string identifier */
+	const char *id;
+
+	void *(*create)(void);
+	void (*destroy)(void *data);
+
+	/**
+	 * Called for every payload handed to the network.
+	 *
+	 * @param  ts     Time the payload was queued for sending (ns)
+	 * @param  bytes  Payload size
+	 */
+	void (*on_send)(void *data, uint64_t ts, size_t bytes);
+
+	/**
+	 * Called when a payload is known to have left the sender (for
+	 * example when a blocking send completes, or on a transport-level
+	 * acknowledgement).
+	 *
+	 * @param  send_ts  Time the payload was queued for sending (ns)
+	 * @param  ack_ts   Time the payload was acknowledged (ns)
+	 * @param  bytes    Payload size
+	 */
+	void (*on_ack)(void *data, uint64_t send_ts, uint64_t ack_ts, size_t bytes);
+
+	void (*get_estimate)(void *data, uint64_t now, struct obs_bandwidth_estimate *estimate);
+};
+
+/**
+ * Registers a bandwidth estimator.  The built-in "delivery_rate" (BBR-like,
+ * windowed maximum delivery rate with RTT inflation detection) and
+ * "delay_gradient" (GCC-like trendline of one-way delay variation)
+ * estimators are always available.
+ */
+EXPORT void obs_register_bitrate_estimator(const struct obs_bitrate_estimator_info *info);
+
+/**
+ * Creates a bitrate controller driving the "bitrate" setting of a video
+ * encoder.
+ *
+ * @param  estimator_id  Estimator to use, NULL for the default
+ * @param  encoder       Encoder to update, or NULL to only compute bitrates
+ *                       (see obs_bitrate_controller_get_bitrate)
+ * @param  min_kbps      Lowest bitrate the controller may select
+ * @param  max_kbps      Highest bitrate the controller may select, which is
+ *                       also the initial bitrate
+ */
+EXPORT obs_bitrate_controller_t *obs_bitrate_controller_create(const char *estimator_id, obs_encoder_t *encoder,
+							       uint32_t min_kbps, uint32_t max_kbps);
+EXPORT void obs_bitrate_controller_destroy(obs_bitrate_controller_t *controller);
+
+/** Bitrate of other streams sharing the link (audio, etc), in kbps */
+EXPORT void obs_bitrate_controller_set_overhead(obs_bitrate_controller_t *controller, uint32_t kbps);
+
+EXPORT void obs_bitrate_controller_on_send(obs_bitrate_controller_t *controller, uint64_t ts, size_t bytes);
+EXPORT void obs_bitrate_controller_on_ack(obs_bitrate_controller_t *controller, uint64_t send_ts, uint64_t ack_ts,
+					  size_t bytes);
+
+/**
+ * Reports how much media (in microseconds) is buffered in the output waiting
+ * to be sent.  Values above the queue threshold are treated as overuse
+ * regardless of the estimator.
+ */
+EXPORT void obs_bitrate_controller_on_queue(obs_bitrate_controller_t *controller, uint64_t ts,
+					    int64_t buffered_usec);
+
+/**
+ * Re-evaluates the target bitrate and updates the encoder if it changed.
+ * Should be called regularly (for example for every sent packet).
+ *
+ * @return  true if the bitrate was changed
+ */
+EXPORT bool obs_bitrate_controller_update(obs_bitrate_controller_t *controller, uint64_t now);
+
+/** Restores the maximum bitrate on the encoder (for example on stop) */
+EXPORT void obs_bitrate_controller_reset(obs_bitrate_controller_t *controller);
+
+EXPORT uint32_t obs_bitrate_controller_get_bitrate(const obs_bitrate_controller_t *controller);
+EXPORT void obs_bitrate_controller_get_estimate(obs_bitrate_controller_t *controller, uint64_t now,
+						struct obs_bandwidth_estimate *estimate);
+
+#ifdef __cplusplus
+}
+#endif
@@ -19,6 +19,7 @@
 #include "util/threading.h"
 #include "util/dstr.h"
 #include "util/darray.h"
+#include "util/fnv1a.h"
 #include "util/platform.h"
 #include "util/uthash.h"
 #include "graphics/vec2.h"
@@ -27,7 +28,9 @@
 #include "graphics/quat.h"
 #include "obs-data.h"
 
-#include <jansson.h>
+#include <errno.h>
+#include <locale.h>
+#include <math.h>
 
 struct obs_data_item {
 	volatile long ref;
@@ -439,148 +442,902 @@ static inline void obs_data_item_set_autoselect_data(struct obs_data_item **p_it
 }
 
 /* ------------------------------------------------------------------------- */
+/* JSON reading and writing
+ *
+ * Text is parsed straight into obs_data and written straight from it,
+ * without building an intermediate jansson tree.  Both directions match the
+ * behavior of jansson (json_loads with JSON_REJECT_DUPLICATES, json_dumps
+ * with JSON_PRESERVE_ORDER and either JSON_COMPACT or JSON_INDENT(4)), which
+ * was used before, so existing files are read and written byte for byte the
+ * same. */
+
+#define JSON_MAX_DEPTH 2048
+
+/* returns the size of the UTF-8 sequence at str, or 0 if it is invalid
+ * (overlong, surrogate or out of range code points) */
+static size_t json_utf8_size(const unsigned char *str)
+{
+	unsigned char c = str[0];
+	uint32_t val;
+	size_t size;
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key, json_t *json);
+	if (c < 0x80)
+		return 1;
+	else if (c >= 0xC2 && c <= 0xDF)
+		size = 2, val = c & 0x1F;
+	else if (c >= 0xE0 && c <= 0xEF)
+		size = 3, val = c & 0x0F;
+	else if (c >= 0xF0 && c <= 0xF4)
+		size = 4, val = c & 0x07;
+	else
+		return 0;
+
+	for (size_t i = 1; i < size; i++) {
+		if ((str[i] & 0xC0) != 0x80)
+			return 0;
+		val = (val << 6) | (str[i] & 0x3F);
+	}
 
-static inline void obs_data_add_json_object_data(obs_data_t *data, json_t *jobj)
+	if (val > 0x10FFFF || (val >= 0xD800 && val <= 0xDFFF))
+		return 0;
+	if ((size == 3 && val < 0x800) || (size == 4 && val < 0x10000))
+		return 0;
+
+	return size;
+}
+
+static bool json_utf8_valid(const char *str)
 {
-	const char *item_key;
-	json_t *jitem;
+	const unsigned char *pos = (const unsigned char *)str;
 
-	json_object_foreach (jobj, item_key, jitem) {
-		obs_data_add_json_item(data, item_key, jitem);
+	while (*pos) {
+		size_t size = json_utf8_size(pos);
+		if (!size)
+			return false;
+		pos += size;
 	}
+
+	return true;
 }
 
-static inline void obs_data_add_json_object(obs_data_t *data, const char *key, json_t *jobj)
+/* per nesting depth, reused by sibling objects */
+struct json_level {
+	struct dstr key;
+
+	/* keys with null values are not stored in obs_data, but still have
+	 * to be checked for duplicates */
+	DARRAY(char) null_keys;
+};
+
+struct json_reader {
+	const char *pos;
+	int line;
+	int depth;
+	char decimal_point;
+
+	DARRAY(struct json_level) levels;
+	struct dstr str;
+	struct dstr num;
+
+	char error[128];
+};
+
+static void json_reader_free(struct json_reader *r)
+{
+	for (size_t i = 0; i < r->levels.num; i++) {
+		dstr_free(&r->levels.array[i].key);
+		da_free(r->levels.array[i].null_keys);
+	}
+	da_free(r->levels);
+	dstr_free(&r->str);
+	dstr_free(&r->num);
+}
+
+static bool json_error(struct json_reader *r, const char *format, ...)
 {
-	obs_data_t *sub_obj = obs_data_create();
+	va_list args;
+
+	va_start(args, format);
+	vsnprintf(r->error, sizeof(r->error), format, args);
+	va_end(args);
+	return false;
+}
 
-	obs_data_add_json_object_data(sub_obj, jobj);
-	obs_data_set_obj(data, key, sub_obj);
-	obs_data_release(sub_obj);
+static inline const char *json_str(const struct dstr *str)
+{
+	return str->len ? str->array : "";
 }
 
-static void obs_data_add_json_array(obs_data_t *data, const char *key, json_t *jarray)
+static inline void json_skip_whitespace(struct json_reader *r)
 {
-	obs_data_array_t *array = obs_data_array_create();
-	size_t idx;
-	json_t *jitem;
+	for (;; r->pos++) {
+		char c = *r->pos;
+
+		if (c == '\n')
+			r->line++;
+		else if (c != ' ' && c != '\t' && c != '\r')
+			break;
+	}
+}
 
-	json_array_foreach (jarray, idx, jitem) {
-		obs_data_t *item;
+static int json_read_hex4(const char *pos)
+{
+	int val = 0;
 
-		if (!json_is_object(jitem))
-			continue;
+	for (size_t i = 0; i < 4; i++) {
+		char c = pos[i];
 
-		item = obs_data_create();
-		obs_data_add_json_object_data(item, jitem);
-		obs_data_array_push_back(array, item);
-		obs_data_release(item);
+		val <<= 4;
+		if (c >= '0' && c <= '9')
+			val |= c - '0';
+		else if (c >= 'a' && c <= 'f')
+			val |= c - 'a' + 10;
+		else if (c >= 'A' && c <= 'F')
+			val |= c - 'A' + 10;
+		else
+			return -1;
 	}
 
-	obs_data_set_array(data, key, array);
-	obs_data_array_release(array);
+	return val;
 }
 
-static void obs_data_add_json_item(obs_data_t *data, const char *key, json_t *json)
+static void json_cat_code_point(struct dstr *out, uint32_t cp)
 {
-	if (json_is_object(json))
-		obs_data_add_json_object(data, key, json);
-	else if (json_is_array(json))
-		obs_data_add_json_array(data, key, json);
-	else if (json_is_string(json))
-		obs_data_set_string(data, key, json_string_value(json));
-	else if (json_is_integer(json))
-		obs_data_set_int(data, key, json_integer_value(json));
-	else if (json_is_real(json))
-		obs_data_set_double(data, key, json_real_value(json));
-	else if (json_is_true(json))
-		obs_data_set_bool(data, key, true);
-	else if (json_is_false(json))
-		obs_data_set_bool(data, key, false);
+	char buf[4];
+	size_t size;
+
+	if (cp < 0x80) {
+		buf[0] = (char)cp;
+		size = 1;
+	} else if (cp < 0x800) {
+		buf[0] = (char)(0xC0 | (cp >> 6));
+		buf[1] = (char)(0x80 | (cp & 0x3F));
+		size = 2;
+	} else if (cp < 0x10000) {
+		buf[0] = (char)(0xE0 | (cp >> 12));
+		buf[1] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		buf[2] = (char)(0x80 | (cp & 0x3F));
+		size = 3;
+	} else {
+		buf[0] = (char)(0xF0 | (cp >> 18));
+		buf[1] = (char)(0x80 | ((cp >> 12) & 0x3F));
+		buf[2] = (char)(0x80 | ((cp >> 6) & 0x3F));
+		buf[3] = (char)(0x80 | (cp & 0x3F));
+		size = 4;
+	}
+
+	dstr_ncat(out, buf, size);
+}
+
+/* decodes the escape sequence at pos, returns the position after it */
+static const char *json_read_escape(struct json_reader *r, const char *pos, struct dstr *out)
+{
+	char c = 0;
+
+	switch (pos[1]) {
+	case '"':
+	case '\\':
+	case '/':
+		c = pos[1];
+		break;
+	case 'b':
+		c = '\b';
+		break;
+	case 'f':
+		c = '\f';
+		break;
+	case 'n':
+		c = '\n';
+		break;
+	case 'r':
+		c = '\r';
+		break;
+	case 't':
+		c = '\t';
+		break;
+	case 'u': {
+		int cp = json_read_hex4(pos + 2);
+		if (cp < 0)
+			break;
+
+		pos += 6;
+
+		if (cp >= 0xD800 && cp <= 0xDBFF) {
+			int low = (pos[0] == '\\' && pos[1] == 'u') ? json_read_hex4(pos + 2) : -1;
+			if (low < 0xDC00 || low > 0xDFFF) {
+				json_error(r, "invalid Unicode '\\u%04X'", cp);
+				return NULL;
+			}
+
+			cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+			pos += 6;
+
+		} else if (cp >= 0xDC00 && cp <= 0xDFFF) {
+			json_error(r, "invalid Unicode '\\u%04X'", cp);
+			return NULL;
+
+		} else if (cp == 0) {
+			json_error(r, "\\u0000 is not allowed");
+			return NULL;
+		}
+
+		json_cat_code_point(out, (uint32_t)cp);
+		return pos;
+	}
+	default:
+		break;
+	}
+
+	if (c) {
+		dstr_ncat(out, &c, 1);
+		return pos + 2;
+	}
+
+	json_error(r, "invalid escape");
+	return NULL;
 }
 
-/* ------------------------------------------------------------------------- */
+/* reads the string at r->pos (opening quote) into out */
+static bool json_read_string(struct json_reader *r, struct dstr *out)
+{
+	const char *pos = r->pos + 1;
+	const char *start = pos;
+
+	out->len = 0;
+
+	for (;;) {
+		unsigned char c = (unsigned char)*pos;
+
+		if (c >= 0x20 && c < 0x80 && c != '"' && c != '\\') {
+			pos++;
+			continue;
+		}
+
+		if (c >= 0x80) {
+			size_t size = json_utf8_size((const unsigned char *)pos);
+			if (!size)
+				return json_error(r, "invalid UTF-8 in string");
+			pos += size;
+			continue;
+		}
+
+		if (pos > start)
+			dstr_ncat(out, start, pos - start);
 
-static inline void set_json_string(json_t *json, const char *name, obs_data_item_t *item)
+		if (c == '"')
+			break;
+		if (!c)
+			return json_error(r, "premature end of input");
+		if (c != '\\')
+			return json_error(r, "control character 0x%x in string", c);
+
+		pos = json_read_escape(r, pos, out);
+		if (!pos)
+			return false;
+		start = pos;
+	}
+
+	r->pos = pos + 1;
+	return true;
+}
+
+static inline bool json_is_digit(char c)
 {
-	const char *val = obs_data_item_get_string(item);
-	json_object_set_new(json, name, json_string(val));
+	return c >= '0' && c <= '9';
 }
 
-static inline void set_json_number(json_t *json, const char *name, obs_data_item_t *item)
+/* integers are kept as integers and reals as doubles, like jansson did */
+static bool json_read_number(struct json_reader *r, obs_data_t *data, const char *key)
 {
-	enum obs_data_number_type type = obs_data_item_numtype(item);
+	const char *pos = r->pos;
+	bool real = false;
+
+	if (*pos == '-')
+		pos++;
+
+	if (*pos == '0') {
+		pos++;
+	} else if (json_is_digit(*pos)) {
+		while (json_is_digit(*pos))
+			pos++;
+	} else {
+		return json_error(r, "invalid token");
+	}
+
+	if (*pos == '.') {
+		real = true;
+		if (!json_is_digit(*++pos))
+			return json_error(r, "invalid token");
+		while (json_is_digit(*pos))
+			pos++;
+	}
+
+	if (*pos == 'e' || *pos == 'E') {
+		real = true;
+		pos++;
+		if (*pos == '+' || *pos == '-')
+			pos++;
+		if (!json_is_digit(*pos))
+			return json_error(r, "invalid token");
+		while (json_is_digit(*pos))
+			pos++;
+	}
+
+	errno = 0;
+
+	if (!real) {
+		long long val = strtoll(r->pos, NULL, 10);
+		if (errno == ERANGE)
+			return json_error(r, val < 0 ? "too big negative integer" : "too big integer");
+
+		if (data)
+			obs_data_set_int(data, key, val);
 
-	if (type == OBS_DATA_NUM_INT) {
-		long long val = obs_data_item_get_int(item);
-		json_object_set_new(json, name, json_integer(val));
 	} else {
-		double val = obs_data_item_get_double(item);
-		json_object_set_new(json, name, json_real(val));
+		const char *str = r->pos;
+		double val;
+
+		if (!r->decimal_point)
+			r->decimal_point = *localeconv()->decimal_point;
+
+		/* strtod is locale dependent */
+		if (r->decimal_point != '.') {
+			char *point;
+
+			r->num.len = 0;
+			dstr_ncat(&r->num, r->pos, pos - r->pos);
+			point = strchr(r->num.array, '.');
+			if (point)
+				*point = r->decimal_point;
+			str = r->num.array;
+		}
+
+		val = strtod(str, NULL);
+		if ((val == HUGE_VAL || val == -HUGE_VAL) && errno == ERANGE)
+			return json_error(r, "real number overflow");
+
+		if (data)
+			obs_data_set_double(data, key, val);
 	}
+
+	r->pos = pos;
+	return true;
 }
 
-static inline void set_json_bool(json_t *json, const char *name, obs_data_item_t *item)
+static bool json_read_literal(struct json_reader *r, const char *literal, size_t len)
 {
-	bool val = obs_data_item_get_bool(item);
-	json_object_set_new(json, name, val ? json_true() : json_false());
+	if (strncmp(r->pos, literal, len) != 0)
+		return json_error(r, "invalid token");
+
+	r->pos += len;
+	return true;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults);
+static bool json_read_object(struct json_reader *r, obs_data_t *data);
+static bool json_read_array(struct json_reader *r, obs_data_array_t *array);
 
-static inline void set_json_obj(json_t *json, const char *name, obs_data_item_t *item, bool with_defaults)
+/* reads the value at r->pos and sets it as key of data, data is NULL for
+ * values that are validated but not kept (arrays only keep objects) */
+static bool json_read_value(struct json_reader *r, obs_data_t *data, const char *key)
 {
-	obs_data_t *obj = obs_data_item_get_obj(item);
-	json_object_set_new(json, name, obs_data_to_json(obj, with_defaults));
-	obs_data_release(obj);
+	switch (*r->pos) {
+	case '{': {
+		obs_data_t *obj = obs_data_create();
+		bool success = json_read_object(r, obj);
+
+		if (success && data)
+			obs_data_set_obj(data, key, obj);
+		obs_data_release(obj);
+		return success;
+	}
+	case '[': {
+		obs_data_array_t *array = data ? obs_data_array_create() : NULL;
+		bool success = json_read_array(r, array);
+
+		if (success && data)
+			obs_data_set_array(data, key, array);
+		obs_data_array_release(array);
+		return success;
+	}
+	case '"':
+		if (!json_read_string(r, &r->str))
+			return false;
+		if (data)
+			obs_data_set_string(data, key, json_str(&r->str));
+		return true;
+	case 't':
+		if (!json_read_literal(r, "true", 4))
+			return false;
+		if (data)
+			obs_data_set_bool(data, key, true);
+		return true;
+	case 'f':
+		if (!json_read_literal(r, "false", 5))
+			return false;
+		if (data)
+			obs_data_set_bool(data, key, false);
+		return true;
+	case 'n':
+		return json_read_literal(r, "null", 4);
+	default:
+		return json_read_number(r, data, key);
+	}
 }
 
-static inline void set_json_array(json_t *json, const char *name, obs_data_item_t *item, bool with_defaults)
+static bool json_null_key_exists(struct json_level *level, const char *name)
 {
-	json_t *jarray = json_array();
-	obs_data_array_t *array = obs_data_item_get_array(item);
-	size_t count = obs_data_array_count(array);
+	size_t pos = 0;
 
-	for (size_t idx = 0; idx < count; idx++) {
-		obs_data_t *sub_item = obs_data_array_item(array, idx);
-		json_t *jitem = obs_data_to_json(sub_item, with_defaults);
-		json_array_append_new(jarray, jitem);
-		obs_data_release(sub_item);
+	while (pos < level->null_keys.num) {
+		const char *key = level->null_keys.array + pos;
+		if (strcmp(key, name) == 0)
+			return true;
+		pos += strlen(key) + 1;
 	}
 
-	json_object_set_new(json, name, jarray);
-	obs_data_array_release(array);
+	return false;
 }
 
-static json_t *obs_data_to_json(obs_data_t *data, bool with_defaults)
+static bool json_read_object(struct json_reader *r, obs_data_t *data)
 {
-	json_t *json = json_object();
+	if (++r->depth > JSON_MAX_DEPTH)
+		return json_error(r, "maximum parsing depth reached");
+	while (r->levels.num < (size_t)r->depth)
+		da_push_back_new(r->levels);
 
-	obs_data_item_t *item = NULL;
-	obs_data_item_t *temp = NULL;
+	r->levels.array[r->depth - 1].null_keys.num = 0;
 
-	HASH_ITER (hh, data->items, item, temp) {
-		enum obs_data_type type = obs_data_item_gettype(item);
-		const char *name = get_item_name(item);
+	r->pos++;
+	json_skip_whitespace(r);
+
+	if (*r->pos != '}') {
+		for (;;) {
+			/* deeper objects never touch the key buffer of this
+			 * level, so the key stays valid while reading the
+			 * value (the level itself may move though) */
+			struct json_level *level = &r->levels.array[r->depth - 1];
+			const char *name;
+
+			if (*r->pos != '"')
+				return json_error(r, "string or '}' expected");
+			if (!json_read_string(r, &level->key))
+				return false;
+
+			name = json_str(&level->key);
+			if (obs_data_has_user_value(data, name) || json_null_key_exists(level, name))
+				return json_error(r, "duplicate object key");
+
+			json_skip_whitespace(r);
+			if (*r->pos != ':')
+				return json_error(r, "':' expected");
+			r->pos++;
+			json_skip_whitespace(r);
+
+			if (*r->pos == 'n')
+				da_push_back_array(level->null_keys, name, strlen(name) + 1);
+
+			if (!json_read_value(r, data, name))
+				return false;
+
+			json_skip_whitespace(r);
+			if (*r->pos == '}')
+				break;
+			if (*r->pos != ',')
+				return json_error(r, "'}' expected");
+			r->pos++;
+			json_skip_whitespace(r);
+		}
+	}
+
+	r->pos++;
+	r->depth--;
+	return true;
+}
+
+static bool json_read_array(struct json_reader *r, obs_data_array_t *array)
+{
+	if (++r->depth > JSON_MAX_DEPTH)
+		return json_error(r, "maximum parsing depth reached");
+
+	r->pos++;
+	json_skip_whitespace(r);
+
+	if (*r->pos != ']') {
+		for (;;) {
+			if (*r->pos == '{') {
+				obs_data_t *item = obs_data_create();
+				bool success = json_read_object(r, item);
+
+				if (success && array)
+					obs_data_array_push_back(array, item);
+				obs_data_release(item);
+				if (!success)
+					return false;
+
+			} else if (!json_read_value(r, NULL, NULL)) {
+				return false;
+			}
+
+			json_skip_whitespace(r);
+			if (*r->pos == ']')
+				break;
+			if (*r->pos != ',')
+				return json_error(r, "']' expected");
+			r->pos++;
+			json_skip_whitespace(r);
+		}
+	}
+
+	r->pos++;
+	r->depth--;
+	return true;
+}
 
-		if (!with_defaults && !obs_data_item_has_user_value(item))
+static bool json_read(struct json_reader *r, obs_data_t *data)
+{
+	if (!r->pos)
+		return json_error(r, "wrong arguments");
+
+	json_skip_whitespace(r);
+
+	/* like before, a top level array is accepted but results in empty
+	 * data */
+	if (*r->pos == '{') {
+		if (!json_read_object(r, data))
+			return false;
+	} else if (*r->pos == '[') {
+		if (!json_read_array(r, NULL))
+			return false;
+	} else {
+		return json_error(r, "'[' or '{' expected");
+	}
+
+	json_skip_whitespace(r);
+	if (*r->pos)
+		return json_error(r, "end of file expected");
+
+	return true;
+}
+
+struct json_writer {
+	struct dstr out;
+	bool pretty;
+	bool with_defaults;
+	char decimal_point;
+};
+
+static void json_write_indent(struct json_writer *w, size_t depth)
+{
+	size_t spaces = depth * 4;
+
+	if (!w->pretty)
+		return;
+
+	dstr_ensure_capacity(&w->out, w->out.len + spaces + 2);
+	w->out.array[w->out.len++] = '\n';
+	memset(w->out.array + w->out.len, ' ', spaces);
+	w->out.len += spaces;
+	w->out.array[w->out.len] = 0;
+}
+
+static void json_write_string(struct json_writer *w, const char *str)
+{
+	const char *start = str;
+
+	dstr_cat_ch(&w->out, '"');
+
+	for (;; str++) {
+		unsigned char c = (unsigned char)*str;
+		char escape[8];
+
+		if (c >= 0x20 && c != '"' && c != '\\')
 			continue;
 
-		if (type == OBS_DATA_STRING)
-			set_json_string(json, name, item);
-		else if (type == OBS_DATA_NUMBER)
-			set_json_number(json, name, item);
-		else if (type == OBS_DATA_BOOLEAN)
-			set_json_bool(json, name, item);
-		else if (type == OBS_DATA_OBJECT)
-			set_json_obj(json, name, item, with_defaults);
-		else if (type == OBS_DATA_ARRAY)
-			set_json_array(json, name, item, with_defaults);
+		if (str > start)
+			dstr_ncat(&w->out, start, str - start);
+		if (!c)
+			break;
+
+		switch (c) {
+		case '"':
+			dstr_cat(&w->out, "\\\"");
+			break;
+		case '\\':
+			dstr_cat(&w->out, "\\\\");
+			break;
+		case '\b':
+			dstr_cat(&w->out, "\\b");
+			break;
+		case '\f':
+			dstr_cat(&w->out, "\\f");
+			break;
+		case '\n':
+			dstr_cat(&w->out, "\\n");
+			break;
+		case '\r':
+			dstr_cat(&w->out, "\\r");
+			break;
+		case '\t':
+			dstr_cat(&w->out, "\\t");
+			break;
+		default:
+			snprintf(escape, sizeof(escape), "\\u%04X", c);
+			dstr_cat(&w->out, escape);
+		}
+
+		start = str + 1;
 	}
 
-	return json;
+	dstr_cat_ch(&w->out, '"');
+}
+
+static void json_write_int(struct json_writer *w, long long val)
+{
+	char buf[32];
+	int len = snprintf(buf, sizeof(buf), "%lld", val);
+	dstr_ncat(&w->out, buf, (size_t)len);
+}
+
+/* shortest form that reads back exactly, always with a '.' or exponent so
+ * that it reads back as a real, same as jansson */
+static void json_write_real(struct json_writer *w, double val)
+{
+	char buf[40];
+	size_t len = (size_t)snprintf(buf, sizeof(buf), "%.17g", val);
+	char *exp;
+
+	if (!w->decimal_point)
+		w->decimal_point = *localeconv()->decimal_point;
+	if (w->decimal_point != '.') {
+		char *point = strchr(buf, w->decimal_point);
+		if (point)
+			*point = '.';
+	}
+
+	if (!strchr(buf, '.') && !strchr(buf, 'e')) {
+		memcpy(buf + len, ".0", 3);
+		len += 2;
+	}
+
+	/* remove '+' and leading zeros from the exponent */
+	exp = strchr(buf, 'e');
+	if (exp) {
+		char *start = exp + 1;
+		char *end = start + 1;
+
+		if (*start == '-')
+			start++;
+		while (*end == '0')
+			end++;
+
+		if (end != start) {
+			memmove(start, end, len - (size_t)(end - buf) + 1);
+			len -= (size_t)(end - start);
+		}
+	}
+
+	dstr_ncat(&w->out, buf, len);
+}
+
+/* items jansson could not represent were left out */
+static bool json_item_writable(obs_data_item_t *item, const char *name)
+{
+	switch (item->type) {
+	case OBS_DATA_STRING: {
+		const char *val = obs_data_item_get_string(item);
+		if (!val || !json_utf8_valid(val))
+			return false;
+		break;
+	}
+	case OBS_DATA_NUMBER:
+		if (obs_data_item_numtype(item) != OBS_DATA_NUM_INT && !isfinite(obs_data_item_get_double(item)))
+			return false;
+		break;
+	case OBS_DATA_BOOLEAN:
+	case OBS_DATA_OBJECT:
+	case OBS_DATA_ARRAY:
+		break;
+	default:
+		return false;
+	}
+
+	return json_utf8_valid(name);
+}
+
+static void json_write_obj(struct json_writer *w, obs_data_t *data, size_t depth);
+
+static void json_write_array(struct json_writer *w, obs_data_array_t *array, size_t depth)
+{
+	size_t count = array ? array->objects.num : 0;
+
+	dstr_cat_ch(&w->out, '[');
+
+	for (size_t i = 0; i < count; i++) {
+		if (i)
+			dstr_cat_ch(&w->out, ',');
+		json_write_indent(w, depth + 1);
+		json_write_obj(w, array->objects.array[i], depth + 1);
+	}
+
+	if (count)
+		json_write_indent(w, depth);
+	dstr_cat_ch(&w->out, ']');
+}
+
+static void json_write_item(struct json_writer *w, obs_data_item_t *item, size_t depth)
+{
+	switch (item->type) {
+	case OBS_DATA_STRING:
+		json_write_string(w, obs_data_item_get_string(item));
+		break;
+	case OBS_DATA_NUMBER:
+		if (obs_data_item_numtype(item) == OBS_DATA_NUM_INT)
+			json_write_int(w, obs_data_item_get_int(item));
+		else
+			json_write_real(w, obs_data_item_get_double(item));
+		break;
+	case OBS_DATA_BOOLEAN:
+		dstr_cat(&w->out, obs_data_item_get_bool(item) ? "true" : "false");
+		break;
+	case OBS_DATA_OBJECT: {
+		obs_data_t *obj = obs_data_item_get_obj(item);
+		json_write_obj(w, obj, depth);
+		obs_data_release(obj);
+		break;
+	}
+	case OBS_DATA_ARRAY: {
+		obs_data_array_t *array = obs_data_item_get_array(item);
+		json_write_array(w, array, depth);
+		obs_data_array_release(array);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void json_write_obj(struct json_writer *w, obs_data_t *data, size_t depth)
+{
+	struct obs_data_item *item, *temp;
+	bool empty = true;
+
+	dstr_cat_ch(&w->out, '{');
+
+	if (data) {
+		HASH_ITER (hh, data->items, item, temp) {
+			const char *name = get_item_name(item);
+
+			if (!w->with_defaults && !obs_data_item_has_user_value(item))
+				continue;
+			if (!json_item_writable(item, name))
+				continue;
+
+			if (!empty)
+				dstr_cat_ch(&w->out, ',');
+			json_write_indent(w, depth + 1);
+			empty = false;
+
+			json_write_string(w, name);
+			dstr_cat(&w->out, w->pretty ? ": " : ":");
+			json_write_item(w, item, depth + 1);
+		}
+	}
+
+	if (!empty)
+		json_write_indent(w, depth);
+	dstr_cat_ch(&w->out, '}');
+}
+
+/* ------------------------------------------------------------------------- */
+/* Hashing */
+
+/* Hashes the user values like the JSON writer writes them.  Every object,
+ * item and array element is delimited, so data with a different structure
+ * does not produce the same bytes. */
+
+static inline void hash_bytes(uint64_t *hash, const void *data, size_t size)
+{
+	*hash = fnv1a_64(*hash, data, size);
+}
+
+static inline void hash_tag(uint64_t *hash, char tag)
+{
+	hash_bytes(hash, &tag, 1);
+}
+
+static void hash_obj(uint64_t *hash, obs_data_t *data);
+
+static void hash_array(uint64_t *hash, obs_data_array_t *array)
+{
+	size_t count = array ? array->objects.num : 0;
+
+	hash_tag(hash, '[');
+	hash_bytes(hash, &count, sizeof(count));
+
+	for (size_t i = 0; i < count; i++) {
+		hash_tag(hash, ',');
+		hash_obj(hash, array->objects.array[i]);
+	}
+
+	hash_tag(hash, ']');
+}
+
+static void hash_item(uint64_t *hash, obs_data_item_t *item)
+{
+	switch (item->type) {
+	case OBS_DATA_STRING: {
+		const char *val = obs_data_item_get_string(item);
+		if (!val)
+			val = "";
+		hash_bytes(hash, val, strlen(val) + 1);
+		break;
+	}
+	case OBS_DATA_NUMBER: {
+		enum obs_data_number_type type = obs_data_item_numtype(item);
+		hash_bytes(hash, &type, sizeof(type));
+
+		if (type == OBS_DATA_NUM_INT) {
+			long long val = obs_data_item_get_int(item);
+			hash_bytes(hash, &val, sizeof(val));
+		} else {
+			double val = obs_data_item_get_double(item);
+			hash_bytes(hash, &val, sizeof(val));
+		}
+		break;
+	}
+	case OBS_DATA_BOOLEAN: {
+		bool val = obs_data_item_get_bool(item);
+		hash_bytes(hash, &val, sizeof(val));
+		break;
+	}
+	case OBS_DATA_OBJECT: {
+		obs_data_t *obj = obs_data_item_get_obj(item);
+		hash_obj(hash, obj);
+		obs_data_release(obj);
+		break;
+	}
+	case OBS_DATA_ARRAY: {
+		obs_data_array_t *array = obs_data_item_get_array(item);
+		hash_array(hash, array);
+		obs_data_array_release(array);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static void hash_obj(uint64_t *hash, obs_data_t *data)
+{
+	struct obs_data_item *item, *temp;
+	size_t count = 0;
+
+	hash_tag(hash, '{');
+
+	if (data) {
+		HASH_ITER (hh, data->items, item, temp) {
+			const char *name = get_item_name(item);
+
+			if (!obs_data_item_has_user_value(item))
+				continue;
+
+			hash_tag(hash, ':');
+			hash_bytes(hash, name, strlen(name) + 1);
+			hash_bytes(hash, &item->type, sizeof(item->type));
+			hash_item(hash, item);
+			count++;
+		}
+	}
+
+	hash_tag(hash, '}');
+	hash_bytes(hash, &count, sizeof(count));
+}
+
+uint64_t obs_data_get_hash(obs_data_t *data)
+{
+	uint64_t hash = FNV1A_64_INIT;
+	hash_obj(&hash, data);
+	return hash;
 }
 
 /* ------------------------------------------------------------------------- */
@@ -596,22 +1353,18 @@ obs_data_t *obs_data_create()
 obs_data_t *obs_data_create_from_json(const char *json_string)
 {
 	obs_data_t *data = obs_data_create();
+	struct json_reader reader = {.pos = json_string, .line = 1};
 
-	json_error_t error;
-	json_t *root = json_loads(json_string, JSON_REJECT_DUPLICATES, &error);
-
-	if (root) {
-		obs_data_add_json_object_data(data, root);
-		json_decref(root);
-	} else {
+	if (!json_read(&reader, data)) {
 		blog(LOG_ERROR,
 		     "obs-data.c: [obs_data_create_from_json] "
 		     "Failed reading json string (%d): %s",
-		     error.line, error.text);
+		     reader.line, reader.error);
 		obs_data_release(data);
 		data = NULL;
 	}
 
+	json_reader_free(&reader);
 	return data;
 }
 
@@ -672,8 +1425,7 @@ static inline void obs_data_destroy(struct obs_data *data)
 		obs_data_item_release(&item);
 	}
 
-	/* NOTE: don't use bfree for json text, allocated by json */
-	free(data->json);
+	bfree(data->json);
 	bfree(data);
 }
 
@@ -691,21 +1443,12 @@ static const char *obs_data_get_json_internal(obs_data_t *data, bool pretty, boo
 	if (!data)
 		return NULL;
 
-	size_t flags = JSON_PRESERVE_ORDER;
-
-	if (pretty)
-		flags |= JSON_INDENT(4);
-	else
-		flags |= JSON_COMPACT;
-
-	/* NOTE: don't use libobs bfree for json text */
-	free(data->json);
-	data->json = NULL;
+	struct json_writer writer = {.pretty = pretty, .with_defaults = with_defaults};
 
-	json_t *root = obs_data_to_json(data, with_defaults);
-	data->json = json_dumps(root, flags);
-	json_decref(root);
+	bfree(data->json);
 
+	json_write_obj(&writer, data, 0);
+	data->json = writer.out.array;
 	return data->json;
 }
 
@@ -69,6 +69,11 @@ EXPORT const char *obs_data_get_json_with_defaults(obs_data_t *data);
 EXPORT const char *obs_data_get_json_pretty(obs_data_t *data);
 EXPORT const char *obs_data_get_json_pretty_with_defaults(obs_data_t *data);
 EXPORT const char *obs_data_get_last_json(obs_data_t *data);
+
+/** Hash of the user values, as written by obs_data_get_json, to tell whether
+ * data has changed.  Data with equal values has the same hash. */
+EXPORT uint64_t obs_data_get_hash(obs_data_t *data);
+
 EXPORT bool obs_data_save_json(obs_data_t *data, const char *file);
 EXPORT bool obs_data_save_json_safe(obs_data_t *data, const char *file, const char *temp_ext, const char *backup_ext);
 EXPORT bool obs_data_save_json_pretty_safe(obs_data_t *data, const char *file, const char *temp_ext,
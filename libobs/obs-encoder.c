@@ -35,6 +35,9 @@ struct obs_encoder_info *find_encoder(const char *id)
 			return info;
 	}
 
+	if (obs_module_load_deferred(OBS_MODULE_TYPE_ENCODER, id, false))
+		return find_encoder(id);
+
 	return NULL;
 }
 
@@ -1433,6 +1436,7 @@ bool do_encode(struct obs_encoder *encoder, struct encoder_frame *frame, const u
 		ept->pts = frame->pts;
 		ept->cts = *frame_cts;
 		ept->fer = fer_ts;
+		get_frame_timing(encoder->media, ept->cts, ept);
 	}
 	send_off_encoder_packet(encoder, success, received, &pkt);
 
@@ -1976,6 +1980,18 @@ uint64_t obs_encoder_get_pause_offset(const obs_encoder_t *encoder)
 	return encoder ? encoder->pause.ts_offset : 0;
 }
 
+void obs_encoder_memory_add(obs_encoder_t *encoder, size_t size)
+{
+	if (obs_encoder_valid(encoder, "obs_encoder_memory_add"))
+		obs_context_memory_add(&encoder->context, size);
+}
+
+void obs_encoder_memory_remove(obs_encoder_t *encoder, size_t size)
+{
+	if (obs_encoder_valid(encoder, "obs_encoder_memory_remove"))
+		obs_context_memory_remove(&encoder->context, size);
+}
+
 bool obs_encoder_has_roi(const obs_encoder_t *encoder)
 {
 	return encoder->roi.num > 0;
@@ -49,14 +49,14 @@ enum obs_encoder_type {
  * with each video frame. This is useful for deriving absolute
  * timestamps (i.e. wall-clock based formats) and measuring latency.
  *
- * For each frame, there are four events of interest, described in
- * the encoder_packet_time struct, namely cts, fer, ferc, and pir.
- * The timebase of these four events is os_gettime_ns(), which provides
- * very high resolution timestamping, and the ability to convert the
- * timing to any other time format.
+ * For each frame, there are six events of interest, described in
+ * the encoder_packet_time struct, namely cts, rendered, queued, fer,
+ * ferc, and pir. The timebase of these events is os_gettime_ns(),
+ * which provides very high resolution timestamping, and the ability
+ * to convert the timing to any other time format.
  *
  * Each frame follows a timeline in the following temporal order:
- *   CTS, FER, FERC, PIR
+ *   CTS, rendered, queued, FER, FERC, PIR
  *
  * PTS is the integer-based monotonically increasing value that is used
  * to associate an encoder_packet_time entry with a specific encoder_packet.
@@ -93,6 +93,18 @@ struct encoder_packet_time {
 	 * and packet interleaving.
 	 */
 	uint64_t pir;
+
+	/* When the frame finished rendering on the graphics thread,
+	 * captured via os_gettime_ns(). 0 if unknown.
+	 */
+	uint64_t rendered;
+
+	/* When the rendered frame was handed to the encoders, either
+	 * queued for raw encoders after being downloaded from the GPU
+	 * or queued for texture encoders, captured via os_gettime_ns().
+	 * 0 if unknown.
+	 */
+	uint64_t queued;
 };
 
 /** Encoder output packet */
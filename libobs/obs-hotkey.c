@@ -464,6 +464,8 @@ static inline void create_binding(obs_hotkey_t *hotkey, obs_key_combination_t co
 	binding->key = combo;
 	binding->hotkey_id = hotkey->id;
 	binding->hotkey = hotkey;
+
+	obs->hotkeys.key_bindings_dirty = true;
 }
 
 static inline void load_binding(obs_hotkey_t *hotkey, obs_data_t *data)
@@ -811,6 +813,7 @@ static inline bool remove_bindings(obs_hotkey_id id)
 			release_pressed_binding(binding);
 
 		da_erase(obs->hotkeys.bindings, idx);
+		obs->hotkeys.key_bindings_dirty = true;
 		removed = true;
 	}
 
@@ -959,6 +962,9 @@ void obs_hotkeys_free(void)
 
 	da_free(obs->hotkeys.bindings);
 
+	for (size_t i = 0; i < OBS_KEY_LAST_VALUE; i++)
+		da_free(obs->hotkeys.key_bindings[i]);
+
 	for (size_t i = 0; i < OBS_KEY_LAST_VALUE; i++) {
 		if (obs->hotkeys.translations[i]) {
 			bfree(obs->hotkeys.translations[i]);
@@ -1152,6 +1158,94 @@ static inline void query_hotkeys()
 	enum_bindings(query_hotkey, &param);
 }
 
+static void rebuild_key_bindings(void)
+{
+	struct obs_core_hotkeys *hotkeys = &obs->hotkeys;
+
+	for (size_t i = 0; i < OBS_KEY_LAST_VALUE; i++)
+		da_resize(hotkeys->key_bindings[i], 0);
+
+	for (size_t i = 0; i < hotkeys->bindings.num; i++) {
+		obs_key_t key = hotkeys->bindings.array[i].key.key;
+		if ((size_t)key < OBS_KEY_LAST_VALUE)
+			da_push_back(hotkeys->key_bindings[key], &i);
+	}
+
+	hotkeys->key_bindings_dirty = false;
+}
+
+static inline uint32_t pressed_modifiers(void)
+{
+	bool *pressed = obs->hotkeys.key_pressed;
+	uint32_t modifiers = 0;
+
+	if (pressed[OBS_KEY_SHIFT])
+		modifiers |= INTERACT_SHIFT_KEY;
+	if (pressed[OBS_KEY_CONTROL])
+		modifiers |= INTERACT_CONTROL_KEY;
+	if (pressed[OBS_KEY_ALT])
+		modifiers |= INTERACT_ALT_KEY;
+	if (pressed[OBS_KEY_META])
+		modifiers |= INTERACT_COMMAND_KEY;
+	return modifiers;
+}
+
+static inline bool is_modifier_key(obs_key_t key)
+{
+	return key == OBS_KEY_SHIFT || key == OBS_KEY_CONTROL || key == OBS_KEY_ALT || key == OBS_KEY_META;
+}
+
+/* Same as query_hotkeys, but with key state tracked from events.  Only the
+ * bindings of the key are handled, except for modifier changes, which can
+ * affect any binding.  Hotkey callbacks may change the bindings, in which
+ * case the index is rebuilt and the (idempotent) walk starts over. */
+void obs_hotkeys_key_event(obs_key_t key, bool pressed)
+{
+	struct obs_core_hotkeys *hotkeys;
+
+	if (key <= OBS_KEY_NONE || key >= OBS_KEY_LAST_VALUE)
+		return;
+	if (!lock())
+		return;
+
+	hotkeys = &obs->hotkeys;
+	hotkeys->key_pressed[key] = pressed;
+
+	uint32_t modifiers = pressed_modifiers();
+	bool no_press = hotkeys->thread_disable_press;
+	bool strict_modifiers = hotkeys->strict_modifiers;
+
+restart:
+	if (hotkeys->key_bindings_dirty)
+		rebuild_key_bindings();
+
+	if (is_modifier_key(key)) {
+		for (size_t i = 0; i < hotkeys->bindings.num; i++) {
+			obs_hotkey_binding_t *binding = &hotkeys->bindings.array[i];
+			obs_key_t binding_key = binding->key.key;
+
+			if ((size_t)binding_key >= OBS_KEY_LAST_VALUE)
+				continue;
+
+			handle_binding(binding, modifiers, no_press, strict_modifiers,
+				       &hotkeys->key_pressed[binding_key]);
+			if (hotkeys->key_bindings_dirty)
+				goto restart;
+		}
+	} else {
+		for (size_t i = 0; i < hotkeys->key_bindings[key].num; i++) {
+			size_t idx = hotkeys->key_bindings[key].array[i];
+
+			handle_binding(&hotkeys->bindings.array[idx], modifiers, no_press, strict_modifiers,
+				       &hotkeys->key_pressed[key]);
+			if (hotkeys->key_bindings_dirty)
+				goto restart;
+		}
+	}
+
+	unlock();
+}
+
 #define NBSP "\xC2\xA0"
 
 void *obs_hotkey_thread(void *arg)
@@ -1160,6 +1254,16 @@ void *obs_hotkey_thread(void *arg)
 
 	os_set_thread_name("libobs: hotkey thread");
 
+	const struct obs_hotkeys_events *events = obs->hotkeys.events;
+	if (events) {
+		while (os_event_try(obs->hotkeys.stop_event) == EAGAIN) {
+			if (!events->wait(obs->hotkeys.platform_context)) {
+				blog(LOG_WARNING, "Hotkey events stopped working, falling back to polling");
+				break;
+			}
+		}
+	}
+
 	const char *hotkey_thread_name =
 		profile_store_name(obs_get_profiler_name_store(), "obs_hotkey_thread(%g" NBSP "ms)", 25.);
 	profile_register_root(hotkey_thread_name, (uint64_t)25000000);
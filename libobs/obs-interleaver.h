@@ -0,0 +1,206 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "obs.h"
+#include "util/deque.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Interleave buffer for encoded packets of an output.
+ *
+ * Packets are kept in one FIFO per encoder track (encoders emit packets in
+ * DTS order), and are taken out with a k-way merge of the track heads, so
+ * queueing and sending a packet does not depend on the number of packets
+ * buffered.  The merged order is:
+ *
+ *   - ascending DTS (dts_usec)
+ *   - on equal DTS, video before audio, video tracks by track index
+ *   - on equal DTS, audio in the order it was queued
+ *
+ * Not thread safe, the output's interleaved_mutex protects it.
+ */
+
+#define INTERLEAVER_TRACKS (MAX_OUTPUT_VIDEO_ENCODERS + MAX_OUTPUT_AUDIO_ENCODERS)
+
+struct interleaved_packet {
+	struct encoder_packet packet;
+	uint64_t seq;
+};
+
+struct interleaver {
+	/* video tracks first, then audio tracks */
+	struct deque tracks[INTERLEAVER_TRACKS];
+	size_t num;
+	uint64_t seq;
+};
+
+/* position of an in-order walk over queued packets (zero-initialize) */
+struct interleaver_cursor {
+	size_t pos[INTERLEAVER_TRACKS];
+};
+
+static inline size_t interleaver_track(enum obs_encoder_type type, size_t track_idx)
+{
+	return type == OBS_ENCODER_VIDEO ? track_idx : MAX_OUTPUT_VIDEO_ENCODERS + track_idx;
+}
+
+static inline bool interleaved_packet_before(const struct interleaved_packet *a, size_t track_a,
+					     const struct interleaved_packet *b, size_t track_b)
+{
+	if (a->packet.dts_usec != b->packet.dts_usec)
+		return a->packet.dts_usec < b->packet.dts_usec;
+	if (track_a < MAX_OUTPUT_VIDEO_ENCODERS || track_b < MAX_OUTPUT_VIDEO_ENCODERS)
+		return track_a < track_b;
+	return a->seq < b->seq;
+}
+
+static inline struct interleaved_packet *interleaver_track_at(struct interleaver *il, size_t track, size_t idx)
+{
+	return (struct interleaved_packet *)deque_data(&il->tracks[track], idx * sizeof(struct interleaved_packet));
+}
+
+static inline size_t interleaver_track_size(const struct interleaver *il, size_t track)
+{
+	return il->tracks[track].size / sizeof(struct interleaved_packet);
+}
+
+/* packets must be released before (see interleaver_pop) */
+static inline void interleaver_free(struct interleaver *il)
+{
+	for (size_t i = 0; i < INTERLEAVER_TRACKS; i++)
+		deque_free(&il->tracks[i]);
+	il->num = 0;
+	il->seq = 0;
+}
+
+static inline void interleaver_push(struct interleaver *il, const struct encoder_packet *packet)
+{
+	struct interleaved_packet entry = {*packet, il->seq++};
+	size_t track = interleaver_track(packet->type, packet->track_idx);
+
+	deque_push_back(&il->tracks[track], &entry, sizeof(entry));
+	il->num++;
+}
+
+/* returns the next packet in interleaved order without moving the cursor */
+static inline struct encoder_packet *interleaver_cursor_peek(struct interleaver *il,
+							     const struct interleaver_cursor *cursor,
+							     size_t *track_out)
+{
+	struct interleaved_packet *best = NULL;
+	size_t best_track = 0;
+
+	for (size_t i = 0; i < INTERLEAVER_TRACKS; i++) {
+		struct interleaved_packet *cur = interleaver_track_at(il, i, cursor->pos[i]);
+
+		if (cur && (!best || interleaved_packet_before(cur, i, best, best_track))) {
+			best = cur;
+			best_track = i;
+		}
+	}
+
+	if (track_out)
+		*track_out = best_track;
+	return best ? &best->packet : NULL;
+}
+
+/* returns the next packet in interleaved order and advances the cursor */
+static inline struct encoder_packet *interleaver_next(struct interleaver *il, struct interleaver_cursor *cursor)
+{
+	size_t track;
+	struct encoder_packet *packet = interleaver_cursor_peek(il, cursor, &track);
+
+	if (packet)
+		cursor->pos[track]++;
+	return packet;
+}
+
+static inline struct encoder_packet *interleaver_peek(struct interleaver *il)
+{
+	struct interleaver_cursor cursor = {0};
+	return interleaver_cursor_peek(il, &cursor, NULL);
+}
+
+static inline bool interleaver_pop(struct interleaver *il, struct encoder_packet *packet)
+{
+	struct interleaver_cursor cursor = {0};
+	struct interleaved_packet entry;
+	size_t track;
+
+	if (!interleaver_cursor_peek(il, &cursor, &track))
+		return false;
+
+	deque_pop_front(&il->tracks[track], &entry, sizeof(entry));
+	*packet = entry.packet;
+	il->num--;
+	return true;
+}
+
+static inline struct encoder_packet *interleaver_first(struct interleaver *il, enum obs_encoder_type type,
+						       size_t track_idx)
+{
+	struct interleaved_packet *entry = interleaver_track_at(il, interleaver_track(type, track_idx), 0);
+	return entry ? &entry->packet : NULL;
+}
+
+static inline struct encoder_packet *interleaver_last(struct interleaver *il, enum obs_encoder_type type,
+						      size_t track_idx)
+{
+	size_t track = interleaver_track(type, track_idx);
+	size_t size = interleaver_track_size(il, track);
+	return size ? &interleaver_track_at(il, track, size - 1)->packet : NULL;
+}
+
+/* position of the first packet of a track in interleaved order, or -1 */
+static inline int interleaver_first_idx(struct interleaver *il, enum obs_encoder_type type, size_t track_idx)
+{
+	struct interleaver_cursor cursor = {0};
+	size_t track = interleaver_track(type, track_idx);
+
+	if (!interleaver_track_size(il, track))
+		return -1;
+
+	for (int idx = 0;; idx++) {
+		size_t next;
+		interleaver_cursor_peek(il, &cursor, &next);
+		if (next == track)
+			return idx;
+		cursor.pos[next]++;
+	}
+}
+
+/* Renumbers queued packets in their current interleaved order.  Must be
+ * called before changing the timestamps of queued packets, so that audio
+ * packets which end up with equal timestamps keep their relative order. */
+static inline void interleaver_resequence(struct interleaver *il)
+{
+	struct interleaver_cursor cursor = {0};
+	struct encoder_packet *packet;
+
+	il->seq = 0;
+	while ((packet = interleaver_next(il, &cursor)) != NULL)
+		((struct interleaved_packet *)packet)->seq = il->seq++;
+}
+
+#ifdef __cplusplus
+}
+#endif
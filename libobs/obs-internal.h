@@ -38,6 +38,7 @@
 #include "media-io/audio-io.h"
 
 #include "obs.h"
+#include "obs-interleaver.h"
 
 #include <obsversion.h>
 #include <caption/caption.h>
@@ -113,6 +114,13 @@ struct obs_module {
 	void *module;
 	bool loaded;
 
+	/* declares its types in its manifest and has not been opened yet;
+	 * opened the first time one of the types is requested */
+	bool deferred;
+	uint32_t declared_source_types;
+	uint64_t open_time_ns;
+	uint64_t load_time_ns;
+
 	enum obs_module_load_state load_state;
 
 	bool (*load)(void);
@@ -153,6 +161,21 @@ struct obs_disabled_module {
 
 extern void free_module(struct obs_module *mod);
 
+enum obs_module_type {
+	OBS_MODULE_TYPE_SOURCE,
+	OBS_MODULE_TYPE_OUTPUT,
+	OBS_MODULE_TYPE_ENCODER,
+	OBS_MODULE_TYPE_SERVICE,
+};
+
+/* Loads the deferred module declaring the type, returns true if a module was
+ * loaded.  With unversioned set, id is matched against unversioned source ids.
+ * Only loads modules on the thread that loaded all modules. */
+extern bool obs_module_load_deferred(enum obs_module_type type, const char *id, bool unversioned);
+/* Loads all deferred modules declaring a type of this kind */
+extern void obs_module_load_all_deferred(enum obs_module_type type);
+extern void obs_module_load_deferred_sources(enum obs_source_type type);
+
 struct obs_module_path {
 	char *bin;
 	char *data;
@@ -247,6 +270,18 @@ bool obs_hotkeys_platform_init(struct obs_core_hotkeys *hotkeys);
 void obs_hotkeys_platform_free(struct obs_core_hotkeys *hotkeys);
 bool obs_hotkeys_platform_is_pressed(obs_hotkeys_platform_t *context, obs_key_t key);
 
+/* Optional event-driven key input, set up by obs_hotkeys_platform_init.
+ * wait blocks until key events arrive, which it passes on to
+ * obs_hotkeys_key_event, or until wake is called.  It returns false if
+ * events stopped working, in which case the hotkey thread falls back to
+ * polling obs_hotkeys_platform_is_pressed. */
+struct obs_hotkeys_events {
+	bool (*wait)(obs_hotkeys_platform_t *context);
+	void (*wake)(obs_hotkeys_platform_t *context);
+};
+
+void obs_hotkeys_key_event(obs_key_t key, bool pressed);
+
 const char *obs_get_hotkey_translation(obs_key_t key, const char *def);
 
 struct obs_context_data;
@@ -311,6 +346,7 @@ extern void obs_display_free(struct obs_display *display);
 
 struct obs_vframe_info {
 	uint64_t timestamp;
+	uint64_t rendered;
 	int count;
 };
 
@@ -381,11 +417,24 @@ struct obs_core_video_mix {
 	long encoder_refs;
 
 	bool mix_audio;
+
+	uint64_t rendered_ts;
 };
 
 extern struct obs_core_video_mix *obs_create_video_mix(struct obs_video_info *ovi);
 extern void obs_free_video_mix(struct obs_core_video_mix *video);
 
+/* stage timestamps of recently output frames, looked up by encoders when
+ * filling encoder_packet_time */
+#define FRAME_TIMING_FRAMES 64
+
+struct obs_frame_timing {
+	video_t *video;
+	uint64_t timestamp;
+	uint64_t rendered;
+	uint64_t queued;
+};
+
 struct obs_core_video {
 	graphics_t *graphics;
 	gs_effect_t *default_effect;
@@ -433,12 +482,21 @@ struct obs_core_video {
 
 	pthread_mutex_t mixes_mutex;
 	DARRAY(struct obs_core_video_mix *) mixes;
+
+	pthread_mutex_t frame_timing_mutex;
+	struct obs_frame_timing frame_timing[FRAME_TIMING_FRAMES];
+	size_t frame_timing_next;
 };
 
 extern void add_ready_encoder_group(obs_encoder_t *encoder);
+extern void get_frame_timing(video_t *video, uint64_t timestamp, struct encoder_packet_time *packet_time);
 
 struct audio_monitor;
 
+#define DEFAULT_MONITORING_LATENCY_MS 50
+#define MIN_MONITORING_LATENCY_MS 10
+#define MAX_MONITORING_LATENCY_MS 1000
+
 struct obs_core_audio {
 	audio_t *audio;
 
@@ -456,6 +514,7 @@ struct obs_core_audio {
 	DARRAY(struct audio_monitor *) monitors;
 	char *monitoring_device_name;
 	char *monitoring_device_id;
+	uint32_t monitoring_latency_ms;
 
 	pthread_mutex_t task_mutex;
 	struct deque tasks;
@@ -522,6 +581,12 @@ struct obs_core_hotkeys {
 	bool reroute_hotkeys;
 	DARRAY(obs_hotkey_binding_t) bindings;
 
+	/* event-driven input: key state, and binding indices per key */
+	const struct obs_hotkeys_events *events;
+	bool key_pressed[OBS_KEY_LAST_VALUE];
+	DARRAY(size_t) key_bindings[OBS_KEY_LAST_VALUE];
+	bool key_bindings_dirty;
+
 	obs_hotkey_callback_router_func router_func;
 	void *router_func_data;
 
@@ -546,6 +611,9 @@ typedef DARRAY(struct obs_source_info) obs_source_info_array_t;
 struct obs_core {
 	struct obs_module *first_module;
 	struct obs_module *first_disabled_module;
+	size_t deferred_module_count;
+	pthread_t module_thread;
+	bool modules_post_loaded;
 
 	DARRAY(struct obs_module_path) module_paths;
 	DARRAY(char *) safe_modules;
@@ -559,6 +627,7 @@ struct obs_core {
 	DARRAY(struct obs_output_info) output_types;
 	DARRAY(struct obs_encoder_info) encoder_types;
 	DARRAY(struct obs_service_info) service_types;
+	DARRAY(struct obs_bitrate_estimator_info) bitrate_estimator_types;
 
 	signal_handler_t *signals;
 	proc_handler_t *procs;
@@ -643,6 +712,12 @@ struct obs_context_data {
 	DARRAY(char *) rename_cache;
 	pthread_mutex_t rename_cache_mutex;
 
+	/* memory attributed to the object (see obs_context_memory_add) */
+	pthread_mutex_t memory_mutex;
+	uint64_t memory_bytes;
+	uint64_t memory_bytes_max;
+	uint64_t memory_allocs;
+
 	pthread_mutex_t *mutex;
 	struct obs_context_data *next;
 	struct obs_context_data **prev_next;
@@ -668,6 +743,9 @@ extern void obs_context_data_remove_uuid(struct obs_context_data *context, pthre
 
 extern void obs_context_wait(struct obs_context_data *context);
 
+extern void obs_context_memory_add(struct obs_context_data *context, size_t size);
+extern void obs_context_memory_remove(struct obs_context_data *context, size_t size);
+
 extern void obs_context_data_setname(struct obs_context_data *context, const char *name);
 extern void obs_context_data_setname_ht(struct obs_context_data *context, const char *name, void *phead);
 
@@ -752,8 +830,13 @@ extern void obs_canvas_rename_source(obs_source_t *source, const char *name);
 
 struct async_frame {
 	struct obs_source_frame *frame;
+	size_t size;
 	long unused_count;
 	bool used;
+
+	/* frames output without copying are given back to the source */
+	void (*release)(void *param);
+	void *release_param;
 };
 
 enum audio_action_type {
@@ -805,6 +888,11 @@ struct media_action {
 	};
 };
 
+struct source_drop_counter {
+	char *stage;
+	uint64_t dropped;
+};
+
 struct obs_source {
 	struct obs_context_data context;
 	struct obs_source_info info;
@@ -912,7 +1000,14 @@ struct obs_source {
 	struct obs_source_frame *async_preload_frame;
 	DARRAY(struct async_frame) async_cache;
 	DARRAY(struct obs_source_frame *) async_frames;
+	/* frames output without copying that are not released yet, the event
+	 * is signaled when there are none */
+	DARRAY(struct async_frame) async_nocopy_frames;
+	os_event_t *async_nocopy_event;
 	pthread_mutex_t async_mutex;
+	/* frames dropped by the source, per pipeline stage */
+	DARRAY(struct source_drop_counter) drop_counters;
+	pthread_mutex_t drop_mutex;
 	uint32_t async_width;
 	uint32_t async_height;
 	uint32_t async_cache_width;
@@ -1019,6 +1114,7 @@ extern void obs_transition_load(obs_source_t *source, obs_data_t *data);
 struct audio_monitor *audio_monitor_create(obs_source_t *source);
 void audio_monitor_reset(struct audio_monitor *monitor);
 extern void audio_monitor_destroy(struct audio_monitor *monitor);
+extern bool audio_monitor_get_stats(struct obs_audio_monitoring_stats *stats);
 
 extern obs_source_t *obs_source_create_canvas(obs_canvas_t *canvas, const char *id, const char *name,
 					      obs_data_t *settings, obs_data_t *hotkey_data);
@@ -1026,6 +1122,15 @@ extern obs_source_t *obs_source_create_set_last_ver(obs_canvas_t *canvas, const
 						    const char *uuid, obs_data_t *settings, obs_data_t *hotkey_data,
 						    uint32_t last_obs_ver, bool is_private);
 
+/* Source creation in steps, so that create callbacks of sources with
+ * OBS_SOURCE_PARALLEL_CREATE can run on other threads while loading.  The
+ * source only becomes visible to others in obs_source_create_finish. */
+extern obs_source_t *obs_source_create_prepare(const char *id, const char *name, const char *uuid,
+					       obs_data_t *settings, obs_data_t *hotkey_data, bool private,
+					       uint32_t last_obs_ver);
+extern void obs_source_create_data(obs_source_t *source);
+extern void obs_source_create_finish(obs_source_t *source, obs_canvas_t *canvas);
+
 extern void obs_source_destroy(struct obs_source *source);
 extern void obs_source_addref(obs_source_t *source);
 
@@ -1152,12 +1257,45 @@ enum delay_msg {
 	DELAY_MSG_STOP,
 };
 
+enum delay_storage {
+	DELAY_STORAGE_HEAP,
+	DELAY_STORAGE_ARENA,
+	DELAY_STORAGE_SPILL,
+};
+
 struct delay_data {
 	enum delay_msg msg;
 	uint64_t ts;
 	struct encoder_packet packet;
 	bool packet_time_valid;
 	struct encoder_packet_time packet_time;
+
+	/* where the packet payload is stored; for arena and spill storage
+	 * packet.data is NULL, and spilled payloads are at `offset` */
+	enum delay_storage storage;
+	uint64_t offset;
+};
+
+/* FIFO of delayed packet payloads stored in fixed-size memory segments.
+ * Segments are never reallocated; a payload may span several of them. */
+struct delay_arena {
+	struct deque segments; /* uint8_t *, oldest first */
+	uint8_t *spare;
+	size_t read_pos;
+	size_t write_pos;
+	uint64_t used;
+};
+
+/* FIFO byte ring holding spilled packet payloads in the spill file.
+ * Payloads are always freed in the order they were allocated. */
+struct delay_ring {
+	uint64_t capacity;
+	uint64_t head;
+	uint64_t tail;
+	/* end of the older data once allocation wrapped around, 0 otherwise */
+	uint64_t wrap_end;
+	uint64_t used;
+	size_t count;
 };
 
 typedef void (*encoded_callback_t)(void *data, struct encoder_packet *packet, struct encoder_packet_time *frame_time);
@@ -1209,6 +1347,25 @@ struct keyframe_group_data {
 	enum keyframe_group_track_status seen_on_track[MAX_OUTPUT_VIDEO_ENCODERS];
 };
 
+/* log-scaled histogram of latencies: 1 us buckets below 16 us, then four
+ * buckets per power of two */
+#define LATENCY_BUCKETS 128
+#define LATENCY_MAX_PENDING_SENDS 256
+
+struct latency_histogram {
+	uint64_t buckets[LATENCY_BUCKETS];
+	uint64_t count;
+	uint64_t max_ns;
+};
+
+/* interleaved video packet waiting to be reported by obs_output_packet_sent */
+struct latency_pending_send {
+	size_t track_idx;
+	int64_t pts;
+	uint64_t cts;
+	uint64_t pir;
+};
+
 struct obs_output {
 	struct obs_context_data context;
 	struct obs_output_info info;
@@ -1228,7 +1385,7 @@ struct obs_output {
 	pthread_t end_data_capture_thread;
 	os_event_t *stopping_event;
 	pthread_mutex_t interleaved_mutex;
-	DARRAY(struct encoder_packet) interleaved_packets;
+	struct interleaver interleaved_packets;
 	size_t interleaver_max_batch_size;
 	int stop_code;
 
@@ -1284,6 +1441,12 @@ struct obs_output {
 	pthread_mutex_t pkt_callbacks_mutex;
 	DARRAY(struct packet_callback) pkt_callbacks;
 
+	/* Per-stage video latency */
+	pthread_mutex_t latency_mutex;
+	struct latency_histogram latency[OBS_LATENCY_STAGE_COUNT];
+	DARRAY(struct latency_pending_send) latency_pending_sends;
+	volatile bool latency_reports_sends;
+
 	struct reconnect_callback reconnect_callback;
 
 	bool valid;
@@ -1292,6 +1455,15 @@ struct obs_output {
 	encoded_callback_t delay_callback;
 	struct deque delay_data; /* struct delay_data */
 	pthread_mutex_t delay_mutex;
+	struct delay_arena delay_arena;
+	FILE *delay_spill_file;
+	char *delay_spill_file_path;
+	struct delay_ring delay_spill_ring;
+	uint64_t delay_heap_bytes;
+	uint64_t delay_memory_limit;
+	char *delay_spill_dir;
+	bool delay_spill_failed;
+	bool delay_limit_warned;
 	uint32_t delay_sec;
 	uint32_t delay_flags;
 	uint32_t delay_cur_flags;
@@ -79,14 +79,10 @@ const char *obs_module_get_locale_text(const obs_module_t *mod, const char *text
 
 static inline char *get_module_name(const char *file)
 {
-	static size_t ext_len = 0;
+	/* not cached, modules are opened from multiple threads */
+	size_t ext_len = strlen(get_module_extension());
 	struct dstr name = {0};
 
-	if (ext_len == 0) {
-		const char *ext = get_module_extension();
-		ext_len = strlen(ext);
-	}
-
 	dstr_copy(&name, file);
 	dstr_resize(&name, name.len - ext_len);
 	return name.array;
@@ -96,6 +92,42 @@ static inline char *get_module_name(const char *file)
 extern void reset_win32_symbol_paths(void);
 #endif
 
+static uint32_t get_declared_source_type(const char *type)
+{
+	if (strcmp(type, "input") == 0)
+		return 1 << OBS_SOURCE_TYPE_INPUT;
+	if (strcmp(type, "filter") == 0)
+		return 1 << OBS_SOURCE_TYPE_FILTER;
+	if (strcmp(type, "transition") == 0)
+		return 1 << OBS_SOURCE_TYPE_TRANSITION;
+	if (strcmp(type, "scene") == 0)
+		return 1 << OBS_SOURCE_TYPE_SCENE;
+
+	/* unknown or missing, could be any type */
+	return UINT32_MAX;
+}
+
+static void load_declared_types(obs_data_t *types, const char *name, struct darray *ids, uint32_t *source_types)
+{
+	obs_data_array_t *array = obs_data_get_array(types, name);
+	size_t count = obs_data_array_count(array);
+
+	for (size_t i = 0; i < count; i++) {
+		obs_data_t *item = obs_data_array_item(array, i);
+		const char *id = obs_data_get_string(item, "id");
+		if (*id) {
+			char *id_copy = bstrdup(id);
+			darray_push_back(sizeof(char *), ids, &id_copy);
+
+			if (source_types)
+				*source_types |= get_declared_source_type(obs_data_get_string(item, "type"));
+		}
+		obs_data_release(item);
+	}
+
+	obs_data_array_release(array);
+}
+
 int obs_module_load_metadata(struct obs_module *mod)
 {
 	struct obs_module_metadata *md = NULL;
@@ -130,6 +162,21 @@ int obs_module_load_metadata(struct obs_module *mod)
 
 		md->has_banner = obs_data_get_bool(metadata, "has_banner");
 		md->has_icon = obs_data_get_bool(metadata, "has_icon");
+
+		/* Type ids registered by the module, in the form
+		 * "types": {"sources": [{"id": "...", "type": "input"}],
+		 * "outputs": [{"id": "..."}], "encoders": [...],
+		 * "services": [...]}.  Replaced by the types actually
+		 * registered once the module is loaded. */
+		obs_data_t *types = obs_data_get_obj(metadata, "types");
+		if (types) {
+			load_declared_types(types, "sources", &mod->sources.da, &mod->declared_source_types);
+			load_declared_types(types, "outputs", &mod->outputs.da, NULL);
+			load_declared_types(types, "encoders", &mod->encoders.da, NULL);
+			load_declared_types(types, "services", &mod->services.da, NULL);
+			obs_data_release(types);
+		}
+
 		obs_data_release(metadata);
 	}
 	dstr_free(&path);
@@ -137,13 +184,34 @@ int obs_module_load_metadata(struct obs_module *mod)
 	return MODULE_SUCCESS;
 }
 
-int obs_open_module(obs_module_t **module, const char *path, const char *data_path)
+static void free_type_ids(struct darray *ids)
 {
-	struct obs_module mod = {0};
-	int errorcode;
+	char **array = ids->array;
+	for (size_t i = 0; i < ids->num; i++)
+		bfree(array[i]);
+	darray_free(ids);
+}
 
-	if (!module || !path || !obs)
-		return MODULE_ERROR;
+static void free_module_info(struct obs_module *mod)
+{
+	bfree(mod->mod_name);
+	bfree(mod->bin_path);
+	bfree(mod->data_path);
+
+	free_type_ids(&mod->sources.da);
+	free_type_ids(&mod->outputs.da);
+	free_type_ids(&mod->encoders.da);
+	free_type_ids(&mod->services.da);
+
+	if (mod->metadata) {
+		free_module_metadata(mod->metadata);
+		bfree(mod->metadata);
+	}
+}
+
+static int open_module_binary(struct obs_module *mod, const char *path)
+{
+	int errorcode;
 
 #ifdef __APPLE__
 	/* HACK: Do not load obsolete obs-browser build on macOS; the
@@ -157,36 +225,69 @@ int obs_open_module(obs_module_t **module, const char *path, const char *data_pa
 
 	blog(LOG_DEBUG, "---------------------------------");
 
-	mod.module = os_dlopen(path);
-	if (!mod.module) {
+	mod->module = os_dlopen(path);
+	if (!mod->module) {
 		blog(LOG_WARNING, "Module '%s' not loaded", path);
 		return MODULE_FAILED_TO_OPEN;
 	}
 
-	errorcode = load_module_exports(&mod, path);
+	errorcode = load_module_exports(mod, path);
 	if (errorcode != MODULE_SUCCESS)
 		return errorcode;
 
 	/* Reject plugins compiled with a newer libobs. Patch version (lower 16-bit) is ignored. */
-	uint32_t ver = mod.ver ? mod.ver() & 0xFFFF0000 : 0;
+	uint32_t ver = mod->ver ? mod->ver() & 0xFFFF0000 : 0;
 	if (ver > LIBOBS_API_VER) {
 		blog(LOG_WARNING, "Module '%s' compiled with newer libobs %d.%d", path, (ver >> 24) & 0xFF,
 		     (ver >> 16) & 0xFF);
 		return MODULE_INCOMPATIBLE_VER;
 	}
 
-	mod.bin_path = bstrdup(path);
-	mod.file = strrchr(mod.bin_path, '/');
-	mod.file = (!mod.file) ? mod.bin_path : (mod.file + 1);
-	mod.mod_name = get_module_name(mod.file);
-	mod.data_path = bstrdup(data_path);
-	mod.next = obs->first_module;
-	mod.load_state = OBS_MODULE_ENABLED;
+	return MODULE_SUCCESS;
+}
+
+static void init_module_paths(struct obs_module *mod, const char *path, const char *data_path)
+{
+	mod->bin_path = bstrdup(path);
+	mod->file = strrchr(mod->bin_path, '/');
+	mod->file = (!mod->file) ? mod->bin_path : (mod->file + 1);
+	mod->mod_name = get_module_name(mod->file);
+	mod->data_path = bstrdup(data_path);
+
+	da_init(mod->sources);
+	da_init(mod->outputs);
+	da_init(mod->encoders);
+	da_init(mod->services);
+}
+
+static void init_module_locale(obs_module_t *module)
+{
+	module->set_pointer(module);
+
+	if (module->set_locale)
+		module->set_locale(obs->locale);
+}
+
+static inline void add_module(obs_module_t *module)
+{
+	module->next = obs->first_module;
+	obs->first_module = module;
+}
+
+int obs_open_module(obs_module_t **module, const char *path, const char *data_path)
+{
+	struct obs_module mod = {0};
+	int errorcode;
+
+	if (!module || !path || !obs)
+		return MODULE_ERROR;
+
+	errorcode = open_module_binary(&mod, path);
+	if (errorcode != MODULE_SUCCESS)
+		return errorcode;
 
-	da_init(mod.sources);
-	da_init(mod.outputs);
-	da_init(mod.encoders);
-	da_init(mod.services);
+	init_module_paths(&mod, path, data_path);
+	mod.load_state = OBS_MODULE_ENABLED;
 
 	if (mod.file) {
 		blog(LOG_DEBUG, "Loading module: %s", mod.file);
@@ -195,11 +296,8 @@ int obs_open_module(obs_module_t **module, const char *path, const char *data_pa
 	obs_module_load_metadata(&mod);
 
 	*module = bmemdup(&mod, sizeof(mod));
-	obs->first_module = (*module);
-	mod.set_pointer(*module);
-
-	if (mod.set_locale)
-		mod.set_locale(obs->locale);
+	add_module(*module);
+	init_module_locale(*module);
 
 	return MODULE_SUCCESS;
 }
@@ -209,19 +307,10 @@ bool obs_create_disabled_module(obs_module_t **module, const char *path, const c
 {
 	struct obs_module mod = {0};
 
-	mod.bin_path = bstrdup(path);
-	mod.file = strrchr(mod.bin_path, '/');
-	mod.file = (!mod.file) ? mod.bin_path : (mod.file + 1);
-	mod.mod_name = get_module_name(mod.file);
-	mod.data_path = bstrdup(data_path);
+	init_module_paths(&mod, path, data_path);
 	mod.next = obs->first_disabled_module;
 	mod.load_state = state;
 
-	da_init(mod.sources);
-	da_init(mod.outputs);
-	da_init(mod.encoders);
-	da_init(mod.services);
-
 	obs_module_load_metadata(&mod);
 
 	*module = bmemdup(&mod, sizeof(mod));
@@ -230,10 +319,14 @@ bool obs_create_disabled_module(obs_module_t **module, const char *path, const c
 	return true;
 }
 
+static enum obs_module_load_state init_deferred_module(obs_module_t *module, const char *type_id);
+
 bool obs_init_module(obs_module_t *module)
 {
 	if (!module || !obs)
 		return false;
+	if (module->deferred)
+		return init_deferred_module(module, NULL) == OBS_MODULE_ENABLED;
 	if (module->loaded)
 		return true;
 
@@ -241,10 +334,21 @@ bool obs_init_module(obs_module_t *module)
 		profile_store_name(obs_get_profiler_name_store(), "obs_init_module(%s)", module->file);
 	profile_start(profile_name);
 
+	/* types declared in the manifest are replaced by the ones the module
+	 * actually registers */
+	free_type_ids(&module->sources.da);
+	free_type_ids(&module->outputs.da);
+	free_type_ids(&module->encoders.da);
+	free_type_ids(&module->services.da);
+
+	uint64_t start = os_gettime_ns();
+
 	loadingModule = module;
 	module->loaded = module->load();
 	loadingModule = NULL;
 
+	module->load_time_ns = os_gettime_ns() - start;
+
 	if (!module->loaded)
 		blog(LOG_WARNING, "Failed to initialize module '%s'", module->file);
 
@@ -256,8 +360,13 @@ void obs_log_loaded_modules(void)
 {
 	blog(LOG_INFO, "  Loaded Modules:");
 
-	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next)
-		blog(LOG_INFO, "    %s", mod->file);
+	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next) {
+		if (mod->deferred)
+			blog(LOG_INFO, "    %s (deferred)", mod->file);
+		else
+			blog(LOG_INFO, "    %s (open %.1f ms, load %.1f ms)", mod->file,
+			     (double)mod->open_time_ns / 1000000.0, (double)mod->load_time_ns / 1000000.0);
+	}
 }
 
 const char *obs_get_module_file_name(obs_module_t *module)
@@ -490,86 +599,234 @@ bool obs_get_module_allow_disable(const char *name)
 	return !is_core_module(name);
 }
 
-static void load_all_callback(void *param, const struct obs_module_info2 *info)
-{
-	struct fail_info *fail_info = param;
-	obs_module_t *module;
-	obs_module_t *disabled_module;
+/* ------------------------------------------------------------------------- */
+/* Loading all modules: modules are found first, then opened (dlopen, exports,
+ * metadata and locale) on worker threads, then initialized one at a time on
+ * the calling thread in the order they were found.  Modules that declare
+ * their types in their manifest are not opened until a type is requested. */
 
+#define MAX_MODULE_OPEN_THREADS 8
+
+struct module_load_job {
+	char *bin_path;
+	char *data_path;
+	char *name;
+
+	enum obs_module_load_state skip_state;
 	bool is_obs_plugin;
+	int code;
+	obs_module_t *module;
+};
+
+struct module_load_jobs {
+	DARRAY(struct module_load_job) jobs;
+	volatile long next_job;
+};
+
+static void find_module_callback(void *param, const struct obs_module_info2 *info)
+{
+	struct module_load_jobs *jobs = param;
+	struct module_load_job *job = da_push_back_new(jobs->jobs);
+
+	job->bin_path = bstrdup(info->bin_path);
+	job->data_path = bstrdup(info->data_path);
+	job->name = bstrdup(info->name);
+
+	if (!is_safe_module(info->name))
+		job->skip_state = OBS_MODULE_DISABLED_SAFE;
+	else if (is_disabled_module(info->name))
+		job->skip_state = OBS_MODULE_DISABLED;
+	else
+		job->skip_state = OBS_MODULE_ENABLED;
+}
+
+static void open_module_job(struct module_load_job *job)
+{
+	struct obs_module mod = {0};
+	uint64_t start = os_gettime_ns();
+
+	get_plugin_info(job->bin_path, &job->is_obs_plugin);
+	if (!job->is_obs_plugin || job->skip_state != OBS_MODULE_ENABLED)
+		return;
+
+	init_module_paths(&mod, job->bin_path, job->data_path);
+	mod.load_state = OBS_MODULE_ENABLED;
+	obs_module_load_metadata(&mod);
+
+	bool declares_types = mod.sources.num || mod.outputs.num || mod.encoders.num || mod.services.num;
+	if (declares_types) {
+		mod.deferred = true;
+		job->code = MODULE_SUCCESS;
+		job->module = bmemdup(&mod, sizeof(mod));
+		return;
+	}
+
+	job->code = open_module_binary(&mod, job->bin_path);
+	if (job->code != MODULE_SUCCESS) {
+		free_module_info(&mod);
+		return;
+	}
+
+	blog(LOG_DEBUG, "Loading module: %s", mod.file);
+
+	job->module = bmemdup(&mod, sizeof(mod));
+	init_module_locale(job->module);
+	job->module->open_time_ns = os_gettime_ns() - start;
+}
+
+static void open_next_modules(struct module_load_jobs *jobs)
+{
+	for (;;) {
+		size_t idx = (size_t)os_atomic_inc_long(&jobs->next_job) - 1;
+		if (idx >= jobs->jobs.num)
+			break;
+
+		open_module_job(jobs->jobs.array + idx);
+	}
+}
+
+static void *open_modules_thread(void *param)
+{
+	os_set_thread_name("libobs: module loader");
+	open_next_modules(param);
+	return NULL;
+}
+
+static void open_modules(struct module_load_jobs *jobs)
+{
+	pthread_t threads[MAX_MODULE_OPEN_THREADS];
+	size_t thread_count = (size_t)os_get_logical_cores();
+
+	if (thread_count > MAX_MODULE_OPEN_THREADS)
+		thread_count = MAX_MODULE_OPEN_THREADS;
+	if (thread_count > jobs->jobs.num)
+		thread_count = jobs->jobs.num;
+
+	size_t started = 0;
+	for (; started + 1 < thread_count; started++) {
+		if (pthread_create(&threads[started], NULL, open_modules_thread, jobs) != 0)
+			break;
+	}
+
+	/* the calling thread opens modules as well */
+	open_next_modules(jobs);
 
-	get_plugin_info(info->bin_path, &is_obs_plugin);
+	for (size_t i = 0; i < started; i++)
+		pthread_join(threads[i], NULL);
+}
+
+static void init_module_job(struct module_load_job *job, struct fail_info *fail_info)
+{
+	obs_module_t *disabled_module;
 
-	if (!is_obs_plugin) {
-		blog(LOG_WARNING, "Skipping module '%s', not an OBS plugin", info->bin_path);
+	if (!job->is_obs_plugin) {
+		blog(LOG_WARNING, "Skipping module '%s', not an OBS plugin", job->bin_path);
 		return;
 	}
 
-	if (!is_safe_module(info->name)) {
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path, OBS_MODULE_DISABLED_SAFE);
-		blog(LOG_WARNING, "Skipping module '%s', not on safe list", info->name);
+	if (job->skip_state == OBS_MODULE_DISABLED_SAFE) {
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path, OBS_MODULE_DISABLED_SAFE);
+		blog(LOG_WARNING, "Skipping module '%s', not on safe list", job->name);
 		return;
 	}
 
-	if (is_disabled_module(info->name)) {
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path, OBS_MODULE_DISABLED);
-		blog(LOG_WARNING, "Skipping module '%s', is disabled", info->name);
+	if (job->skip_state == OBS_MODULE_DISABLED) {
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path, OBS_MODULE_DISABLED);
+		blog(LOG_WARNING, "Skipping module '%s', is disabled", job->name);
 		return;
 	}
 
-	int code = obs_open_module(&module, info->bin_path, info->data_path);
-	switch (code) {
+	switch (job->code) {
 	case MODULE_MISSING_EXPORTS:
-		blog(LOG_DEBUG, "Failed to load module file '%s', not an OBS plugin", info->bin_path);
+		blog(LOG_DEBUG, "Failed to load module file '%s', not an OBS plugin", job->bin_path);
 		return;
 	case MODULE_FAILED_TO_OPEN:
-		blog(LOG_DEBUG, "Failed to load module file '%s', module failed to open", info->bin_path);
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path,
+		blog(LOG_DEBUG, "Failed to load module file '%s', module failed to open", job->bin_path);
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path,
 					   OBS_MODULE_FAILED_TO_OPEN);
 		goto load_failure;
 	case MODULE_ERROR:
-		blog(LOG_DEBUG, "Failed to load module file '%s' (unknown error)", info->bin_path);
+		blog(LOG_DEBUG, "Failed to load module file '%s' (unknown error)", job->bin_path);
 		goto load_failure;
 	case MODULE_INCOMPATIBLE_VER:
-		blog(LOG_DEBUG, "Failed to load module file '%s', incompatible version", info->bin_path);
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path,
+		blog(LOG_DEBUG, "Failed to load module file '%s', incompatible version", job->bin_path);
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path,
 					   OBS_MODULE_FAILED_TO_OPEN);
 		goto load_failure;
 	case MODULE_HARDCODED_SKIP:
 		return;
 	}
 
+	obs_module_t *module = job->module;
+	add_module(module);
+
+	if (module->deferred) {
+		obs->deferred_module_count++;
+		blog(LOG_DEBUG, "Deferring module '%s' until one of its types is used", module->file);
+		return;
+	}
+
 	if (!obs_init_module(module)) {
 		free_module(module);
-		obs_create_disabled_module(&disabled_module, info->bin_path, info->data_path,
+		obs_create_disabled_module(&disabled_module, job->bin_path, job->data_path,
 					   OBS_MODULE_FAILED_TO_INITIALIZE);
 	}
 
-	UNUSED_PARAMETER(param);
 	return;
 
 load_failure:
 	if (fail_info) {
-		dstr_cat(&fail_info->fail_modules, info->name);
+		dstr_cat(&fail_info->fail_modules, job->name);
 		dstr_cat(&fail_info->fail_modules, ";");
 		fail_info->fail_count++;
 	}
 }
 
 static const char *obs_load_all_modules_name = "obs_load_all_modules";
+static const char *obs_open_modules_name = "open modules";
 #ifdef _WIN32
 static const char *reset_win32_symbol_paths_name = "reset_win32_symbol_paths";
 #endif
 
-void obs_load_all_modules(void)
+static void load_all_modules(struct fail_info *fail_info)
 {
-	profile_start(obs_load_all_modules_name);
-	obs_find_modules2(load_all_callback, NULL);
+	struct module_load_jobs jobs = {0};
+	uint64_t start = os_gettime_ns();
+
+	obs->module_thread = pthread_self();
+
+	obs_find_modules2(find_module_callback, &jobs);
+
+	profile_start(obs_open_modules_name);
+	open_modules(&jobs);
+	profile_end(obs_open_modules_name);
+
+	for (size_t i = 0; i < jobs.jobs.num; i++) {
+		struct module_load_job *job = jobs.jobs.array + i;
+
+		init_module_job(job, fail_info);
+
+		bfree(job->bin_path);
+		bfree(job->data_path);
+		bfree(job->name);
+	}
+
 #ifdef _WIN32
 	profile_start(reset_win32_symbol_paths_name);
 	reset_win32_symbol_paths();
 	profile_end(reset_win32_symbol_paths_name);
 #endif
+
+	blog(LOG_INFO, "Loaded %zu modules in %.1f ms, %zu deferred", jobs.jobs.num,
+	     (double)(os_gettime_ns() - start) / 1000000.0, obs->deferred_module_count);
+
+	da_free(jobs.jobs);
+}
+
+void obs_load_all_modules(void)
+{
+	profile_start(obs_load_all_modules_name);
+	load_all_modules(NULL);
 	profile_end(obs_load_all_modules_name);
 }
 
@@ -581,12 +838,7 @@ void obs_load_all_modules2(struct obs_module_failure_info *mfi)
 	memset(mfi, 0, sizeof(*mfi));
 
 	profile_start(obs_load_all_modules2_name);
-	obs_find_modules2(load_all_callback, &fail_info);
-#ifdef _WIN32
-	profile_start(reset_win32_symbol_paths_name);
-	reset_win32_symbol_paths();
-	profile_end(reset_win32_symbol_paths_name);
-#endif
+	load_all_modules(&fail_info);
 	profile_end(obs_load_all_modules2_name);
 
 	mfi->count = fail_info.fail_count;
@@ -607,6 +859,150 @@ void obs_post_load_modules(void)
 	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next)
 		if (mod->post_load)
 			mod->post_load();
+
+	obs->modules_post_loaded = true;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Deferred modules */
+
+static enum obs_module_load_state init_deferred_module(obs_module_t *module, const char *type_id)
+{
+	uint64_t start = os_gettime_ns();
+
+	module->deferred = false;
+	obs->deferred_module_count--;
+
+	int code = open_module_binary(module, module->bin_path);
+	if (code != MODULE_SUCCESS) {
+		blog(LOG_WARNING, "Failed to open deferred module '%s'", module->file);
+		module->module = NULL;
+		return OBS_MODULE_FAILED_TO_OPEN;
+	}
+
+	init_module_locale(module);
+	module->open_time_ns = os_gettime_ns() - start;
+
+#ifdef _WIN32
+	reset_win32_symbol_paths();
+#endif
+
+	if (!obs_init_module(module))
+		return OBS_MODULE_FAILED_TO_INITIALIZE;
+
+	if (obs->modules_post_loaded && module->post_load)
+		module->post_load();
+
+	blog(LOG_INFO, "Loaded deferred module '%s'%s%s%s in %.1f ms", module->file, type_id ? " for '" : "",
+	     type_id ? type_id : "", type_id ? "'" : "", (double)(os_gettime_ns() - start) / 1000000.0);
+	return OBS_MODULE_ENABLED;
+}
+
+/* on failure the module is replaced by a disabled module, the same way a
+ * module that fails while loading all modules is, so the module pointer must
+ * not be used afterwards */
+static bool load_deferred_module(obs_module_t *module, const char *type_id)
+{
+	enum obs_module_load_state state = init_deferred_module(module, type_id);
+	if (state == OBS_MODULE_ENABLED)
+		return true;
+
+	obs_module_t *disabled_module;
+	char *bin_path = bstrdup(module->bin_path);
+	char *data_path = bstrdup(module->data_path);
+
+	free_module(module);
+	obs_create_disabled_module(&disabled_module, bin_path, data_path, state);
+
+	bfree(bin_path);
+	bfree(data_path);
+	return false;
+}
+
+static inline struct darray *get_module_types(obs_module_t *module, enum obs_module_type type)
+{
+	switch (type) {
+	case OBS_MODULE_TYPE_SOURCE:
+		return &module->sources.da;
+	case OBS_MODULE_TYPE_OUTPUT:
+		return &module->outputs.da;
+	case OBS_MODULE_TYPE_ENCODER:
+		return &module->encoders.da;
+	case OBS_MODULE_TYPE_SERVICE:
+		return &module->services.da;
+	}
+
+	return NULL;
+}
+
+static bool type_id_matches(const char *declared_id, const char *id, bool unversioned)
+{
+	if (strcmp(declared_id, id) == 0)
+		return true;
+	if (!unversioned)
+		return false;
+
+	/* versioned source ids are the unversioned id followed by _v<N> */
+	size_t len = strlen(id);
+	return strncmp(declared_id, id, len) == 0 && strncmp(declared_id + len, "_v", 2) == 0;
+}
+
+static inline bool can_load_deferred(void)
+{
+	/* modules are never loaded from within another module's load, and
+	 * only on the thread that loaded all other modules */
+	return obs && obs->deferred_module_count && !loadingModule &&
+	       pthread_equal(pthread_self(), obs->module_thread);
+}
+
+bool obs_module_load_deferred(enum obs_module_type type, const char *id, bool unversioned)
+{
+	if (!id || !can_load_deferred())
+		return false;
+
+	for (obs_module_t *mod = obs->first_module; !!mod; mod = mod->next) {
+		if (!mod->deferred)
+			continue;
+
+		struct darray *types = get_module_types(mod, type);
+		char **ids = types->array;
+
+		for (size_t i = 0; i < types->num; i++) {
+			if (type_id_matches(ids[i], id, unversioned))
+				return load_deferred_module(mod, id);
+		}
+	}
+
+	return false;
+}
+
+static void load_all_deferred(enum obs_module_type type, uint32_t source_types)
+{
+	if (!can_load_deferred())
+		return;
+
+	obs_module_t *next;
+
+	for (obs_module_t *mod = obs->first_module; !!mod; mod = next) {
+		next = mod->next;
+
+		if (!mod->deferred || !get_module_types(mod, type)->num)
+			continue;
+		if (type == OBS_MODULE_TYPE_SOURCE && (mod->declared_source_types & source_types) == 0)
+			continue;
+
+		load_deferred_module(mod, NULL);
+	}
+}
+
+void obs_module_load_all_deferred(enum obs_module_type type)
+{
+	load_all_deferred(type, UINT32_MAX);
+}
+
+void obs_module_load_deferred_sources(enum obs_source_type type)
+{
+	load_all_deferred(OBS_MODULE_TYPE_SOURCE, 1 << type);
 }
 
 static inline void make_data_dir(struct dstr *parsed_data_dir, const char *data_dir, const char *name)
@@ -817,34 +1213,7 @@ void free_module(struct obs_module *mod)
 			obs->first_disabled_module = mod->next;
 	}
 
-	bfree(mod->mod_name);
-	bfree(mod->bin_path);
-	bfree(mod->data_path);
-
-	for (size_t i = 0; i < mod->sources.num; i++) {
-		bfree(mod->sources.array[i]);
-	}
-	da_free(mod->sources);
-
-	for (size_t i = 0; i < mod->outputs.num; i++) {
-		bfree(mod->outputs.array[i]);
-	}
-	da_free(mod->outputs);
-
-	for (size_t i = 0; i < mod->encoders.num; i++) {
-		bfree(mod->encoders.array[i]);
-	}
-	da_free(mod->encoders);
-
-	for (size_t i = 0; i < mod->services.num; i++) {
-		bfree(mod->services.array[i]);
-	}
-	da_free(mod->services);
-
-	if (mod->metadata) {
-		free_module_metadata(mod->metadata);
-		bfree(mod->metadata);
-	}
+	free_module_info(mod);
 	bfree(mod);
 }
 
@@ -31,6 +31,14 @@
 #include <X11/XF86keysym.h>
 #include <X11/Sunkeysym.h>
 
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+
+/* xinput button numbers, 4 to 7 are the wheel axes */
+#define XINPUT_MOUSE_LEN 33
+
 void obs_nix_x11_log_info(void)
 {
 	Display *dpy = obs_get_nix_platform_display();
@@ -96,6 +104,12 @@ struct obs_hotkeys_platform {
 	bool pressed[XINPUT_MOUSE_LEN];
 	bool update[XINPUT_MOUSE_LEN];
 	bool button_pressed[XINPUT_MOUSE_LEN];
+
+	/* raw input events, only read by the hotkey thread */
+	xcb_connection_t *event_connection;
+	int wake_pipe[2];
+	obs_key_t keycode_keys[256];
+	bool keycode_down[256];
 #endif
 };
 
@@ -821,10 +835,23 @@ static inline xcb_window_t root_window(obs_hotkeys_platform_t *context, xcb_conn
 }
 
 #if defined(XCB_XINPUT_FOUND)
-static inline void registerMouseEvents(struct obs_core_hotkeys *hotkeys)
+static bool xinput2_available(xcb_connection_t *connection)
+{
+	const xcb_query_extension_reply_t *ext = xcb_get_extension_data(connection, &xcb_input_id);
+	xcb_input_xi_query_version_reply_t *reply;
+	bool available;
+
+	if (!ext || !ext->present)
+		return false;
+
+	reply = xcb_input_xi_query_version_reply(connection, xcb_input_xi_query_version(connection, 2, 2), NULL);
+	available = reply && reply->major_version >= 2;
+	free(reply);
+	return available;
+}
+
+static inline void select_raw_events(obs_hotkeys_platform_t *context, xcb_connection_t *connection, uint32_t events)
 {
-	obs_hotkeys_platform_t *context = hotkeys->platform_context;
-	xcb_connection_t *connection = XGetXCBConnection(context->display);
 	xcb_window_t window = root_window(context, connection);
 
 	struct {
@@ -833,11 +860,92 @@ static inline void registerMouseEvents(struct obs_core_hotkeys *hotkeys)
 	} mask;
 	mask.head.deviceid = XCB_INPUT_DEVICE_ALL_MASTER;
 	mask.head.mask_len = sizeof(mask.mask) / sizeof(uint32_t);
-	mask.mask = XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_PRESS | XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_RELEASE;
+	mask.mask = events;
 
 	xcb_input_xi_select_events(connection, window, 1, &mask.head);
 	xcb_flush(connection);
 }
+
+static inline void registerMouseEvents(struct obs_core_hotkeys *hotkeys)
+{
+	obs_hotkeys_platform_t *context = hotkeys->platform_context;
+	xcb_connection_t *connection = XGetXCBConnection(context->display);
+
+	if (!xinput2_available(connection))
+		return;
+
+	select_raw_events(context, connection,
+			  XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_PRESS | XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_RELEASE);
+}
+
+static const struct obs_hotkeys_events x11_hotkeys_events;
+
+/* Raw key and button events are read from a separate connection, so that
+ * requests made on the main one from other threads cannot take events off
+ * the socket while the hotkey thread waits for it. */
+static bool init_key_events(struct obs_core_hotkeys *hotkeys)
+{
+	obs_hotkeys_platform_t *context = hotkeys->platform_context;
+	xcb_connection_t *connection;
+
+	context->wake_pipe[0] = -1;
+	context->wake_pipe[1] = -1;
+
+	connection = xcb_connect(DisplayString(context->display), NULL);
+	if (xcb_connection_has_error(connection) || !xinput2_available(connection)) {
+		blog(LOG_INFO, "XInput2 not available, polling hotkeys");
+		xcb_disconnect(connection);
+		return false;
+	}
+
+	if (pipe(context->wake_pipe) != 0) {
+		blog(LOG_WARNING, "Failed to create hotkey wake pipe, polling hotkeys");
+		context->wake_pipe[0] = -1;
+		context->wake_pipe[1] = -1;
+		xcb_disconnect(connection);
+		return false;
+	}
+
+	for (size_t i = 0; i < 2; i++) {
+		fcntl(context->wake_pipe[i], F_SETFD, FD_CLOEXEC);
+		fcntl(context->wake_pipe[i], F_SETFL, O_NONBLOCK);
+	}
+
+	for (size_t i = 0; i < OBS_KEY_LAST_VALUE; i++) {
+		struct keycode_list *codes = &context->keycodes[i];
+
+		for (size_t j = 0; j < codes->list.num; j++)
+			context->keycode_keys[codes->list.array[j]] = (obs_key_t)i;
+	}
+	if (context->super_l_code)
+		context->keycode_keys[context->super_l_code] = OBS_KEY_META;
+	if (context->super_r_code)
+		context->keycode_keys[context->super_r_code] = OBS_KEY_META;
+
+	context->event_connection = connection;
+	select_raw_events(context, connection,
+			  XCB_INPUT_XI_EVENT_MASK_RAW_KEY_PRESS | XCB_INPUT_XI_EVENT_MASK_RAW_KEY_RELEASE |
+				  XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_PRESS |
+				  XCB_INPUT_XI_EVENT_MASK_RAW_BUTTON_RELEASE);
+
+	hotkeys->events = &x11_hotkeys_events;
+	return true;
+}
+
+static void free_key_events(struct obs_core_hotkeys *hotkeys)
+{
+	obs_hotkeys_platform_t *context = hotkeys->platform_context;
+
+	if (!context->event_connection)
+		return;
+
+	xcb_disconnect(context->event_connection);
+	close(context->wake_pipe[0]);
+	close(context->wake_pipe[1]);
+
+	context->event_connection = NULL;
+	hotkeys->events = NULL;
+}
 #endif
 
 static bool obs_nix_x11_hotkeys_platform_init(struct obs_core_hotkeys *hotkeys)
@@ -850,11 +958,12 @@ static bool obs_nix_x11_hotkeys_platform_init(struct obs_core_hotkeys *hotkeys)
 	hotkeys->platform_context = bzalloc(sizeof(obs_hotkeys_platform_t));
 	hotkeys->platform_context->display = display;
 
-#if defined(XCB_XINPUT_FOUND)
-	registerMouseEvents(hotkeys);
-#endif
 	fill_base_keysyms(hotkeys);
 	fill_keycodes(hotkeys);
+#if defined(XCB_XINPUT_FOUND)
+	if (!init_key_events(hotkeys))
+		registerMouseEvents(hotkeys);
+#endif
 	return true;
 }
 
@@ -864,6 +973,10 @@ static void obs_nix_x11_hotkeys_platform_free(struct obs_core_hotkeys *hotkeys)
 	if (!context)
 		return;
 
+#if defined(XCB_XINPUT_FOUND)
+	free_key_events(hotkeys);
+#endif
+
 	for (size_t i = 0; i < OBS_KEY_LAST_VALUE; i++)
 		da_free(context->keycodes[i].list);
 
@@ -1088,6 +1201,124 @@ static bool obs_nix_x11_hotkeys_platform_is_pressed(obs_hotkeys_platform_t *cont
 	}
 }
 
+#if defined(XCB_XINPUT_FOUND)
+static obs_key_t key_from_button(uint32_t button)
+{
+	// Mouse 2 for OBS is Right Click and Mouse 3 is Wheel Click.
+	// Mouse Wheel axis clicks (xinput button 4 5 6 7) are ignored.
+	switch (button) {
+	case 1:
+		return OBS_KEY_MOUSE1;
+	case 2:
+		return OBS_KEY_MOUSE3;
+	case 3:
+		return OBS_KEY_MOUSE2;
+	}
+
+	if (button >= 8 && button <= XINPUT_MOUSE_LEN)
+		return (obs_key_t)(OBS_KEY_MOUSE4 + (button - 8));
+	return OBS_KEY_NONE;
+}
+
+static void handle_raw_key(obs_hotkeys_platform_t *context, xcb_input_raw_key_press_event_t *ev, bool pressed)
+{
+	xcb_keycode_t code = (xcb_keycode_t)ev->detail;
+	obs_key_t key;
+
+	if (ev->detail > UINT8_MAX)
+		return;
+
+	key = context->keycode_keys[code];
+	if (key == OBS_KEY_NONE)
+		return;
+	if (pressed && (ev->flags & XCB_INPUT_KEY_EVENT_FLAGS_KEY_REPEAT) != 0)
+		return;
+
+	context->keycode_down[code] = pressed;
+
+	/* keys can have more than one key code, e.g. both shift keys */
+	if (!pressed) {
+		if (key == OBS_KEY_META) {
+			pressed = context->keycode_down[context->super_l_code] ||
+				  context->keycode_down[context->super_r_code];
+		} else {
+			struct keycode_list *codes = &context->keycodes[key];
+			for (size_t i = 0; i < codes->list.num && !pressed; i++)
+				pressed = context->keycode_down[codes->list.array[i]];
+		}
+	}
+
+	obs_hotkeys_key_event(key, pressed);
+}
+
+static void handle_raw_event(obs_hotkeys_platform_t *context, xcb_generic_event_t *ev)
+{
+	if ((ev->response_type & ~0x80) != XCB_GE_GENERIC)
+		return;
+
+	switch (((xcb_ge_event_t *)ev)->event_type) {
+	case XCB_INPUT_RAW_KEY_PRESS:
+		handle_raw_key(context, (xcb_input_raw_key_press_event_t *)ev, true);
+		break;
+	case XCB_INPUT_RAW_KEY_RELEASE:
+		handle_raw_key(context, (xcb_input_raw_key_press_event_t *)ev, false);
+		break;
+	case XCB_INPUT_RAW_BUTTON_PRESS:
+	case XCB_INPUT_RAW_BUTTON_RELEASE: {
+		xcb_input_raw_button_press_event_t *button = (xcb_input_raw_button_press_event_t *)ev;
+		bool pressed = button->event_type == XCB_INPUT_RAW_BUTTON_PRESS;
+
+		obs_hotkeys_key_event(key_from_button(button->detail), pressed);
+		break;
+	}
+	default:
+		break;
+	}
+}
+
+static bool obs_nix_x11_hotkeys_wait(obs_hotkeys_platform_t *context)
+{
+	xcb_connection_t *connection = context->event_connection;
+	xcb_generic_event_t *ev;
+	char buf[64];
+
+	while ((ev = xcb_poll_for_event(connection))) {
+		handle_raw_event(context, ev);
+		free(ev);
+	}
+
+	if (xcb_connection_has_error(connection))
+		return false;
+
+	struct pollfd fds[2] = {
+		{.fd = xcb_get_file_descriptor(connection), .events = POLLIN},
+		{.fd = context->wake_pipe[0], .events = POLLIN},
+	};
+
+	if (poll(fds, 2, -1) < 0 && errno != EINTR)
+		return false;
+
+	if (fds[1].revents & POLLIN) {
+		while (read(context->wake_pipe[0], buf, sizeof(buf)) > 0)
+			;
+	}
+
+	return true;
+}
+
+static void obs_nix_x11_hotkeys_wake(obs_hotkeys_platform_t *context)
+{
+	char c = 0;
+	if (write(context->wake_pipe[1], &c, 1) < 0)
+		blog(LOG_WARNING, "Failed to wake hotkey thread");
+}
+
+static const struct obs_hotkeys_events x11_hotkeys_events = {
+	.wait = obs_nix_x11_hotkeys_wait,
+	.wake = obs_nix_x11_hotkeys_wake,
+};
+#endif
+
 static bool get_key_translation(struct dstr *dstr, xcb_keycode_t keycode)
 {
 	xcb_connection_t *connection;
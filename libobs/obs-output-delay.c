@@ -43,19 +43,340 @@ static inline bool log_flag_encoded(const struct obs_output *output, const char
 	return ret;
 }
 
+/* ------------------------------------------------------------------------- */
+/* payload storage
+ *
+ * Without a memory limit, delayed packets are kept on the heap as regular
+ * reference counted packets.  With a limit, payloads are copied into an
+ * arena of fixed-size segments instead of one heap allocation per packet,
+ * up to the limit; past it, payloads spill to a file if a spill directory
+ * was set, and are otherwise kept on the heap. */
+
+#define DELAY_SEGMENT_SIZE (1024 * 1024)
+
+/* returns false if there is no room for `size` without growing the ring */
+static bool delay_ring_alloc(struct delay_ring *ring, uint64_t size, uint64_t *offset)
+{
+	if (!ring->count) {
+		ring->head = 0;
+		ring->tail = 0;
+		ring->wrap_end = 0;
+	}
+
+	if (ring->wrap_end) {
+		if (ring->head + size > ring->tail)
+			return false;
+
+	} else if (ring->head + size > ring->capacity) {
+		/* wrap around once enough space was freed at the start */
+		if (!ring->count || size > ring->tail)
+			return false;
+
+		ring->wrap_end = ring->head;
+		ring->head = 0;
+	}
+
+	*offset = ring->head;
+	ring->head += size;
+	ring->used += size;
+	ring->count++;
+	return true;
+}
+
+/* frees the oldest allocation of the ring */
+static void delay_ring_free(struct delay_ring *ring, uint64_t offset, uint64_t size)
+{
+	ring->used -= size;
+	ring->count--;
+	ring->tail = offset + size;
+
+	if (ring->wrap_end && ring->tail == ring->wrap_end) {
+		ring->tail = 0;
+		ring->wrap_end = 0;
+	}
+}
+
+/* undoes the newest allocation of the ring */
+static void delay_ring_unalloc(struct delay_ring *ring, uint64_t offset, uint64_t size)
+{
+	ring->used -= size;
+	ring->count--;
+	ring->head = offset;
+
+	if (ring->wrap_end && !ring->head) {
+		ring->head = ring->wrap_end;
+		ring->wrap_end = 0;
+	}
+}
+
+static inline size_t delay_arena_segment_count(const struct delay_arena *arena)
+{
+	return arena->segments.size / sizeof(uint8_t *);
+}
+
+static bool store_in_arena(struct obs_output *output, const struct encoder_packet *packet)
+{
+	struct delay_arena *arena = &output->delay_arena;
+	size_t segments = delay_arena_segment_count(arena);
+	size_t free_size = segments ? DELAY_SEGMENT_SIZE - arena->write_pos : 0;
+	const uint8_t *data = packet->data;
+	size_t size = packet->size;
+
+	if (size > free_size) {
+		size_t new_segments = (size - free_size + DELAY_SEGMENT_SIZE - 1) / DELAY_SEGMENT_SIZE;
+		if ((uint64_t)(segments + new_segments) * DELAY_SEGMENT_SIZE > output->delay_memory_limit)
+			return false;
+	}
+
+	while (size) {
+		uint8_t *segment;
+		size_t copy_size;
+
+		if (!delay_arena_segment_count(arena) || arena->write_pos == DELAY_SEGMENT_SIZE) {
+			segment = arena->spare ? arena->spare : bmalloc(DELAY_SEGMENT_SIZE);
+			arena->spare = NULL;
+			arena->write_pos = 0;
+			deque_push_back(&arena->segments, &segment, sizeof(segment));
+		} else {
+			deque_peek_back(&arena->segments, &segment, sizeof(segment));
+		}
+
+		copy_size = DELAY_SEGMENT_SIZE - arena->write_pos;
+		if (copy_size > size)
+			copy_size = size;
+
+		memcpy(segment + arena->write_pos, data, copy_size);
+		arena->write_pos += copy_size;
+		data += copy_size;
+		size -= copy_size;
+	}
+
+	arena->used += packet->size;
+	return true;
+}
+
+static void release_segment(struct delay_arena *arena)
+{
+	uint8_t *segment;
+
+	deque_pop_front(&arena->segments, &segment, sizeof(segment));
+	if (arena->spare)
+		bfree(segment);
+	else
+		arena->spare = segment;
+}
+
+/* consumes the oldest payload of the arena, copying it to `data` if set */
+static void read_from_arena(struct delay_arena *arena, uint8_t *data, size_t size)
+{
+	arena->used -= size;
+
+	while (size) {
+		uint8_t *segment;
+		size_t copy_size = DELAY_SEGMENT_SIZE - arena->read_pos;
+
+		if (copy_size > size)
+			copy_size = size;
+
+		if (data) {
+			deque_peek_front(&arena->segments, &segment, sizeof(segment));
+			memcpy(data, segment + arena->read_pos, copy_size);
+			data += copy_size;
+		}
+
+		arena->read_pos += copy_size;
+		size -= copy_size;
+
+		if (arena->read_pos == DELAY_SEGMENT_SIZE) {
+			release_segment(arena);
+			arena->read_pos = 0;
+		}
+	}
+
+	if (!arena->used) {
+		while (delay_arena_segment_count(arena))
+			release_segment(arena);
+		arena->read_pos = 0;
+		arena->write_pos = 0;
+	}
+}
+
+static bool open_spill_file(struct obs_output *output)
+{
+	struct dstr path = {0};
+
+	if (output->delay_spill_file)
+		return true;
+	if (output->delay_spill_failed || !output->delay_spill_dir || !*output->delay_spill_dir)
+		return false;
+
+	os_mkdirs(output->delay_spill_dir);
+	dstr_printf(&path, "%s/obs-output-delay-%p.tmp", output->delay_spill_dir, (void *)output);
+
+	output->delay_spill_file = os_fopen(path.array, "w+b");
+	if (!output->delay_spill_file) {
+		blog(LOG_WARNING, "Output '%s': Failed to create delay spill file '%s'", output->context.name,
+		     path.array);
+		output->delay_spill_failed = true;
+		dstr_free(&path);
+		return false;
+	}
+
+	blog(LOG_INFO, "Output '%s': Delay buffer memory limit reached, spilling to '%s'", output->context.name,
+	     path.array);
+	output->delay_spill_file_path = path.array;
+	return true;
+}
+
+static bool store_in_spill_file(struct obs_output *output, struct delay_data *dd, const struct encoder_packet *packet)
+{
+	struct delay_ring *ring = &output->delay_spill_ring;
+
+	if (!open_spill_file(output))
+		return false;
+
+	if (!delay_ring_alloc(ring, packet->size, &dd->offset)) {
+		/* the file simply grows while its data is contiguous */
+		if (ring->wrap_end)
+			return false;
+
+		ring->capacity = ring->head + packet->size;
+		delay_ring_alloc(ring, packet->size, &dd->offset);
+	}
+
+	if (os_fseeki64(output->delay_spill_file, (int64_t)dd->offset, SEEK_SET) != 0 ||
+	    fwrite(packet->data, 1, packet->size, output->delay_spill_file) != packet->size) {
+		blog(LOG_WARNING, "Output '%s': Failed to write to delay spill file, keeping packets in memory",
+		     output->context.name);
+		delay_ring_unalloc(ring, dd->offset, packet->size);
+		output->delay_spill_failed = true;
+		return false;
+	}
+
+	dd->storage = DELAY_STORAGE_SPILL;
+	return true;
+}
+
+static void store_payload(struct obs_output *output, struct delay_data *dd, struct encoder_packet *packet)
+{
+	if (packet->size && output->delay_memory_limit) {
+		if (store_in_arena(output, packet)) {
+			dd->storage = DELAY_STORAGE_ARENA;
+			return;
+		}
+		if (store_in_spill_file(output, dd, packet))
+			return;
+
+		if (!output->delay_limit_warned) {
+			blog(LOG_WARNING,
+			     "Output '%s': Delay buffer memory limit of %" PRIu64 " bytes reached, "
+			     "keeping packets in memory",
+			     output->context.name, output->delay_memory_limit);
+			output->delay_limit_warned = true;
+		}
+	}
+
+	obs_encoder_packet_create_instance(&dd->packet, packet);
+	dd->storage = DELAY_STORAGE_HEAP;
+	output->delay_heap_bytes += packet->size;
+}
+
+/* turns a popped packet back into a regular reference counted packet */
+static bool load_payload(struct obs_output *output, struct delay_data *dd)
+{
+	size_t size = dd->packet.size;
+	bool success = true;
+	long *p_refs;
+
+	if (dd->storage == DELAY_STORAGE_HEAP) {
+		output->delay_heap_bytes -= size;
+		return true;
+	}
+
+	p_refs = bmalloc(size + sizeof(long));
+	*p_refs = 1;
+
+	if (dd->storage == DELAY_STORAGE_ARENA) {
+		read_from_arena(&output->delay_arena, (uint8_t *)(p_refs + 1), size);
+
+	} else {
+		success = os_fseeki64(output->delay_spill_file, (int64_t)dd->offset, SEEK_SET) == 0 &&
+			  fread(p_refs + 1, 1, size, output->delay_spill_file) == size;
+		delay_ring_free(&output->delay_spill_ring, dd->offset, size);
+
+		if (!success) {
+			blog(LOG_ERROR, "Output '%s': Failed to read from delay spill file, dropping packet",
+			     output->context.name);
+			bfree(p_refs);
+			return false;
+		}
+	}
+
+	dd->packet.data = (uint8_t *)(p_refs + 1);
+	dd->storage = DELAY_STORAGE_HEAP;
+	return true;
+}
+
+static void discard_payload(struct obs_output *output, struct delay_data *dd)
+{
+	switch (dd->storage) {
+	case DELAY_STORAGE_HEAP:
+		output->delay_heap_bytes -= dd->packet.size;
+		obs_encoder_packet_release(&dd->packet);
+		break;
+	case DELAY_STORAGE_ARENA:
+		read_from_arena(&output->delay_arena, NULL, dd->packet.size);
+		break;
+	case DELAY_STORAGE_SPILL:
+		delay_ring_free(&output->delay_spill_ring, dd->offset, dd->packet.size);
+		break;
+	}
+}
+
+static void free_delay_storage(struct obs_output *output)
+{
+	struct delay_arena *arena = &output->delay_arena;
+
+	while (delay_arena_segment_count(arena)) {
+		uint8_t *segment;
+		deque_pop_front(&arena->segments, &segment, sizeof(segment));
+		bfree(segment);
+	}
+	deque_free(&arena->segments);
+	bfree(arena->spare);
+	memset(arena, 0, sizeof(*arena));
+
+	if (output->delay_spill_file) {
+		fclose(output->delay_spill_file);
+		os_unlink(output->delay_spill_file_path);
+		output->delay_spill_file = NULL;
+	}
+	bfree(output->delay_spill_file_path);
+	output->delay_spill_file_path = NULL;
+	memset(&output->delay_spill_ring, 0, sizeof(output->delay_spill_ring));
+
+	output->delay_heap_bytes = 0;
+	output->delay_spill_failed = false;
+	output->delay_limit_warned = false;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static inline void push_packet(struct obs_output *output, struct encoder_packet *packet,
 			       struct encoder_packet_time *packet_time, uint64_t t)
 {
-	struct delay_data dd;
+	struct delay_data dd = {0};
 
 	dd.msg = DELAY_MSG_PACKET;
 	dd.ts = t;
 	dd.packet_time_valid = packet_time != NULL;
 	if (packet_time != NULL)
 		dd.packet_time = *packet_time;
-	obs_encoder_packet_create_instance(&dd.packet, packet);
+	dd.packet = *packet;
+	dd.packet.data = NULL;
 
 	pthread_mutex_lock(&output->delay_mutex);
+	store_payload(output, &dd, packet);
 	deque_push_back(&output->delay_data, &dd, sizeof(dd));
 	pthread_mutex_unlock(&output->delay_mutex);
 }
@@ -85,10 +406,12 @@ void obs_output_cleanup_delay(obs_output_t *output)
 	while (output->delay_data.size) {
 		deque_pop_front(&output->delay_data, &dd, sizeof(dd));
 		if (dd.msg == DELAY_MSG_PACKET) {
-			obs_encoder_packet_release(&dd.packet);
+			discard_payload(output, &dd);
 		}
 	}
 
+	free_delay_storage(output);
+
 	output->active_delay_ns = 0;
 	os_atomic_set_long(&output->delay_restart_refs, 0);
 }
@@ -98,6 +421,7 @@ static inline bool pop_packet(struct obs_output *output, uint64_t t)
 	uint64_t elapsed_time;
 	struct delay_data dd;
 	bool popped = false;
+	bool loaded = true;
 	bool preserve;
 
 	/* ------------------------------------------------ */
@@ -115,6 +439,8 @@ static inline bool pop_packet(struct obs_output *output, uint64_t t)
 
 		} else if (elapsed_time > output->active_delay_ns) {
 			deque_pop_front(&output->delay_data, NULL, sizeof(dd));
+			if (dd.msg == DELAY_MSG_PACKET)
+				loaded = load_payload(output, &dd);
 			popped = true;
 		}
 	}
@@ -123,7 +449,7 @@ static inline bool pop_packet(struct obs_output *output, uint64_t t)
 
 	/* ------------------------------------------------ */
 
-	if (popped)
+	if (popped && loaded)
 		process_delay_data(output, &dd);
 
 	return popped;
@@ -207,3 +533,41 @@ uint32_t obs_output_get_active_delay(const obs_output_t *output)
 	return obs_output_valid(output, "obs_output_set_delay") ? (uint32_t)(output->active_delay_ns / 1000000000ULL)
 								: 0;
 }
+
+void obs_output_set_delay_memory_limit(obs_output_t *output, uint64_t max_bytes)
+{
+	if (!obs_output_valid(output, "obs_output_set_delay_memory_limit"))
+		return;
+
+	pthread_mutex_lock(&output->delay_mutex);
+	output->delay_memory_limit = max_bytes;
+	pthread_mutex_unlock(&output->delay_mutex);
+}
+
+void obs_output_set_delay_spill_path(obs_output_t *output, const char *path)
+{
+	if (!obs_output_valid(output, "obs_output_set_delay_spill_path"))
+		return;
+
+	pthread_mutex_lock(&output->delay_mutex);
+	bfree(output->delay_spill_dir);
+	output->delay_spill_dir = bstrdup(path);
+	pthread_mutex_unlock(&output->delay_mutex);
+}
+
+void obs_output_get_delay_stats(obs_output_t *output, struct obs_output_delay_stats *stats)
+{
+	size_t segments;
+
+	memset(stats, 0, sizeof(*stats));
+
+	if (!obs_output_valid(output, "obs_output_get_delay_stats"))
+		return;
+
+	pthread_mutex_lock(&output->delay_mutex);
+	segments = delay_arena_segment_count(&output->delay_arena) + (output->delay_arena.spare ? 1 : 0);
+	stats->buffered_bytes = output->delay_arena.used + output->delay_spill_ring.used + output->delay_heap_bytes;
+	stats->spilled_bytes = output->delay_spill_ring.used;
+	stats->memory_bytes = (uint64_t)segments * DELAY_SEGMENT_SIZE + output->delay_heap_bytes;
+	pthread_mutex_unlock(&output->delay_mutex);
+}
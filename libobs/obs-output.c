@@ -126,6 +126,9 @@ const struct obs_output_info *find_output(const char *id)
 		if (strcmp(obs->output_types.array[i].id, id) == 0)
 			return obs->output_types.array + i;
 
+	if (obs_module_load_deferred(OBS_MODULE_TYPE_OUTPUT, id, false))
+		return find_output(id);
+
 	return NULL;
 }
 
@@ -204,6 +207,7 @@ obs_output_t *obs_output_create(const char *id, const char *name, obs_data_t *se
 	pthread_mutex_init_value(&output->delay_mutex);
 	pthread_mutex_init_value(&output->pause.mutex);
 	pthread_mutex_init_value(&output->pkt_callbacks_mutex);
+	pthread_mutex_init_value(&output->latency_mutex);
 
 	if (pthread_mutex_init(&output->interleaved_mutex, NULL) != 0)
 		goto fail;
@@ -213,6 +217,8 @@ obs_output_t *obs_output_create(const char *id, const char *name, obs_data_t *se
 		goto fail;
 	if (pthread_mutex_init(&output->pkt_callbacks_mutex, NULL) != 0)
 		goto fail;
+	if (pthread_mutex_init(&output->latency_mutex, NULL) != 0)
+		goto fail;
 	if (os_event_init(&output->stopping_event, OS_EVENT_TYPE_MANUAL) != 0)
 		goto fail;
 	if (!init_output_handlers(output, name, settings, hotkey_data))
@@ -260,11 +266,28 @@ fail:
 	return NULL;
 }
 
+static inline void push_interleaved_packet(struct obs_output *output, const struct encoder_packet *packet)
+{
+	interleaver_push(&output->interleaved_packets, packet);
+	obs_context_memory_add(&output->context, packet->size);
+}
+
+static inline bool pop_interleaved_packet(struct obs_output *output, struct encoder_packet *packet)
+{
+	if (!interleaver_pop(&output->interleaved_packets, packet))
+		return false;
+
+	obs_context_memory_remove(&output->context, packet->size);
+	return true;
+}
+
 static inline void free_packets(struct obs_output *output)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++)
-		obs_encoder_packet_release(output->interleaved_packets.array + i);
-	da_free(output->interleaved_packets);
+	struct encoder_packet packet;
+
+	while (pop_interleaved_packet(output, &packet))
+		obs_encoder_packet_release(&packet);
+	interleaver_free(&output->interleaved_packets);
 }
 
 static inline void clear_raw_audio_buffers(obs_output_t *output)
@@ -332,6 +355,7 @@ void obs_output_destroy(obs_output_t *output)
 			da_free(output->encoder_packet_times[i]);
 
 		da_free(output->pkt_callbacks);
+		da_free(output->latency_pending_sends);
 
 		clear_raw_audio_buffers(output);
 
@@ -340,9 +364,12 @@ void obs_output_destroy(obs_output_t *output)
 		pthread_mutex_destroy(&output->interleaved_mutex);
 		pthread_mutex_destroy(&output->delay_mutex);
 		pthread_mutex_destroy(&output->pkt_callbacks_mutex);
+		pthread_mutex_destroy(&output->latency_mutex);
 		os_event_destroy(output->reconnect_stop_event);
 		obs_context_data_free(&output->context);
+		obs_output_cleanup_delay(output);
 		deque_free(&output->delay_data);
+		bfree(output->delay_spill_dir);
 		if (output->owns_info_id)
 			bfree((void *)output->info.id);
 		if (output->last_error_message)
@@ -421,6 +448,25 @@ static inline bool data_active(struct obs_output *output)
 	return os_atomic_load_bool(&output->data_active);
 }
 
+static void log_latency(struct obs_output *output)
+{
+	static const char *stage_names[OBS_LATENCY_STAGE_COUNT] = {
+		"render", "output", "encoder queue", "encode", "interleave", "send", "total",
+	};
+
+	for (size_t i = 0; i < OBS_LATENCY_STAGE_COUNT; i++) {
+		struct obs_latency_stats stats;
+		if (!obs_output_get_latency(output, (enum obs_latency_stage)i, &stats))
+			continue;
+
+		blog(LOG_INFO,
+		     "Output '%s': Video latency (%s): "
+		     "median %.2f ms, 99th percentile %.2f ms, max %.2f ms",
+		     output->context.name, stage_names[i], (double)stats.p50_ns / 1000000.0,
+		     (double)stats.p99_ns / 1000000.0, (double)stats.max_ns / 1000000.0);
+	}
+}
+
 static void log_frame_info(struct obs_output *output)
 {
 	struct obs_core_video *video = &obs->video;
@@ -465,6 +511,8 @@ static void log_frame_info(struct obs_output *output)
 		     "to insufficient bandwidth/connection stalls: "
 		     "%d (%0.1f%%)",
 		     output->context.name, dropped, percentage_dropped);
+
+	log_latency(output);
 }
 
 static inline void signal_stop(struct obs_output *output);
@@ -1678,13 +1726,163 @@ static bool add_caption(struct obs_output *output, struct encoder_packet *out)
 	return avc || hevc || av1;
 }
 
+/* ------------------------------------------------------------------------- */
+/* Video latency */
+
+static size_t latency_bucket(uint64_t ns)
+{
+	uint64_t usec = ns / 1000;
+	if (usec < 16)
+		return (size_t)usec;
+
+	size_t exp = 4;
+	while (usec >> (exp + 1))
+		exp++;
+
+	size_t bucket = 16 + (exp - 4) * 4 + ((usec >> (exp - 2)) & 3);
+	return bucket < LATENCY_BUCKETS ? bucket : LATENCY_BUCKETS - 1;
+}
+
+/* middle of the bucket, in nanoseconds */
+static uint64_t latency_bucket_value(size_t bucket)
+{
+	if (bucket < 16)
+		return bucket * 1000 + 500;
+
+	size_t exp = 4 + (bucket - 16) / 4;
+	uint64_t width = 1ULL << (exp - 2);
+	uint64_t lower = (4 + (bucket - 16) % 4) * width;
+	return (lower * 2 + width) * 500;
+}
+
+static void add_latency(struct obs_output *output, enum obs_latency_stage stage, uint64_t start, uint64_t end)
+{
+	if (!start || !end || end < start)
+		return;
+
+	struct latency_histogram *histogram = &output->latency[stage];
+	uint64_t ns = end - start;
+
+	histogram->buckets[latency_bucket(ns)]++;
+	histogram->count++;
+	if (ns > histogram->max_ns)
+		histogram->max_ns = ns;
+}
+
+static void reset_latency(struct obs_output *output)
+{
+	pthread_mutex_lock(&output->latency_mutex);
+	memset(output->latency, 0, sizeof(output->latency));
+	da_clear(output->latency_pending_sends);
+	pthread_mutex_unlock(&output->latency_mutex);
+}
+
+static void add_packet_latency(struct obs_output *output, const struct encoder_packet *packet,
+			       const struct encoder_packet_time *packet_time)
+{
+	uint64_t pir = os_gettime_ns();
+
+	pthread_mutex_lock(&output->latency_mutex);
+
+	add_latency(output, OBS_LATENCY_RENDER, packet_time->cts, packet_time->rendered);
+	add_latency(output, OBS_LATENCY_OUTPUT, packet_time->rendered, packet_time->queued);
+	add_latency(output, OBS_LATENCY_ENCODER_QUEUE, packet_time->queued, packet_time->fer);
+	add_latency(output, OBS_LATENCY_ENCODE, packet_time->fer, packet_time->ferc);
+	add_latency(output, OBS_LATENCY_INTERLEAVE, packet_time->ferc, pir);
+
+	if (os_atomic_load_bool(&output->latency_reports_sends)) {
+		struct latency_pending_send pending = {packet->track_idx, packet->pts, packet_time->cts, pir};
+
+		/* packets may be dropped by the output without being sent */
+		if (output->latency_pending_sends.num == LATENCY_MAX_PENDING_SENDS)
+			da_erase(output->latency_pending_sends, 0);
+		da_push_back(output->latency_pending_sends, &pending);
+	} else {
+		add_latency(output, OBS_LATENCY_TOTAL, packet_time->cts, pir);
+	}
+
+	pthread_mutex_unlock(&output->latency_mutex);
+}
+
+void obs_output_packet_sent(obs_output_t *output, const struct encoder_packet *packet)
+{
+	if (!obs_output_valid(output, "obs_output_packet_sent"))
+		return;
+	if (!obs_ptr_valid(packet, "obs_output_packet_sent"))
+		return;
+	if (packet->type != OBS_ENCODER_VIDEO)
+		return;
+
+	uint64_t sent = os_gettime_ns();
+
+	pthread_mutex_lock(&output->latency_mutex);
+	os_atomic_set_bool(&output->latency_reports_sends, true);
+
+	for (size_t i = 0; i < output->latency_pending_sends.num; i++) {
+		struct latency_pending_send *pending = &output->latency_pending_sends.array[i];
+
+		if (pending->track_idx == packet->track_idx && pending->pts == packet->pts) {
+			add_latency(output, OBS_LATENCY_SEND, pending->pir, sent);
+			add_latency(output, OBS_LATENCY_TOTAL, pending->cts, sent);
+
+			/* earlier packets were dropped */
+			da_erase_range(output->latency_pending_sends, 0, i + 1);
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&output->latency_mutex);
+}
+
+static uint64_t latency_percentile(const struct latency_histogram *histogram, uint64_t percent)
+{
+	uint64_t target = (histogram->count * percent + 99) / 100;
+	uint64_t total = 0;
+
+	for (size_t i = 0; i < LATENCY_BUCKETS; i++) {
+		total += histogram->buckets[i];
+		if (total >= target) {
+			uint64_t value = latency_bucket_value(i);
+			return value < histogram->max_ns ? value : histogram->max_ns;
+		}
+	}
+
+	return histogram->max_ns;
+}
+
+bool obs_output_get_latency(const obs_output_t *output, enum obs_latency_stage stage, struct obs_latency_stats *stats)
+{
+	if (!obs_output_valid(output, "obs_output_get_latency"))
+		return false;
+	if (!obs_ptr_valid(stats, "obs_output_get_latency"))
+		return false;
+	if ((size_t)stage >= OBS_LATENCY_STAGE_COUNT)
+		return false;
+
+	struct obs_output *out = (struct obs_output *)output;
+
+	pthread_mutex_lock(&out->latency_mutex);
+
+	const struct latency_histogram *histogram = &out->latency[stage];
+	stats->count = histogram->count;
+	stats->p50_ns = latency_percentile(histogram, 50);
+	stats->p99_ns = latency_percentile(histogram, 99);
+	stats->max_ns = histogram->max_ns;
+
+	pthread_mutex_unlock(&out->latency_mutex);
+
+	return stats->count > 0;
+}
+
+/* ------------------------------------------------------------------------- */
+
 static inline void send_interleaved(struct obs_output *output)
 {
-	struct encoder_packet out = output->interleaved_packets.array[0];
+	struct encoder_packet out;
 	struct encoder_packet_time ept_local = {0};
 	bool found_ept = false;
 
-	da_erase(output->interleaved_packets, 0);
+	pop_interleaved_packet(output, &out);
 
 	if (out.type == OBS_ENCODER_VIDEO) {
 		output->total_frames++;
@@ -1753,6 +1951,9 @@ static inline void send_interleaved(struct obs_output *output)
 	}
 	pthread_mutex_unlock(&output->pkt_callbacks_mutex);
 
+	if (found_ept)
+		add_packet_latency(output, &out, &ept_local);
+
 	output->info.encoded_packet(output->context.data, &out);
 	obs_encoder_packet_release(&out);
 }
@@ -1777,11 +1978,12 @@ static size_t get_interleaved_start_idx(struct obs_output *output)
 {
 	int64_t closest_diff = 0x7FFFFFFFFFFFFFFFLL;
 	struct encoder_packet *first_video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
+	struct interleaver_cursor cursor = {0};
+	struct encoder_packet *packet;
 	size_t video_idx = DARRAY_INVALID;
 	size_t idx = 0;
 
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	for (size_t i = 0; (packet = interleaver_next(&output->interleaved_packets, &cursor)) != NULL; i++) {
 		int64_t diff;
 
 		if (packet->type != OBS_ENCODER_AUDIO) {
@@ -1801,11 +2003,13 @@ static size_t get_interleaved_start_idx(struct obs_output *output)
 
 	/* Early AAC/Opus audio packets will be for "priming" the encoder and contain silence, but they should not be
 	 * discarded. Set the idx to the first audio packet if closest PTS was <= 0. */
-	size_t first_audio_idx = idx;
-	while (output->interleaved_packets.array[first_audio_idx].type != OBS_ENCODER_AUDIO)
-		first_audio_idx++;
+	memset(&cursor, 0, sizeof(cursor));
+	for (size_t i = 0; (packet = interleaver_next(&output->interleaved_packets, &cursor)) != NULL; i++) {
+		if (i >= idx && packet->type == OBS_ENCODER_AUDIO)
+			break;
+	}
 
-	if (output->interleaved_packets.array[first_audio_idx].pts <= 0) {
+	if (packet && packet->pts <= 0) {
 		for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
 			int audio_idx = find_first_packet_type_idx(output, OBS_ENCODER_AUDIO, i);
 			if (audio_idx >= 0 && (size_t)audio_idx < idx)
@@ -1836,7 +2040,7 @@ static int prune_premature_packets(struct obs_output *output)
 		return -1;
 
 	max_idx = video_idx;
-	video = &output->interleaved_packets.array[video_idx];
+	video = find_first_packet_type(output, OBS_ENCODER_VIDEO, 0);
 	duration_usec = video->timebase_num * 1000000LL / video->timebase_den;
 
 	for (size_t i = 0; i < MAX_OUTPUT_AUDIO_ENCODERS; i++) {
@@ -1854,7 +2058,7 @@ static int prune_premature_packets(struct obs_output *output)
 			return -1;
 		}
 
-		audio = &output->interleaved_packets.array[audio_idx];
+		audio = find_first_packet_type(output, OBS_ENCODER_AUDIO, i);
 		if (audio_idx > max_idx)
 			max_idx = audio_idx;
 
@@ -1882,21 +2086,25 @@ static int prune_premature_packets(struct obs_output *output)
 
 #define DEBUG_STARTING_PACKETS 0
 
-static void discard_to_idx(struct obs_output *output, size_t idx)
+static void discard_interleaved_packet(struct obs_output *output)
 {
-	for (size_t i = 0; i < idx; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	struct encoder_packet packet;
+
+	pop_interleaved_packet(output, &packet);
 #if DEBUG_STARTING_PACKETS == 1
-		blog(LOG_DEBUG, "discarding %s packet, dts: %lld, pts: %lld",
-		     packet->type == OBS_ENCODER_VIDEO ? "video" : "audio", packet->dts, packet->pts);
+	blog(LOG_DEBUG, "discarding %s packet, dts: %lld, pts: %lld",
+	     packet.type == OBS_ENCODER_VIDEO ? "video" : "audio", packet.dts, packet.pts);
 #endif
-		if (packet->type == OBS_ENCODER_VIDEO) {
-			da_pop_front(output->encoder_packet_times[packet->track_idx]);
-		}
-		obs_encoder_packet_release(packet);
+	if (packet.type == OBS_ENCODER_VIDEO) {
+		da_pop_front(output->encoder_packet_times[packet.track_idx]);
 	}
+	obs_encoder_packet_release(&packet);
+}
 
-	da_erase_range(output->interleaved_packets, 0, idx);
+static void discard_to_idx(struct obs_output *output, size_t idx)
+{
+	for (size_t i = 0; i < idx; i++)
+		discard_interleaved_packet(output);
 }
 
 static bool prune_interleaved_packets(struct obs_output *output)
@@ -1906,8 +2114,9 @@ static bool prune_interleaved_packets(struct obs_output *output)
 
 #if DEBUG_STARTING_PACKETS == 1
 	blog(LOG_DEBUG, "--------- Pruning! %d ---------", prune_start);
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	struct interleaver_cursor cursor = {0};
+	struct encoder_packet *packet;
+	for (size_t i = 0; (packet = interleaver_next(&output->interleaved_packets, &cursor)) != NULL; i++) {
 		blog(LOG_DEBUG, "packet: %s %d, ts: %lld, pruned = %s",
 		     packet->type == OBS_ENCODER_AUDIO ? "audio" : "video", (int)packet->track_idx, packet->dts_usec,
 		     (int)i < prune_start ? "true" : "false");
@@ -1930,40 +2139,19 @@ static bool prune_interleaved_packets(struct obs_output *output)
 
 static int find_first_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
 {
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
-
-		if (packet->type == type && packet->track_idx == idx)
-			return (int)i;
-	}
-
-	return -1;
-}
-
-static int find_last_packet_type_idx(struct obs_output *output, enum obs_encoder_type type, size_t idx)
-{
-	for (size_t i = output->interleaved_packets.num; i > 0; i--) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i - 1];
-
-		if (packet->type == type && packet->track_idx == idx)
-			return (int)(i - 1);
-	}
-
-	return -1;
+	return interleaver_first_idx(&output->interleaved_packets, type, idx);
 }
 
 static inline struct encoder_packet *find_first_packet_type(struct obs_output *output, enum obs_encoder_type type,
 							    size_t audio_idx)
 {
-	int idx = find_first_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return interleaver_first(&output->interleaved_packets, type, audio_idx);
 }
 
 static inline struct encoder_packet *find_last_packet_type(struct obs_output *output, enum obs_encoder_type type,
 							   size_t audio_idx)
 {
-	int idx = find_last_packet_type_idx(output, type, audio_idx);
-	return (idx != -1) ? &output->interleaved_packets.array[idx] : NULL;
+	return interleaver_last(&output->interleaved_packets, type, audio_idx);
 }
 
 static bool get_audio_and_video_packets(struct obs_output *output, struct encoder_packet **video,
@@ -2061,68 +2249,26 @@ static bool initialize_interleaved_packets(struct obs_output *output)
 	/* subtract offsets from highest TS offset variables */
 	output->highest_audio_ts -= audio[first_audio_idx]->dts_usec;
 
-	/* apply new offsets to all existing packet DTS/PTS values */
-	for (size_t i = 0; i < output->interleaved_packets.num; i++) {
-		struct encoder_packet *packet = &output->interleaved_packets.array[i];
+	/* apply new offsets to all existing packet DTS/PTS values, keeping
+	 * the current order of audio packets that end up with equal DTS */
+	interleaver_resequence(&output->interleaved_packets);
+
+	struct interleaver_cursor cursor = {0};
+	struct encoder_packet *packet;
+	while ((packet = interleaver_next(&output->interleaved_packets, &cursor)) != NULL) {
 		apply_interleaved_packet_offset(output, packet, NULL);
+		set_higher_ts(output, packet);
 	}
 
 	return true;
 }
 
-static inline void insert_interleaved_packet(struct obs_output *output, struct encoder_packet *out)
-{
-	size_t idx;
-	for (idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *cur_packet;
-		cur_packet = output->interleaved_packets.array + idx;
-
-		// sort video packets with same DTS by track index,
-		// to prevent the pruning logic from removing additional
-		// video tracks
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
-		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
-			continue;
-
-		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
-			break;
-		} else if (out->dts_usec < cur_packet->dts_usec) {
-			break;
-		}
-	}
-
-	da_insert(output->interleaved_packets, idx, out);
-}
-
-static void resort_interleaved_packets(struct obs_output *output)
-{
-	DARRAY(struct encoder_packet) old_array;
-
-	old_array.da = output->interleaved_packets.da;
-	memset(&output->interleaved_packets, 0, sizeof(output->interleaved_packets));
-
-	for (size_t i = 0; i < old_array.num; i++) {
-		set_higher_ts(output, &old_array.array[i]);
-
-		insert_interleaved_packet(output, &old_array.array[i]);
-	}
-
-	da_free(old_array);
-}
-
 static void discard_unused_audio_packets(struct obs_output *output, int64_t dts_usec)
 {
-	size_t idx = 0;
-
-	for (; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *p = &output->interleaved_packets.array[idx];
+	struct encoder_packet *p;
 
-		if (p->dts_usec >= dts_usec)
-			break;
-	}
-
-	if (idx)
-		discard_to_idx(output, idx);
+	while ((p = interleaver_peek(&output->interleaved_packets)) != NULL && p->dts_usec < dts_usec)
+		discard_interleaved_packet(output);
 }
 
 static bool purge_encoder_group_keyframe_data(obs_output_t *output, size_t idx)
@@ -2201,13 +2347,15 @@ static void apply_ept_offsets(struct obs_output *output)
 	}
 }
 
-static inline size_t count_streamable_frames(struct obs_output *output)
+/* counts streamable packets, stopping at `max` as callers only need to know
+ * whether there are more than a few */
+static inline size_t count_streamable_frames(struct obs_output *output, size_t max)
 {
+	struct interleaver_cursor cursor = {0};
+	struct encoder_packet *pkt;
 	size_t eligible = 0;
 
-	for (size_t idx = 0; idx < output->interleaved_packets.num; idx++) {
-		struct encoder_packet *pkt = &output->interleaved_packets.array[idx];
-
+	while (eligible < max && (pkt = interleaver_next(&output->interleaved_packets, &cursor)) != NULL) {
 		/* Only count an interleaved packet as streamable if there are packets of the opposing type and of a
 		 * higher timestamp in the interleave buffer. This ensures that the timestamps are monotonic. */
 		if (!has_higher_opposing_ts(output, pkt))
@@ -2269,7 +2417,7 @@ static void interleave_packets(void *data, struct encoder_packet *packet, struct
 	else
 		check_received(output, packet);
 
-	insert_interleaved_packet(output, &out);
+	push_interleaved_packet(output, &out);
 
 	received_video = true;
 	for (size_t i = 0; i < MAX_OUTPUT_VIDEO_ENCODERS; i++) {
@@ -2283,7 +2431,6 @@ static void interleave_packets(void *data, struct encoder_packet *packet, struct
 		if (!was_started) {
 			if (prune_interleaved_packets(output)) {
 				if (initialize_interleaved_packets(output)) {
-					resort_interleaved_packets(output);
 					apply_ept_offsets(output);
 					send_interleaved(output);
 				}
@@ -2291,7 +2438,8 @@ static void interleave_packets(void *data, struct encoder_packet *packet, struct
 		} else {
 			set_higher_ts(output, &out);
 
-			size_t streamable = count_streamable_frames(output);
+			size_t streamable =
+				count_streamable_frames(output, output->interleaver_max_batch_size + 2);
 			if (streamable) {
 				send_interleaved(output);
 
@@ -2768,6 +2916,7 @@ bool obs_output_begin_data_capture(obs_output_t *output, uint32_t flags)
 		return false;
 
 	output->total_frames = 0;
+	reset_latency(output);
 
 	if (!flag_encoded(output))
 		reset_raw_output(output);
@@ -3108,6 +3257,18 @@ void *obs_output_get_type_data(obs_output_t *output)
 	return obs_output_valid(output, "obs_output_get_type_data") ? output->info.type_data : NULL;
 }
 
+void obs_output_memory_add(obs_output_t *output, size_t size)
+{
+	if (obs_output_valid(output, "obs_output_memory_add"))
+		obs_context_memory_add(&output->context, size);
+}
+
+void obs_output_memory_remove(obs_output_t *output, size_t size)
+{
+	if (obs_output_valid(output, "obs_output_memory_remove"))
+		obs_context_memory_remove(&output->context, size);
+}
+
 const char *obs_output_get_id(const obs_output_t *output)
 {
 	return obs_output_valid(output, "obs_output_get_id") ? output->info.id : NULL;
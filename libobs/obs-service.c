@@ -26,6 +26,9 @@ const struct obs_service_info *find_service(const char *id)
 		if (strcmp(obs->service_types.array[i].id, id) == 0)
 			return obs->service_types.array + i;
 
+	if (obs_module_load_deferred(OBS_MODULE_TYPE_SERVICE, id, false))
+		return find_service(id);
+
 	return NULL;
 }
 
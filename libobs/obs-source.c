@@ -58,6 +58,9 @@ struct obs_source_info *get_source_info(const char *id)
 			return info;
 	}
 
+	if (obs_module_load_deferred(OBS_MODULE_TYPE_SOURCE, id, false))
+		return get_source_info(id);
+
 	return NULL;
 }
 
@@ -69,6 +72,9 @@ struct obs_source_info *get_source_info2(const char *unversioned_id, uint32_t ve
 			return info;
 	}
 
+	if (obs_module_load_deferred(OBS_MODULE_TYPE_SOURCE, unversioned_id, true))
+		return get_source_info2(unversioned_id, ver);
+
 	return NULL;
 }
 
@@ -226,6 +232,7 @@ static bool obs_source_init(struct obs_source *source)
 	pthread_mutex_init_value(&source->audio_cb_mutex);
 	pthread_mutex_init_value(&source->caption_cb_mutex);
 	pthread_mutex_init_value(&source->media_actions_mutex);
+	pthread_mutex_init_value(&source->drop_mutex);
 
 	if (pthread_mutex_init_recursive(&source->filter_mutex) != 0)
 		return false;
@@ -243,6 +250,8 @@ static bool obs_source_init(struct obs_source *source)
 		return false;
 	if (pthread_mutex_init(&source->media_actions_mutex, NULL) != 0)
 		return false;
+	if (pthread_mutex_init(&source->drop_mutex, NULL) != 0)
+		return false;
 
 	if (is_audio_source(source) || is_composite_source(source))
 		allocate_audio_output_buffer(source);
@@ -368,9 +377,8 @@ static void obs_source_init_audio_hotkeys(struct obs_source *source)
 							      obs_source_hotkey_push_to_talk, source);
 }
 
-static obs_source_t *obs_source_create_internal(const char *id, const char *name, const char *uuid,
-						obs_data_t *settings, obs_data_t *hotkey_data, bool private,
-						uint32_t last_obs_ver, obs_canvas_t *canvas)
+obs_source_t *obs_source_create_prepare(const char *id, const char *name, const char *uuid, obs_data_t *settings,
+				       obs_data_t *hotkey_data, bool private, uint32_t last_obs_ver)
 {
 	struct obs_source *source = bzalloc(sizeof(struct obs_source));
 
@@ -412,23 +420,39 @@ static obs_source_t *obs_source_create_internal(const char *id, const char *name
 	if (!obs_source_init(source))
 		goto fail;
 
-	/* Scenes need canvases, fall back to using default canvas if none provided here. */
-	if (requires_canvas(source) && !canvas) {
-		blog(LOG_WARNING, "Attempted to add Scene without specifying a canvas! Using default canvas instead.");
-		canvas = obs->data.main_canvas;
-	}
-
 	if (!private)
 		obs_source_init_audio_hotkeys(source);
 
+	return source;
+
+fail:
+	blog(LOG_ERROR, "obs_source_create failed");
+	obs_source_destroy(source);
+	return NULL;
+}
+
+void obs_source_create_data(obs_source_t *source)
+{
+	const char *name = source->context.name;
+
 	/* allow the source to be created even if creation fails so that the
 	 * user's data doesn't become lost */
-	if (info && info->create)
-		source->context.data = info->create(source->context.settings, source);
-	if ((!info || info->create) && !source->context.data)
+	if (source->info.create)
+		source->context.data = source->info.create(source->context.settings, source);
+	if ((source->owns_info_id || source->info.create) && !source->context.data)
 		blog(LOG_ERROR, "Failed to create source '%s'!", name);
 
-	blog(LOG_DEBUG, "%ssource '%s' (%s) created", private ? "private " : "", name, id);
+	blog(LOG_DEBUG, "%ssource '%s' (%s) created", source->context.private ? "private " : "", name,
+	     source->info.id);
+}
+
+void obs_source_create_finish(obs_source_t *source, obs_canvas_t *canvas)
+{
+	/* Scenes need canvases, fall back to using default canvas if none provided here. */
+	if (requires_canvas(source) && !canvas) {
+		blog(LOG_WARNING, "Attempted to add Scene without specifying a canvas! Using default canvas instead.");
+		canvas = obs->data.main_canvas;
+	}
 
 	source->flags = source->default_flags;
 	source->enabled = true;
@@ -437,19 +461,26 @@ static obs_source_t *obs_source_create_internal(const char *id, const char *name
 	source->audio_is_duplicated = false;
 
 	obs_source_init_finalize(source, canvas);
-	if (!private) {
+	if (!source->context.private) {
 		if (canvas)
 			obs_source_dosignal_canvas(source, canvas, "source_create_canvas", NULL);
 		if (!canvas || canvas == obs->data.main_canvas)
 			obs_source_dosignal(source, "source_create", NULL);
 	}
+}
 
-	return source;
+static obs_source_t *obs_source_create_internal(const char *id, const char *name, const char *uuid,
+						obs_data_t *settings, obs_data_t *hotkey_data, bool private,
+						uint32_t last_obs_ver, obs_canvas_t *canvas)
+{
+	obs_source_t *source =
+		obs_source_create_prepare(id, name, uuid, settings, hotkey_data, private, last_obs_ver);
+	if (!source)
+		return NULL;
 
-fail:
-	blog(LOG_ERROR, "obs_source_create failed");
-	obs_source_destroy(source);
-	return NULL;
+	obs_source_create_data(source);
+	obs_source_create_finish(source, canvas);
+	return source;
 }
 
 obs_source_t *obs_source_create(const char *id, const char *name, obs_data_t *settings, obs_data_t *hotkey_data)
@@ -632,12 +663,35 @@ void obs_source_frame_init(struct obs_source_frame *frame, enum video_format for
 	}
 }
 
-static inline void obs_source_frame_decref(struct obs_source_frame *frame)
+/* frames output without copying only free the frame structure, their data is
+ * given back to the source once the last reference is gone */
+static void async_frame_destroy(obs_source_t *source, struct obs_source_frame *frame)
+{
+	for (size_t i = 0; i < source->async_nocopy_frames.num; i++) {
+		struct async_frame *af = &source->async_nocopy_frames.array[i];
+
+		if (af->frame == frame) {
+			af->release(af->release_param);
+			da_erase(source->async_nocopy_frames, i);
+			if (!source->async_nocopy_frames.num)
+				os_event_signal(source->async_nocopy_event);
+
+			bfree(frame);
+			return;
+		}
+	}
+
+	obs_source_frame_destroy(frame);
+}
+
+static inline void obs_source_frame_decref(obs_source_t *source, struct obs_source_frame *frame)
 {
 	if (os_atomic_dec_long(&frame->refs) == 0)
-		obs_source_frame_destroy(frame);
+		async_frame_destroy(source, frame);
 }
 
+static void flush_video_nocopy(obs_source_t *source);
+
 static bool obs_source_filter_remove_refless(obs_source_t *source, obs_source_t *filter);
 static void obs_source_destroy_defer(struct obs_source *source);
 
@@ -707,6 +761,9 @@ static void obs_source_destroy_defer(struct obs_source *source)
 
 	obs_source_dosignal(source, "source_destroy", "destroy");
 
+	/* the source may free the data of frames it output without copying */
+	flush_video_nocopy(source);
+
 	if (source->context.data) {
 		source->info.destroy(source->context.data);
 		source->context.data = NULL;
@@ -721,7 +778,7 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	obs_hotkey_pair_unregister(source->mute_unmute_key);
 
 	for (i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+		obs_source_frame_decref(source, source->async_cache.array[i].frame);
 
 	gs_enter_context(obs->video.graphics);
 	if (source->async_texrender)
@@ -756,8 +813,13 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	da_free(source->caption_cb_list);
 	da_free(source->async_cache);
 	da_free(source->async_frames);
+	da_free(source->async_nocopy_frames);
+	os_event_destroy(source->async_nocopy_event);
 	da_free(source->filters);
 	da_free(source->media_actions);
+	for (size_t i = 0; i < source->drop_counters.num; i++)
+		bfree(source->drop_counters.array[i].stage);
+	da_free(source->drop_counters);
 	pthread_mutex_destroy(&source->filter_mutex);
 	pthread_mutex_destroy(&source->audio_actions_mutex);
 	pthread_mutex_destroy(&source->audio_buf_mutex);
@@ -766,6 +828,7 @@ static void obs_source_destroy_defer(struct obs_source *source)
 	pthread_mutex_destroy(&source->caption_cb_mutex);
 	pthread_mutex_destroy(&source->async_mutex);
 	pthread_mutex_destroy(&source->media_actions_mutex);
+	pthread_mutex_destroy(&source->drop_mutex);
 	obs_data_release(source->private_settings);
 	obs_context_data_free(&source->context);
 
@@ -3407,10 +3470,27 @@ static inline bool async_texture_changed(struct obs_source *source, const struct
 	return source->async_cache_width != frame->width || source->async_cache_height != frame->height || prev != cur;
 }
 
+static size_t get_frame_size(const struct obs_source_frame *frame)
+{
+	uint32_t heights[MAX_AV_PLANES];
+	size_t size = 0;
+
+	video_frame_get_plane_heights(heights, frame->format, frame->height);
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
+		size += (size_t)frame->linesize[i] * heights[i];
+	return size;
+}
+
 static inline void free_async_cache(struct obs_source *source)
 {
-	for (size_t i = 0; i < source->async_cache.num; i++)
-		obs_source_frame_decref(source->async_cache.array[i].frame);
+	for (size_t i = 0; i < source->async_cache.num; i++) {
+		struct async_frame *af = &source->async_cache.array[i];
+
+		/* no-copy frames were never added to the memory stats */
+		if (af->size)
+			obs_context_memory_remove(&source->context, af->size);
+		obs_source_frame_decref(source, af->frame);
+	}
 
 	da_resize(source->async_cache, 0);
 	da_resize(source->async_frames, 0);
@@ -3428,6 +3508,8 @@ static void clean_cache(obs_source_t *source)
 		struct async_frame *af = &source->async_cache.array[i - 1];
 		if (!af->used) {
 			if (++af->unused_count == MAX_UNUSED_FRAME_DURATION) {
+				if (af->size)
+					obs_context_memory_remove(&source->context, af->size);
 				obs_source_frame_destroy(af->frame);
 				da_erase(source->async_cache, i - 1);
 			}
@@ -3436,18 +3518,14 @@ static void clean_cache(obs_source_t *source)
 }
 
 #define MAX_ASYNC_FRAMES 30
-//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
-static inline struct obs_source_frame *cache_video(struct obs_source *source, const struct obs_source_frame *frame)
-{
-	struct obs_source_frame *new_frame = NULL;
-
-	pthread_mutex_lock(&source->async_mutex);
 
+/* returns false if too many frames are queued, call with async_mutex held */
+static bool update_async_cache(struct obs_source *source, const struct obs_source_frame *frame)
+{
 	if (source->async_frames.num >= MAX_ASYNC_FRAMES) {
 		free_async_cache(source);
 		source->last_frame_ts = 0;
-		pthread_mutex_unlock(&source->async_mutex);
-		return NULL;
+		return false;
 	}
 
 	if (async_texture_changed(source, frame)) {
@@ -3456,10 +3534,25 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 		source->async_cache_height = frame->height;
 	}
 
-	const enum video_format format = frame->format;
-	source->async_cache_format = format;
+	source->async_cache_format = frame->format;
 	source->async_cache_full_range = frame->full_range;
 	source->async_cache_trc = frame->trc;
+	return true;
+}
+
+//if return value is not null then do (os_atomic_dec_long(&output->refs) == 0) && obs_source_frame_destroy(output)
+static inline struct obs_source_frame *cache_video(struct obs_source *source, const struct obs_source_frame *frame)
+{
+	struct obs_source_frame *new_frame = NULL;
+
+	pthread_mutex_lock(&source->async_mutex);
+
+	if (!update_async_cache(source, frame)) {
+		pthread_mutex_unlock(&source->async_mutex);
+		return NULL;
+	}
+
+	const enum video_format format = frame->format;
 
 	for (size_t i = 0; i < source->async_cache.num; i++) {
 		struct async_frame *af = &source->async_cache.array[i];
@@ -3479,10 +3572,14 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 
 		new_frame = obs_source_frame_create(format, frame->width, frame->height);
 		new_af.frame = new_frame;
+		new_af.size = get_frame_size(new_frame);
 		new_af.used = true;
 		new_af.unused_count = 0;
+		new_af.release = NULL;
+		new_af.release_param = NULL;
 		new_frame->refs = 1;
 
+		obs_context_memory_add(&source->context, new_af.size);
 		da_push_back(source->async_cache, &new_af);
 	}
 
@@ -3495,29 +3592,61 @@ static inline struct obs_source_frame *cache_video(struct obs_source *source, co
 	return new_frame;
 }
 
-static void obs_source_output_video_internal(obs_source_t *source, const struct obs_source_frame *frame)
+/* Frames output without copying are added to the cache as used entries that
+ * point to the caller's data, and are removed from the cache and released
+ * instead of being reused once libobs is done with them. */
+static struct obs_source_frame *cache_video_nocopy(struct obs_source *source, const struct obs_source_frame *frame,
+						   void (*release)(void *param), void *param)
 {
-	if (!obs_source_valid(source, "obs_source_output_video"))
-		return;
+	struct obs_source_frame *new_frame;
+	struct async_frame new_af;
 
-	if (!frame) {
-		pthread_mutex_lock(&source->async_mutex);
-		source->async_active = false;
-		source->last_frame_ts = 0;
-		free_async_cache(source);
+	pthread_mutex_lock(&source->async_mutex);
+
+	/* checked with the mutex held, so no frame is added after the frames
+	 * are flushed on destroy */
+	if (destroying(source) || !update_async_cache(source, frame)) {
 		pthread_mutex_unlock(&source->async_mutex);
-		return;
+		release(param);
+		return NULL;
 	}
 
-	source_profiler_async_frame_received(source);
+	if (!source->async_nocopy_event && os_event_init(&source->async_nocopy_event, OS_EVENT_TYPE_MANUAL) != 0) {
+		source->async_nocopy_event = NULL;
+		pthread_mutex_unlock(&source->async_mutex);
+		release(param);
+		return NULL;
+	}
+
+	clean_cache(source);
+
+	new_frame = bmalloc(sizeof(*new_frame));
+	*new_frame = *frame;
+	new_frame->refs = 2;
+	new_frame->prev_frame = false;
 
-	struct obs_source_frame *output = cache_video(source, frame);
+	new_af.frame = new_frame;
+	new_af.size = 0;
+	new_af.used = true;
+	new_af.unused_count = 0;
+	new_af.release = release;
+	new_af.release_param = param;
+	da_push_back(source->async_cache, &new_af);
+
+	if (!source->async_nocopy_frames.num)
+		os_event_reset(source->async_nocopy_event);
+	da_push_back(source->async_nocopy_frames, &new_af);
+
+	pthread_mutex_unlock(&source->async_mutex);
+	return new_frame;
+}
 
-	/* ------------------------------------------- */
+static void output_async_frame(obs_source_t *source, struct obs_source_frame *output)
+{
 	pthread_mutex_lock(&source->async_mutex);
 	if (output) {
 		if (os_atomic_dec_long(&output->refs) == 0) {
-			obs_source_frame_destroy(output);
+			async_frame_destroy(source, output);
 			output = NULL;
 		} else {
 			da_push_back(source->async_frames, &output);
@@ -3527,6 +3656,25 @@ static void obs_source_output_video_internal(obs_source_t *source, const struct
 	pthread_mutex_unlock(&source->async_mutex);
 }
 
+static void obs_source_output_video_internal(obs_source_t *source, const struct obs_source_frame *frame)
+{
+	if (!obs_source_valid(source, "obs_source_output_video"))
+		return;
+
+	if (!frame) {
+		pthread_mutex_lock(&source->async_mutex);
+		source->async_active = false;
+		source->last_frame_ts = 0;
+		free_async_cache(source);
+		pthread_mutex_unlock(&source->async_mutex);
+		return;
+	}
+
+	source_profiler_async_frame_received(source);
+
+	output_async_frame(source, cache_video(source, frame));
+}
+
 void obs_source_output_video(obs_source_t *source, const struct obs_source_frame *frame)
 {
 	if (destroying(source))
@@ -3542,6 +3690,48 @@ void obs_source_output_video(obs_source_t *source, const struct obs_source_frame
 	obs_source_output_video_internal(source, &new_frame);
 }
 
+void obs_source_output_video_nocopy(obs_source_t *source, const struct obs_source_frame *frame,
+				    void (*release)(void *param), void *param)
+{
+	if (!obs_ptr_valid(release, "obs_source_output_video_nocopy"))
+		return;
+	if (!obs_source_valid(source, "obs_source_output_video_nocopy") || destroying(source) ||
+	    !obs_ptr_valid(frame, "obs_source_output_video_nocopy")) {
+		release(param);
+		return;
+	}
+
+	struct obs_source_frame new_frame = *frame;
+	new_frame.full_range = format_is_yuv(frame->format) ? new_frame.full_range : true;
+
+	source_profiler_async_frame_received(source);
+
+	output_async_frame(source, cache_video_nocopy(source, &new_frame, release, param));
+}
+
+/* drops the frames held by libobs, then waits for the ones still in use, which
+ * are released when the graphics thread is done with them */
+static void flush_video_nocopy(obs_source_t *source)
+{
+	pthread_mutex_lock(&source->async_mutex);
+	if (source->async_nocopy_frames.num) {
+		source->last_frame_ts = 0;
+		free_async_cache(source);
+	}
+	pthread_mutex_unlock(&source->async_mutex);
+
+	if (source->async_nocopy_event)
+		os_event_wait(source->async_nocopy_event);
+}
+
+void obs_source_flush_video_nocopy(obs_source_t *source)
+{
+	if (!obs_source_valid(source, "obs_source_flush_video_nocopy"))
+		return;
+
+	flush_video_nocopy(source);
+}
+
 void obs_source_output_video2(obs_source_t *source, const struct obs_source_frame2 *frame)
 {
 	if (destroying(source))
@@ -4012,6 +4202,12 @@ void remove_async_frame(obs_source_t *source, struct obs_source_frame *frame)
 
 		if (f->frame == frame) {
 			f->used = false;
+
+			/* frames that were not copied are never reused */
+			if (f->release) {
+				da_erase(source->async_cache, i);
+				obs_source_frame_decref(source, frame);
+			}
 			break;
 		}
 	}
@@ -4163,7 +4359,7 @@ void obs_source_release_frame(obs_source_t *source, struct obs_source_frame *fra
 		pthread_mutex_lock(&source->async_mutex);
 
 		if (os_atomic_dec_long(&frame->refs) == 0)
-			obs_source_frame_destroy(frame);
+			async_frame_destroy(source, frame);
 		else
 			remove_async_frame(source, frame);
 
@@ -5125,6 +5321,45 @@ void *obs_source_get_type_data(obs_source_t *source)
 	return obs_source_valid(source, "obs_source_get_type_data") ? source->info.type_data : NULL;
 }
 
+void obs_source_memory_add(obs_source_t *source, size_t size)
+{
+	if (obs_source_valid(source, "obs_source_memory_add"))
+		obs_context_memory_add(&source->context, size);
+}
+
+void obs_source_memory_remove(obs_source_t *source, size_t size)
+{
+	if (obs_source_valid(source, "obs_source_memory_remove"))
+		obs_context_memory_remove(&source->context, size);
+}
+
+void obs_source_add_dropped_frames(obs_source_t *source, const char *stage, uint64_t count)
+{
+	if (!obs_source_valid(source, "obs_source_add_dropped_frames"))
+		return;
+	if (!obs_ptr_valid(stage, "obs_source_add_dropped_frames"))
+		return;
+
+	pthread_mutex_lock(&source->drop_mutex);
+
+	struct source_drop_counter *counter = NULL;
+	for (size_t i = 0; i < source->drop_counters.num; i++) {
+		if (strcmp(source->drop_counters.array[i].stage, stage) == 0) {
+			counter = source->drop_counters.array + i;
+			break;
+		}
+	}
+
+	if (!counter) {
+		counter = da_push_back_new(source->drop_counters);
+		counter->stage = bstrdup(stage);
+	}
+
+	counter->dropped += count;
+
+	pthread_mutex_unlock(&source->drop_mutex);
+}
+
 static float get_source_volume(obs_source_t *source, uint64_t os_time)
 {
 	if (source->push_to_mute_enabled && source->push_to_mute_pressed)
@@ -208,6 +208,16 @@ enum obs_media_state {
  */
 #define OBS_SOURCE_REQUIRES_CANVAS (1 << 17)
 
+/**
+ * Source type's create callback is thread safe
+ *
+ * When loading sources, the create callback may be called from a worker
+ * thread, at the same time as the create callbacks of other sources.  The
+ * callback must not look up other sources, and should leave graphics work
+ * to video_tick where possible instead of entering the graphics context.
+ */
+#define OBS_SOURCE_PARALLEL_CREATE (1 << 18)
+
 /** @} */
 
 typedef void (*obs_source_enum_proc_t)(obs_source_t *parent, obs_source_t *child, void *param);
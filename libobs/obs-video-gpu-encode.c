@@ -181,6 +181,7 @@ static void *gpu_encode_thread(void *data)
 				ept->pts = encoder->cur_pts;
 				ept->cts = tf.timestamp;
 				ept->fer = fer_ts;
+				get_frame_timing(encoder->media, ept->cts, ept);
 			}
 
 			send_off_encoder_packet(encoder, success, received, &pkt);
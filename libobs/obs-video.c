@@ -439,6 +439,39 @@ static inline void stage_output_texture(struct obs_core_video_mix *video, int cu
 	profile_end(stage_output_texture_name);
 }
 
+static void set_frame_timing(struct obs_core_video_mix *video, uint64_t timestamp, uint64_t rendered,
+			     uint64_t queued)
+{
+	pthread_mutex_lock(&obs->video.frame_timing_mutex);
+
+	size_t idx = obs->video.frame_timing_next++ % FRAME_TIMING_FRAMES;
+	struct obs_frame_timing *timing = &obs->video.frame_timing[idx];
+	timing->video = video->video;
+	timing->timestamp = timestamp;
+	timing->rendered = rendered;
+	timing->queued = queued;
+
+	pthread_mutex_unlock(&obs->video.frame_timing_mutex);
+}
+
+void get_frame_timing(video_t *video, uint64_t timestamp, struct encoder_packet_time *packet_time)
+{
+	pthread_mutex_lock(&obs->video.frame_timing_mutex);
+
+	size_t next = obs->video.frame_timing_next;
+	for (size_t i = 1; i <= FRAME_TIMING_FRAMES; i++) {
+		const struct obs_frame_timing *timing = &obs->video.frame_timing[(next - i) % FRAME_TIMING_FRAMES];
+
+		if (timing->video == video && timing->timestamp == timestamp) {
+			packet_time->rendered = timing->rendered;
+			packet_time->queued = timing->queued;
+			break;
+		}
+	}
+
+	pthread_mutex_unlock(&obs->video.frame_timing_mutex);
+}
+
 static inline bool queue_frame(struct obs_core_video_mix *video, bool raw_active, struct obs_vframe_info *vframe_info)
 {
 	bool duplicate = !video->gpu_encoder_avail_queue.size ||
@@ -499,6 +532,7 @@ static inline bool queue_frame(struct obs_core_video_mix *video, bool raw_active
 	tf.handle = gs_texture_get_shared_handle(tf.tex);
 	gs_texture_release_sync(tf.tex, ++tf.lock_key);
 #endif
+	set_frame_timing(video, tf.timestamp, vframe_info->rendered, os_gettime_ns());
 	deque_push_back(&video->gpu_encoder_queue, &tf, sizeof(tf));
 
 	os_sem_post(video->gpu_encode_semaphore);
@@ -528,6 +562,10 @@ static void output_gpu_encoders(struct obs_core_video_mix *video, bool raw_activ
 	struct obs_vframe_info vframe_info;
 	deque_pop_front(&video->vframe_info_buffer_gpu, &vframe_info, sizeof(vframe_info));
 
+	/* unlike downloaded raw frames, the texture queued here was rendered
+	 * during this frame */
+	vframe_info.rendered = os_gettime_ns();
+
 	pthread_mutex_lock(&video->gpu_encoder_mutex);
 	encode_gpu(video, raw_active, &vframe_info);
 	pthread_mutex_unlock(&video->gpu_encoder_mutex);
@@ -776,7 +814,8 @@ static inline void copy_rgbx_frame(struct video_frame *output, const struct vide
 	}
 }
 
-static inline void output_video_data(struct obs_core_video_mix *video, struct video_data *input_frame, int count)
+static inline void output_video_data(struct obs_core_video_mix *video, struct video_data *input_frame,
+				     const struct obs_vframe_info *vframe_info)
 {
 	const struct video_output_info *info;
 	struct video_frame output_frame;
@@ -784,7 +823,7 @@ static inline void output_video_data(struct obs_core_video_mix *video, struct vi
 
 	info = video_output_get_info(video->video);
 
-	locked = video_output_lock_frame(video->video, &output_frame, count, input_frame->timestamp);
+	locked = video_output_lock_frame(video->video, &output_frame, vframe_info->count, input_frame->timestamp);
 	if (locked) {
 		if (video->gpu_conversion) {
 			set_gpu_converted_data(&output_frame, input_frame, info);
@@ -792,6 +831,7 @@ static inline void output_video_data(struct obs_core_video_mix *video, struct vi
 			copy_rgbx_frame(&output_frame, input_frame, info);
 		}
 
+		set_frame_timing(video, input_frame->timestamp, vframe_info->rendered, os_gettime_ns());
 		video_output_unlock_frame(video->video);
 	}
 }
@@ -854,6 +894,8 @@ static inline void video_sleep(struct obs_core_video *video, uint64_t *p_time, u
 		bool raw_active = video->raw_was_active;
 		bool gpu_active = video->gpu_was_active;
 
+		vframe_info.rendered = video->rendered_ts;
+
 		if (raw_active)
 			deque_push_back(&video->vframe_info_buffer, &vframe_info, sizeof(vframe_info));
 		if (gpu_active)
@@ -888,6 +930,8 @@ static inline void output_frame(struct obs_core_video_mix *video)
 	GS_DEBUG_MARKER_END();
 	profile_end(output_frame_render_video_name);
 
+	video->rendered_ts = os_gettime_ns();
+
 	if (raw_active) {
 		profile_start(output_frame_download_frame_name);
 		frame_ready = download_frame(video, prev_texture, &frame);
@@ -907,7 +951,7 @@ static inline void output_frame(struct obs_core_video_mix *video)
 
 		frame.timestamp = vframe_info.timestamp;
 		profile_start(output_frame_output_video_data_name);
-		output_video_data(video, &frame, vframe_info.count);
+		output_video_data(video, &frame, &vframe_info);
 		profile_end(output_frame_output_video_data_name);
 	}
 
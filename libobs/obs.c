@@ -698,6 +698,8 @@ static int obs_init_video(struct obs_video_info *ovi)
 		return OBS_VIDEO_FAIL;
 	if (pthread_mutex_init(&video->mixes_mutex, NULL) < 0)
 		return OBS_VIDEO_FAIL;
+	if (pthread_mutex_init(&video->frame_timing_mutex, NULL) < 0)
+		return OBS_VIDEO_FAIL;
 
 	/* Reset main canvas mix first so it remains first in the rendering order. */
 	if (!obs_canvas_reset_video_internal(obs->data.main_canvas, ovi))
@@ -837,6 +839,11 @@ static void obs_free_video(void)
 	pthread_mutex_destroy(&obs->video.mixes_mutex);
 	pthread_mutex_init_value(&obs->video.mixes_mutex);
 
+	pthread_mutex_destroy(&obs->video.frame_timing_mutex);
+	pthread_mutex_init_value(&obs->video.frame_timing_mutex);
+	memset(obs->video.frame_timing, 0, sizeof(obs->video.frame_timing));
+	obs->video.frame_timing_next = 0;
+
 	for (size_t i = 0; i < obs->video.ready_encoder_groups.num; i++) {
 		obs_weak_encoder_release(obs->video.ready_encoder_groups.array[i]);
 	}
@@ -899,6 +906,7 @@ static bool obs_init_audio(struct audio_output_info *ai)
 
 	audio->monitoring_device_name = bstrdup("Default");
 	audio->monitoring_device_id = bstrdup("default");
+	audio->monitoring_latency_ms = DEFAULT_MONITORING_LATENCY_MS;
 	audio->monitoring_duplication_prevented_on_prev_tick = false;
 
 	errorcode = audio_output_open(&audio->audio, ai);
@@ -1156,6 +1164,8 @@ static inline void stop_hotkeys(void)
 
 	if (hotkeys->hotkey_thread_initialized) {
 		os_event_signal(hotkeys->stop_event);
+		if (hotkeys->events)
+			hotkeys->events->wake(hotkeys->platform_context);
 		pthread_join(hotkeys->hotkey_thread, &thread_ret);
 		hotkeys->hotkey_thread_initialized = false;
 	}
@@ -1208,6 +1218,7 @@ static bool obs_init(const char *locale, const char *module_config_path, profile
 	pthread_mutex_init_value(&obs->video.task_mutex);
 	pthread_mutex_init_value(&obs->video.encoder_group_mutex);
 	pthread_mutex_init_value(&obs->video.mixes_mutex);
+	pthread_mutex_init_value(&obs->video.frame_timing_mutex);
 
 	obs->name_store_owned = !store;
 	obs->name_store = store ? store : profiler_name_store_create();
@@ -1386,6 +1397,7 @@ void obs_shutdown(void)
 
 #undef FREE_REGISTERED_TYPES
 
+	da_free(obs->bitrate_estimator_types);
 	da_free(obs->input_types);
 	da_free(obs->filter_types);
 	da_free(obs->transition_types);
@@ -1695,6 +1707,8 @@ bool obs_get_audio_info2(struct obs_audio_info2 *oai2)
 
 bool obs_enum_source_types(size_t idx, const char **id)
 {
+	if (idx == 0)
+		obs_module_load_all_deferred(OBS_MODULE_TYPE_SOURCE);
 	if (idx >= obs->source_types.num)
 		return false;
 	*id = obs->source_types.array[idx].id;
@@ -1703,6 +1717,8 @@ bool obs_enum_source_types(size_t idx, const char **id)
 
 bool obs_enum_input_types(size_t idx, const char **id)
 {
+	if (idx == 0)
+		obs_module_load_deferred_sources(OBS_SOURCE_TYPE_INPUT);
 	if (idx >= obs->input_types.num)
 		return false;
 	*id = obs->input_types.array[idx].id;
@@ -1711,6 +1727,8 @@ bool obs_enum_input_types(size_t idx, const char **id)
 
 bool obs_enum_input_types2(size_t idx, const char **id, const char **unversioned_id)
 {
+	if (idx == 0)
+		obs_module_load_deferred_sources(OBS_SOURCE_TYPE_INPUT);
 	if (idx >= obs->input_types.num)
 		return false;
 	if (id)
@@ -1728,6 +1746,8 @@ const char *obs_get_latest_input_type_id(const char *unversioned_id)
 	if (!unversioned_id)
 		return NULL;
 
+	obs_module_load_deferred(OBS_MODULE_TYPE_SOURCE, unversioned_id, true);
+
 	for (size_t i = 0; i < obs->source_types.num; i++) {
 		struct obs_source_info *info = &obs->source_types.array[i];
 		if (strcmp(info->unversioned_id, unversioned_id) == 0 && (int)info->version > version) {
@@ -1745,6 +1765,8 @@ const char *obs_get_latest_input_type_id(const char *unversioned_id)
 
 bool obs_enum_filter_types(size_t idx, const char **id)
 {
+	if (idx == 0)
+		obs_module_load_deferred_sources(OBS_SOURCE_TYPE_FILTER);
 	if (idx >= obs->filter_types.num)
 		return false;
 	*id = obs->filter_types.array[idx].id;
@@ -1753,6 +1775,8 @@ bool obs_enum_filter_types(size_t idx, const char **id)
 
 bool obs_enum_transition_types(size_t idx, const char **id)
 {
+	if (idx == 0)
+		obs_module_load_deferred_sources(OBS_SOURCE_TYPE_TRANSITION);
 	if (idx >= obs->transition_types.num)
 		return false;
 	*id = obs->transition_types.array[idx].id;
@@ -1761,6 +1785,8 @@ bool obs_enum_transition_types(size_t idx, const char **id)
 
 bool obs_enum_output_types(size_t idx, const char **id)
 {
+	if (idx == 0)
+		obs_module_load_all_deferred(OBS_MODULE_TYPE_OUTPUT);
 	if (idx >= obs->output_types.num)
 		return false;
 	*id = obs->output_types.array[idx].id;
@@ -1769,6 +1795,8 @@ bool obs_enum_output_types(size_t idx, const char **id)
 
 bool obs_enum_encoder_types(size_t idx, const char **id)
 {
+	if (idx == 0)
+		obs_module_load_all_deferred(OBS_MODULE_TYPE_ENCODER);
 	if (idx >= obs->encoder_types.num)
 		return false;
 	*id = obs->encoder_types.array[idx].id;
@@ -1777,6 +1805,8 @@ bool obs_enum_encoder_types(size_t idx, const char **id)
 
 bool obs_enum_service_types(size_t idx, const char **id)
 {
+	if (idx == 0)
+		obs_module_load_all_deferred(OBS_MODULE_TYPE_SERVICE);
 	if (idx >= obs->service_types.num)
 		return false;
 	*id = obs->service_types.array[idx].id;
@@ -2232,9 +2262,9 @@ gs_texture_t *obs_get_main_texture(void)
 	return video->render_texture;
 }
 
-static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_private)
+/* creates the source without calling its create callback yet */
+static obs_source_t *obs_load_source_prepare(obs_data_t *source_data, bool is_private, obs_canvas_t **p_canvas)
 {
-	obs_data_array_t *filters = obs_data_get_array(source_data, "filters");
 	obs_source_t *source;
 	const char *name = obs_data_get_string(source_data, "name");
 	const char *uuid = obs_data_get_string(source_data, "uuid");
@@ -2243,16 +2273,7 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_priva
 	obs_data_t *settings = obs_data_get_obj(source_data, "settings");
 	obs_data_t *hotkeys = obs_data_get_obj(source_data, "hotkeys");
 	obs_canvas_t *canvas = NULL;
-	double volume;
-	double balance;
-	int64_t sync;
 	uint32_t prev_ver;
-	uint32_t caps;
-	uint32_t flags;
-	uint32_t mixers;
-	int di_order;
-	int di_mode;
-	int monitoring_type;
 
 	prev_ver = (uint32_t)obs_data_get_int(source_data, "prev_ver");
 
@@ -2268,7 +2289,36 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_priva
 		}
 	}
 
-	source = obs_source_create_set_last_ver(canvas, v_id, name, uuid, settings, hotkeys, prev_ver, is_private);
+	source = obs_source_create_prepare(v_id, name, uuid, settings, hotkeys, is_private, prev_ver);
+
+	obs_data_release(hotkeys);
+	obs_data_release(settings);
+
+	if (!source) {
+		obs_canvas_release(canvas);
+		canvas = NULL;
+	}
+
+	*p_canvas = canvas;
+	return source;
+}
+
+/* makes the created source available and restores its saved state */
+static void obs_load_source_finish(obs_source_t *source, obs_data_t *source_data, obs_canvas_t *canvas)
+{
+	const char *id = obs_data_get_string(source_data, "id");
+	double volume;
+	double balance;
+	int64_t sync;
+	uint32_t prev_ver;
+	uint32_t caps;
+	uint32_t flags;
+	uint32_t mixers;
+	int di_order;
+	int di_mode;
+	int monitoring_type;
+
+	obs_source_create_finish(source, canvas);
 
 	if (source->owns_info_id) {
 		bfree((void *)source->info.unversioned_id);
@@ -2276,8 +2326,8 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_priva
 	}
 
 	obs_canvas_release(canvas);
-	obs_data_release(hotkeys);
 
+	prev_ver = (uint32_t)obs_data_get_int(source_data, "prev_ver");
 	caps = obs_source_get_output_flags(source);
 
 	obs_data_set_default_double(source_data, "volume", 1.0);
@@ -2339,7 +2389,22 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_priva
 	source->private_settings = obs_data_get_obj(source_data, "private_settings");
 	if (!source->private_settings)
 		source->private_settings = obs_data_create();
+}
+
+static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_private)
+{
+	obs_data_array_t *filters;
+	obs_canvas_t *canvas;
+	obs_source_t *source;
+
+	source = obs_load_source_prepare(source_data, is_private, &canvas);
+	if (!source)
+		return NULL;
+
+	obs_source_create_data(source);
+	obs_load_source_finish(source, source_data, canvas);
 
+	filters = obs_data_get_array(source_data, "filters");
 	if (filters) {
 		size_t count = obs_data_array_count(filters);
 
@@ -2358,8 +2423,6 @@ static obs_source_t *obs_load_source_type(obs_data_t *source_data, bool is_priva
 		obs_data_array_release(filters);
 	}
 
-	obs_data_release(settings);
-
 	return source;
 }
 
@@ -2373,44 +2436,172 @@ obs_source_t *obs_load_private_source(obs_data_t *source_data)
 	return obs_load_source_type(source_data, true);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Loading of multiple sources
+ *
+ * Sources and their filters are flattened into a list of jobs, in the order
+ * the serial loader would create them (a source followed by its filters).
+ * Create callbacks of source types with OBS_SOURCE_PARALLEL_CREATE are run
+ * by worker threads, everything else stays on the calling thread, and the
+ * sources are still made available one by one in list order.  So a create
+ * callback that is not thread safe sees exactly the sources that it would
+ * see when loading serially.  Scenes resolve their items in the load pass
+ * afterwards, once all sources exist. */
+
+#define MAX_SOURCE_LOAD_THREADS 8
+
+struct source_load_job {
+	obs_data_t *data;
+	obs_source_t *source;
+	obs_canvas_t *canvas;
+	size_t parent;
+
+	bool parallel;
+	volatile long claimed;
+	os_event_t *created;
+};
+
+struct source_loader {
+	DARRAY(struct source_load_job) jobs;
+	DARRAY(size_t) parallel_jobs;
+	volatile long next_parallel_job;
+};
+
+static void source_loader_add(struct source_loader *loader, obs_data_t *data, bool is_private, size_t parent)
+{
+	struct source_load_job *job = da_push_back_new(loader->jobs);
+	size_t idx = loader->jobs.num - 1;
+	obs_source_t *source;
+
+	job->data = data;
+	job->parent = parent;
+	job->source = obs_load_source_prepare(data, is_private, &job->canvas);
+
+	source = job->source;
+	if (!source)
+		return;
+
+	if ((source->info.output_flags & OBS_SOURCE_PARALLEL_CREATE) != 0 &&
+	    os_event_init(&job->created, OS_EVENT_TYPE_MANUAL) == 0) {
+		job->parallel = true;
+		da_push_back(loader->parallel_jobs, &idx);
+	}
+
+	/* job pointer is invalid from here on */
+	obs_data_array_t *filters = obs_data_get_array(data, "filters");
+	size_t count = obs_data_array_count(filters);
+
+	for (size_t i = 0; i < count; i++)
+		source_loader_add(loader, obs_data_array_item(filters, i), true, idx);
+
+	obs_data_array_release(filters);
+}
+
+static inline bool source_load_job_claim(struct source_load_job *job)
+{
+	return os_atomic_compare_swap_long(&job->claimed, 0, 1);
+}
+
+static void *source_loader_thread(void *data)
+{
+	struct source_loader *loader = data;
+
+	os_set_thread_name("libobs: source loader");
+
+	for (;;) {
+		size_t i = (size_t)os_atomic_inc_long(&loader->next_parallel_job) - 1;
+		if (i >= loader->parallel_jobs.num)
+			break;
+
+		struct source_load_job *job = &loader->jobs.array[loader->parallel_jobs.array[i]];
+		if (source_load_job_claim(job)) {
+			obs_source_create_data(job->source);
+			os_event_signal(job->created);
+		}
+	}
+
+	return NULL;
+}
+
 void obs_load_sources(obs_data_array_t *array, obs_load_source_cb cb, void *private_data)
 {
-	DARRAY(obs_source_t *) sources;
+	struct source_loader loader = {0};
+	pthread_t threads[MAX_SOURCE_LOAD_THREADS];
+	size_t num_threads = 0;
+	size_t max_threads;
 	size_t count;
 	size_t i;
 
-	da_init(sources);
-
 	count = obs_data_array_count(array);
-	da_reserve(sources, count);
+	da_reserve(loader.jobs, count);
+
+	for (i = 0; i < count; i++)
+		source_loader_add(&loader, obs_data_array_item(array, i), false, DARRAY_INVALID);
+
+	/* the calling thread takes part as well */
+	max_threads = loader.parallel_jobs.num ? loader.parallel_jobs.num - 1 : 0;
+	if (max_threads > (size_t)os_get_logical_cores() - 1)
+		max_threads = (size_t)os_get_logical_cores() - 1;
+	if (max_threads > MAX_SOURCE_LOAD_THREADS)
+		max_threads = MAX_SOURCE_LOAD_THREADS;
+
+	for (i = 0; i < max_threads; i++) {
+		if (pthread_create(&threads[num_threads], NULL, source_loader_thread, &loader) == 0)
+			num_threads++;
+	}
+
+	if (loader.parallel_jobs.num)
+		blog(LOG_DEBUG, "obs_load_sources: %zu of %zu sources created on %zu threads",
+		     loader.parallel_jobs.num, loader.jobs.num, num_threads);
+
+	/* make sources available in order, creating them here unless a
+	 * loader thread got to it first */
+	for (i = 0; i < loader.jobs.num; i++) {
+		struct source_load_job *job = &loader.jobs.array[i];
+		if (!job->source)
+			continue;
 
-	for (i = 0; i < count; i++) {
-		obs_data_t *source_data = obs_data_array_item(array, i);
-		obs_source_t *source = obs_load_source(source_data);
+		if (!job->parallel || source_load_job_claim(job))
+			obs_source_create_data(job->source);
+		else
+			os_event_wait(job->created);
 
-		da_push_back(sources, &source);
+		obs_load_source_finish(job->source, job->data, job->canvas);
 
-		obs_data_release(source_data);
+		if (job->parent != DARRAY_INVALID) {
+			obs_source_filter_add(loader.jobs.array[job->parent].source, job->source);
+			obs_source_release(job->source);
+			job->source = NULL;
+		}
 	}
 
+	for (i = 0; i < num_threads; i++)
+		pthread_join(threads[i], NULL);
+
 	/* tell sources that we want to load */
-	for (i = 0; i < sources.num; i++) {
-		obs_source_t *source = sources.array[i];
-		obs_data_t *source_data = obs_data_array_item(array, i);
-		if (source) {
+	for (i = 0; i < loader.jobs.num; i++) {
+		struct source_load_job *job = &loader.jobs.array[i];
+		obs_source_t *source = job->source;
+
+		if (job->parent == DARRAY_INVALID && source) {
 			if (source->info.type == OBS_SOURCE_TYPE_TRANSITION)
-				obs_transition_load(source, source_data);
+				obs_transition_load(source, job->data);
 			obs_source_load2(source);
 			if (cb)
 				cb(private_data, source);
 		}
-		obs_data_release(source_data);
 	}
 
-	for (i = 0; i < sources.num; i++)
-		obs_source_release(sources.array[i]);
+	for (i = 0; i < loader.jobs.num; i++) {
+		struct source_load_job *job = &loader.jobs.array[i];
 
-	da_free(sources);
+		obs_source_release(job->source);
+		obs_data_release(job->data);
+		os_event_destroy(job->created);
+	}
+
+	da_free(loader.parallel_jobs);
+	da_free(loader.jobs);
 }
 
 obs_data_t *obs_save_source(obs_source_t *source)
@@ -2609,6 +2800,9 @@ static inline bool obs_context_data_init_wrap(struct obs_context_data *context,
 	pthread_mutex_init_value(&context->rename_cache_mutex);
 	if (pthread_mutex_init(&context->rename_cache_mutex, NULL) < 0)
 		return false;
+	pthread_mutex_init_value(&context->memory_mutex);
+	if (pthread_mutex_init(&context->memory_mutex, NULL) < 0)
+		return false;
 
 	context->signals = signal_handler_create();
 	if (!context->signals)
@@ -2649,6 +2843,7 @@ void obs_context_data_free(struct obs_context_data *context)
 	obs_data_release(context->settings);
 	obs_context_data_remove(context);
 	pthread_mutex_destroy(&context->rename_cache_mutex);
+	pthread_mutex_destroy(&context->memory_mutex);
 	bfree(context->name);
 	bfree((void *)context->uuid);
 
@@ -2659,6 +2854,25 @@ void obs_context_data_free(struct obs_context_data *context)
 	memset(context, 0, sizeof(*context));
 }
 
+void obs_context_memory_add(struct obs_context_data *context, size_t size)
+{
+	pthread_mutex_lock(&context->memory_mutex);
+	context->memory_bytes += size;
+	context->memory_allocs++;
+	if (context->memory_bytes > context->memory_bytes_max)
+		context->memory_bytes_max = context->memory_bytes;
+	pthread_mutex_unlock(&context->memory_mutex);
+}
+
+void obs_context_memory_remove(struct obs_context_data *context, size_t size)
+{
+	pthread_mutex_lock(&context->memory_mutex);
+	context->memory_bytes -= size < context->memory_bytes ? size : context->memory_bytes;
+	if (context->memory_allocs)
+		context->memory_allocs--;
+	pthread_mutex_unlock(&context->memory_mutex);
+}
+
 void obs_context_init_control(struct obs_context_data *context, void *object, obs_destroy_cb destroy)
 {
 	context->control = bzalloc(sizeof(obs_weak_object_t));
@@ -2982,6 +3196,36 @@ void obs_get_audio_monitoring_device(const char **name, const char **id)
 		*id = obs->audio.monitoring_device_id;
 }
 
+void obs_set_audio_monitoring_latency(uint32_t latency_ms)
+{
+	if (latency_ms < MIN_MONITORING_LATENCY_MS)
+		latency_ms = MIN_MONITORING_LATENCY_MS;
+	else if (latency_ms > MAX_MONITORING_LATENCY_MS)
+		latency_ms = MAX_MONITORING_LATENCY_MS;
+
+	pthread_mutex_lock(&obs->audio.monitoring_mutex);
+
+	if (obs->audio.monitoring_latency_ms != latency_ms) {
+		obs->audio.monitoring_latency_ms = latency_ms;
+		obs_reset_audio_monitoring();
+	}
+
+	pthread_mutex_unlock(&obs->audio.monitoring_mutex);
+}
+
+uint32_t obs_get_audio_monitoring_latency(void)
+{
+	return obs->audio.monitoring_latency_ms;
+}
+
+bool obs_get_audio_monitoring_stats(struct obs_audio_monitoring_stats *stats)
+{
+	if (!stats || !obs_audio_monitoring_available())
+		return false;
+
+	return audio_monitor_get_stats(stats);
+}
+
 void obs_add_tick_callback(void (*tick)(void *param, float seconds), void *param)
 {
 	struct tick_callback data = {tick, param};
@@ -53,6 +53,7 @@ struct obs_module_metadata;
 struct obs_fader;
 struct obs_volmeter;
 struct obs_canvas;
+struct obs_bitrate_controller;
 
 typedef struct obs_context_data obs_object_t;
 typedef struct obs_display obs_display_t;
@@ -69,6 +70,7 @@ typedef struct obs_module_metadata obs_module_metadata_t;
 typedef struct obs_fader obs_fader_t;
 typedef struct obs_volmeter obs_volmeter_t;
 typedef struct obs_canvas obs_canvas_t;
+typedef struct obs_bitrate_controller obs_bitrate_controller_t;
 
 typedef struct obs_weak_object obs_weak_object_t;
 typedef struct obs_weak_source obs_weak_source_t;
@@ -83,6 +85,7 @@ typedef struct obs_weak_canvas obs_weak_canvas_t;
 #include "obs-output.h"
 #include "obs-service.h"
 #include "obs-audio-controls.h"
+#include "obs-bitrate-controller.h"
 #include "obs-hotkey.h"
 
 /**
@@ -885,6 +888,24 @@ EXPORT void obs_enum_audio_monitoring_devices(obs_enum_audio_device_cb cb, void
 EXPORT bool obs_set_audio_monitoring_device(const char *name, const char *id);
 EXPORT void obs_get_audio_monitoring_device(const char **name, const char **id);
 
+/** Sets the target latency of audio monitoring in milliseconds */
+EXPORT void obs_set_audio_monitoring_latency(uint32_t latency_ms);
+EXPORT uint32_t obs_get_audio_monitoring_latency(void);
+
+struct obs_audio_monitoring_stats {
+	uint32_t target_latency_ms;
+	uint32_t device_latency_ms;
+	uint32_t sources;
+	uint32_t min_buffered_ms;
+	uint32_t max_buffered_ms;
+	uint64_t source_underruns;
+	uint64_t dropped_frames;
+	uint64_t device_underflows;
+};
+
+/** Gets the buffer levels of the monitoring mix, if the platform has one */
+EXPORT bool obs_get_audio_monitoring_stats(struct obs_audio_monitoring_stats *stats);
+
 EXPORT void obs_add_tick_callback(void (*tick)(void *param, float seconds), void *param);
 EXPORT void obs_remove_tick_callback(void (*tick)(void *param, float seconds), void *param);
 
@@ -1371,6 +1392,20 @@ EXPORT void obs_source_restore_filters(obs_source_t *source, obs_data_array_t *a
 
 EXPORT void *obs_source_get_type_data(obs_source_t *source);
 
+/**
+ * Attributes memory held by the source to it, such as decoded frame caches,
+ * for source_profiler_fill_memory_result.  Every obs_source_memory_add must
+ * be matched by an obs_source_memory_remove of the same size.
+ */
+EXPORT void obs_source_memory_add(obs_source_t *source, size_t size);
+EXPORT void obs_source_memory_remove(obs_source_t *source, size_t size);
+
+/**
+ * Counts frames the source dropped at a stage of its own pipeline (such as
+ * "capture" or "decode"), for source_profiler_enum_dropped_frames.
+ */
+EXPORT void obs_source_add_dropped_frames(obs_source_t *source, const char *stage, uint64_t count);
+
 /**
  * Helper function to set the color matrix information when drawing the source.
  *
@@ -1409,6 +1444,24 @@ EXPORT void obs_source_draw(gs_texture_t *image, int x, int y, uint32_t cx, uint
 EXPORT void obs_source_output_video(obs_source_t *source, const struct obs_source_frame *frame);
 EXPORT void obs_source_output_video2(obs_source_t *source, const struct obs_source_frame2 *frame);
 
+/**
+ * Outputs asynchronous video data without copying it.  The frame data must
+ * stay valid until release is called, which happens once libobs no longer
+ * uses the frame, and may happen on any thread (usually the graphics thread).
+ * release is called exactly once, including when the frame is dropped.
+ */
+EXPORT void obs_source_output_video_nocopy(obs_source_t *source, const struct obs_source_frame *frame,
+					   void (*release)(void *param), void *param);
+
+/**
+ * Drops the frames output with obs_source_output_video_nocopy that libobs still
+ * holds and waits until every one of them has been released.  Call after
+ * stopping output and before freeing the frame data.  This is done
+ * automatically before the source is destroyed.  Must not be called from the
+ * graphics thread.
+ */
+EXPORT void obs_source_flush_video_nocopy(obs_source_t *source);
+
 EXPORT void obs_source_set_async_rotation(obs_source_t *source, long rotation);
 
 EXPORT void obs_source_output_cea708(obs_source_t *source, const struct obs_source_cea_708 *captions);
@@ -1932,6 +1985,27 @@ EXPORT uint32_t obs_output_get_delay(const obs_output_t *output);
 /** If delay is active, gets the currently active delay value, in seconds. */
 EXPORT uint32_t obs_output_get_active_delay(const obs_output_t *output);
 
+/**
+ * Sets how much memory the delay buffer may use for packet data, in bytes
+ * (0 for no limit, the default).  Past the limit, packets are spilled to a
+ * file if a spill path is set, or kept in memory otherwise.
+ */
+EXPORT void obs_output_set_delay_memory_limit(obs_output_t *output, uint64_t max_bytes);
+
+/** Sets the directory for the delay buffer spill file (NULL to disable) */
+EXPORT void obs_output_set_delay_spill_path(obs_output_t *output, const char *path);
+
+struct obs_output_delay_stats {
+	/** Packet data currently held by the delay buffer */
+	uint64_t buffered_bytes;
+	/** Part of buffered_bytes held in the spill file */
+	uint64_t spilled_bytes;
+	/** Memory currently allocated by the delay buffer for packet data */
+	uint64_t memory_bytes;
+};
+
+EXPORT void obs_output_get_delay_stats(obs_output_t *output, struct obs_output_delay_stats *stats);
+
 /** Forces the output to stop.  Usually only used with delay. */
 EXPORT void obs_output_force_stop(obs_output_t *output);
 
@@ -2063,6 +2137,33 @@ EXPORT uint64_t obs_output_get_total_bytes(const obs_output_t *output);
 EXPORT int obs_output_get_frames_dropped(const obs_output_t *output);
 EXPORT int obs_output_get_total_frames(const obs_output_t *output);
 
+/** Stages of the video pipeline, measured for every video frame of an output */
+enum obs_latency_stage {
+	OBS_LATENCY_RENDER,        /**< Frame time to rendered */
+	OBS_LATENCY_OUTPUT,        /**< Rendered to handed to the encoders */
+	OBS_LATENCY_ENCODER_QUEUE, /**< Handed to the encoders to encode request */
+	OBS_LATENCY_ENCODE,        /**< Encode request to encode complete */
+	OBS_LATENCY_INTERLEAVE,    /**< Encode complete to interleaved, includes encoder delay */
+	OBS_LATENCY_SEND,          /**< Interleaved to sent, see obs_output_packet_sent */
+	OBS_LATENCY_TOTAL,         /**< Frame time to sent, or to interleaved if sends are not reported */
+	OBS_LATENCY_STAGE_COUNT,
+};
+
+struct obs_latency_stats {
+	uint64_t count;
+	uint64_t p50_ns;
+	uint64_t p99_ns;
+	uint64_t max_ns;
+};
+
+/**
+ * Gets the latency of a pipeline stage for the video frames of this output
+ * since it was last started.  Percentiles are approximate (within about 12%).
+ * Returns false if no frames have been measured for the stage.
+ */
+EXPORT bool obs_output_get_latency(const obs_output_t *output, enum obs_latency_stage stage,
+				   struct obs_latency_stats *stats);
+
 /**
  * Sets the preferred scaled resolution for this output.  Set width and height
  * to 0 to disable scaling.
@@ -2170,6 +2271,18 @@ EXPORT void obs_output_set_reconnect_callback(obs_output_t *output,
 
 EXPORT void *obs_output_get_type_data(obs_output_t *output);
 
+/**
+ * Reports that an encoded packet has been sent, for outputs that send packets
+ * after obs_output_info.encoded_packet returns (such as on their own thread).
+ * Only the type, track_idx and pts of the packet are used, so the packet data
+ * may already have been released.
+ */
+EXPORT void obs_output_packet_sent(obs_output_t *output, const struct encoder_packet *packet);
+
+/** Attributes memory held by the output to it, see obs_source_memory_add */
+EXPORT void obs_output_memory_add(obs_output_t *output, size_t size);
+EXPORT void obs_output_memory_remove(obs_output_t *output, size_t size);
+
 /** Gets the video conversion info.  Used only for raw output */
 EXPORT const struct video_scale_info *obs_output_get_video_conversion(obs_output_t *output);
 
@@ -2448,6 +2561,10 @@ EXPORT void obs_encoder_set_last_error(obs_encoder_t *encoder, const char *messa
 
 EXPORT uint64_t obs_encoder_get_pause_offset(const obs_encoder_t *encoder);
 
+/** Attributes memory held by the encoder to it, see obs_source_memory_add */
+EXPORT void obs_encoder_memory_add(obs_encoder_t *encoder, size_t size);
+EXPORT void obs_encoder_memory_remove(obs_encoder_t *encoder, size_t size);
+
 /**
  * Creates an "encoder group", allowing synchronized startup of encoders within
  * the group. Encoder groups are single owner, and hold strong references to
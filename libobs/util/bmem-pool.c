@@ -0,0 +1,515 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "bmem-pool.h"
+#include "bmem.h"
+#include "threading.h"
+
+/*
+ * Every thread keeps a free list per size class and allocates from it
+ * without locking.  Threads exchange blocks in batches through a shared
+ * list per size class: a thread whose free list runs empty takes a batch,
+ * and a thread whose free list grows too long (such as an output thread
+ * freeing packets allocated by an encoder thread) returns a batch.  New
+ * blocks are carved from 64 KB slabs, which are never returned to the
+ * system.
+ *
+ * The counters of each thread are only written by that thread, and are
+ * summed up per thread name when reading statistics.
+ */
+
+#define POOL_HEADER_SIZE 32
+#define POOL_SLAB_SIZE (64 * 1024)
+#define POOL_NUM_CLASSES 14
+#define POOL_BATCH_BYTES (16 * 1024)
+#define POOL_MAX_NAME 32
+
+static const size_t class_sizes[POOL_NUM_CLASSES] = {
+	32, 64, 96, 128, 192, 256, 384, 512, 768, 1024, 1536, 2048, 3072, 4096,
+};
+
+struct pool_header {
+	size_t size;
+	uint32_t size_class;
+	uint8_t reserved[POOL_HEADER_SIZE - sizeof(size_t) - sizeof(uint32_t) - 1];
+	uint8_t marker;
+};
+
+struct pool_block {
+	struct pool_block *next;
+};
+
+struct pool_free_list {
+	struct pool_block *head;
+	size_t count;
+};
+
+struct pool_counters {
+	uint64_t allocs;
+	uint64_t frees;
+	uint64_t bytes_requested;
+	uint64_t bytes_allocated;
+	uint64_t bytes_freed;
+};
+
+struct pool_thread_cache {
+	struct pool_free_list lists[POOL_NUM_CLASSES];
+	struct pool_counters counters;
+	char name[POOL_MAX_NAME];
+
+	struct pool_thread_cache *prev;
+	struct pool_thread_cache *next;
+};
+
+struct pool_central_list {
+	pthread_mutex_t mutex;
+	struct pool_block *head;
+	size_t count;
+};
+
+struct pool_retired_counters {
+	char name[POOL_MAX_NAME];
+	struct pool_counters counters;
+};
+
+static pthread_once_t pool_once = PTHREAD_ONCE_INIT;
+static volatile bool pool_initialized = false;
+static bool pool_enabled = false;
+
+static struct pool_central_list central[POOL_NUM_CLASSES];
+static size_t batch_sizes[POOL_NUM_CLASSES];
+
+/* registry_mutex protects the list of thread caches, the counters of
+ * exited threads and the slab counter */
+static pthread_mutex_t registry_mutex;
+static struct pool_thread_cache *caches = NULL;
+static struct pool_retired_counters *retired = NULL;
+static size_t num_retired = 0;
+static size_t reserved_bytes = 0;
+
+static pthread_key_t cache_key;
+static THREAD_LOCAL struct pool_thread_cache *thread_cache = NULL;
+
+static void destroy_thread_cache(void *data);
+
+static void pool_init(void)
+{
+	const char *env = getenv("OBS_MEMORY_POOL");
+
+	if (env && strcmp(env, "1") == 0 && pthread_key_create(&cache_key, destroy_thread_cache) == 0 &&
+	    pthread_mutex_init(&registry_mutex, NULL) == 0) {
+		for (size_t i = 0; i < POOL_NUM_CLASSES; i++) {
+			size_t batch = POOL_BATCH_BYTES / (class_sizes[i] + POOL_HEADER_SIZE);
+			batch_sizes[i] = batch < 4 ? 4 : batch;
+			pthread_mutex_init(&central[i].mutex, NULL);
+		}
+
+		pool_enabled = true;
+	}
+
+	os_atomic_set_bool(&pool_initialized, true);
+}
+
+static inline bool pool_active(void)
+{
+	if (!os_atomic_load_bool(&pool_initialized))
+		pthread_once(&pool_once, pool_init);
+	return pool_enabled;
+}
+
+static inline bool get_size_class(size_t size, uint32_t *size_class)
+{
+	if (size <= 128) {
+		*size_class = (uint32_t)((size + 31) / 32 - 1);
+		return true;
+	}
+
+	for (uint32_t i = 4; i < POOL_NUM_CLASSES; i++) {
+		if (size <= class_sizes[i]) {
+			*size_class = i;
+			return true;
+		}
+	}
+
+	return false;
+}
+
+static inline struct pool_header *get_header(const void *ptr)
+{
+	return (struct pool_header *)((uint8_t *)ptr - POOL_HEADER_SIZE);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Shared lists */
+
+/* called with the central list locked */
+static bool add_slab(uint32_t size_class)
+{
+	size_t stride = POOL_HEADER_SIZE + class_sizes[size_class];
+	size_t count = POOL_SLAB_SIZE / stride;
+
+	uint8_t *mem = malloc(POOL_SLAB_SIZE + POOL_HEADER_SIZE);
+	if (!mem)
+		return false;
+
+	/* align the first header, and with it every block */
+	uint8_t *slab = mem + (POOL_HEADER_SIZE - ((uintptr_t)mem & (POOL_HEADER_SIZE - 1)));
+
+	for (size_t i = 0; i < count; i++) {
+		struct pool_header *header = (struct pool_header *)(slab + i * stride);
+		struct pool_block *block = (struct pool_block *)(header + 1);
+
+		memset(header, 0, sizeof(*header));
+		header->size_class = size_class;
+
+		block->next = central[size_class].head;
+		central[size_class].head = block;
+	}
+
+	central[size_class].count += count;
+
+	pthread_mutex_lock(&registry_mutex);
+	reserved_bytes += POOL_SLAB_SIZE + POOL_HEADER_SIZE;
+	pthread_mutex_unlock(&registry_mutex);
+	return true;
+}
+
+static void take_batch(struct pool_free_list *list, uint32_t size_class)
+{
+	struct pool_central_list *shared = &central[size_class];
+
+	pthread_mutex_lock(&shared->mutex);
+
+	if (!shared->count)
+		add_slab(size_class);
+
+	for (size_t i = 0; i < batch_sizes[size_class] && shared->head; i++) {
+		struct pool_block *block = shared->head;
+		shared->head = block->next;
+		shared->count--;
+
+		block->next = list->head;
+		list->head = block;
+		list->count++;
+	}
+
+	pthread_mutex_unlock(&shared->mutex);
+}
+
+static void return_blocks(struct pool_free_list *list, uint32_t size_class, size_t count)
+{
+	struct pool_central_list *shared = &central[size_class];
+
+	pthread_mutex_lock(&shared->mutex);
+
+	for (size_t i = 0; i < count && list->head; i++) {
+		struct pool_block *block = list->head;
+		list->head = block->next;
+		list->count--;
+
+		block->next = shared->head;
+		shared->head = block;
+		shared->count++;
+	}
+
+	pthread_mutex_unlock(&shared->mutex);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Thread caches */
+
+static void add_counters(struct pool_counters *dst, const struct pool_counters *src)
+{
+	dst->allocs += src->allocs;
+	dst->frees += src->frees;
+	dst->bytes_requested += src->bytes_requested;
+	dst->bytes_allocated += src->bytes_allocated;
+	dst->bytes_freed += src->bytes_freed;
+}
+
+/* called with registry_mutex locked, uses malloc as bmalloc would recurse */
+static void retire_counters(const struct pool_thread_cache *cache)
+{
+	for (size_t i = 0; i < num_retired; i++) {
+		if (strcmp(retired[i].name, cache->name) == 0) {
+			add_counters(&retired[i].counters, &cache->counters);
+			return;
+		}
+	}
+
+	struct pool_retired_counters *new_retired = realloc(retired, (num_retired + 1) * sizeof(*retired));
+	if (!new_retired)
+		return;
+
+	retired = new_retired;
+	memcpy(retired[num_retired].name, cache->name, POOL_MAX_NAME);
+	retired[num_retired].counters = cache->counters;
+	num_retired++;
+}
+
+static void destroy_thread_cache(void *data)
+{
+	struct pool_thread_cache *cache = data;
+
+	for (uint32_t i = 0; i < POOL_NUM_CLASSES; i++)
+		return_blocks(&cache->lists[i], i, cache->lists[i].count);
+
+	pthread_mutex_lock(&registry_mutex);
+	if (cache->prev)
+		cache->prev->next = cache->next;
+	else
+		caches = cache->next;
+	if (cache->next)
+		cache->next->prev = cache->prev;
+	retire_counters(cache);
+	pthread_mutex_unlock(&registry_mutex);
+
+	if (thread_cache == cache)
+		thread_cache = NULL;
+	free(cache);
+}
+
+static struct pool_thread_cache *get_thread_cache(void)
+{
+	if (thread_cache)
+		return thread_cache;
+
+	struct pool_thread_cache *cache = calloc(1, sizeof(*cache));
+	if (!cache)
+		return NULL;
+
+	strcpy(cache->name, "unnamed thread");
+
+	pthread_mutex_lock(&registry_mutex);
+	cache->next = caches;
+	if (caches)
+		caches->prev = cache;
+	caches = cache;
+	pthread_mutex_unlock(&registry_mutex);
+
+	pthread_setspecific(cache_key, cache);
+	thread_cache = cache;
+	return cache;
+}
+
+/* ------------------------------------------------------------------------- */
+
+void *bmem_pool_alloc(size_t size)
+{
+	uint32_t size_class;
+
+	if (!pool_active() || !get_size_class(size, &size_class))
+		return NULL;
+
+	struct pool_thread_cache *cache = get_thread_cache();
+	if (!cache)
+		return NULL;
+
+	struct pool_free_list *list = &cache->lists[size_class];
+	if (!list->head) {
+		take_batch(list, size_class);
+		if (!list->head)
+			return NULL;
+	}
+
+	struct pool_block *block = list->head;
+	list->head = block->next;
+	list->count--;
+
+	get_header(block)->size = size;
+
+	cache->counters.allocs++;
+	cache->counters.bytes_requested += size;
+	cache->counters.bytes_allocated += class_sizes[size_class];
+	return block;
+}
+
+void bmem_pool_free(void *ptr)
+{
+	struct pool_header *header = get_header(ptr);
+	uint32_t size_class = header->size_class;
+	struct pool_block *block = ptr;
+
+	/* pool_active() has been called by the allocation */
+	struct pool_thread_cache *cache = get_thread_cache();
+	if (!cache) {
+		struct pool_free_list list = {block, 1};
+		block->next = NULL;
+		return_blocks(&list, size_class, 1);
+		return;
+	}
+
+	cache->counters.frees++;
+	cache->counters.bytes_freed += header->size;
+
+	struct pool_free_list *list = &cache->lists[size_class];
+	block->next = list->head;
+	list->head = block;
+	list->count++;
+
+	if (list->count >= batch_sizes[size_class] * 2)
+		return_blocks(list, size_class, batch_sizes[size_class]);
+}
+
+bool bmem_pool_resize(void *ptr, size_t size)
+{
+	struct pool_header *header = get_header(ptr);
+	if (size > class_sizes[header->size_class])
+		return false;
+
+	struct pool_thread_cache *cache = get_thread_cache();
+	if (cache) {
+		cache->counters.bytes_requested += size;
+		cache->counters.bytes_freed += header->size;
+	}
+
+	header->size = size;
+	return true;
+}
+
+bool bmem_pool_owns(const void *ptr)
+{
+	/* pool_active() has been called by the allocation */
+	return pool_enabled && ((const uint8_t *)ptr)[-1] == 0;
+}
+
+size_t bmem_pool_size(const void *ptr)
+{
+	return get_header(ptr)->size;
+}
+
+static void sum_counters(struct pool_counters *total)
+{
+	memset(total, 0, sizeof(*total));
+
+	for (struct pool_thread_cache *cache = caches; cache; cache = cache->next)
+		add_counters(total, &cache->counters);
+	for (size_t i = 0; i < num_retired; i++)
+		add_counters(total, &retired[i].counters);
+}
+
+long bmem_pool_num_allocs(void)
+{
+	struct pool_counters total;
+
+	if (!pool_active())
+		return 0;
+
+	pthread_mutex_lock(&registry_mutex);
+	sum_counters(&total);
+	pthread_mutex_unlock(&registry_mutex);
+
+	return (long)(total.allocs - total.frees);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Statistics */
+
+bool bmem_pool_enabled(void)
+{
+	return pool_active();
+}
+
+void bmem_pool_set_thread_name(const char *name)
+{
+	if (!name || !pool_active())
+		return;
+
+	struct pool_thread_cache *cache = get_thread_cache();
+	if (!cache)
+		return;
+
+	pthread_mutex_lock(&registry_mutex);
+	strncpy(cache->name, name, POOL_MAX_NAME - 1);
+	cache->name[POOL_MAX_NAME - 1] = 0;
+	pthread_mutex_unlock(&registry_mutex);
+}
+
+static void fill_stats(struct bmem_pool_stats *stats, const char *name, const struct pool_counters *counters)
+{
+	stats->name = name;
+	stats->allocs = counters->allocs;
+	stats->frees = counters->frees;
+	stats->bytes_requested = counters->bytes_requested;
+	stats->bytes_allocated = counters->bytes_allocated;
+}
+
+void bmem_pool_enum_stats(bool (*callback)(void *param, const struct bmem_pool_stats *stats), void *param)
+{
+	if (!pool_active())
+		return;
+
+	pthread_mutex_lock(&registry_mutex);
+
+	/* merge threads of the same name, starting with exited threads */
+	size_t count = num_retired;
+	for (struct pool_thread_cache *cache = caches; cache; cache = cache->next)
+		count++;
+
+	struct pool_retired_counters *merged = calloc(count ? count : 1, sizeof(*merged));
+	size_t num_merged = 0;
+
+	if (merged) {
+		for (size_t i = 0; i < num_retired; i++)
+			merged[num_merged++] = retired[i];
+
+		for (struct pool_thread_cache *cache = caches; cache; cache = cache->next) {
+			size_t idx = 0;
+			while (idx < num_merged && strcmp(merged[idx].name, cache->name) != 0)
+				idx++;
+
+			if (idx == num_merged) {
+				memcpy(merged[idx].name, cache->name, POOL_MAX_NAME);
+				num_merged++;
+			}
+
+			add_counters(&merged[idx].counters, &cache->counters);
+		}
+	}
+
+	pthread_mutex_unlock(&registry_mutex);
+
+	for (size_t i = 0; i < num_merged; i++) {
+		struct bmem_pool_stats stats;
+		fill_stats(&stats, merged[i].name, &merged[i].counters);
+		if (!callback(param, &stats))
+			break;
+	}
+
+	free(merged);
+}
+
+void bmem_pool_get_memory(size_t *reserved, size_t *in_use)
+{
+	struct pool_counters total = {0};
+	size_t slab_bytes = 0;
+
+	if (pool_active()) {
+		pthread_mutex_lock(&registry_mutex);
+		sum_counters(&total);
+		slab_bytes = reserved_bytes;
+		pthread_mutex_unlock(&registry_mutex);
+	}
+
+	if (reserved)
+		*reserved = slab_bytes;
+	if (in_use)
+		*in_use = (size_t)(total.bytes_requested - total.bytes_freed);
+}
@@ -0,0 +1,54 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "c99defs.h"
+
+/*
+ * Size class pool used by bmalloc for small allocations, only used when the
+ * OBS_MEMORY_POOL environment variable is set to 1.
+ *
+ * Pool blocks are preceded by a 32 byte header whose last byte is always 0.
+ * While the pool is enabled, the byte before system allocations holds the
+ * alignment offset, which is never 0, so bmem can tell both apart from the
+ * pointer alone.
+ */
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* returns NULL if the pool is disabled or the size is too large */
+void *bmem_pool_alloc(size_t size);
+void bmem_pool_free(void *ptr);
+
+/* resizes in place if the size fits the block, returns false otherwise */
+bool bmem_pool_resize(void *ptr, size_t size);
+
+/* requested size of a pool block */
+size_t bmem_pool_size(const void *ptr);
+
+/* pool allocations that have not been freed yet */
+long bmem_pool_num_allocs(void);
+
+/* only valid for pointers returned by bmalloc/brealloc */
+bool bmem_pool_owns(const void *ptr);
+
+#ifdef __cplusplus
+}
+#endif
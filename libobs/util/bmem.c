@@ -18,6 +18,7 @@
 #include <string.h>
 #include "base.h"
 #include "bmem.h"
+#include "bmem-pool.h"
 #include "platform.h"
 #include "threading.h"
 
@@ -44,10 +45,32 @@
 #define ALIGNMENT_HACK 1
 #endif
 
+/*
+ * When the memory pool is enabled, system allocations have a nonzero byte
+ * right before the returned pointer, which is what tells them apart from
+ * memory pool blocks.  The alignment hack always leaves one; _aligned_malloc()
+ * needs an extra aligned prefix for it, which is only allocated with the
+ * pool enabled.  Whether the pool is enabled never changes once the first
+ * allocation has been made.
+ */
+
+#ifdef ALIGNED_MALLOC
+static inline size_t a_prefix(void)
+{
+	return bmem_pool_enabled() ? ALIGNMENT : 0;
+}
+#endif
+
 static void *a_malloc(size_t size)
 {
 #ifdef ALIGNED_MALLOC
-	return _aligned_malloc(size, ALIGNMENT);
+	size_t prefix = a_prefix();
+	char *ptr = _aligned_malloc(size + prefix, ALIGNMENT);
+	if (ptr && prefix) {
+		ptr += prefix;
+		ptr[-1] = (char)prefix;
+	}
+	return ptr;
 #elif ALIGNMENT_HACK
 	void *ptr = NULL;
 	long diff;
@@ -68,7 +91,14 @@ static void *a_malloc(size_t size)
 static void *a_realloc(void *ptr, size_t size)
 {
 #ifdef ALIGNED_MALLOC
-	return _aligned_realloc(ptr, size, ALIGNMENT);
+	size_t prefix = a_prefix();
+
+	if (!ptr)
+		return a_malloc(size);
+	ptr = _aligned_realloc((char *)ptr - prefix, size + prefix, ALIGNMENT);
+	if (ptr)
+		ptr = (char *)ptr + prefix;
+	return ptr;
 #elif ALIGNMENT_HACK
 	long diff;
 
@@ -87,7 +117,8 @@ static void *a_realloc(void *ptr, size_t size)
 static void a_free(void *ptr)
 {
 #ifdef ALIGNED_MALLOC
-	_aligned_free(ptr);
+	if (ptr)
+		_aligned_free((char *)ptr - a_prefix());
 #elif ALIGNMENT_HACK
 	if (ptr)
 		free((char *)ptr - ((char *)ptr)[-1]);
@@ -105,7 +136,11 @@ void *bmalloc(size_t size)
 		bcrash("bmalloc: Allocating 0 bytes is broken behavior, please fix your code!");
 	}
 
-	void *ptr = a_malloc(size);
+	void *ptr = bmem_pool_alloc(size);
+	if (ptr)
+		return ptr;
+
+	ptr = a_malloc(size);
 
 	if (!ptr) {
 		os_oom();
@@ -116,16 +151,30 @@ void *bmalloc(size_t size)
 	return ptr;
 }
 
-void *brealloc(void *ptr, size_t size)
+static void *pool_realloc(void *ptr, size_t size)
 {
-	if (!ptr)
-		os_atomic_inc_long(&num_allocs);
+	if (bmem_pool_resize(ptr, size))
+		return ptr;
+
+	size_t old_size = bmem_pool_size(ptr);
+	void *new_ptr = bmalloc(size);
+	memcpy(new_ptr, ptr, old_size < size ? old_size : size);
+	bmem_pool_free(ptr);
+	return new_ptr;
+}
 
+void *brealloc(void *ptr, size_t size)
+{
 	if (!size) {
 		os_breakpoint();
 		bcrash("brealloc: Allocating 0 bytes is broken behavior, please fix your code!");
 	}
 
+	if (!ptr)
+		return bmalloc(size);
+	if (bmem_pool_owns(ptr))
+		return pool_realloc(ptr, size);
+
 	ptr = a_realloc(ptr, size);
 
 	if (!ptr) {
@@ -138,7 +187,12 @@ void *brealloc(void *ptr, size_t size)
 
 void bfree(void *ptr)
 {
-	if (ptr) {
+	if (!ptr)
+		return;
+
+	if (bmem_pool_owns(ptr)) {
+		bmem_pool_free(ptr);
+	} else {
 		os_atomic_dec_long(&num_allocs);
 		a_free(ptr);
 	}
@@ -146,7 +200,7 @@ void bfree(void *ptr)
 
 long bnum_allocs(void)
 {
-	return num_allocs;
+	return num_allocs + bmem_pool_num_allocs();
 }
 
 int base_get_alignment(void)
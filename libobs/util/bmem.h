@@ -41,6 +41,22 @@ EXPORT long bnum_allocs(void);
 
 EXPORT void *bmemdup(const void *ptr, size_t size);
 
+/* ------------------------------------------------------------------------- */
+/* Memory pool statistics */
+
+struct bmem_pool_stats {
+	const char *name;
+	uint64_t allocs;
+	uint64_t frees;
+	uint64_t bytes_requested;
+	uint64_t bytes_allocated;
+};
+
+EXPORT bool bmem_pool_enabled(void);
+EXPORT void bmem_pool_set_thread_name(const char *name);
+EXPORT void bmem_pool_enum_stats(bool (*callback)(void *param, const struct bmem_pool_stats *stats), void *param);
+EXPORT void bmem_pool_get_memory(size_t *reserved, size_t *in_use);
+
 static inline void *bzalloc(size_t size)
 {
 	void *mem = bmalloc(size);
@@ -0,0 +1,45 @@
+/*
+ * Copyright (c) 2026 by the OBS Project
+ *
+ * Permission to use, copy, modify, and distribute this software for any
+ * purpose with or without fee is hereby granted, provided that the above
+ * copyright notice and this permission notice appear in all copies.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR
+ * ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES
+ * WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN
+ * ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF
+ * OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#pragma once
+
+#include "c99defs.h"
+
+#include <string.h>
+
+/*
+ * 64 bit FNV-1a hash, for cache keys and checksums of data that is not
+ * adversarial.  Start with FNV1A_64_INIT and feed the data in any number of
+ * calls.
+ */
+
+#define FNV1A_64_INIT 14695981039346656037ULL
+
+static inline uint64_t fnv1a_64(uint64_t hash, const void *data, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t *)data;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= (uint64_t)bytes[i];
+		hash *= 1099511628211ULL;
+	}
+	return hash;
+}
+
+static inline uint64_t fnv1a_64_str(const char *str)
+{
+	return fnv1a_64(FNV1A_64_INIT, str, strlen(str));
+}
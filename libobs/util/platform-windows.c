@@ -62,6 +62,10 @@ static inline uint32_t get_winver(void)
 	return winver;
 }
 
+/* SetDllDirectoryW is process-wide, so loads that set it must not overlap
+ * (modules are opened from several threads at startup) */
+static SRWLOCK dll_directory_lock = SRWLOCK_INIT;
+
 void *os_dlopen(const char *path)
 {
 	struct dstr dll_name;
@@ -80,6 +84,8 @@ void *os_dlopen(const char *path)
 
 	dstr_free(&dll_name);
 
+	AcquireSRWLockExclusive(&dll_directory_lock);
+
 	/* to make module dependency issues easier to deal with, allow
 	 * dynamically loaded libraries on windows to search for dependent
 	 * libraries that are within the library's own directory */
@@ -97,6 +103,8 @@ void *os_dlopen(const char *path)
 	if (wpath_slash)
 		SetDllDirectoryW(NULL);
 
+	ReleaseSRWLockExclusive(&dll_directory_lock);
+
 	if (!h_library) {
 		DWORD error = GetLastError();
 
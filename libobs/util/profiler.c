@@ -4,8 +4,10 @@
 #include "darray.h"
 #include "dstr.h"
 #include "platform.h"
+#include "spsc-ring.h"
 #include "threading.h"
 
+#include <errno.h>
 #include <math.h>
 
 #include <zlib.h>
@@ -45,7 +47,6 @@ struct profile_call {
 #endif
 	uint64_t expected_time_between_calls;
 	DARRAY(profile_call) children;
-	profile_call *parent;
 };
 
 typedef struct profile_times_table_entry profile_times_table_entry;
@@ -248,24 +249,32 @@ static void merge_call(profile_entry *entry, profile_call *call, profile_call *p
 #endif
 }
 
-static bool enabled = false;
+static volatile bool enabled = false;
 static pthread_mutex_t root_mutex = PTHREAD_MUTEX_INITIALIZER;
 static DARRAY(profile_root_entry) root_entries;
 
-static THREAD_LOCAL profile_call *thread_context = NULL;
 static THREAD_LOCAL bool thread_enabled = true;
 
+static void aggregate_threads(void);
+
+static void start_aggregator(void);
+
 void profiler_start(void)
 {
 	pthread_mutex_lock(&root_mutex);
-	enabled = true;
+	os_atomic_set_bool(&enabled, true);
 	pthread_mutex_unlock(&root_mutex);
+
+	start_aggregator();
 }
 
 void profiler_stop(void)
 {
+	/* merge what has been recorded up to here */
+	aggregate_threads();
+
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
+	os_atomic_set_bool(&enabled, false);
 	pthread_mutex_unlock(&root_mutex);
 }
 
@@ -274,9 +283,7 @@ void profile_reenable_thread(void)
 	if (thread_enabled)
 		return;
 
-	pthread_mutex_lock(&root_mutex);
-	thread_enabled = enabled;
-	pthread_mutex_unlock(&root_mutex);
+	thread_enabled = os_atomic_load_bool(&enabled);
 }
 
 static bool lock_root(void)
@@ -284,7 +291,6 @@ static bool lock_root(void)
 	pthread_mutex_lock(&root_mutex);
 	if (!enabled) {
 		pthread_mutex_unlock(&root_mutex);
-		thread_enabled = false;
 		return false;
 	}
 
@@ -325,6 +331,7 @@ void profile_register_root(const char *name, uint64_t expected_time_between_call
 }
 
 static void free_call_context(profile_call *context);
+static void free_call_children(profile_call *call);
 
 static void merge_context(profile_call *context)
 {
@@ -355,78 +362,356 @@ static void merge_context(profile_call *context)
 	free_call_context(prev_call);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Call recording
+ *
+ * profile_start/profile_end only touch data of the calling thread: a fixed
+ * size stack of active calls, and a ring of finished call records that
+ * nothing but the aggregator thread reads.  The aggregator rebuilds the call
+ * trees from the records and merges them like before.  Records of a thread
+ * arrive in the order calls end, so the children of a call always come
+ * before the call itself. */
+
+#define PROFILE_MAX_DEPTH 64
+#define PROFILE_THREAD_RECORDS 8192
+#define PROFILE_AGGREGATE_INTERVAL_MS 100
+
+/* records before this one were lost because the ring was full */
+#define PROFILE_RECORD_AFTER_LOSS (1 << 0)
+
+struct profile_record {
+	const char *name;
+#ifdef TRACK_OVERHEAD
+	uint64_t overhead_start;
+#endif
+	uint64_t start_time;
+	uint64_t end_time;
+#ifdef TRACK_OVERHEAD
+	uint64_t overhead_end;
+#endif
+	uint32_t depth;
+	uint32_t flags;
+};
+
+struct profile_active_call {
+	const char *name;
+#ifdef TRACK_OVERHEAD
+	uint64_t overhead_start;
+#endif
+	uint64_t start_time;
+};
+
+typedef struct profile_thread profile_thread;
+struct profile_thread {
+	struct spsc_ring records;
+	uint32_t id;
+	volatile bool exited;
+
+	/* recording thread only */
+	struct profile_active_call stack[PROFILE_MAX_DEPTH];
+	size_t depth;
+	size_t untracked_depth;
+	bool lost;
+
+	/* aggregator only, finished calls waiting for their parent */
+	DARRAY(profile_call) pending[PROFILE_MAX_DEPTH];
+};
+
+struct profile_trace_record {
+	struct profile_record record;
+	uint32_t thread_id;
+};
+
+/* threads_mutex protects the list of threads and the trace, and is held
+ * while aggregating, as only one thread may read the record rings */
+static pthread_mutex_t threads_mutex = PTHREAD_MUTEX_INITIALIZER;
+static DARRAY(profile_thread *) threads;
+static uint32_t next_thread_id = 0;
+static pthread_key_t thread_key;
+static bool thread_key_valid = false;
+
+/* invalidates thread_data of all threads when the profiler is freed */
+static volatile long thread_generation = 0;
+static THREAD_LOCAL profile_thread *thread_data = NULL;
+static THREAD_LOCAL long thread_data_generation = 0;
+
+static pthread_t aggregator_thread;
+static os_event_t *aggregator_stop = NULL;
+static bool aggregator_active = false;
+
+static bool tracing = false;
+static struct profile_trace_record *trace_records = NULL;
+static size_t trace_capacity = 0;
+static size_t trace_count = 0;
+
+static void profile_thread_exited(void *data)
+{
+	profile_thread *thread = data;
+	os_atomic_set_bool(&thread->exited, true);
+}
+
+static inline profile_thread *current_thread(void)
+{
+	if (thread_data_generation != os_atomic_load_long(&thread_generation))
+		thread_data = NULL;
+	return thread_data;
+}
+
+static profile_thread *register_thread(void)
+{
+	profile_thread *thread = bzalloc(sizeof(profile_thread));
+	spsc_ring_init(&thread->records, sizeof(struct profile_record), PROFILE_THREAD_RECORDS);
+
+	pthread_mutex_lock(&threads_mutex);
+	if (!thread_key_valid)
+		thread_key_valid = pthread_key_create(&thread_key, profile_thread_exited) == 0;
+	if (thread_key_valid)
+		pthread_setspecific(thread_key, thread);
+
+	thread->id = ++next_thread_id;
+	da_push_back(threads, &thread);
+	pthread_mutex_unlock(&threads_mutex);
+
+	thread_data = thread;
+	thread_data_generation = os_atomic_load_long(&thread_generation);
+	return thread;
+}
+
+static void free_thread(profile_thread *thread)
+{
+	for (size_t i = 0; i < PROFILE_MAX_DEPTH; i++) {
+		for (size_t j = 0; j < thread->pending[i].num; j++)
+			free_call_children(&thread->pending[i].array[j]);
+		da_free(thread->pending[i]);
+	}
+
+	spsc_ring_free(&thread->records);
+	bfree(thread);
+}
+
 void profile_start(const char *name)
 {
 	if (!thread_enabled)
 		return;
 
-	profile_call new_call = {
-		.name = name,
 #ifdef TRACK_OVERHEAD
-		.overhead_start = os_gettime_ns(),
+	uint64_t overhead_start = os_gettime_ns();
 #endif
-		.parent = thread_context,
-	};
+	profile_thread *thread = current_thread();
 
-	profile_call *call = NULL;
+	if (!thread || !thread->depth) {
+		if (!os_atomic_load_bool(&enabled)) {
+			thread_enabled = false;
+			return;
+		}
+		if (!thread)
+			thread = register_thread();
+	}
 
-	if (new_call.parent) {
-		size_t idx = da_push_back(new_call.parent->children, &new_call);
-		call = &new_call.parent->children.array[idx];
-	} else {
-		call = bmalloc(sizeof(profile_call));
-		memcpy(call, &new_call, sizeof(profile_call));
+	if (thread->depth == PROFILE_MAX_DEPTH) {
+		thread->untracked_depth++;
+		return;
 	}
 
-	thread_context = call;
+	struct profile_active_call *call = &thread->stack[thread->depth++];
+	call->name = name;
+#ifdef TRACK_OVERHEAD
+	call->overhead_start = overhead_start;
+#endif
 	call->start_time = os_gettime_ns();
 }
 
+static void record_call(profile_thread *thread, uint64_t end)
+{
+	struct profile_active_call *call = &thread->stack[--thread->depth];
+	struct profile_record record = {
+		.name = call->name,
+#ifdef TRACK_OVERHEAD
+		.overhead_start = call->overhead_start,
+#endif
+		.start_time = call->start_time,
+		.end_time = end,
+		.depth = (uint32_t)thread->depth,
+		.flags = thread->lost ? PROFILE_RECORD_AFTER_LOSS : 0,
+	};
+
+#ifdef TRACK_OVERHEAD
+	record.overhead_end = os_gettime_ns();
+#endif
+
+	thread->lost = !spsc_ring_push(&thread->records, &record, 0);
+}
+
 void profile_end(const char *name)
 {
 	uint64_t end = os_gettime_ns();
 	if (!thread_enabled)
 		return;
 
-	profile_call *call = thread_context;
-	if (!call) {
+	profile_thread *thread = current_thread();
+	if (!thread || (!thread->depth && !thread->untracked_depth)) {
 		blog(LOG_ERROR, "Called profile end with no active profile");
 		return;
 	}
 
-	if (!call->name)
-		call->name = name;
+	if (thread->untracked_depth) {
+		thread->untracked_depth--;
+		return;
+	}
 
-	if (call->name != name) {
+	const char *call_name = thread->stack[thread->depth - 1].name;
+	if (call_name != name) {
 		blog(LOG_ERROR,
 		     "Called profile end with mismatching name: "
 		     "start(\"%s\"[%p]) <-> end(\"%s\"[%p])",
-		     call->name, call->name, name, name);
+		     call_name, call_name, name, name);
 
-		profile_call *parent = call->parent;
-		while (parent && parent->parent && parent->name != name)
-			parent = parent->parent;
+		size_t idx = thread->depth - 1;
+		while (idx > 0 && thread->stack[idx - 1].name != name)
+			idx--;
 
-		if (!parent || parent->name != name)
+		if (idx == 0)
 			return;
 
-		while (call->name != name) {
-			profile_end(call->name);
-			call = call->parent;
-		}
+		while (thread->depth > idx)
+			record_call(thread, end);
+	}
+
+	record_call(thread, end);
+}
+
+/* ------------------------------------------------------------------------- */
+/* Aggregation */
+
+static void clear_pending_calls(profile_thread *thread)
+{
+	for (size_t i = 0; i < PROFILE_MAX_DEPTH; i++) {
+		for (size_t j = 0; j < thread->pending[i].num; j++)
+			free_call_children(&thread->pending[i].array[j]);
+		da_resize(thread->pending[i], 0);
 	}
+}
 
-	thread_context = call->parent;
+static void trace_record(profile_thread *thread, const struct profile_record *record)
+{
+	struct profile_trace_record *trace = &trace_records[trace_count++ % trace_capacity];
+	trace->record = *record;
+	trace->thread_id = thread->id;
+}
 
-	call->end_time = end;
+static void aggregate_record(profile_thread *thread, const struct profile_record *record)
+{
+	size_t depth = record->depth;
+	profile_call call = {
+		.name = record->name,
 #ifdef TRACK_OVERHEAD
-	call->overhead_end = os_gettime_ns();
+		.overhead_start = record->overhead_start,
 #endif
+		.start_time = record->start_time,
+		.end_time = record->end_time,
+#ifdef TRACK_OVERHEAD
+		.overhead_end = record->overhead_end,
+#endif
+	};
 
-	if (call->parent)
-		return;
+	if (tracing)
+		trace_record(thread, record);
+
+	/* parents of pending calls may have been lost */
+	if (record->flags & PROFILE_RECORD_AFTER_LOSS)
+		clear_pending_calls(thread);
+
+	if (depth + 1 < PROFILE_MAX_DEPTH)
+		da_move(call.children, thread->pending[depth + 1]);
+
+	if (depth == 0)
+		merge_context(bmemdup(&call, sizeof(call)));
+	else
+		da_push_back(thread->pending[depth], &call);
+}
+
+static void aggregate_threads_locked(void)
+{
+	struct profile_record record;
+
+	for (size_t i = threads.num; i > 0; i--) {
+		profile_thread *thread = threads.array[i - 1];
+		bool exited = os_atomic_load_bool(&thread->exited);
+
+		while (spsc_ring_pop(&thread->records, &record, NULL))
+			aggregate_record(thread, &record);
+
+		if (exited) {
+			free_thread(thread);
+			da_erase(threads, i - 1);
+		}
+	}
+}
+
+static void aggregate_threads(void)
+{
+	pthread_mutex_lock(&threads_mutex);
+	aggregate_threads_locked();
+	pthread_mutex_unlock(&threads_mutex);
+}
+
+static void *aggregator_thread_func(void *data)
+{
+	UNUSED_PARAMETER(data);
+
+	os_set_thread_name("libobs: profiler aggregator");
+
+	while (os_event_timedwait(aggregator_stop, PROFILE_AGGREGATE_INTERVAL_MS) == ETIMEDOUT)
+		aggregate_threads();
 
-	merge_context(call);
+	return NULL;
+}
+
+static void start_aggregator(void)
+{
+	pthread_mutex_lock(&threads_mutex);
+
+	if (!aggregator_active && os_event_init(&aggregator_stop, OS_EVENT_TYPE_MANUAL) == 0) {
+		aggregator_active = pthread_create(&aggregator_thread, NULL, aggregator_thread_func, NULL) == 0;
+		if (!aggregator_active) {
+			os_event_destroy(aggregator_stop);
+			aggregator_stop = NULL;
+		}
+	}
+
+	pthread_mutex_unlock(&threads_mutex);
+}
+
+static void free_threads(void)
+{
+	if (aggregator_active) {
+		os_event_signal(aggregator_stop);
+		pthread_join(aggregator_thread, NULL);
+		os_event_destroy(aggregator_stop);
+		aggregator_stop = NULL;
+		aggregator_active = false;
+	}
+
+	pthread_mutex_lock(&threads_mutex);
+
+	for (size_t i = 0; i < threads.num; i++)
+		free_thread(threads.array[i]);
+	da_free(threads);
+
+	/* threads still running must not touch their freed data */
+	if (thread_key_valid) {
+		pthread_key_delete(thread_key);
+		thread_key_valid = false;
+	}
+	os_atomic_inc_long(&thread_generation);
+
+	tracing = false;
+	bfree(trace_records);
+	trace_records = NULL;
+	trace_capacity = 0;
+	trace_count = 0;
+
+	pthread_mutex_unlock(&threads_mutex);
 }
 
 static int profiler_time_entry_compare(const void *first, const void *second)
@@ -768,8 +1053,10 @@ void profiler_free(void)
 {
 	DARRAY(profile_root_entry) old_root_entries = {0};
 
+	free_threads();
+
 	pthread_mutex_lock(&root_mutex);
-	enabled = false;
+	os_atomic_set_bool(&enabled, false);
 	da_move(old_root_entries, root_entries);
 	pthread_mutex_unlock(&root_mutex);
 
@@ -794,6 +1081,91 @@ void profiler_free(void)
 	pthread_mutex_destroy(&root_mutex);
 }
 
+/* ------------------------------------------------------------------------- */
+/* Profiler trace */
+
+void profiler_trace_start(size_t max_records)
+{
+	if (!max_records)
+		return;
+
+	pthread_mutex_lock(&threads_mutex);
+	bfree(trace_records);
+	trace_records = bmalloc(max_records * sizeof(struct profile_trace_record));
+	trace_capacity = max_records;
+	trace_count = 0;
+	tracing = true;
+	pthread_mutex_unlock(&threads_mutex);
+}
+
+void profiler_trace_stop(void)
+{
+	aggregate_threads();
+
+	pthread_mutex_lock(&threads_mutex);
+	tracing = false;
+	pthread_mutex_unlock(&threads_mutex);
+}
+
+static void dump_json_string(FILE *f, const char *str)
+{
+	fputc('"', f);
+
+	for (; *str; str++) {
+		unsigned char c = (unsigned char)*str;
+
+		if (c == '"' || c == '\\')
+			fprintf(f, "\\%c", c);
+		else if (c < 0x20)
+			fprintf(f, "\\u%04x", c);
+		else
+			fputc(c, f);
+	}
+
+	fputc('"', f);
+}
+
+bool profiler_trace_dump_json(const char *filename)
+{
+	FILE *f = os_fopen(filename, "wb");
+	if (!f)
+		return false;
+
+	aggregate_threads();
+
+	pthread_mutex_lock(&threads_mutex);
+
+	size_t num = trace_count < trace_capacity ? trace_count : trace_capacity;
+	size_t first = trace_count - num;
+	uint64_t base_time = UINT64_MAX;
+
+	for (size_t i = 0; i < num; i++) {
+		const struct profile_record *record = &trace_records[(first + i) % trace_capacity].record;
+		if (record->start_time < base_time)
+			base_time = record->start_time;
+	}
+
+	fputs("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[", f);
+
+	for (size_t i = 0; i < num; i++) {
+		const struct profile_trace_record *trace = &trace_records[(first + i) % trace_capacity];
+		const struct profile_record *record = &trace->record;
+
+		fputs(i ? ",\n{\"name\":" : "\n{\"name\":", f);
+		dump_json_string(f, record->name);
+		fprintf(f, ",\"cat\":\"obs\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%" PRIu32 "}",
+			(double)(record->start_time - base_time) / 1000.0,
+			(double)(record->end_time - record->start_time) / 1000.0, trace->thread_id);
+	}
+
+	fputs("\n]}\n", f);
+
+	pthread_mutex_unlock(&threads_mutex);
+
+	fclose(f);
+	return true;
+}
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
@@ -887,6 +1259,8 @@ profiler_snapshot_t *profile_snapshot_create(void)
 {
 	profiler_snapshot_t *snap = bzalloc(sizeof(profiler_snapshot_t));
 
+	aggregate_threads();
+
 	pthread_mutex_lock(&root_mutex);
 	da_reserve(snap->roots, root_entries.num);
 	for (size_t i = 0; i < root_entries.num; i++) {
@@ -32,6 +32,13 @@ EXPORT void profiler_print_time_between_calls(profiler_snapshot_t *snap);
 
 EXPORT void profiler_free(void);
 
+/* ------------------------------------------------------------------------- */
+/* Profiler trace */
+
+EXPORT void profiler_trace_start(size_t max_records);
+EXPORT void profiler_trace_stop(void);
+EXPORT bool profiler_trace_dump_json(const char *filename);
+
 /* ------------------------------------------------------------------------- */
 /* Profiler name storage */
 
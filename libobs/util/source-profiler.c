@@ -628,3 +628,52 @@ profiler_result_t *source_profiler_get_result(obs_source_t *source)
 	}
 	return ret;
 }
+
+static bool fill_memory_result(struct obs_context_data *context, struct memory_result *result)
+{
+	if (!result)
+		return false;
+
+	memset(result, 0, sizeof(struct memory_result));
+	if (!context)
+		return false;
+
+	pthread_mutex_lock(&context->memory_mutex);
+	result->bytes = context->memory_bytes;
+	result->bytes_max = context->memory_bytes_max;
+	result->allocations = context->memory_allocs;
+	pthread_mutex_unlock(&context->memory_mutex);
+	return true;
+}
+
+bool source_profiler_fill_memory_result(obs_source_t *source, struct memory_result *result)
+{
+	return fill_memory_result(source ? &source->context : NULL, result);
+}
+
+bool source_profiler_fill_encoder_memory_result(obs_encoder_t *encoder, struct memory_result *result)
+{
+	return fill_memory_result(encoder ? &encoder->context : NULL, result);
+}
+
+bool source_profiler_fill_output_memory_result(obs_output_t *output, struct memory_result *result)
+{
+	return fill_memory_result(output ? &output->context : NULL, result);
+}
+
+void source_profiler_enum_dropped_frames(obs_source_t *source,
+					 bool (*callback)(void *param, const char *stage, uint64_t dropped), void *param)
+{
+	if (!source || !callback)
+		return;
+
+	pthread_mutex_lock(&source->drop_mutex);
+
+	for (size_t i = 0; i < source->drop_counters.num; i++) {
+		struct source_drop_counter *counter = source->drop_counters.array + i;
+		if (!callback(param, counter->stage, counter->dropped))
+			break;
+	}
+
+	pthread_mutex_unlock(&source->drop_mutex);
+}
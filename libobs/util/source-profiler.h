@@ -51,6 +51,15 @@ typedef struct profiler_result {
 	uint64_t async_rendered_worst;
 } profiler_result_t;
 
+typedef struct memory_result {
+	/* Bytes currently attributed to the object */
+	uint64_t bytes;
+	/* Most bytes attributed to the object at once */
+	uint64_t bytes_max;
+	/* Number of attributed allocations still held */
+	uint64_t allocations;
+} memory_result_t;
+
 /* Enable/disable profiler (applied on next frame) */
 EXPORT void source_profiler_enable(bool enable);
 /* Enable/disable GPU profiling (applied on next frame) */
@@ -61,6 +70,18 @@ EXPORT profiler_result_t *source_profiler_get_result(obs_source_t *source);
 /* Update existing profiler results object for source */
 EXPORT bool source_profiler_fill_result(obs_source_t *source, profiler_result_t *result);
 
+/* Get memory attributed to a source, encoder or output (tracked even when the
+ * profiler is disabled, see obs_source_memory_add) */
+EXPORT bool source_profiler_fill_memory_result(obs_source_t *source, memory_result_t *result);
+EXPORT bool source_profiler_fill_encoder_memory_result(obs_encoder_t *encoder, memory_result_t *result);
+EXPORT bool source_profiler_fill_output_memory_result(obs_output_t *output, memory_result_t *result);
+
+/* Enumerate frames dropped by a source per stage (see
+ * obs_source_add_dropped_frames), return false from the callback to stop */
+EXPORT void source_profiler_enum_dropped_frames(obs_source_t *source,
+						bool (*callback)(void *param, const char *stage, uint64_t dropped),
+						void *param);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,228 @@
+/******************************************************************************
+    Copyright (C) 2026 by the OBS Project
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 2 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+******************************************************************************/
+
+#pragma once
+
+#include "c99defs.h"
+#include <string.h>
+
+#include "base.h"
+#include "bmem.h"
+#include "threading.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Bounded lock-free single-producer/single-consumer ring of fixed-size
+ * items, meant for handing encoded packets from an output's encoder callback
+ * to its send thread without either of them ever waiting on the other.
+ *
+ * Every item carries a priority.  The producer can request that queued items
+ * below a given priority be dropped (spsc_ring_drop); the items are marked
+ * in place and the consumer is told about it when it pops them, so it can
+ * release them instead of sending them.
+ *
+ * Positions are free-running counters; items at positions in
+ * [spsc_ring_tail, head) are queued.  The producer may inspect queued items
+ * with spsc_ring_at, as only the producer ever writes to a slot.
+ */
+
+struct spsc_ring {
+	uint8_t *data;
+	int *priorities;
+	volatile bool *dropped;
+
+	size_t item_size;
+	unsigned long mask;
+
+	/* written by the producer only */
+	volatile long head;
+	/* written by the consumer only */
+	volatile long tail;
+};
+
+/* capacity is rounded up to a power of two */
+static inline void spsc_ring_init(struct spsc_ring *ring, size_t item_size, size_t capacity)
+{
+	unsigned long size = 2;
+	while (size < capacity)
+		size <<= 1;
+
+	memset(ring, 0, sizeof(*ring));
+	ring->data = bmalloc(item_size * size);
+	ring->priorities = bzalloc(sizeof(*ring->priorities) * size);
+	ring->dropped = bzalloc(sizeof(*ring->dropped) * size);
+	ring->item_size = item_size;
+	ring->mask = size - 1;
+}
+
+static inline void spsc_ring_free(struct spsc_ring *ring)
+{
+	bfree(ring->data);
+	bfree(ring->priorities);
+	bfree((void *)ring->dropped);
+	memset(ring, 0, sizeof(*ring));
+}
+
+static inline size_t spsc_ring_capacity(const struct spsc_ring *ring)
+{
+	return ring->data ? (size_t)ring->mask + 1 : 0;
+}
+
+static inline unsigned long spsc_ring_head(const struct spsc_ring *ring)
+{
+	return (unsigned long)os_atomic_load_long(&ring->head);
+}
+
+static inline unsigned long spsc_ring_tail(const struct spsc_ring *ring)
+{
+	return (unsigned long)os_atomic_load_long(&ring->tail);
+}
+
+/* number of queued items; exact on the producer and consumer threads as far
+ * as their own side is concerned, a snapshot otherwise */
+static inline size_t spsc_ring_size(const struct spsc_ring *ring)
+{
+	return (size_t)(spsc_ring_head(ring) - spsc_ring_tail(ring));
+}
+
+static inline void *spsc_ring_at(const struct spsc_ring *ring, unsigned long pos)
+{
+	return ring->data + (size_t)(pos & ring->mask) * ring->item_size;
+}
+
+/* producer: whether the queued item at `pos` has been dropped */
+static inline bool spsc_ring_dropped(const struct spsc_ring *ring, unsigned long pos)
+{
+	return os_atomic_load_bool(&ring->dropped[pos & ring->mask]);
+}
+
+/* producer: returns false if the ring is full */
+static inline bool spsc_ring_push(struct spsc_ring *ring, const void *item, int priority)
+{
+	unsigned long head = (unsigned long)ring->head;
+	unsigned long idx = head & ring->mask;
+
+	if (head - spsc_ring_tail(ring) > ring->mask)
+		return false;
+
+	memcpy(spsc_ring_at(ring, head), item, ring->item_size);
+	ring->priorities[idx] = priority;
+	os_atomic_store_bool(&ring->dropped[idx], false);
+
+	os_atomic_store_long(&ring->head, (long)(head + 1));
+	return true;
+}
+
+/* producer: marks all queued items with a priority below `priority` as
+ * dropped, returns the number of items marked.  An item the consumer is
+ * popping at the same time may still be delivered as not dropped, so exact
+ * drop statistics should be kept on the consumer side. */
+static inline size_t spsc_ring_drop(struct spsc_ring *ring, int priority)
+{
+	unsigned long head = (unsigned long)ring->head;
+	size_t count = 0;
+
+	for (unsigned long pos = spsc_ring_tail(ring); pos != head; pos++) {
+		unsigned long idx = pos & ring->mask;
+
+		if (ring->priorities[idx] < priority && !os_atomic_load_bool(&ring->dropped[idx])) {
+			os_atomic_store_bool(&ring->dropped[idx], true);
+			count++;
+		}
+	}
+
+	return count;
+}
+
+/* consumer: pops the oldest item, returns false if the ring is empty.
+ * `dropped` is set if the producer dropped the item while it was queued. */
+static inline bool spsc_ring_pop(struct spsc_ring *ring, void *item, bool *dropped)
+{
+	unsigned long tail = (unsigned long)ring->tail;
+
+	if (tail == spsc_ring_head(ring))
+		return false;
+
+	memcpy(item, spsc_ring_at(ring, tail), ring->item_size);
+	if (dropped)
+		*dropped = os_atomic_load_bool(&ring->dropped[tail & ring->mask]);
+
+	os_atomic_store_long(&ring->tail, (long)(tail + 1));
+	return true;
+}
+
+/*
+ * Producer-side drop policy for rings of encoded packets that are dropped
+ * rather than waited on when the ring is full.  Audio and video keyframes are
+ * queued whenever there is room; once a video packet did not fit, video is
+ * dropped until the next keyframe, as the frames in between cannot be
+ * decoded.  The ring filling up is logged once, and the number of packets
+ * dropped is logged once packets are queued normally again.
+ */
+
+struct spsc_ring_overflow {
+	bool full;
+	bool skip_video;
+	size_t dropped;
+};
+
+static inline void spsc_ring_overflow_reset(struct spsc_ring_overflow *overflow)
+{
+	memset(overflow, 0, sizeof(*overflow));
+}
+
+/* producer: pushes an encoded packet following the policy above, returns
+ * false if it was dropped.  `name` identifies the output in the log. */
+static inline bool spsc_ring_push_packet(struct spsc_ring *ring, struct spsc_ring_overflow *overflow,
+					 const char *name, const void *item, int priority, bool video,
+					 bool keyframe)
+{
+	if (video && overflow->skip_video) {
+		if (!keyframe) {
+			overflow->dropped++;
+			return false;
+		}
+		overflow->skip_video = false;
+	}
+
+	if (!spsc_ring_push(ring, item, priority)) {
+		if (!overflow->full) {
+			blog(LOG_WARNING, "Output '%s': Packet queue full, dropping packets", name);
+			overflow->full = true;
+		}
+		if (video)
+			overflow->skip_video = true;
+		overflow->dropped++;
+		return false;
+	}
+
+	if (overflow->full && !overflow->skip_video) {
+		blog(LOG_WARNING, "Output '%s': Packet queue has room again, dropped %zu packet(s)", name,
+		     overflow->dropped);
+		overflow->full = false;
+		overflow->dropped = 0;
+	}
+
+	return true;
+}
+
+#ifdef __cplusplus
+}
+#endif
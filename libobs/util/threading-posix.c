@@ -257,6 +257,8 @@ int os_sem_wait(os_sem_t *sem)
 
 void os_set_thread_name(const char *name)
 {
+	bmem_pool_set_thread_name(name);
+
 #if defined(__APPLE__)
 	pthread_setname_np(name);
 #elif defined(__FreeBSD__)
@@ -24,6 +24,7 @@ struct image_source {
 	uint64_t last_time;
 	bool active;
 	bool restart_gif;
+	bool defer_texture;
 	volatile bool file_decoded;
 	volatile bool texture_loaded;
 
@@ -53,6 +54,7 @@ void image_source_preload_image(void *data)
 	context->file_timestamp = get_modified_timestamp(context->file);
 	gs_image_file4_init(&context->if4, context->file,
 			    context->linear_alpha ? GS_IMAGE_ALPHA_PREMULTIPLY_SRGB : GS_IMAGE_ALPHA_PREMULTIPLY);
+	obs_source_memory_add(context->source, (size_t)context->if4.image3.image2.mem_usage);
 	os_atomic_set_bool(&context->file_decoded, true);
 }
 
@@ -77,9 +79,15 @@ static void image_source_load_texture(void *data)
 static void image_source_unload(void *data)
 {
 	struct image_source *context = data;
-	os_atomic_set_bool(&context->file_decoded, false);
+	bool decoded = os_atomic_exchange_bool(&context->file_decoded, false);
 	os_atomic_set_bool(&context->texture_loaded, false);
 
+	/* nothing to free, and no reason to wait for the graphics thread */
+	if (!decoded)
+		return;
+
+	obs_source_memory_remove(context->source, (size_t)context->if4.image3.image2.mem_usage);
+
 	obs_enter_graphics();
 	gs_image_file4_free(&context->if4);
 	obs_leave_graphics();
@@ -91,7 +99,8 @@ static void image_source_load(struct image_source *context)
 
 	if (context->file && *context->file) {
 		image_source_preload_image(context);
-		image_source_load_texture(context);
+		if (!context->defer_texture)
+			image_source_load_texture(context);
 	}
 }
 
@@ -170,7 +179,11 @@ static void *image_source_create(obs_data_t *settings, obs_source_t *source)
 	struct image_source *context = bzalloc(sizeof(struct image_source));
 	context->source = source;
 
+	/* the texture is uploaded on the next tick, so that creation does not
+	 * need the graphics context and can run off the UI thread */
+	context->defer_texture = true;
 	image_source_update(context, settings);
+	context->defer_texture = false;
 	return context;
 }
 
@@ -363,7 +376,7 @@ static enum gs_color_space image_source_get_color_space(void *data, size_t count
 static struct obs_source_info image_source_info = {
 	.id = "image_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
-	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB,
+	.output_flags = OBS_SOURCE_VIDEO | OBS_SOURCE_SRGB | OBS_SOURCE_PARALLEL_CREATE,
 	.get_name = image_source_get_name,
 	.create = image_source_create,
 	.destroy = image_source_destroy,
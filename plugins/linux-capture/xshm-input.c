@@ -18,13 +18,17 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 #include <stdio.h>
 #include <stdlib.h>
 #include <inttypes.h>
+#include <xcb/damage.h>
 #include <xcb/randr.h>
 #include <xcb/shm.h>
 #include <xcb/xfixes.h>
 #include <xcb/xinerama.h>
 
 #include <obs-module.h>
+#include <util/darray.h>
 #include <util/dstr.h>
+#include <util/platform.h>
+#include <util/threading.h>
 #include "xcursor-xcb.h"
 #include "xhelpers.h"
 
@@ -34,6 +38,11 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define INVALID_DISPLAY (-1)
 
+/* damaged rectangles fetched separately before falling back to their
+ * bounding box, and rectangles queued for upload before merging them */
+#define MAX_DAMAGE_RECTS 16
+#define MAX_DIRTY_RECTS 64
+
 struct xshm_data {
 	obs_source_t *source;
 
@@ -65,6 +74,21 @@ struct xshm_data {
 	bool use_xinerama;
 	bool use_randr;
 	bool advanced;
+
+	/* capture thread */
+	pthread_t capture_thread;
+	os_event_t *stop_event;
+	bool capture_thread_active;
+	bool use_damage;
+	bool capture_full;
+	xcb_damage_damage_t damage;
+	xcb_xfixes_region_t damage_region;
+	DARRAY(struct gs_rect) damage_rects;
+
+	/* captured image and the regions not yet uploaded */
+	pthread_mutex_t frame_mutex;
+	uint8_t *frame;
+	DARRAY(struct gs_rect) dirty_rects;
 };
 
 /**
@@ -102,6 +126,242 @@ static bool xshm_check_extensions(xcb_connection_t *xcb)
 	return ok;
 }
 
+/**
+ * Start tracking damage of the root window
+ *
+ * @return false if the Damage extension is missing
+ */
+static bool xshm_init_damage(struct xshm_data *data)
+{
+	xcb_damage_query_version_cookie_t ver_c;
+
+	if (!xcb_get_extension_data(data->xcb, &xcb_damage_id)->present ||
+	    !xcb_get_extension_data(data->xcb, &xcb_xfixes_id)->present) {
+		blog(LOG_INFO, "Missing Damage extension, capturing full frames");
+		return false;
+	}
+
+	ver_c = xcb_damage_query_version(data->xcb, XCB_DAMAGE_MAJOR_VERSION, XCB_DAMAGE_MINOR_VERSION);
+	free(xcb_damage_query_version_reply(data->xcb, ver_c, NULL));
+
+	data->damage = xcb_generate_id(data->xcb);
+	xcb_damage_create(data->xcb, data->damage, data->xcb_screen->root, XCB_DAMAGE_REPORT_LEVEL_NON_EMPTY);
+
+	data->damage_region = xcb_generate_id(data->xcb);
+	xcb_xfixes_create_region(data->xcb, data->damage_region, 0, NULL);
+
+	xcb_flush(data->xcb);
+	return true;
+}
+
+static void xshm_free_damage(struct xshm_data *data)
+{
+	if (!data->use_damage)
+		return;
+
+	xcb_damage_destroy(data->xcb, data->damage);
+	xcb_xfixes_destroy_region(data->xcb, data->damage_region);
+	xcb_flush(data->xcb);
+	data->use_damage = false;
+}
+
+static void get_bounding_rect(struct gs_rect *rects, size_t num, struct gs_rect *bounds)
+{
+	int x1 = rects[0].x, y1 = rects[0].y;
+	int x2 = rects[0].x + rects[0].cx, y2 = rects[0].y + rects[0].cy;
+
+	for (size_t i = 1; i < num; i++) {
+		if (rects[i].x < x1)
+			x1 = rects[i].x;
+		if (rects[i].y < y1)
+			y1 = rects[i].y;
+		if (rects[i].x + rects[i].cx > x2)
+			x2 = rects[i].x + rects[i].cx;
+		if (rects[i].y + rects[i].cy > y2)
+			y2 = rects[i].y + rects[i].cy;
+	}
+
+	bounds->x = x1;
+	bounds->y = y1;
+	bounds->cx = x2 - x1;
+	bounds->cy = y2 - y1;
+}
+
+/**
+ * Get the rectangles of the capture region changed since the last call
+ *
+ * The rectangles are relative to the capture region.
+ */
+static void xshm_fetch_damage(struct xshm_data *data)
+{
+	xcb_xfixes_fetch_region_cookie_t region_c;
+	xcb_xfixes_fetch_region_reply_t *region_r;
+
+	da_resize(data->damage_rects, 0);
+
+	xcb_damage_subtract(data->xcb, data->damage, XCB_NONE, data->damage_region);
+	region_c = xcb_xfixes_fetch_region(data->xcb, data->damage_region);
+	region_r = xcb_xfixes_fetch_region_reply(data->xcb, region_c, NULL);
+	if (!region_r)
+		return;
+
+	xcb_rectangle_t *rects = xcb_xfixes_fetch_region_rectangles(region_r);
+	int count = xcb_xfixes_fetch_region_rectangles_length(region_r);
+
+	for (int i = 0; i < count; i++) {
+		int x1 = rects[i].x - (int)data->adj_x_org;
+		int y1 = rects[i].y - (int)data->adj_y_org;
+		int x2 = x1 + rects[i].width;
+		int y2 = y1 + rects[i].height;
+
+		if (x1 < 0)
+			x1 = 0;
+		if (y1 < 0)
+			y1 = 0;
+		if (x2 > data->adj_width)
+			x2 = data->adj_width;
+		if (y2 > data->adj_height)
+			y2 = data->adj_height;
+		if (x2 <= x1 || y2 <= y1)
+			continue;
+
+		struct gs_rect rect = {x1, y1, x2 - x1, y2 - y1};
+		da_push_back(data->damage_rects, &rect);
+	}
+
+	free(region_r);
+
+	/* a single larger request is cheaper than many small ones */
+	if (data->damage_rects.num > MAX_DAMAGE_RECTS) {
+		get_bounding_rect(data->damage_rects.array, data->damage_rects.num, data->damage_rects.array);
+		da_resize(data->damage_rects, 1);
+	}
+}
+
+/**
+ * Copy a region of the screen into the captured image
+ *
+ * @note called from the capture thread
+ */
+static bool xshm_capture_rect(struct xshm_data *data, const struct gs_rect *rect)
+{
+	xcb_shm_get_image_cookie_t img_c;
+	xcb_shm_get_image_reply_t *img_r;
+
+	img_c = xcb_shm_get_image_unchecked(data->xcb, data->xcb_screen->root, data->adj_x_org + rect->x,
+					    data->adj_y_org + rect->y, rect->cx, rect->cy, ~0,
+					    XCB_IMAGE_FORMAT_Z_PIXMAP, data->xshm->seg, 0);
+
+	img_r = xcb_shm_get_image_reply(data->xcb, img_c, NULL);
+	if (!img_r)
+		return false;
+	free(img_r);
+
+	const size_t linesize = (size_t)data->adj_width * 4;
+	const size_t row_size = (size_t)rect->cx * 4;
+	const uint8_t *src = data->xshm->data;
+	uint8_t *dst = data->frame + (size_t)rect->y * linesize + (size_t)rect->x * 4;
+
+	pthread_mutex_lock(&data->frame_mutex);
+
+	for (int y = 0; y < rect->cy; y++)
+		memcpy(dst + y * linesize, src + y * row_size, row_size);
+
+	da_push_back(data->dirty_rects, rect);
+	if (data->dirty_rects.num > MAX_DIRTY_RECTS) {
+		get_bounding_rect(data->dirty_rects.array, data->dirty_rects.num, data->dirty_rects.array);
+		da_resize(data->dirty_rects, 1);
+	}
+
+	pthread_mutex_unlock(&data->frame_mutex);
+	return true;
+}
+
+/**
+ * Capture thread
+ *
+ * Fetches the regions reported as damaged once per frame, or the whole
+ * capture region without the Damage extension, so the graphics thread only
+ * uploads what changed.
+ */
+static void *xshm_capture_thread(void *vptr)
+{
+	XSHM_DATA(vptr);
+	struct obs_video_info ovi;
+	unsigned long interval_ms = 16;
+	xcb_generic_event_t *event;
+
+	os_set_thread_name("xshm: capture");
+
+	if (obs_get_video_info(&ovi) && ovi.fps_num)
+		interval_ms = 1000UL * ovi.fps_den / ovi.fps_num;
+	if (!interval_ms)
+		interval_ms = 1;
+
+	while (os_event_timedwait(data->stop_event, interval_ms) == ETIMEDOUT) {
+		/* damage notifications are not needed, the region is
+		 * queried directly */
+		while ((event = xcb_poll_for_event(data->xcb)) != NULL)
+			free(event);
+
+		if (!obs_source_showing(data->source))
+			continue;
+
+		if (data->use_damage)
+			xshm_fetch_damage(data);
+
+		if (!data->use_damage || data->capture_full) {
+			struct gs_rect full = {0, 0, (int)data->adj_width, (int)data->adj_height};
+
+			da_resize(data->damage_rects, 0);
+			da_push_back(data->damage_rects, &full);
+			data->capture_full = false;
+		}
+
+		for (size_t i = 0; i < data->damage_rects.num; i++) {
+			if (!xshm_capture_rect(data, &data->damage_rects.array[i]))
+				break;
+		}
+	}
+
+	return NULL;
+}
+
+static void xshm_stop_capture_thread(struct xshm_data *data)
+{
+	if (data->capture_thread_active) {
+		os_event_signal(data->stop_event);
+		pthread_join(data->capture_thread, NULL);
+		data->capture_thread_active = false;
+	}
+
+	os_event_destroy(data->stop_event);
+	data->stop_event = NULL;
+
+	xshm_free_damage(data);
+
+	pthread_mutex_lock(&data->frame_mutex);
+	bfree(data->frame);
+	data->frame = NULL;
+	da_resize(data->dirty_rects, 0);
+	pthread_mutex_unlock(&data->frame_mutex);
+}
+
+static bool xshm_start_capture_thread(struct xshm_data *data)
+{
+	data->frame = bzalloc((size_t)data->adj_width * data->adj_height * 4);
+	data->use_damage = xshm_init_damage(data);
+	data->capture_full = true;
+
+	if (os_event_init(&data->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
+		return false;
+	if (pthread_create(&data->capture_thread, NULL, xshm_capture_thread, data) != 0)
+		return false;
+
+	data->capture_thread_active = true;
+	return true;
+}
+
 /**
  * Update the capture
  *
@@ -184,6 +444,8 @@ static const char *xshm_getname(void *unused)
  */
 static void xshm_capture_stop(struct xshm_data *data)
 {
+	xshm_stop_capture_thread(data);
+
 	obs_enter_graphics();
 
 	if (data->texture) {
@@ -262,6 +524,11 @@ static void xshm_capture_start(struct xshm_data *data)
 
 	obs_leave_graphics();
 
+	if (!xshm_start_capture_thread(data)) {
+		blog(LOG_ERROR, "failed to start capture thread !");
+		goto fail;
+	}
+
 	return;
 fail:
 	xshm_capture_stop(data);
@@ -465,6 +732,9 @@ static void xshm_destroy(void *vptr)
 
 	xshm_capture_stop(data);
 
+	da_free(data->damage_rects);
+	da_free(data->dirty_rects);
+	pthread_mutex_destroy(&data->frame_mutex);
 	bfree(data);
 }
 
@@ -475,6 +745,7 @@ static void *xshm_create(obs_data_t *settings, obs_source_t *source)
 {
 	struct xshm_data *data = bzalloc(sizeof(struct xshm_data));
 	data->source = source;
+	pthread_mutex_init(&data->frame_mutex, NULL);
 
 	xshm_update(data, settings);
 
@@ -482,7 +753,7 @@ static void *xshm_create(obs_data_t *settings, obs_source_t *source)
 }
 
 /**
- * Prepare the capture data
+ * Upload the regions changed since the last tick
  */
 static void xshm_video_tick(void *vptr, float seconds)
 {
@@ -494,27 +765,19 @@ static void xshm_video_tick(void *vptr, float seconds)
 	if (!obs_source_showing(data->source))
 		return;
 
-	xcb_shm_get_image_cookie_t img_c;
-	xcb_shm_get_image_reply_t *img_r;
-
-	img_c = xcb_shm_get_image_unchecked(data->xcb, data->xcb_screen->root, data->adj_x_org, data->adj_y_org,
-					    data->adj_width, data->adj_height, ~0, XCB_IMAGE_FORMAT_Z_PIXMAP,
-					    data->xshm->seg, 0);
-
-	img_r = xcb_shm_get_image_reply(data->xcb, img_c, NULL);
-
-	if (!img_r)
-		goto exit;
-
 	obs_enter_graphics();
 
-	gs_texture_set_image(data->texture, (void *)data->xshm->data, data->adj_width * 4, false);
+	pthread_mutex_lock(&data->frame_mutex);
+	if (data->dirty_rects.num) {
+		gs_texture_set_image_rects(data->texture, data->frame, data->adj_width * 4, data->dirty_rects.array,
+					   data->dirty_rects.num);
+		da_resize(data->dirty_rects, 0);
+	}
+	pthread_mutex_unlock(&data->frame_mutex);
+
 	xcb_xcursor_update(data->xcb, data->cursor);
 
 	obs_leave_graphics();
-
-exit:
-	free(img_r);
 }
 
 /**
@@ -0,0 +1,497 @@
+/* audio-capture.c
+ *
+ * Copyright (C) 2026 by the OBS Project
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 2 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ */
+
+#include "audio-capture.h"
+#include "pipewire.h"
+
+#include <util/darray.h>
+#include <util/platform.h>
+#include <util/util_uint64.h>
+
+#include <spa/param/audio/format-utils.h>
+#include <spa/utils/result.h>
+
+/* Audio is requested as float planar at the sample rate and speaker layout of
+ * libobs, so the converter of the stream delivers blocks that libobs can mix
+ * without resampling them again.  A small quantum is requested to keep the
+ * latency low, the graph may still run with a larger one. */
+#define CAPTURE_QUANTUM 256
+
+#define SEC_TO_NSEC 1000000000ULL
+
+#if PW_CHECK_VERSION(0, 3, 64)
+#define TARGET_OBJECT_KEY PW_KEY_TARGET_OBJECT
+#else
+#define TARGET_OBJECT_KEY PW_KEY_NODE_TARGET
+#endif
+
+struct audio_node {
+	uint32_t id;
+	char *name;
+	char *description;
+};
+
+struct pipewire_audio_capture {
+	obs_source_t *source;
+	bool output;
+
+	obs_pipewire *obs_pw;
+
+	/* protected by the thread loop lock */
+	DARRAY(struct audio_node) nodes;
+
+	struct pw_stream *stream;
+	struct spa_hook stream_listener;
+	char *device_id;
+
+	struct spa_audio_info_raw format;
+	enum speaker_layout speakers;
+};
+
+static enum speaker_layout channels_to_speakers(uint32_t channels)
+{
+	switch (channels) {
+	case 1:
+		return SPEAKERS_MONO;
+	case 2:
+		return SPEAKERS_STEREO;
+	case 3:
+		return SPEAKERS_2POINT1;
+	case 4:
+		return SPEAKERS_4POINT0;
+	case 5:
+		return SPEAKERS_4POINT1;
+	case 6:
+		return SPEAKERS_5POINT1;
+	case 8:
+		return SPEAKERS_7POINT1;
+	default:
+		return SPEAKERS_UNKNOWN;
+	}
+}
+
+static void set_channel_positions(enum speaker_layout speakers, uint32_t *position)
+{
+	position[0] = SPA_AUDIO_CHANNEL_FL;
+	position[1] = SPA_AUDIO_CHANNEL_FR;
+	position[2] = SPA_AUDIO_CHANNEL_FC;
+	position[3] = SPA_AUDIO_CHANNEL_LFE;
+	position[4] = SPA_AUDIO_CHANNEL_RL;
+	position[5] = SPA_AUDIO_CHANNEL_RR;
+	position[6] = SPA_AUDIO_CHANNEL_SL;
+	position[7] = SPA_AUDIO_CHANNEL_SR;
+
+	switch (speakers) {
+	case SPEAKERS_MONO:
+		position[0] = SPA_AUDIO_CHANNEL_MONO;
+		break;
+	case SPEAKERS_2POINT1:
+		position[2] = SPA_AUDIO_CHANNEL_LFE;
+		break;
+	case SPEAKERS_4POINT0:
+		position[3] = SPA_AUDIO_CHANNEL_RC;
+		break;
+	case SPEAKERS_4POINT1:
+		position[4] = SPA_AUDIO_CHANNEL_RC;
+		break;
+	default:
+		break;
+	}
+}
+
+/* The graph clock is CLOCK_MONOTONIC, the same clock as os_gettime_ns().  The
+ * first frame of a block was captured the duration of the block plus the
+ * delay of the graph before the cycle started. */
+static uint64_t get_timestamp(struct pipewire_audio_capture *pwac, uint32_t frames)
+{
+	struct pw_time t = {0};
+	uint64_t now = os_gettime_ns();
+	uint64_t latency = util_mul_div64(frames, SEC_TO_NSEC, pwac->format.rate);
+
+#if PW_CHECK_VERSION(0, 3, 50)
+	pw_stream_get_time_n(pwac->stream, &t, sizeof(t));
+#else
+	pw_stream_get_time(pwac->stream, &t);
+#endif
+
+	if (t.now > 0 && (uint64_t)t.now <= now) {
+		now = (uint64_t)t.now;
+
+		if (t.delay > 0 && t.rate.denom)
+			latency += util_mul_div64((uint64_t)t.delay, SEC_TO_NSEC * t.rate.num, t.rate.denom);
+	}
+
+	return now > latency ? now - latency : 0;
+}
+
+/* ------------------------------------------------- */
+
+static void on_process_cb(void *user_data)
+{
+	struct pipewire_audio_capture *pwac = user_data;
+	struct obs_source_audio out = {0};
+	struct spa_buffer *buffer;
+	struct pw_buffer *b;
+	uint32_t channels = pwac->format.channels;
+
+	b = pw_stream_dequeue_buffer(pwac->stream);
+	if (!b)
+		return;
+
+	buffer = b->buffer;
+	if (!channels || channels > MAX_AV_PLANES || buffer->n_datas < channels)
+		goto queue;
+
+	out.frames = buffer->datas[0].chunk->size / sizeof(float);
+	if (!out.frames)
+		goto queue;
+
+	for (uint32_t i = 0; i < channels; i++) {
+		struct spa_data *d = &buffer->datas[i];
+
+		if (!d->data || d->chunk->size / sizeof(float) < out.frames)
+			goto queue;
+
+		out.data[i] = SPA_PTROFF(d->data, d->chunk->offset % d->maxsize, uint8_t);
+	}
+
+	out.speakers = pwac->speakers;
+	out.format = AUDIO_FORMAT_FLOAT_PLANAR;
+	out.samples_per_sec = pwac->format.rate;
+	out.timestamp = get_timestamp(pwac, out.frames);
+
+	obs_source_output_audio(pwac->source, &out);
+
+queue:
+	pw_stream_queue_buffer(pwac->stream, b);
+}
+
+static void on_param_changed_cb(void *user_data, uint32_t id, const struct spa_pod *param)
+{
+	struct pipewire_audio_capture *pwac = user_data;
+	uint32_t media_type, media_subtype;
+
+	if (!param || id != SPA_PARAM_Format)
+		return;
+
+	if (spa_format_parse(param, &media_type, &media_subtype) < 0 || media_type != SPA_MEDIA_TYPE_audio ||
+	    media_subtype != SPA_MEDIA_SUBTYPE_raw)
+		return;
+
+	if (spa_format_audio_raw_parse(param, &pwac->format) < 0 || pwac->format.format != SPA_AUDIO_FORMAT_F32P ||
+	    channels_to_speakers(pwac->format.channels) == SPEAKERS_UNKNOWN || !pwac->format.rate) {
+		blog(LOG_WARNING, "[pipewire-audio] Unsupported format negotiated for '%s'",
+		     obs_source_get_name(pwac->source));
+		pwac->format.channels = 0;
+		return;
+	}
+
+	pwac->speakers = channels_to_speakers(pwac->format.channels);
+
+	blog(LOG_INFO, "[pipewire-audio] '%s': %" PRIu32 " Hz, %" PRIu32 " channels",
+	     obs_source_get_name(pwac->source), pwac->format.rate, pwac->format.channels);
+}
+
+static void on_state_changed_cb(void *user_data, enum pw_stream_state old, enum pw_stream_state state,
+				const char *error)
+{
+	UNUSED_PARAMETER(old);
+
+	struct pipewire_audio_capture *pwac = user_data;
+
+	blog(LOG_INFO, "[pipewire-audio] '%s' stream state: %s%s%s", obs_source_get_name(pwac->source),
+	     pw_stream_state_as_string(state), error ? ": " : "", error ? error : "");
+}
+
+static const struct pw_stream_events stream_events = {
+	PW_VERSION_STREAM_EVENTS,
+	.state_changed = on_state_changed_cb,
+	.param_changed = on_param_changed_cb,
+	.process = on_process_cb,
+};
+
+/* Without PW_STREAM_FLAG_RT_PROCESS the process event is dispatched on the
+ * thread loop, which keeps the locking of libobs off the real-time thread. */
+static void connect_stream(struct pipewire_audio_capture *pwac)
+{
+	struct pw_thread_loop *thread_loop = obs_pipewire_get_thread_loop(pwac->obs_pw);
+	struct spa_audio_info_raw info = {0};
+	struct pw_properties *props;
+	const struct spa_pod *params[1];
+	struct obs_audio_info oai;
+	uint8_t buffer[1024];
+
+	obs_get_audio_info(&oai);
+
+	struct spa_pod_builder pod_builder = SPA_POD_BUILDER_INIT(buffer, sizeof(buffer));
+
+	info.format = SPA_AUDIO_FORMAT_F32P;
+	info.rate = oai.samples_per_sec;
+	info.channels = get_audio_channels(oai.speakers);
+	set_channel_positions(oai.speakers, info.position);
+	params[0] = spa_format_audio_raw_build(&pod_builder, SPA_PARAM_EnumFormat, &info);
+
+	props = pw_properties_new(PW_KEY_MEDIA_TYPE, "Audio", PW_KEY_MEDIA_CATEGORY, "Capture", PW_KEY_MEDIA_ROLE,
+				  "Production", PW_KEY_NODE_DESCRIPTION, obs_source_get_name(pwac->source), NULL);
+	pw_properties_setf(props, PW_KEY_NODE_LATENCY, "%u/%u", CAPTURE_QUANTUM, oai.samples_per_sec);
+
+	if (pwac->output)
+		pw_properties_set(props, PW_KEY_STREAM_CAPTURE_SINK, "true");
+	if (strcmp(pwac->device_id, "default") != 0)
+		pw_properties_set(props, TARGET_OBJECT_KEY, pwac->device_id);
+
+	pw_thread_loop_lock(thread_loop);
+
+	pwac->format.channels = 0;
+	pwac->stream = pw_stream_new(obs_pipewire_get_core(pwac->obs_pw), "OBS Audio Capture", props);
+	if (!pwac->stream) {
+		blog(LOG_WARNING, "[pipewire-audio] Failed to create stream for '%s'", obs_source_get_name(pwac->source));
+		pw_thread_loop_unlock(thread_loop);
+		return;
+	}
+
+	pw_stream_add_listener(pwac->stream, &pwac->stream_listener, &stream_events, pwac);
+	pw_stream_connect(pwac->stream, PW_DIRECTION_INPUT, PW_ID_ANY,
+			  PW_STREAM_FLAG_AUTOCONNECT | PW_STREAM_FLAG_MAP_BUFFERS, params, 1);
+
+	pw_thread_loop_unlock(thread_loop);
+
+	blog(LOG_INFO, "[pipewire-audio] Capturing '%s' in '%s'", pwac->device_id, obs_source_get_name(pwac->source));
+}
+
+static void disconnect_stream(struct pipewire_audio_capture *pwac)
+{
+	struct pw_thread_loop *thread_loop;
+
+	if (!pwac->stream)
+		return;
+
+	thread_loop = obs_pipewire_get_thread_loop(pwac->obs_pw);
+
+	pw_thread_loop_lock(thread_loop);
+	pw_stream_disconnect(pwac->stream);
+	spa_hook_remove(&pwac->stream_listener);
+	pw_stream_destroy(pwac->stream);
+	pwac->stream = NULL;
+	pw_thread_loop_unlock(thread_loop);
+}
+
+/* ------------------------------------------------- */
+
+static bool is_capture_node(const struct pipewire_audio_capture *pwac, const char *media_class)
+{
+	if (!media_class)
+		return false;
+	if (pwac->output)
+		return strcmp(media_class, "Audio/Sink") == 0;
+
+	return strncmp(media_class, "Audio/Source", 12) == 0 || strcmp(media_class, "Audio/Duplex") == 0;
+}
+
+static void on_registry_global_cb(void *user_data, uint32_t id, uint32_t permissions, const char *type,
+				  uint32_t version, const struct spa_dict *props)
+{
+	UNUSED_PARAMETER(permissions);
+	UNUSED_PARAMETER(version);
+
+	struct pipewire_audio_capture *pwac = user_data;
+	const char *name, *description;
+
+	if (strcmp(type, PW_TYPE_INTERFACE_Node) != 0 || !props)
+		return;
+	if (!is_capture_node(pwac, spa_dict_lookup(props, PW_KEY_MEDIA_CLASS)))
+		return;
+
+	name = spa_dict_lookup(props, PW_KEY_NODE_NAME);
+	if (!name)
+		return;
+
+	description = spa_dict_lookup(props, PW_KEY_NODE_DESCRIPTION);
+
+	struct audio_node *node = da_push_back_new(pwac->nodes);
+	node->id = id;
+	node->name = bstrdup(name);
+	node->description = bstrdup(description ? description : name);
+
+	obs_source_update_properties(pwac->source);
+}
+
+static void on_registry_global_remove_cb(void *user_data, uint32_t id)
+{
+	struct pipewire_audio_capture *pwac = user_data;
+
+	for (size_t i = 0; i < pwac->nodes.num; i++) {
+		struct audio_node *node = &pwac->nodes.array[i];
+		if (node->id != id)
+			continue;
+
+		bfree(node->name);
+		bfree(node->description);
+		da_erase(pwac->nodes, i);
+
+		obs_source_update_properties(pwac->source);
+		break;
+	}
+}
+
+static const struct pw_registry_events registry_events = {
+	PW_VERSION_REGISTRY_EVENTS,
+	.global = on_registry_global_cb,
+	.global_remove = on_registry_global_remove_cb,
+};
+
+/* obs_source_info methods */
+
+static const char *pipewire_audio_input_get_name(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return obs_module_text("PipeWireAudioInput");
+}
+
+static const char *pipewire_audio_output_get_name(void *data)
+{
+	UNUSED_PARAMETER(data);
+	return obs_module_text("PipeWireAudioOutput");
+}
+
+static void pipewire_audio_capture_update(void *data, obs_data_t *settings)
+{
+	struct pipewire_audio_capture *pwac = data;
+	const char *device_id = obs_data_get_string(settings, "device_id");
+
+	if (!pwac->obs_pw)
+		return;
+	if (pwac->stream && pwac->device_id && strcmp(pwac->device_id, device_id) == 0)
+		return;
+
+	disconnect_stream(pwac);
+
+	bfree(pwac->device_id);
+	pwac->device_id = bstrdup(*device_id ? device_id : "default");
+
+	connect_stream(pwac);
+}
+
+static void *pipewire_audio_capture_create(obs_data_t *settings, obs_source_t *source, bool output)
+{
+	struct pipewire_audio_capture *pwac = bzalloc(sizeof(*pwac));
+
+	pwac->source = source;
+	pwac->output = output;
+
+	pwac->obs_pw = obs_pipewire_connect(&registry_events, pwac);
+	if (!pwac->obs_pw)
+		blog(LOG_WARNING, "[pipewire-audio] Failed to connect to PipeWire");
+	else
+		obs_pipewire_roundtrip(pwac->obs_pw);
+
+	pipewire_audio_capture_update(pwac, settings);
+	return pwac;
+}
+
+static void *pipewire_audio_input_create(obs_data_t *settings, obs_source_t *source)
+{
+	return pipewire_audio_capture_create(settings, source, false);
+}
+
+static void *pipewire_audio_output_create(obs_data_t *settings, obs_source_t *source)
+{
+	return pipewire_audio_capture_create(settings, source, true);
+}
+
+static void pipewire_audio_capture_destroy(void *data)
+{
+	struct pipewire_audio_capture *pwac = data;
+
+	if (!pwac)
+		return;
+
+	if (pwac->obs_pw) {
+		disconnect_stream(pwac);
+		obs_pipewire_destroy(pwac->obs_pw);
+	}
+
+	for (size_t i = 0; i < pwac->nodes.num; i++) {
+		bfree(pwac->nodes.array[i].name);
+		bfree(pwac->nodes.array[i].description);
+	}
+	da_free(pwac->nodes);
+
+	bfree(pwac->device_id);
+	bfree(pwac);
+}
+
+static void pipewire_audio_capture_get_defaults(obs_data_t *settings)
+{
+	obs_data_set_default_string(settings, "device_id", "default");
+}
+
+static obs_properties_t *pipewire_audio_capture_get_properties(void *data)
+{
+	struct pipewire_audio_capture *pwac = data;
+	obs_properties_t *props = obs_properties_create();
+	obs_property_t *devices = obs_properties_add_list(props, "device_id", obs_module_text("PipeWireAudioDevice"),
+							  OBS_COMBO_TYPE_LIST, OBS_COMBO_FORMAT_STRING);
+
+	obs_property_list_add_string(devices, obs_module_text("PipeWireAudioDefault"), "default");
+
+	if (!pwac || !pwac->obs_pw)
+		return props;
+
+	struct pw_thread_loop *thread_loop = obs_pipewire_get_thread_loop(pwac->obs_pw);
+
+	pw_thread_loop_lock(thread_loop);
+	for (size_t i = 0; i < pwac->nodes.num; i++)
+		obs_property_list_add_string(devices, pwac->nodes.array[i].description, pwac->nodes.array[i].name);
+	pw_thread_loop_unlock(thread_loop);
+
+	return props;
+}
+
+void audio_capture_load(void)
+{
+	const struct obs_source_info pipewire_audio_input_capture_info = {
+		.id = "pipewire-audio-input-capture-source",
+		.type = OBS_SOURCE_TYPE_INPUT,
+		.output_flags = OBS_SOURCE_AUDIO | OBS_SOURCE_DO_NOT_DUPLICATE,
+		.get_name = pipewire_audio_input_get_name,
+		.create = pipewire_audio_input_create,
+		.destroy = pipewire_audio_capture_destroy,
+		.update = pipewire_audio_capture_update,
+		.get_defaults = pipewire_audio_capture_get_defaults,
+		.get_properties = pipewire_audio_capture_get_properties,
+		.icon_type = OBS_ICON_TYPE_AUDIO_INPUT,
+	};
+	obs_register_source(&pipewire_audio_input_capture_info);
+
+	const struct obs_source_info pipewire_audio_output_capture_info = {
+		.id = "pipewire-audio-output-capture-source",
+		.type = OBS_SOURCE_TYPE_INPUT,
+		.output_flags = OBS_SOURCE_AUDIO | OBS_SOURCE_DO_NOT_DUPLICATE | OBS_SOURCE_DO_NOT_SELF_MONITOR,
+		.get_name = pipewire_audio_output_get_name,
+		.create = pipewire_audio_output_create,
+		.destroy = pipewire_audio_capture_destroy,
+		.update = pipewire_audio_capture_update,
+		.get_defaults = pipewire_audio_capture_get_defaults,
+		.get_properties = pipewire_audio_capture_get_properties,
+		.icon_type = OBS_ICON_TYPE_AUDIO_OUTPUT,
+	};
+	obs_register_source(&pipewire_audio_output_capture_info);
+}
@@ -23,6 +23,7 @@
 #include "formats.h"
 
 #include <util/darray.h>
+#include <util/threading.h>
 
 #include <gio/gio.h>
 #include <gio/gunixfdlist.h>
@@ -41,6 +42,15 @@
 
 //#define DEBUG_PIPEWIRE
 
+/* Async frames are output without copying and keep their buffer until libobs
+ * releases them, so enough buffers are requested to cover the frames libobs
+ * holds for rendering.  Frames are copied instead when fewer than
+ * MIN_QUEUED_BUFFERS buffers would be left to the producer. */
+#define ASYNC_BUFFERS_UNBUFFERED 5
+#define ASYNC_BUFFERS_BUFFERED 8
+#define MAX_ASYNC_BUFFERS 16
+#define MIN_QUEUED_BUFFERS 2
+
 #if !PW_CHECK_VERSION(0, 3, 62)
 enum spa_meta_videotransform_value {
 	SPA_META_TRANSFORMATION_None = 0,   /**< no transform */
@@ -95,6 +105,11 @@ struct _obs_pipewire {
 	GPtrArray *streams;
 };
 
+struct held_buffer {
+	obs_pipewire_stream *obs_pw_stream;
+	struct pw_buffer *buffer;
+};
+
 struct _obs_pipewire_stream {
 	obs_pipewire *obs_pw;
 	obs_source_t *source;
@@ -147,6 +162,14 @@ struct _obs_pipewire_stream {
 		bool release_point_will_signal;
 		bool set;
 	} sync;
+
+	struct {
+		pthread_mutex_t mutex;
+		struct spa_source *queue_event;
+		DARRAY(struct pw_buffer *) released;
+		uint32_t count;
+		uint32_t held;
+	} buffers;
 };
 
 /* auxiliary methods */
@@ -658,6 +681,60 @@ static bool prepare_obs_frame(obs_pipewire_stream *obs_pw_stream, struct obs_sou
 	return true;
 }
 
+/* libobs calls this with its async mutex held, which the PipeWire thread takes
+ * when outputting a frame, so the buffer is only recorded here and queued
+ * back from a loop event. */
+static void release_held_buffer(void *param)
+{
+	struct held_buffer *held = param;
+	obs_pipewire_stream *obs_pw_stream = held->obs_pw_stream;
+
+	pthread_mutex_lock(&obs_pw_stream->buffers.mutex);
+	da_push_back(obs_pw_stream->buffers.released, &held->buffer);
+	obs_pw_stream->buffers.held--;
+	pw_loop_signal_event(pw_thread_loop_get_loop(obs_pw_stream->obs_pw->thread_loop),
+			     obs_pw_stream->buffers.queue_event);
+	pthread_mutex_unlock(&obs_pw_stream->buffers.mutex);
+}
+
+static void queue_released_buffers(void *data, uint64_t expirations)
+{
+	obs_pipewire_stream *obs_pw_stream = data;
+
+	UNUSED_PARAMETER(expirations);
+
+	pthread_mutex_lock(&obs_pw_stream->buffers.mutex);
+	for (size_t i = 0; i < obs_pw_stream->buffers.released.num; i++)
+		pw_stream_queue_buffer(obs_pw_stream->stream, obs_pw_stream->buffers.released.array[i]);
+	da_resize(obs_pw_stream->buffers.released, 0);
+	pthread_mutex_unlock(&obs_pw_stream->buffers.mutex);
+}
+
+static bool hold_buffer(obs_pipewire_stream *obs_pw_stream, struct pw_buffer *b)
+{
+	bool hold;
+
+	if (!b->user_data)
+		return false;
+
+	pthread_mutex_lock(&obs_pw_stream->buffers.mutex);
+	hold = obs_pw_stream->buffers.held + MIN_QUEUED_BUFFERS < obs_pw_stream->buffers.count;
+	if (hold)
+		obs_pw_stream->buffers.held++;
+	pthread_mutex_unlock(&obs_pw_stream->buffers.mutex);
+
+	return hold;
+}
+
+/* Frames are released when the graphics thread is done with them, nothing in
+ * that path takes the PipeWire loop lock, so the PipeWire thread can wait for
+ * them.  No release happens after this returns, so the held buffers and the
+ * stream can be freed. */
+static void flush_held_buffers(obs_pipewire_stream *obs_pw_stream)
+{
+	obs_source_flush_video_nocopy(obs_pw_stream->source);
+}
+
 static void process_video_async(obs_pipewire_stream *obs_pw_stream)
 {
 	struct spa_buffer *buffer;
@@ -702,6 +779,11 @@ static void process_video_async(obs_pipewire_stream *obs_pw_stream)
 	}
 #endif
 
+	if (hold_buffer(obs_pw_stream, b)) {
+		obs_source_output_video_nocopy(obs_pw_stream->source, &out, release_held_buffer, b->user_data);
+		return;
+	}
+
 	obs_source_output_video(obs_pw_stream->source, &out);
 
 done:
@@ -1029,8 +1111,19 @@ static void on_param_changed_cb(void *user_data, uint32_t id, const struct spa_p
 	}
 #endif
 
-	params[n_params++] = spa_pod_builder_add_object(&pod_builder, SPA_TYPE_OBJECT_ParamBuffers, SPA_PARAM_Buffers,
-							SPA_PARAM_BUFFERS_dataType, SPA_POD_Int(buffer_types));
+	if (output_flags & OBS_SOURCE_ASYNC_VIDEO) {
+		int async_buffers = obs_source_async_unbuffered(obs_pw_stream->source) ? ASYNC_BUFFERS_UNBUFFERED
+										       : ASYNC_BUFFERS_BUFFERED;
+
+		params[n_params++] = spa_pod_builder_add_object(
+			&pod_builder, SPA_TYPE_OBJECT_ParamBuffers, SPA_PARAM_Buffers, SPA_PARAM_BUFFERS_buffers,
+			SPA_POD_CHOICE_RANGE_Int(async_buffers, 2, MAX_ASYNC_BUFFERS), SPA_PARAM_BUFFERS_dataType,
+			SPA_POD_Int(buffer_types));
+	} else {
+		params[n_params++] = spa_pod_builder_add_object(&pod_builder, SPA_TYPE_OBJECT_ParamBuffers,
+								SPA_PARAM_Buffers, SPA_PARAM_BUFFERS_dataType,
+								SPA_POD_Int(buffer_types));
+	}
 
 	/* Sync timeline */
 #if PW_CHECK_VERSION(1, 2, 0)
@@ -1073,10 +1166,48 @@ static void on_state_changed_cb(void *user_data, enum pw_stream_state old, enum
 	     pw_stream_state_as_string(state), error ? error : "none");
 }
 
+static void on_add_buffer_cb(void *user_data, struct pw_buffer *buffer)
+{
+	obs_pipewire_stream *obs_pw_stream = user_data;
+	uint32_t output_flags = obs_source_get_output_flags(obs_pw_stream->source);
+
+	/* only memory buffers of async sources are held by libobs */
+	if ((output_flags & OBS_SOURCE_ASYNC_VIDEO) != OBS_SOURCE_ASYNC_VIDEO)
+		return;
+
+	struct held_buffer *held = bmalloc(sizeof(*held));
+	held->obs_pw_stream = obs_pw_stream;
+	held->buffer = buffer;
+	buffer->user_data = held;
+
+	pthread_mutex_lock(&obs_pw_stream->buffers.mutex);
+	obs_pw_stream->buffers.count++;
+	pthread_mutex_unlock(&obs_pw_stream->buffers.mutex);
+}
+
+static void on_remove_buffer_cb(void *user_data, struct pw_buffer *buffer)
+{
+	obs_pipewire_stream *obs_pw_stream = user_data;
+
+	if (!buffer->user_data)
+		return;
+
+	flush_held_buffers(obs_pw_stream);
+
+	pthread_mutex_lock(&obs_pw_stream->buffers.mutex);
+	da_erase_item(obs_pw_stream->buffers.released, &buffer);
+	obs_pw_stream->buffers.count--;
+	pthread_mutex_unlock(&obs_pw_stream->buffers.mutex);
+
+	g_clear_pointer(&buffer->user_data, bfree);
+}
+
 static const struct pw_stream_events stream_events = {
 	PW_VERSION_STREAM_EVENTS,
 	.state_changed = on_state_changed_cb,
 	.param_changed = on_param_changed_cb,
+	.add_buffer = on_add_buffer_cb,
+	.remove_buffer = on_remove_buffer_cb,
 	.process = on_process_cb,
 };
 
@@ -1113,26 +1244,17 @@ static const struct pw_core_events core_events = {
 
 /* obs_source_info methods */
 
-obs_pipewire *obs_pipewire_connect_fd(int pipewire_fd, const struct pw_registry_events *registry_events,
-				      void *user_data)
+static obs_pipewire *connect_core(obs_pipewire *obs_pw, const struct pw_registry_events *registry_events,
+				  void *user_data)
 {
-	obs_pipewire *obs_pw;
-
-	obs_pw = bzalloc(sizeof(obs_pipewire));
-	obs_pw->pipewire_fd = pipewire_fd;
-	obs_pw->thread_loop = pw_thread_loop_new("PipeWire thread loop", NULL);
-	obs_pw->context = pw_context_new(pw_thread_loop_get_loop(obs_pw->thread_loop), NULL, 0);
-
-	if (pw_thread_loop_start(obs_pw->thread_loop) < 0) {
-		blog(LOG_WARNING, "Error starting threaded mainloop");
-		bfree(obs_pw);
-		return NULL;
-	}
-
 	pw_thread_loop_lock(obs_pw->thread_loop);
 
 	/* Core */
-	obs_pw->core = pw_context_connect_fd(obs_pw->context, fcntl(obs_pw->pipewire_fd, F_DUPFD_CLOEXEC, 5), NULL, 0);
+	if (obs_pw->pipewire_fd >= 0)
+		obs_pw->core =
+			pw_context_connect_fd(obs_pw->context, fcntl(obs_pw->pipewire_fd, F_DUPFD_CLOEXEC, 5), NULL, 0);
+	else
+		obs_pw->core = pw_context_connect(obs_pw->context, NULL, 0);
 	if (!obs_pw->core) {
 		blog(LOG_WARNING, "Error creating PipeWire core: %m");
 		pw_thread_loop_unlock(obs_pw->thread_loop);
@@ -1160,6 +1282,53 @@ obs_pipewire *obs_pipewire_connect_fd(int pipewire_fd, const struct pw_registry_
 	return obs_pw;
 }
 
+static obs_pipewire *create_pipewire(int pipewire_fd)
+{
+	obs_pipewire *obs_pw;
+
+	obs_pw = bzalloc(sizeof(obs_pipewire));
+	obs_pw->pipewire_fd = pipewire_fd;
+	obs_pw->thread_loop = pw_thread_loop_new("PipeWire thread loop", NULL);
+	obs_pw->context = pw_context_new(pw_thread_loop_get_loop(obs_pw->thread_loop), NULL, 0);
+
+	if (pw_thread_loop_start(obs_pw->thread_loop) < 0) {
+		blog(LOG_WARNING, "Error starting threaded mainloop");
+		bfree(obs_pw);
+		return NULL;
+	}
+
+	return obs_pw;
+}
+
+obs_pipewire *obs_pipewire_connect_fd(int pipewire_fd, const struct pw_registry_events *registry_events,
+				      void *user_data)
+{
+	obs_pipewire *obs_pw = create_pipewire(pipewire_fd);
+	if (!obs_pw)
+		return NULL;
+
+	return connect_core(obs_pw, registry_events, user_data);
+}
+
+obs_pipewire *obs_pipewire_connect(const struct pw_registry_events *registry_events, void *user_data)
+{
+	obs_pipewire *obs_pw = create_pipewire(-1);
+	if (!obs_pw)
+		return NULL;
+
+	return connect_core(obs_pw, registry_events, user_data);
+}
+
+struct pw_core *obs_pipewire_get_core(obs_pipewire *obs_pw)
+{
+	return obs_pw->core;
+}
+
+struct pw_thread_loop *obs_pipewire_get_thread_loop(obs_pipewire *obs_pw)
+{
+	return obs_pw->thread_loop;
+}
+
 struct pw_registry *obs_pipewire_get_registry(obs_pipewire *obs_pw)
 {
 	return obs_pw->registry;
@@ -1208,6 +1377,7 @@ obs_pipewire_stream *obs_pipewire_connect_stream(obs_pipewire *obs_pw, obs_sourc
 	obs_pw_stream->resolution.set = connect_info->video.resolution != NULL;
 	obs_pw_stream->sync.acquire_syncobj_fd = -1;
 	obs_pw_stream->sync.release_syncobj_fd = -1;
+	pthread_mutex_init(&obs_pw_stream->buffers.mutex, NULL);
 
 	if (obs_pw_stream->framerate.set)
 		obs_pw_stream->framerate.fraction = *connect_info->video.framerate;
@@ -1224,6 +1394,9 @@ obs_pipewire_stream *obs_pipewire_connect_stream(obs_pipewire *obs_pw, obs_sourc
 		pw_loop_add_event(pw_thread_loop_get_loop(obs_pw->thread_loop), renegotiate_format, obs_pw_stream);
 	blog(LOG_DEBUG, "[pipewire] registered event %p", obs_pw_stream->reneg);
 
+	obs_pw_stream->buffers.queue_event =
+		pw_loop_add_event(pw_thread_loop_get_loop(obs_pw->thread_loop), queue_released_buffers, obs_pw_stream);
+
 	/* Stream */
 	obs_pw_stream->stream = pw_stream_new(obs_pw->core, connect_info->stream_name, connect_info->stream_properties);
 	pw_stream_add_listener(obs_pw_stream->stream, &obs_pw_stream->stream_listener, &stream_events, obs_pw_stream);
@@ -1236,6 +1409,7 @@ obs_pipewire_stream *obs_pipewire_connect_stream(obs_pipewire *obs_pw, obs_sourc
 
 	if (!build_format_params(obs_pw_stream, &pod_builder, &params, &n_params)) {
 		pw_thread_loop_unlock(obs_pw->thread_loop);
+		pthread_mutex_destroy(&obs_pw_stream->buffers.mutex);
 		bfree(obs_pw_stream);
 		return NULL;
 	}
@@ -1405,8 +1579,10 @@ void obs_pipewire_stream_destroy(obs_pipewire_stream *obs_pw_stream)
 		return;
 
 	output_flags = obs_source_get_output_flags(obs_pw_stream->source);
-	if (output_flags & OBS_SOURCE_ASYNC_VIDEO)
+	if (output_flags & OBS_SOURCE_ASYNC_VIDEO) {
 		obs_source_output_video(obs_pw_stream->source, NULL);
+		flush_held_buffers(obs_pw_stream);
+	}
 
 	g_ptr_array_remove(obs_pw_stream->obs_pw->streams, obs_pw_stream);
 
@@ -1419,8 +1595,14 @@ void obs_pipewire_stream_destroy(obs_pipewire_stream *obs_pw_stream)
 	if (obs_pw_stream->stream)
 		pw_stream_disconnect(obs_pw_stream->stream);
 	g_clear_pointer(&obs_pw_stream->stream, pw_stream_destroy);
+	if (obs_pw_stream->buffers.queue_event)
+		pw_loop_destroy_source(pw_thread_loop_get_loop(obs_pw_stream->obs_pw->thread_loop),
+				       obs_pw_stream->buffers.queue_event);
 	pw_thread_loop_unlock(obs_pw_stream->obs_pw->thread_loop);
 
+	da_free(obs_pw_stream->buffers.released);
+	pthread_mutex_destroy(&obs_pw_stream->buffers.mutex);
+
 	g_clear_fd(&obs_pw_stream->sync.acquire_syncobj_fd, NULL);
 	g_clear_fd(&obs_pw_stream->sync.release_syncobj_fd, NULL);
 
@@ -16,6 +16,7 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 */
 
 #include <obs-module.h>
+#include <util/platform.h>
 #include <linux/videodev2.h>
 #include <libavutil/error.h>
 
@@ -56,11 +57,27 @@ int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt)
 
 	decoder->context->flags2 |= AV_CODEC_FLAG2_FAST;
 
+	/* MJPEG frames are usually a single slice, so only frame threading can
+	 * spread them across cores; the decode queue bounds how far behind it
+	 * can get.  H264 from cameras is low-latency by nature, so it sticks to
+	 * slice threading rather than adding a frame of delay per thread. */
+	int threads = os_get_logical_cores();
+	decoder->context->thread_count = threads > 4 ? 4 : (threads > 0 ? threads : 1);
+	decoder->context->thread_type = pixfmt == V4L2_PIX_FMT_MJPEG ? FF_THREAD_FRAME | FF_THREAD_SLICE
+								      : FF_THREAD_SLICE;
+
 	if (avcodec_open2(decoder->context, decoder->codec, NULL) < 0) {
 		blog(LOG_ERROR, "failed to open codec");
 		return -1;
 	}
 
+	int active = decoder->context->active_thread_type;
+	blog(LOG_INFO, "%s decoder using %d thread(s), %s threading", decoder->codec->name,
+	     decoder->context->thread_count,
+	     active & FF_THREAD_FRAME   ? "frame"
+	     : active & FF_THREAD_SLICE ? "slice"
+					: "no");
+
 	blog(LOG_DEBUG, "initialized avcodec");
 
 	return 0;
@@ -85,30 +102,14 @@ void v4l2_destroy_decoder(struct v4l2_decoder *decoder)
 	}
 }
 
-int v4l2_decode_frame(struct obs_source_frame *out, uint8_t *data, size_t length, struct v4l2_decoder *decoder)
+static bool v4l2_frame_from_avframe(struct obs_source_frame *out, const AVFrame *frame)
 {
-	int r;
-	decoder->packet->data = data;
-	decoder->packet->size = length;
-	if (avcodec_send_packet(decoder->context, decoder->packet) < 0) {
-		blog(LOG_ERROR, "failed to send frame to codec");
-		return -1;
-	}
-	r = avcodec_receive_frame(decoder->context, decoder->frame);
-	if (r == AVERROR(EAGAIN)) {
-		blog(LOG_DEBUG, "failed to receive frame in this state, try to send new frame to codec");
-		return 0;
-	} else if (r < 0) {
-		blog(LOG_ERROR, "failed to receive frame from codec");
-		return -1;
-	}
-
 	for (uint_fast32_t i = 0; i < MAX_AV_PLANES; ++i) {
-		out->data[i] = decoder->frame->data[i];
-		out->linesize[i] = decoder->frame->linesize[i];
+		out->data[i] = frame->data[i];
+		out->linesize[i] = frame->linesize[i];
 	}
 
-	switch (decoder->context->pix_fmt) {
+	switch (frame->format) {
 	case AV_PIX_FMT_GRAY8:
 		out->format = VIDEO_FORMAT_Y800;
 		break;
@@ -125,8 +126,156 @@ int v4l2_decode_frame(struct obs_source_frame *out, uint8_t *data, size_t length
 		out->format = VIDEO_FORMAT_I444;
 		break;
 	default:
-		break;
+		return out->format != VIDEO_FORMAT_NONE;
+	}
+
+	return true;
+}
+
+static void v4l2_decode_packet(struct v4l2_decode_pipeline *pipeline, struct v4l2_decode_packet *packet)
+{
+	struct v4l2_decoder *decoder = &pipeline->decoder;
+	int r;
+
+	decoder->packet->data = packet->data;
+	decoder->packet->size = (int)packet->size;
+	decoder->packet->pts = (int64_t)packet->timestamp;
+
+	if (avcodec_send_packet(decoder->context, decoder->packet) < 0) {
+		blog(LOG_DEBUG, "failed to send frame to codec");
+		obs_source_add_dropped_frames(pipeline->source, "decode", 1);
+		return;
+	}
+
+	/* with frame threading (MJPEG), frames come out later than they go in */
+	while ((r = avcodec_receive_frame(decoder->context, decoder->frame)) == 0) {
+		if (!v4l2_frame_from_avframe(&pipeline->frame, decoder->frame)) {
+			obs_source_add_dropped_frames(pipeline->source, "decode", 1);
+			continue;
+		}
+
+		pipeline->frame.timestamp = (uint64_t)decoder->frame->pts;
+		obs_source_output_video(pipeline->source, &pipeline->frame);
+	}
+
+	if (r != AVERROR(EAGAIN) && r != AVERROR_EOF) {
+		blog(LOG_DEBUG, "failed to receive frame from codec");
+		obs_source_add_dropped_frames(pipeline->source, "decode", 1);
+	}
+}
+
+static void *v4l2_decode_thread(void *vptr)
+{
+	struct v4l2_decode_pipeline *pipeline = vptr;
+
+	os_set_thread_name("v4l2: decode");
+
+	for (;;) {
+		os_sem_wait(pipeline->packets_ready);
+
+		pthread_mutex_lock(&pipeline->mutex);
+		bool stop = pipeline->stop;
+		struct v4l2_decode_packet *packet =
+			pipeline->packet_count ? &pipeline->packets[pipeline->first_packet] : NULL;
+		pthread_mutex_unlock(&pipeline->mutex);
+
+		if (stop)
+			break;
+		if (!packet)
+			continue;
+
+		/* the capture thread does not touch queued packets */
+		v4l2_decode_packet(pipeline, packet);
+
+		pthread_mutex_lock(&pipeline->mutex);
+		pipeline->first_packet = (pipeline->first_packet + 1) % V4L2_DECODE_QUEUE_SIZE;
+		pipeline->packet_count--;
+		pthread_mutex_unlock(&pipeline->mutex);
+	}
+
+	return NULL;
+}
+
+int v4l2_start_decode_pipeline(struct v4l2_decode_pipeline *pipeline, obs_source_t *source,
+			       const struct obs_source_frame *frame)
+{
+	pipeline->source = source;
+	pipeline->frame = *frame;
+	pipeline->stop = false;
+	pipeline->first_packet = 0;
+	pipeline->packet_count = 0;
+
+	if (pthread_mutex_init(&pipeline->mutex, NULL) != 0)
+		return -1;
+	if (os_sem_init(&pipeline->packets_ready, 0) != 0) {
+		pthread_mutex_destroy(&pipeline->mutex);
+		return -1;
+	}
+	if (pthread_create(&pipeline->thread, NULL, v4l2_decode_thread, pipeline) != 0) {
+		os_sem_destroy(pipeline->packets_ready);
+		pthread_mutex_destroy(&pipeline->mutex);
+		return -1;
 	}
 
+	pipeline->thread_active = true;
 	return 0;
 }
+
+void v4l2_stop_decode_pipeline(struct v4l2_decode_pipeline *pipeline)
+{
+	if (!pipeline->thread_active)
+		return;
+
+	pthread_mutex_lock(&pipeline->mutex);
+	pipeline->stop = true;
+	pthread_mutex_unlock(&pipeline->mutex);
+
+	os_sem_post(pipeline->packets_ready);
+	pthread_join(pipeline->thread, NULL);
+	pipeline->thread_active = false;
+
+	os_sem_destroy(pipeline->packets_ready);
+	pthread_mutex_destroy(&pipeline->mutex);
+
+	for (size_t i = 0; i < V4L2_DECODE_QUEUE_SIZE; i++) {
+		bfree(pipeline->packets[i].data);
+		pipeline->packets[i] = (struct v4l2_decode_packet){0};
+	}
+
+	/* drop frames still held by MJPEG frame threads */
+	avcodec_flush_buffers(pipeline->decoder.context);
+}
+
+bool v4l2_queue_decode_frame(struct v4l2_decode_pipeline *pipeline, const uint8_t *data, size_t length,
+			     uint64_t timestamp)
+{
+	pthread_mutex_lock(&pipeline->mutex);
+	bool full = pipeline->packet_count == V4L2_DECODE_QUEUE_SIZE;
+	size_t idx = (pipeline->first_packet + pipeline->packet_count) % V4L2_DECODE_QUEUE_SIZE;
+	pthread_mutex_unlock(&pipeline->mutex);
+
+	if (full) {
+		obs_source_add_dropped_frames(pipeline->source, "decode queue", 1);
+		return false;
+	}
+
+	/* the decode thread does not touch packets that are not queued */
+	struct v4l2_decode_packet *packet = &pipeline->packets[idx];
+	if (packet->capacity < length + AV_INPUT_BUFFER_PADDING_SIZE) {
+		packet->capacity = length + AV_INPUT_BUFFER_PADDING_SIZE;
+		bfree(packet->data);
+		packet->data = bmalloc(packet->capacity);
+	}
+
+	memcpy(packet->data, data, length);
+	memset(packet->data + length, 0, AV_INPUT_BUFFER_PADDING_SIZE);
+	packet->size = length;
+	packet->timestamp = timestamp;
+
+	pthread_mutex_lock(&pipeline->mutex);
+	pipeline->packet_count++;
+	pthread_mutex_unlock(&pipeline->mutex);
+
+	os_sem_post(pipeline->packets_ready);
+	return true;
+}
@@ -25,6 +25,9 @@ extern "C" {
 #include <libavformat/avformat.h>
 #include <libavutil/pixfmt.h>
 
+#include <obs-module.h>
+#include <util/threading.h>
+
 /**
  * Data structure for decoder
  */
@@ -35,6 +38,42 @@ struct v4l2_decoder {
 	AVFrame *frame;
 };
 
+/** Number of compressed frames that can wait for the decoder */
+#define V4L2_DECODE_QUEUE_SIZE 4
+
+/**
+ * Compressed frame waiting to be decoded
+ */
+struct v4l2_decode_packet {
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+	uint64_t timestamp;
+};
+
+/**
+ * Data structure for the decode pipeline
+ *
+ * The capture thread copies compressed frames into a bounded queue so the
+ * buffer can be returned to the driver right away, a separate thread decodes
+ * them and outputs the frames to the source.
+ */
+struct v4l2_decode_pipeline {
+	struct v4l2_decoder decoder;
+	obs_source_t *source;
+	struct obs_source_frame frame;
+
+	pthread_t thread;
+	bool thread_active;
+	pthread_mutex_t mutex;
+	os_sem_t *packets_ready;
+	bool stop;
+
+	struct v4l2_decode_packet packets[V4L2_DECODE_QUEUE_SIZE];
+	size_t first_packet;
+	size_t packet_count;
+};
+
 /**
  * Initialize the decoder.
  * The decoder must be destroyed on failure.
@@ -53,15 +92,36 @@ int v4l2_init_decoder(struct v4l2_decoder *decoder, int pixfmt);
 void v4l2_destroy_decoder(struct v4l2_decoder *decoder);
 
 /**
- * Decode a jpeg or h264 frame into an obs frame
+ * Start the decode thread.
+ * The decoder of the pipeline must have been initialized.
+ *
+ * @param pipeline the pipeline structure
+ * @param source the source decoded frames are output to
+ * @param frame prepared frame with all data known before decoding
+ * @return non-zero on failure
+ */
+int v4l2_start_decode_pipeline(struct v4l2_decode_pipeline *pipeline, obs_source_t *source,
+			       const struct obs_source_frame *frame);
+
+/**
+ * Stop the decode thread and free the queued frames.
  *
- * @param out the obs frame to decode into
+ * @param pipeline the pipeline structure
+ */
+void v4l2_stop_decode_pipeline(struct v4l2_decode_pipeline *pipeline);
+
+/**
+ * Queue a jpeg or h264 frame for decoding.
+ * The data is copied, so the buffer can be reused when this returns.
+ *
+ * @param pipeline the pipeline structure
  * @param data the codec data
  * @param length length of the data
- * @param decoder the decoder as initialized by v4l2_init_decoder
- * @return non-zero on failure
+ * @param timestamp timestamp of the frame
+ * @return false if the queue is full and the frame was dropped
  */
-int v4l2_decode_frame(struct obs_source_frame *out, uint8_t *data, size_t length, struct v4l2_decoder *decoder);
+bool v4l2_queue_decode_frame(struct v4l2_decode_pipeline *pipeline, const uint8_t *data, size_t length,
+			     uint64_t timestamp);
 
 #ifdef __cplusplus
 }
@@ -96,13 +96,13 @@ int_fast32_t v4l2_query_all_buffers(int_fast32_t dev, struct v4l2_buffer_data *b
 }
 #endif
 
-int_fast32_t v4l2_create_mmap(int_fast32_t dev, struct v4l2_buffer_data *buf)
+int_fast32_t v4l2_create_mmap(int_fast32_t dev, struct v4l2_buffer_data *buf, uint32_t count)
 {
 	struct v4l2_requestbuffers req;
 	struct v4l2_buffer map;
 
 	memset(&req, 0, sizeof(req));
-	req.count = 4;
+	req.count = count;
 	req.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 	req.memory = V4L2_MEMORY_MMAP;
 
@@ -220,14 +220,16 @@ int_fast32_t v4l2_query_all_buffers(int_fast32_t dev, struct v4l2_buffer_data *b
 /**
  * Create memory mapping for buffers
  *
- * This tries to map at least 2, preferably 4, buffers to application memory.
+ * This tries to map at least 2, preferably count, buffers to application
+ * memory.
  *
  * @param dev handle for the v4l2 device
  * @param buf buffer data
+ * @param count number of buffers to request
  *
  * @return negative on failure
  */
-int_fast32_t v4l2_create_mmap(int_fast32_t dev, struct v4l2_buffer_data *buf);
+int_fast32_t v4l2_create_mmap(int_fast32_t dev, struct v4l2_buffer_data *buf, uint32_t count);
 
 /**
  * Destroy the memory mapping for buffers
@@ -41,6 +41,15 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define FALLBACK_FRAMERATE 30
 
+/* Raw frames are handed to libobs without copying and keep their buffer until
+ * libobs releases them, so extra buffers cover the frames libobs holds for
+ * rendering.  A few buffers always stay queued to the driver, if libobs holds
+ * all the others frames are copied instead. */
+#define CAPTURE_BUFFERS 4
+#define NOCOPY_EXTRA_BUFFERS_UNBUFFERED 3
+#define NOCOPY_EXTRA_BUFFERS_BUFFERED 6
+#define MIN_QUEUED_BUFFERS 2
+
 #if HAVE_UDEV
 #include "v4l2-udev.h"
 #endif
@@ -63,6 +72,16 @@ along with this program.  If not, see <http://www.gnu.org/licenses/>.
 
 #define blog(level, msg, ...) blog(level, "v4l2-input: " msg, ##__VA_ARGS__)
 
+struct v4l2_data;
+
+/**
+ * Parameter for releasing a buffer held by libobs
+ */
+struct v4l2_buffer_ref {
+	struct v4l2_data *data;
+	uint32_t index;
+};
+
 /**
  * Data structure for the v4l2 source
  */
@@ -81,7 +100,7 @@ struct v4l2_data {
 	obs_source_t *source;
 	pthread_t thread;
 	os_event_t *event;
-	struct v4l2_decoder decoder;
+	struct v4l2_decode_pipeline decode;
 
 	bool framerate_unchanged;
 	bool resolution_unchanged;
@@ -91,6 +110,12 @@ struct v4l2_data {
 	int linesize;
 	struct v4l2_buffer_data buffers;
 
+	/* buffers held by libobs */
+	pthread_mutex_t buffer_mutex;
+	struct v4l2_buffer_ref *buffer_refs;
+	uint32_t buffers_held;
+	bool streaming;
+
 	bool auto_reset;
 	int timeout_frames;
 };
@@ -154,8 +179,85 @@ static void v4l2_prep_obs_frame(struct v4l2_data *data, struct obs_source_frame
 	}
 }
 
+static inline bool v4l2_is_compressed(int pixfmt)
+{
+	return pixfmt == V4L2_PIX_FMT_MJPEG || pixfmt == V4L2_PIX_FMT_H264;
+}
+
+/**
+ * Return a buffer held by libobs to the driver
+ *
+ * Called by libobs once it no longer uses the frame, usually from the
+ * graphics thread.
+ */
+static void v4l2_release_buffer(void *param)
+{
+	struct v4l2_buffer_ref *ref = param;
+	struct v4l2_data *data = ref->data;
+	struct v4l2_buffer buf;
+
+	pthread_mutex_lock(&data->buffer_mutex);
+
+	if (data->streaming) {
+		memset(&buf, 0, sizeof(buf));
+		buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+		buf.memory = V4L2_MEMORY_MMAP;
+		buf.index = ref->index;
+
+		if (v4l2_ioctl(data->dev, VIDIOC_QBUF, &buf) < 0)
+			blog(LOG_ERROR, "%s: failed to enqueue buffer", data->device_id);
+	}
+	data->buffers_held--;
+
+	pthread_mutex_unlock(&data->buffer_mutex);
+}
+
+/**
+ * Check whether a buffer can be handed to libobs
+ *
+ * @return true if enough buffers stay queued to the driver
+ */
+static bool v4l2_hold_buffer(struct v4l2_data *data)
+{
+	bool hold;
+
+	if (!data->buffer_refs)
+		return false;
+
+	pthread_mutex_lock(&data->buffer_mutex);
+	hold = data->buffers_held + MIN_QUEUED_BUFFERS < data->buffers.count;
+	if (hold)
+		data->buffers_held++;
+	pthread_mutex_unlock(&data->buffer_mutex);
+
+	return hold;
+}
+
+static void v4l2_set_streaming(struct v4l2_data *data, bool streaming)
+{
+	pthread_mutex_lock(&data->buffer_mutex);
+	data->streaming = streaming;
+	pthread_mutex_unlock(&data->buffer_mutex);
+}
+
+/**
+ * Take back all buffers held by libobs
+ *
+ * This drops the frames libobs has queued and waits for the graphics thread
+ * to release the frame it uses, so the buffers can be requeued or unmapped.
+ */
+static void v4l2_flush_buffers(struct v4l2_data *data)
+{
+	v4l2_set_streaming(data, false);
+	obs_source_flush_video_nocopy(data->source);
+}
+
 /*
  * Worker thread to get video data
+ *
+ * Compressed frames are copied to the decode pipeline, so buffers go back to
+ * the driver without waiting for the decoder.  Raw frames are output without
+ * copying, their buffers go back to the driver once libobs releases them.
  */
 static void *v4l2_thread(void *vptr)
 {
@@ -165,6 +267,8 @@ static void *v4l2_thread(void *vptr)
 	uint8_t *start;
 	uint64_t frames;
 	uint64_t first_ts;
+	uint32_t last_sequence = 0;
+	bool compressed = v4l2_is_compressed(data->pixfmt);
 	struct timeval tv;
 	struct v4l2_buffer buf;
 	struct obs_source_frame out;
@@ -187,6 +291,7 @@ static void *v4l2_thread(void *vptr)
 
 	if (v4l2_start_capture(data->dev, &data->buffers) < 0)
 		goto exit;
+	v4l2_set_streaming(data, true);
 
 	blog(LOG_DEBUG, "%s: new capture started", data->device_id);
 
@@ -196,6 +301,11 @@ static void *v4l2_thread(void *vptr)
 
 	blog(LOG_DEBUG, "%s: obs frame prepared", data->device_id);
 
+	if (compressed && v4l2_start_decode_pipeline(&data->decode, data->source, &out) != 0) {
+		blog(LOG_ERROR, "%s: failed to start decode thread", data->device_id);
+		goto exit;
+	}
+
 	while (os_event_try(data->event) == EAGAIN) {
 		FD_ZERO(&fds);
 		FD_SET(data->dev, &fds);
@@ -222,10 +332,14 @@ static void *v4l2_thread(void *vptr)
 			}
 
 			if (data->auto_reset) {
-				if (v4l2_reset_capture(data->dev, &data->buffers) == 0)
+				v4l2_flush_buffers(data);
+
+				if (v4l2_reset_capture(data->dev, &data->buffers) == 0) {
+					v4l2_set_streaming(data, true);
 					blog(LOG_INFO, "%s: stream reset successful", data->device_id);
-				else
+				} else {
 					blog(LOG_ERROR, "%s: failed to reset", data->device_id);
+				}
 			}
 
 			continue;
@@ -246,6 +360,12 @@ static void *v4l2_thread(void *vptr)
 		blog(LOG_DEBUG, "%s: ts: %06ld buf id #%d, flags 0x%08X, seq #%d, len %d, used %d", data->device_id,
 		     buf.timestamp.tv_usec, buf.index, buf.flags, buf.sequence, buf.length, buf.bytesused);
 
+		/* gaps in the sequence are frames the driver dropped because
+		 * no buffer was queued */
+		if (frames && buf.sequence > last_sequence + 1)
+			obs_source_add_dropped_frames(data->source, "capture", buf.sequence - last_sequence - 1);
+		last_sequence = buf.sequence;
+
 		if (buf.flags & V4L2_BUF_FLAG_ERROR) {
 			blog(LOG_DEBUG, "skipping decoding of buffer with recoverable error-flag set");
 			goto continue_queue_buffer;
@@ -258,16 +378,21 @@ static void *v4l2_thread(void *vptr)
 
 		start = (uint8_t *)data->buffers.info[buf.index].start;
 
-		if (data->pixfmt == V4L2_PIX_FMT_MJPEG || data->pixfmt == V4L2_PIX_FMT_H264) {
-			if (v4l2_decode_frame(&out, start, buf.bytesused, &data->decoder) < 0) {
-				blog(LOG_ERROR, "failed to unpack jpeg or h264");
-				break;
-			}
+		if (compressed) {
+			v4l2_queue_decode_frame(&data->decode, start, buf.bytesused, out.timestamp);
 		} else {
 			for (uint_fast32_t i = 0; i < MAX_AV_PLANES; ++i)
 				out.data[i] = start + plane_offsets[i];
+
+			if (v4l2_hold_buffer(data)) {
+				obs_source_output_video_nocopy(data->source, &out, v4l2_release_buffer,
+							       &data->buffer_refs[buf.index]);
+				frames++;
+				continue;
+			}
+
+			obs_source_output_video(data->source, &out);
 		}
-		obs_source_output_video(data->source, &out);
 
 	continue_queue_buffer:
 		if (v4l2_ioctl(data->dev, VIDIOC_QBUF, &buf) < 0) {
@@ -281,6 +406,8 @@ static void *v4l2_thread(void *vptr)
 	blog(LOG_INFO, "%s: Stopped capture after %" PRIu64 " frames", data->device_id, frames);
 
 exit:
+	v4l2_stop_decode_pipeline(&data->decode);
+	v4l2_flush_buffers(data);
 	v4l2_stop_capture(data->dev);
 	return NULL;
 }
@@ -838,11 +965,14 @@ static void v4l2_terminate(struct v4l2_data *data)
 		data->thread = 0;
 	}
 
-	if (data->pixfmt == V4L2_PIX_FMT_MJPEG || data->pixfmt == V4L2_PIX_FMT_H264) {
-		v4l2_destroy_decoder(&data->decoder);
+	if (v4l2_is_compressed(data->pixfmt)) {
+		v4l2_destroy_decoder(&data->decode.decoder);
 	}
 	v4l2_destroy_mmap(&data->buffers);
 
+	bfree(data->buffer_refs);
+	data->buffer_refs = NULL;
+
 	if (data->dev != -1) {
 		v4l2_close(data->dev);
 		data->dev = -1;
@@ -857,6 +987,7 @@ static void v4l2_destroy(void *vptr)
 		return;
 
 	v4l2_terminate(data);
+	pthread_mutex_destroy(&data->buffer_mutex);
 
 	if (data->device_id)
 		bfree(data->device_id);
@@ -886,6 +1017,7 @@ static void v4l2_destroy(void *vptr)
 static void v4l2_init(struct v4l2_data *data)
 {
 	uint32_t input_caps;
+	uint32_t buffer_count = CAPTURE_BUFFERS;
 	int fps_num, fps_denom;
 
 	blog(LOG_INFO, "Start capture from %s", data->device_id);
@@ -953,16 +1085,26 @@ static void v4l2_init(struct v4l2_data *data)
 	blog(LOG_INFO, "Framerate: %.2f fps", (float)fps_denom / fps_num);
 
 	/* map buffers */
-	if (v4l2_create_mmap(data->dev, &data->buffers) < 0) {
+	if (!v4l2_is_compressed(data->pixfmt))
+		buffer_count += obs_source_async_unbuffered(data->source) ? NOCOPY_EXTRA_BUFFERS_UNBUFFERED
+									   : NOCOPY_EXTRA_BUFFERS_BUFFERED;
+	if (v4l2_create_mmap(data->dev, &data->buffers, buffer_count) < 0) {
 		blog(LOG_ERROR, "Failed to map buffers");
 		goto fail;
 	}
+	blog(LOG_INFO, "Buffers: %u", (unsigned)data->buffers.count);
 
-	if (data->pixfmt == V4L2_PIX_FMT_MJPEG || data->pixfmt == V4L2_PIX_FMT_H264) {
-		if (v4l2_init_decoder(&data->decoder, data->pixfmt) < 0) {
+	if (v4l2_is_compressed(data->pixfmt)) {
+		if (v4l2_init_decoder(&data->decode.decoder, data->pixfmt) < 0) {
 			blog(LOG_ERROR, "Failed to initialize decoder");
 			goto fail;
 		}
+	} else {
+		data->buffer_refs = bzalloc(data->buffers.count * sizeof(struct v4l2_buffer_ref));
+		for (uint32_t i = 0; i < data->buffers.count; i++) {
+			data->buffer_refs[i].data = data;
+			data->buffer_refs[i].index = i;
+		}
 	}
 
 	/* start the capture thread */
@@ -1069,6 +1211,7 @@ static void *v4l2_create(obs_data_t *settings, obs_source_t *source)
 	struct v4l2_data *data = bzalloc(sizeof(struct v4l2_data));
 	data->dev = -1;
 	data->source = source;
+	pthread_mutex_init(&data->buffer_mutex, NULL);
 	data->resolution_unchanged = false;
 	data->framerate_unchanged = false;
 
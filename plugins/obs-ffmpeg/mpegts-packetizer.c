@@ -0,0 +1,663 @@
+// SPDX-FileCopyrightText: 2026 The OBS Project
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#include "mpegts-packetizer.h"
+
+#include <obs-avc.h>
+#include <obs-nal.h>
+#include <util/bmem.h>
+
+#define PAT_PID 0x0000
+#define PMT_PID 0x1000
+#define VIDEO_PID 0x0100
+#define AUDIO_PID_BASE 0x0101
+#define PROGRAM_NUMBER 1
+#define TRANSPORT_STREAM_ID 1
+
+#define STREAM_TYPE_AAC 0x0f
+#define STREAM_TYPE_H264 0x1b
+#define STREAM_TYPE_HEVC 0x24
+#define STREAM_TYPE_PRIVATE 0x06
+
+#define STREAM_ID_VIDEO 0xe0
+#define STREAM_ID_AUDIO 0xc0
+#define STREAM_ID_PRIVATE_1 0xbd
+
+#define HEVC_NAL_SPS 33
+#define HEVC_NAL_AUD 35
+
+/* All timestamps are shifted by 1.4 s so that negative DTS (B-frames) stay
+ * representable, and the PCR runs 0.7 s behind DTS, matching the defaults of
+ * the avformat mpegts muxer. */
+#define TS_CLOCK 90000
+#define TS_OFFSET 126000
+#define PCR_DELAY 63000
+#define PSI_INTERVAL (TS_CLOCK / 10)
+#define TS_MASK ((1ULL << 33) - 1)
+
+#define TS_PAYLOAD_SIZE (MPEGTS_PACKET_SIZE - 4)
+#define MAX_STREAMS (1 + MAX_AUDIO_MIXES)
+
+struct ts_stream {
+	enum mpegts_codec codec;
+	enum obs_encoder_type type;
+	size_t track_idx;
+	uint16_t pid;
+	uint8_t stream_type;
+	uint8_t stream_id;
+	uint8_t cc;
+
+	uint8_t *extra_data;
+	size_t extra_size;
+
+	uint8_t adts[7];
+	uint8_t channels;
+};
+
+struct ts_chunk {
+	const uint8_t *data;
+	size_t size;
+};
+
+struct mpegts_packetizer {
+	struct ts_stream streams[MAX_STREAMS];
+	size_t num_streams;
+
+	uint8_t pat_cc;
+	uint8_t pmt_cc;
+	bool sent_psi;
+	int64_t last_psi_ts;
+
+	mpegts_send_cb send;
+	void *param;
+
+	uint8_t *buf;
+	size_t buf_size;
+	size_t buf_pos;
+};
+
+/* ------------------------------------------------------------------------- */
+
+static uint32_t crc32_mpeg(const uint8_t *data, size_t size)
+{
+	uint32_t crc = 0xffffffff;
+
+	for (size_t i = 0; i < size; i++) {
+		crc ^= (uint32_t)data[i] << 24;
+		for (int bit = 0; bit < 8; bit++)
+			crc = (crc & 0x80000000) ? (crc << 1) ^ 0x04c11db7 : crc << 1;
+	}
+
+	return crc;
+}
+
+static inline void w16(uint8_t **p, uint16_t val)
+{
+	(*p)[0] = (uint8_t)(val >> 8);
+	(*p)[1] = (uint8_t)val;
+	*p += 2;
+}
+
+static inline void w32(uint8_t **p, uint32_t val)
+{
+	w16(p, (uint16_t)(val >> 16));
+	w16(p, (uint16_t)val);
+}
+
+static inline int64_t to_ts_clock(int64_t val, const struct encoder_packet *packet)
+{
+	return val * TS_CLOCK * packet->timebase_num / packet->timebase_den + TS_OFFSET;
+}
+
+/* ------------------------------------------------------------------------- */
+/* Output buffer                                                             */
+
+static int flush_buffer(struct mpegts_packetizer *ts)
+{
+	int ret = 0;
+
+	if (ts->buf_pos) {
+		ret = ts->send(ts->param, ts->buf, ts->buf_pos);
+		ts->buf_pos = 0;
+	}
+
+	return ret < 0 ? ret : 0;
+}
+
+/* Returns the next free 188-byte slot, sending the buffer first if full. */
+static uint8_t *next_ts_packet(struct mpegts_packetizer *ts, int *err)
+{
+	if (ts->buf_pos + MPEGTS_PACKET_SIZE > ts->buf_size) {
+		int ret = flush_buffer(ts);
+		if (ret < 0) {
+			*err = ret;
+			return NULL;
+		}
+	}
+
+	uint8_t *pkt = ts->buf + ts->buf_pos;
+	ts->buf_pos += MPEGTS_PACKET_SIZE;
+	return pkt;
+}
+
+/* ------------------------------------------------------------------------- */
+/* PSI                                                                       */
+
+static int write_section(struct mpegts_packetizer *ts, uint16_t pid, uint8_t *cc, const uint8_t *section,
+			 size_t size)
+{
+	int err = 0;
+	uint8_t *pkt = next_ts_packet(ts, &err);
+	if (!pkt)
+		return err;
+
+	pkt[0] = 0x47;
+	pkt[1] = 0x40 | (uint8_t)(pid >> 8);
+	pkt[2] = (uint8_t)pid;
+	pkt[3] = 0x10 | (*cc & 0xf);
+	pkt[4] = 0; /* pointer_field */
+	*cc = (*cc + 1) & 0xf;
+
+	memcpy(pkt + 5, section, size);
+	memset(pkt + 5 + size, 0xff, MPEGTS_PACKET_SIZE - 5 - size);
+	return 0;
+}
+
+static size_t finish_section(uint8_t *section, uint8_t *end)
+{
+	/* section_length counts everything after itself, including the CRC */
+	size_t length = (size_t)(end - section) - 3 + 4;
+	section[1] = 0xb0 | (uint8_t)(length >> 8);
+	section[2] = (uint8_t)length;
+
+	w32(&end, crc32_mpeg(section, (size_t)(end - section)));
+	return length + 3;
+}
+
+static int write_pat(struct mpegts_packetizer *ts)
+{
+	uint8_t section[MPEGTS_PACKET_SIZE];
+	uint8_t *p = section;
+
+	*p++ = 0x00; /* table_id */
+	p += 2;      /* section_length */
+	w16(&p, TRANSPORT_STREAM_ID);
+	*p++ = 0xc1; /* version 0, current_next_indicator */
+	*p++ = 0;    /* section_number */
+	*p++ = 0;    /* last_section_number */
+	w16(&p, PROGRAM_NUMBER);
+	w16(&p, 0xe000 | PMT_PID);
+
+	size_t size = finish_section(section, p);
+	return write_section(ts, PAT_PID, &ts->pat_cc, section, size);
+}
+
+static int write_pmt(struct mpegts_packetizer *ts)
+{
+	uint8_t section[MPEGTS_PACKET_SIZE];
+	uint8_t *p = section;
+
+	*p++ = 0x02; /* table_id */
+	p += 2;      /* section_length */
+	w16(&p, PROGRAM_NUMBER);
+	*p++ = 0xc1;
+	*p++ = 0;
+	*p++ = 0;
+	w16(&p, 0xe000 | VIDEO_PID); /* PCR_PID */
+	w16(&p, 0xf000);             /* program_info_length */
+
+	for (size_t i = 0; i < ts->num_streams; i++) {
+		struct ts_stream *stream = &ts->streams[i];
+
+		*p++ = stream->stream_type;
+		w16(&p, 0xe000 | stream->pid);
+
+		if (stream->codec == MPEGTS_CODEC_OPUS) {
+			w16(&p, 0xf000 | 10);
+
+			/* registration_descriptor */
+			*p++ = 0x05;
+			*p++ = 4;
+			memcpy(p, "Opus", 4);
+			p += 4;
+
+			/* DVB extension_descriptor, channel configuration */
+			*p++ = 0x7f;
+			*p++ = 2;
+			*p++ = 0x80;
+			*p++ = stream->channels;
+		} else {
+			w16(&p, 0xf000);
+		}
+	}
+
+	size_t size = finish_section(section, p);
+	return write_section(ts, PMT_PID, &ts->pmt_cc, section, size);
+}
+
+static int write_psi(struct mpegts_packetizer *ts, int64_t dts)
+{
+	int ret = write_pat(ts);
+	if (ret == 0)
+		ret = write_pmt(ts);
+
+	ts->sent_psi = true;
+	ts->last_psi_ts = dts;
+	return ret;
+}
+
+/* ------------------------------------------------------------------------- */
+/* PES                                                                       */
+
+static inline void write_pes_ts(uint8_t **p, uint8_t prefix, int64_t val)
+{
+	uint64_t ts = (uint64_t)val & TS_MASK;
+	uint8_t *q = *p;
+
+	q[0] = (uint8_t)((prefix << 4) | (((ts >> 30) & 0x7) << 1) | 1);
+	q[1] = (uint8_t)(ts >> 22);
+	q[2] = (uint8_t)((((ts >> 15) & 0x7f) << 1) | 1);
+	q[3] = (uint8_t)(ts >> 7);
+	q[4] = (uint8_t)(((ts & 0x7f) << 1) | 1);
+	*p += 5;
+}
+
+static size_t copy_chunks(struct ts_chunk *chunks, size_t *cur, uint8_t *dst, size_t size)
+{
+	size_t copied = 0;
+
+	while (copied < size) {
+		struct ts_chunk *chunk = &chunks[*cur];
+		size_t n = chunk->size < size - copied ? chunk->size : size - copied;
+
+		memcpy(dst + copied, chunk->data, n);
+		chunk->data += n;
+		chunk->size -= n;
+		copied += n;
+
+		if (!chunk->size)
+			(*cur)++;
+	}
+
+	return copied;
+}
+
+static int write_pes(struct mpegts_packetizer *ts, struct ts_stream *stream, struct ts_chunk *chunks, size_t total,
+		     bool pcr, bool random_access, int64_t dts)
+{
+	size_t cur = 0;
+	bool first = true;
+
+	while (total) {
+		int err = 0;
+		uint8_t *pkt = next_ts_packet(ts, &err);
+		if (!pkt)
+			return err;
+
+		bool write_pcr = first && pcr;
+		bool rai = first && random_access;
+		size_t af_min = (write_pcr || rai) ? 2 + (write_pcr ? 6 : 0) : 0;
+		size_t payload = total < TS_PAYLOAD_SIZE - af_min ? total : TS_PAYLOAD_SIZE - af_min;
+		size_t af_size = TS_PAYLOAD_SIZE - payload;
+
+		pkt[0] = 0x47;
+		pkt[1] = (first ? 0x40 : 0) | (uint8_t)(stream->pid >> 8);
+		pkt[2] = (uint8_t)stream->pid;
+		pkt[3] = (af_size ? 0x30 : 0x10) | stream->cc;
+		stream->cc = (stream->cc + 1) & 0xf;
+
+		uint8_t *p = pkt + 4;
+		if (af_size) {
+			*p++ = (uint8_t)(af_size - 1);
+
+			if (af_size > 1) {
+				uint8_t *flags = p++;
+				*flags = (rai ? 0x40 : 0) | (write_pcr ? 0x10 : 0);
+
+				if (write_pcr) {
+					uint64_t base = (uint64_t)(dts - PCR_DELAY) & TS_MASK;
+					p[0] = (uint8_t)(base >> 25);
+					p[1] = (uint8_t)(base >> 17);
+					p[2] = (uint8_t)(base >> 9);
+					p[3] = (uint8_t)(base >> 1);
+					p[4] = (uint8_t)(((base & 1) << 7) | 0x7e);
+					p[5] = 0;
+					p += 6;
+				}
+
+				memset(p, 0xff, pkt + 4 + af_size - p);
+				p = pkt + 4 + af_size;
+			}
+		}
+
+		copy_chunks(chunks, &cur, p, payload);
+		total -= payload;
+		first = false;
+	}
+
+	return 0;
+}
+
+static inline uint8_t nal_type(enum mpegts_codec codec, const uint8_t *nal)
+{
+	return codec == MPEGTS_CODEC_HEVC ? (nal[0] >> 1) & 0x3f : nal[0] & 0x1f;
+}
+
+static void scan_nals(enum mpegts_codec codec, const uint8_t *data, size_t size, bool *starts_with_aud,
+		      bool *has_params)
+{
+	const uint8_t aud = codec == MPEGTS_CODEC_HEVC ? HEVC_NAL_AUD : OBS_NAL_AUD;
+	const uint8_t sps = codec == MPEGTS_CODEC_HEVC ? HEVC_NAL_SPS : OBS_NAL_SPS;
+	const uint8_t *end = data + size;
+	const uint8_t *nal = obs_nal_find_startcode(data, end);
+	bool first = true;
+
+	*starts_with_aud = false;
+	*has_params = false;
+
+	while (nal < end) {
+		while (nal < end && !*(nal++))
+			;
+		if (nal == end)
+			break;
+
+		uint8_t type = nal_type(codec, nal);
+		if (first && type == aud)
+			*starts_with_aud = true;
+		if (type == sps)
+			*has_params = true;
+
+		first = false;
+		nal = obs_nal_find_startcode(nal, end);
+	}
+}
+
+static int write_video(struct mpegts_packetizer *ts, struct ts_stream *stream, const struct encoder_packet *packet)
+{
+	static const uint8_t h264_aud[] = {0, 0, 0, 1, 0x09, 0xf0};
+	static const uint8_t hevc_aud[] = {0, 0, 0, 1, 0x46, 0x01, 0x50};
+
+	int64_t pts = to_ts_clock(packet->pts, packet);
+	int64_t dts = to_ts_clock(packet->dts, packet);
+	bool starts_with_aud, has_params;
+
+	scan_nals(stream->codec, packet->data, packet->size, &starts_with_aud, &has_params);
+
+	uint8_t header[19];
+	uint8_t *p = header;
+	bool write_dts = pts != dts;
+
+	*p++ = 0;
+	*p++ = 0;
+	*p++ = 1;
+	*p++ = stream->stream_id;
+	w16(&p, 0); /* unbounded for video */
+	*p++ = 0x84;
+	*p++ = write_dts ? 0xc0 : 0x80;
+	*p++ = write_dts ? 10 : 5;
+	write_pes_ts(&p, write_dts ? 3 : 2, pts);
+	if (write_dts)
+		write_pes_ts(&p, 1, dts);
+
+	struct ts_chunk chunks[4];
+	size_t num = 0;
+
+	chunks[num++] = (struct ts_chunk){header, (size_t)(p - header)};
+	if (!starts_with_aud) {
+		if (stream->codec == MPEGTS_CODEC_HEVC)
+			chunks[num++] = (struct ts_chunk){hevc_aud, sizeof(hevc_aud)};
+		else
+			chunks[num++] = (struct ts_chunk){h264_aud, sizeof(h264_aud)};
+	}
+	if (packet->keyframe && !has_params && stream->extra_size)
+		chunks[num++] = (struct ts_chunk){stream->extra_data, stream->extra_size};
+	chunks[num++] = (struct ts_chunk){packet->data, packet->size};
+
+	size_t total = 0;
+	for (size_t i = 0; i < num; i++)
+		total += chunks[i].size;
+
+	if (!ts->sent_psi || packet->keyframe || dts - ts->last_psi_ts >= PSI_INTERVAL) {
+		int ret = write_psi(ts, dts);
+		if (ret < 0)
+			return ret;
+	}
+
+	int ret = write_pes(ts, stream, chunks, total, true, packet->keyframe, dts);
+	if (ret < 0)
+		return ret;
+
+	/* end of an access unit: send what we have rather than waiting for
+	 * audio to fill up the rest of the message */
+	return flush_buffer(ts);
+}
+
+static int write_audio(struct mpegts_packetizer *ts, struct ts_stream *stream, const struct encoder_packet *packet)
+{
+	int64_t pts = to_ts_clock(packet->pts, packet);
+	uint8_t prefix[7 + 2 + 64];
+	size_t prefix_size = 0;
+
+	if (stream->codec == MPEGTS_CODEC_AAC) {
+		size_t frame_length = packet->size + 7;
+
+		memcpy(prefix, stream->adts, 7);
+		prefix[3] |= (uint8_t)((frame_length >> 11) & 0x3);
+		prefix[4] = (uint8_t)(frame_length >> 3);
+		prefix[5] = (uint8_t)(((frame_length & 0x7) << 5) | 0x1f);
+		prefix_size = 7;
+	} else {
+		/* opus_control_header: prefix, no trim flags, au_size */
+		size_t size = packet->size;
+
+		prefix[prefix_size++] = 0x7f;
+		prefix[prefix_size++] = 0xe0;
+		while (size >= 255 && prefix_size < sizeof(prefix) - 1) {
+			prefix[prefix_size++] = 0xff;
+			size -= 255;
+		}
+		prefix[prefix_size++] = (uint8_t)size;
+	}
+
+	uint8_t header[14];
+	uint8_t *p = header;
+	size_t pes_length = 3 + 5 + prefix_size + packet->size;
+
+	*p++ = 0;
+	*p++ = 0;
+	*p++ = 1;
+	*p++ = stream->stream_id;
+	w16(&p, pes_length > 0xffff ? 0 : (uint16_t)pes_length);
+	*p++ = 0x84;
+	*p++ = 0x80;
+	*p++ = 5;
+	write_pes_ts(&p, 2, pts);
+
+	struct ts_chunk chunks[3] = {
+		{header, (size_t)(p - header)},
+		{prefix, prefix_size},
+		{packet->data, packet->size},
+	};
+
+	if (!ts->sent_psi) {
+		int ret = write_psi(ts, pts);
+		if (ret < 0)
+			return ret;
+	}
+
+	int ret = write_pes(ts, stream, chunks, chunks[0].size + prefix_size + packet->size, false, false, pts);
+	if (ret < 0)
+		return ret;
+
+	/* audio frames are small and frequent, but must not wait for the next
+	 * video access unit either */
+	return flush_buffer(ts);
+}
+
+/* ------------------------------------------------------------------------- */
+
+static const uint32_t aac_sample_rates[] = {96000, 88200, 64000, 48000, 44100, 32000, 24000,
+					    22050, 16000, 12000, 11025, 8000,  7350};
+
+static uint8_t aac_sample_rate_index(uint32_t sample_rate)
+{
+	for (uint8_t i = 0; i < sizeof(aac_sample_rates) / sizeof(aac_sample_rates[0]); i++) {
+		if (aac_sample_rates[i] == sample_rate)
+			return i;
+	}
+	return 3;
+}
+
+static void init_adts(struct ts_stream *stream, const uint8_t *asc, size_t asc_size, uint32_t sample_rate,
+		      uint32_t channels)
+{
+	uint8_t object_type = 2; /* AAC LC */
+	uint8_t freq_index = aac_sample_rate_index(sample_rate);
+	uint8_t channel_config = (uint8_t)(channels == 8 ? 7 : channels);
+
+	if (asc && asc_size >= 2) {
+		object_type = asc[0] >> 3;
+		freq_index = ((asc[0] & 0x7) << 1) | (asc[1] >> 7);
+		channel_config = (asc[1] >> 3) & 0xf;
+
+		if (freq_index == 0xf)
+			freq_index = aac_sample_rate_index(sample_rate);
+		if (!object_type || object_type > 4)
+			object_type = 2;
+	}
+
+	stream->adts[0] = 0xff;
+	stream->adts[1] = 0xf1;
+	stream->adts[2] = (uint8_t)(((object_type - 1) << 6) | (freq_index << 2) | ((channel_config >> 2) & 0x1));
+	stream->adts[3] = (uint8_t)((channel_config & 0x3) << 6);
+	stream->adts[4] = 0;
+	stream->adts[5] = 0x1f;
+	stream->adts[6] = 0xfc;
+}
+
+struct mpegts_packetizer *mpegts_packetizer_create(size_t payload_size, mpegts_send_cb send, void *param)
+{
+	struct mpegts_packetizer *ts = bzalloc(sizeof(struct mpegts_packetizer));
+
+	ts->buf_size = payload_size - payload_size % MPEGTS_PACKET_SIZE;
+	if (ts->buf_size < MPEGTS_PACKET_SIZE)
+		ts->buf_size = MPEGTS_PACKET_SIZE;
+
+	ts->buf = bmalloc(ts->buf_size);
+	ts->send = send;
+	ts->param = param;
+	return ts;
+}
+
+void mpegts_packetizer_destroy(struct mpegts_packetizer *ts)
+{
+	if (!ts)
+		return;
+
+	for (size_t i = 0; i < ts->num_streams; i++)
+		bfree(ts->streams[i].extra_data);
+
+	bfree(ts->buf);
+	bfree(ts);
+}
+
+static struct ts_stream *add_stream(struct mpegts_packetizer *ts, enum mpegts_codec codec,
+				    const uint8_t *extra_data, size_t extra_size)
+{
+	if (ts->num_streams == MAX_STREAMS || ts->sent_psi)
+		return NULL;
+
+	struct ts_stream *stream = &ts->streams[ts->num_streams++];
+	stream->codec = codec;
+	if (extra_size) {
+		stream->extra_data = bmemdup(extra_data, extra_size);
+		stream->extra_size = extra_size;
+	}
+	return stream;
+}
+
+bool mpegts_packetizer_add_video(struct mpegts_packetizer *ts, enum mpegts_codec codec, const uint8_t *extra_data,
+				 size_t extra_size)
+{
+	if (codec != MPEGTS_CODEC_H264 && codec != MPEGTS_CODEC_HEVC)
+		return false;
+
+	for (size_t i = 0; i < ts->num_streams; i++) {
+		if (ts->streams[i].type == OBS_ENCODER_VIDEO)
+			return false;
+	}
+
+	struct ts_stream *stream = add_stream(ts, codec, extra_data, extra_size);
+	if (!stream)
+		return false;
+
+	stream->type = OBS_ENCODER_VIDEO;
+	stream->pid = VIDEO_PID;
+	stream->stream_id = STREAM_ID_VIDEO;
+	stream->stream_type = codec == MPEGTS_CODEC_HEVC ? STREAM_TYPE_HEVC : STREAM_TYPE_H264;
+	return true;
+}
+
+bool mpegts_packetizer_add_audio(struct mpegts_packetizer *ts, enum mpegts_codec codec, size_t track_idx,
+				 const uint8_t *extra_data, size_t extra_size, uint32_t sample_rate,
+				 uint32_t channels)
+{
+	if (codec != MPEGTS_CODEC_AAC && codec != MPEGTS_CODEC_OPUS)
+		return false;
+
+	size_t audio_idx = 0;
+	for (size_t i = 0; i < ts->num_streams; i++) {
+		if (ts->streams[i].type == OBS_ENCODER_AUDIO)
+			audio_idx++;
+	}
+
+	struct ts_stream *stream = add_stream(ts, codec, NULL, 0);
+	if (!stream)
+		return false;
+
+	stream->type = OBS_ENCODER_AUDIO;
+	stream->track_idx = track_idx;
+	stream->pid = (uint16_t)(AUDIO_PID_BASE + audio_idx);
+	stream->channels = (uint8_t)channels;
+
+	if (codec == MPEGTS_CODEC_AAC) {
+		stream->stream_id = (uint8_t)(STREAM_ID_AUDIO + audio_idx);
+		stream->stream_type = STREAM_TYPE_AAC;
+		init_adts(stream, extra_data, extra_size, sample_rate, channels);
+	} else {
+		stream->stream_id = STREAM_ID_PRIVATE_1;
+		stream->stream_type = STREAM_TYPE_PRIVATE;
+	}
+
+	return true;
+}
+
+static struct ts_stream *find_stream(struct mpegts_packetizer *ts, const struct encoder_packet *packet)
+{
+	for (size_t i = 0; i < ts->num_streams; i++) {
+		struct ts_stream *stream = &ts->streams[i];
+
+		if (stream->type != packet->type)
+			continue;
+		if (stream->type == OBS_ENCODER_AUDIO && stream->track_idx != packet->track_idx)
+			continue;
+		return stream;
+	}
+
+	return NULL;
+}
+
+int mpegts_packetizer_write(struct mpegts_packetizer *ts, const struct encoder_packet *packet)
+{
+	struct ts_stream *stream = find_stream(ts, packet);
+	if (!stream || !packet->size)
+		return 0;
+
+	return stream->type == OBS_ENCODER_VIDEO ? write_video(ts, stream, packet) : write_audio(ts, stream, packet);
+}
+
+int mpegts_packetizer_flush(struct mpegts_packetizer *ts)
+{
+	return flush_buffer(ts);
+}
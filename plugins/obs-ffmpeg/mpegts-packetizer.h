@@ -0,0 +1,44 @@
+// SPDX-FileCopyrightText: 2026 The OBS Project
+//
+// SPDX-License-Identifier: GPL-2.0-or-later
+
+#pragma once
+
+#include <obs.h>
+
+/* Minimal MPEG-TS packetizer (ISO/IEC 13818-1) used by the native SRT path.
+ *
+ * Encoder packets are framed straight into PES/TS packets in a single output
+ * buffer of `payload_size` bytes (rounded down to a multiple of 188), which is
+ * handed to the send callback whenever it fills up or a PES packet ends.
+ * Payload bytes are copied exactly once, from the encoder packet into the
+ * send buffer. */
+
+#define MPEGTS_PACKET_SIZE 188
+
+struct mpegts_packetizer;
+
+enum mpegts_codec {
+	MPEGTS_CODEC_H264,
+	MPEGTS_CODEC_HEVC,
+	MPEGTS_CODEC_AAC,
+	MPEGTS_CODEC_OPUS,
+};
+
+/* Returns a negative value on error, which is passed back to the caller of
+ * mpegts_packetizer_write()/mpegts_packetizer_flush(). */
+typedef int (*mpegts_send_cb)(void *param, const uint8_t *data, size_t size);
+
+struct mpegts_packetizer *mpegts_packetizer_create(size_t payload_size, mpegts_send_cb send, void *param);
+void mpegts_packetizer_destroy(struct mpegts_packetizer *ts);
+
+/* Streams must all be added before the first packet is written. The video
+ * stream carries the PCR. Audio streams are matched by track_idx. */
+bool mpegts_packetizer_add_video(struct mpegts_packetizer *ts, enum mpegts_codec codec, const uint8_t *extra_data,
+				 size_t extra_size);
+bool mpegts_packetizer_add_audio(struct mpegts_packetizer *ts, enum mpegts_codec codec, size_t track_idx,
+				 const uint8_t *extra_data, size_t extra_size, uint32_t sample_rate,
+				 uint32_t channels);
+
+int mpegts_packetizer_write(struct mpegts_packetizer *ts, const struct encoder_packet *packet);
+int mpegts_packetizer_flush(struct mpegts_packetizer *ts);
@@ -16,10 +16,12 @@ const char *ffmpeg_hls_mux_getname(void *type)
 	return obs_module_text("FFmpegHlsMuxer");
 }
 
+#define PACKET_RING_SIZE 4096
+
 int hls_stream_dropped_frames(void *data)
 {
 	struct ffmpeg_muxer *stream = data;
-	return stream->dropped_frames;
+	return (int)os_atomic_load_long(&stream->dropped_frames);
 }
 
 void ffmpeg_hls_mux_destroy(void *data)
@@ -35,6 +37,7 @@ void ffmpeg_hls_mux_destroy(void *data)
 
 		da_free(stream->mux_packets);
 		deque_free(&stream->packets);
+		spsc_ring_free(&stream->packet_ring);
 
 		os_process_pipe_destroy(stream->pipe);
 		dstr_free(&stream->path);
@@ -49,6 +52,7 @@ void *ffmpeg_hls_mux_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct ffmpeg_muxer *stream = bzalloc(sizeof(*stream));
 	pthread_mutex_init_value(&stream->write_mutex);
+	spsc_ring_init(&stream->packet_ring, sizeof(struct encoder_packet), PACKET_RING_SIZE);
 	stream->output = output;
 
 	/* init mutex, semaphore and event */
@@ -70,21 +74,19 @@ fail:
 static bool process_packet(struct ffmpeg_muxer *stream)
 {
 	struct encoder_packet packet;
-	bool has_packet = false;
+	bool dropped;
 	bool ret = true;
 
-	pthread_mutex_lock(&stream->write_mutex);
-
-	if (stream->packets.size) {
-		deque_pop_front(&stream->packets, &packet, sizeof(packet));
-		has_packet = true;
-	}
-
-	pthread_mutex_unlock(&stream->write_mutex);
+	while (spsc_ring_pop(&stream->packet_ring, &packet, &dropped)) {
+		if (dropped) {
+			os_atomic_inc_long(&stream->dropped_frames);
+			obs_encoder_packet_release(&packet);
+			continue;
+		}
 
-	if (has_packet) {
 		ret = write_packet(stream, &packet);
 		obs_encoder_packet_release(&packet);
+		break;
 	}
 	return ret;
 }
@@ -160,8 +162,9 @@ bool ffmpeg_hls_mux_start(void *data)
 	os_atomic_set_bool(&stream->capturing, true);
 	stream->is_hls = true;
 	stream->total_bytes = 0;
-	stream->dropped_frames = 0;
+	os_atomic_set_long(&stream->dropped_frames, 0);
 	stream->min_priority = 0;
+	spsc_ring_overflow_reset(&stream->packet_ring_overflow);
 
 	obs_output_begin_data_capture(stream->output, 0);
 
@@ -172,46 +175,34 @@ bool ffmpeg_hls_mux_start(void *data)
 
 static bool write_packet_to_buf(struct ffmpeg_muxer *stream, struct encoder_packet *packet)
 {
-	deque_push_back(&stream->packets, packet, sizeof(struct encoder_packet));
-	return true;
+	bool video = packet->type == OBS_ENCODER_VIDEO;
+	int priority = video ? packet->drop_priority : OBS_NAL_PRIORITY_HIGHEST;
+
+	if (spsc_ring_push_packet(&stream->packet_ring, &stream->packet_ring_overflow,
+				  obs_output_get_name(stream->output), packet, priority, video, packet->keyframe))
+		return true;
+
+	if (video)
+		os_atomic_inc_long(&stream->dropped_frames);
+	return false;
 }
 
 static void drop_frames(struct ffmpeg_muxer *stream, int highest_priority)
 {
-	struct deque new_buf = {0};
-	int num_frames_dropped = 0;
-
-	deque_reserve(&new_buf, sizeof(struct encoder_packet) * 8);
-
-	while (stream->packets.size) {
-		struct encoder_packet packet;
-		deque_pop_front(&stream->packets, &packet, sizeof(packet));
-
-		/* do not drop audio data or video keyframes */
-		if (packet.type == OBS_ENCODER_AUDIO || packet.drop_priority >= highest_priority) {
-			deque_push_back(&new_buf, &packet, sizeof(packet));
-		} else {
-			num_frames_dropped++;
-			obs_encoder_packet_release(&packet);
-		}
-	}
-
-	deque_free(&stream->packets);
-	stream->packets = new_buf;
+	/* marked packets are released (and counted) by the write thread */
+	spsc_ring_drop(&stream->packet_ring, highest_priority);
 
 	if (stream->min_priority < highest_priority)
 		stream->min_priority = highest_priority;
-
-	stream->dropped_frames += num_frames_dropped;
 }
 
 static bool find_first_video_packet(struct ffmpeg_muxer *stream, struct encoder_packet *first)
 {
-	size_t count = stream->packets.size / sizeof(*first);
+	unsigned long end = spsc_ring_head(&stream->packet_ring);
 
-	for (size_t i = 0; i < count; i++) {
-		struct encoder_packet *cur = deque_data(&stream->packets, i * sizeof(*first));
-		if (cur->type == OBS_ENCODER_VIDEO && !cur->keyframe) {
+	for (unsigned long pos = spsc_ring_tail(&stream->packet_ring); pos != end; pos++) {
+		struct encoder_packet *cur = spsc_ring_at(&stream->packet_ring, pos);
+		if (cur->type == OBS_ENCODER_VIDEO && !cur->keyframe && !spsc_ring_dropped(&stream->packet_ring, pos)) {
 			*first = *cur;
 			return true;
 		}
@@ -244,7 +235,7 @@ static bool add_video_packet(struct ffmpeg_muxer *stream, struct encoder_packet
 	/* if currently dropping frames, drop packets until it reaches the
 	 * desired priority */
 	if (packet->drop_priority < stream->min_priority) {
-		stream->dropped_frames++;
+		os_atomic_inc_long(&stream->dropped_frames);
 		return false;
 	} else {
 		stream->min_priority = 0;
@@ -295,15 +286,11 @@ void ffmpeg_hls_mux_data(void *data, struct encoder_packet *packet)
 	}
 	obs_encoder_packet_ref(&new_packet, packet);
 
-	pthread_mutex_lock(&stream->write_mutex);
-
 	if (active(stream)) {
 		added_packet = (packet->type == OBS_ENCODER_VIDEO) ? add_video_packet(stream, &new_packet)
 								   : write_packet_to_buf(stream, &new_packet);
 	}
 
-	pthread_mutex_unlock(&stream->write_mutex);
-
 	if (added_packet)
 		os_sem_post(stream->write_sem);
 	else
@@ -27,6 +27,7 @@
 #include "obs-ffmpeg-compat.h"
 #include "obs-ffmpeg-rist.h"
 #include "obs-ffmpeg-srt.h"
+#include "mpegts-packetizer.h"
 #include <libavutil/channel_layout.h>
 #include <libavutil/mastering_display_metadata.h>
 
@@ -38,6 +39,8 @@
 #define info(format, ...) do_log(LOG_INFO, format, ##__VA_ARGS__)
 #define error(format, ...) do_log(LOG_ERROR, format, ##__VA_ARGS__)
 
+#define PACKET_RING_SIZE 4096
+
 static void ffmpeg_mpegts_set_last_error(struct ffmpeg_data *data, const char *error)
 {
 	if (data->last_error)
@@ -322,6 +325,7 @@ static inline int connect_mpegts_url(struct ffmpeg_output *stream, bool is_rist)
 			if (strlen(stream->ff_data.config.encrypt_passphrase))
 				context->passphrase = av_strdup(stream->ff_data.config.encrypt_passphrase);
 		}
+		context->latency_budget = (int64_t)stream->ff_data.config.latency_budget_ms * 1000;
 	} else {
 		RISTContext *context = (RISTContext *)uc->priv_data;
 		context->secret = NULL;
@@ -450,7 +454,8 @@ static inline int open_output_file(struct ffmpeg_output *stream, struct ffmpeg_d
 	}
 
 	/* Ensure h264 bitstream auto conversion from avcc to annex B */
-	data->output->flags |= AVFMT_FLAG_AUTO_BSF;
+	if (data->output)
+		data->output->flags |= AVFMT_FLAG_AUTO_BSF;
 
 	/* Open URL for rist, srt or other protocols compatible with mpegts
 	 *  muxer supported by avformat (udp, tcp, rtp ...).
@@ -509,7 +514,7 @@ static inline int open_output_file(struct ffmpeg_output *stream, struct ffmpeg_d
 			dstr_free(&str);
 		}
 		av_dict_free(&dict);
-	} else {
+	} else if (!data->config.native_srt) {
 		ret = allocate_custom_aviocontext(stream, rist);
 		if (ret < 0) {
 			info("Couldn't allocate custom avio_context for url: '%s', %s", data->config.url,
@@ -574,8 +579,33 @@ static void close_mpegts_url(struct ffmpeg_output *stream, bool is_rist)
 		info("[ffmpeg mpegts muxer]: Error closing URL %s", stream->ff_data.config.url);
 }
 
+static void native_srt_data_free(struct ffmpeg_output *stream, struct ffmpeg_data *data)
+{
+	if (stream->has_connected) {
+		/* send whatever the packetizer still holds before closing */
+		if (stream->packetizer && mpegts_packetizer_flush(stream->packetizer) < 0)
+			warn("Failed to send the last native SRT packets");
+
+		close_mpegts_url(stream, false);
+		stream->has_connected = false;
+	}
+
+	mpegts_packetizer_destroy(stream->packetizer);
+	stream->packetizer = NULL;
+
+	if (data->last_error)
+		bfree(data->last_error);
+
+	memset(data, 0, sizeof(struct ffmpeg_data));
+}
+
 void ffmpeg_mpegts_data_free(struct ffmpeg_output *stream, struct ffmpeg_data *data)
 {
+	if (data->config.native_srt) {
+		native_srt_data_free(stream, data);
+		return;
+	}
+
 	if (data->initialized)
 		av_write_trailer(data->output);
 
@@ -617,6 +647,12 @@ bool ffmpeg_mpegts_data_init(struct ffmpeg_output *stream, struct ffmpeg_data *d
 	if (!config->url || !*config->url)
 		return false;
 
+	/* the native SRT path packetizes itself and needs no avformat context */
+	if (config->native_srt) {
+		info("Using native SRT mpegts output");
+		return true;
+	}
+
 	avformat_network_init();
 
 	const AVOutputFormat *output_format = av_guess_format("mpegts", NULL, "video/M2PT");
@@ -666,14 +702,22 @@ static void ffmpeg_mpegts_log_callback(void *param, int level, const char *forma
 	UNUSED_PARAMETER(param);
 }
 
+/* only called while the write thread is not running */
+static void free_packets(struct ffmpeg_output *stream)
+{
+	struct encoder_packet packet;
+
+	while (spsc_ring_pop(&stream->packet_ring, &packet, NULL))
+		obs_encoder_packet_release(&packet);
+}
+
 static void *ffmpeg_mpegts_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct ffmpeg_output *data = bzalloc(sizeof(struct ffmpeg_output));
-	pthread_mutex_init_value(&data->write_mutex);
+	pthread_mutex_init_value(&data->start_stop_mutex);
+	spsc_ring_init(&data->packet_ring, sizeof(struct encoder_packet), PACKET_RING_SIZE);
 	data->output = output;
 
-	if (pthread_mutex_init(&data->write_mutex, NULL) != 0)
-		goto fail;
 	if (os_event_init(&data->stop_event, OS_EVENT_TYPE_AUTO) != 0)
 		goto fail;
 	if (os_sem_init(&data->write_sem, 0) != 0)
@@ -687,9 +731,10 @@ static void *ffmpeg_mpegts_create(obs_data_t *settings, obs_output_t *output)
 	return data;
 
 fail:
-	pthread_mutex_destroy(&data->write_mutex);
 	os_event_destroy(data->stop_event);
+	os_sem_destroy(data->write_sem);
 	pthread_mutex_destroy(&data->start_stop_mutex);
+	spsc_ring_free(&data->packet_ring);
 	bfree(data);
 	return NULL;
 }
@@ -719,7 +764,8 @@ static void ffmpeg_mpegts_destroy(void *data)
 		pthread_mutex_unlock(&stream->start_stop_mutex);
 
 		/* Clean up resources */
-		pthread_mutex_destroy(&stream->write_mutex);
+		free_packets(stream);
+		spsc_ring_free(&stream->packet_ring);
 		os_sem_destroy(stream->write_sem);
 		os_event_destroy(stream->stop_event);
 		pthread_mutex_destroy(&stream->start_stop_mutex);
@@ -747,26 +793,67 @@ static uint64_t get_packet_sys_dts(struct ffmpeg_output *stream, AVPacket *packe
 	return start_ts + pause_offset + (uint64_t)av_rescale_q(packet->dts, time_base, (AVRational){1, 1000000000});
 }
 
+static inline int64_t rescale_ts2(AVStream *stream, AVRational codec_time_base, int64_t val)
+{
+	return av_rescale_q_rnd(val / codec_time_base.num, codec_time_base, stream->time_base,
+				AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
+}
+
+/* Convert obs encoder_packet to FFmpeg AVPacket */
+static AVPacket *mpegts_convert_packet(struct ffmpeg_output *stream, struct encoder_packet *encpacket)
+{
+	if (!stream->ff_data.video || !stream->ff_data.video_ctx || !stream->ff_data.audio_infos)
+		return NULL;
+	bool is_video = encpacket->type == OBS_ENCODER_VIDEO;
+	if (!is_video) {
+		if (!stream->ff_data.audio_infos[encpacket->track_idx].stream)
+			return NULL;
+	}
+
+	AVStream *avstream = is_video ? stream->ff_data.video
+				      : stream->ff_data.audio_infos[encpacket->track_idx].stream;
+	AVPacket *packet = NULL;
+
+	const AVRational codec_time_base = is_video ? stream->ff_data.video_ctx->time_base
+						    : stream->ff_data.audio_infos[encpacket->track_idx].ctx->time_base;
+
+	packet = av_packet_alloc();
+
+	packet->data = av_memdup(encpacket->data, (int)encpacket->size);
+	if (packet->data == NULL) {
+		error("Couldn't allocate packet data");
+		av_packet_free(&packet);
+		return NULL;
+	}
+	packet->size = (int)encpacket->size;
+	packet->stream_index = avstream->id;
+	packet->pts = rescale_ts2(avstream, codec_time_base, encpacket->pts);
+	packet->dts = rescale_ts2(avstream, codec_time_base, encpacket->dts);
+
+	if (encpacket->keyframe)
+		packet->flags = AV_PKT_FLAG_KEY;
+
+	return packet;
+}
+
 static int mpegts_process_packet(struct ffmpeg_output *stream)
 {
+	struct encoder_packet encpacket;
 	AVPacket *packet = NULL;
 	int ret = 0;
 
-	pthread_mutex_lock(&stream->write_mutex);
-	if (stream->packets.num) {
-		packet = stream->packets.array[0];
-		da_erase(stream->packets, 0);
-	}
-	pthread_mutex_unlock(&stream->write_mutex);
+	if (!spsc_ring_pop(&stream->packet_ring, &encpacket, NULL))
+		return 0;
+
+	packet = mpegts_convert_packet(stream, &encpacket);
+	obs_encoder_packet_release(&encpacket);
 
 	if (!packet)
 		return 0;
 
 	//blog(LOG_DEBUG,
-	//     "size = %d, flags = %lX, stream = %d, "
-	//     "packets queued: %lu",
-	//     packet->size, packet->flags, packet->stream_index,
-	//     output->packets.num);
+	//     "size = %d, flags = %lX, stream = %d",
+	//     packet->size, packet->flags, packet->stream_index);
 
 	if (stopping(stream)) {
 		uint64_t sys_ts = get_packet_sys_dts(stream, packet);
@@ -795,17 +882,41 @@ end:
 	return ret;
 }
 
+static int mpegts_process_native_packet(struct ffmpeg_output *stream)
+{
+	struct encoder_packet packet;
+	int ret = 0;
+
+	if (!spsc_ring_pop(&stream->packet_ring, &packet, NULL))
+		return 0;
+
+	if (stopping(stream)) {
+		if ((uint64_t)packet.sys_dts_usec * 1000 >= stream->stop_ts)
+			goto end;
+	}
+
+	stream->total_bytes += packet.size;
+	ret = mpegts_packetizer_write(stream->packetizer, &packet);
+	if (ret < 0)
+		ffmpeg_mpegts_log_error(LOG_WARNING, &stream->ff_data, "process_packet: Error sending packet: %d", ret);
+
+end:
+	obs_encoder_packet_release(&packet);
+	return ret < 0 ? ret : 0;
+}
+
 static void ffmpeg_mpegts_stop_internal(void *data, uint64_t ts, bool signal);
 static void *write_thread(void *data)
 {
 	struct ffmpeg_output *stream = data;
+	bool native = stream->ff_data.config.native_srt;
 
 	while (os_sem_wait(stream->write_sem) == 0) {
 		/* check to see if shutting down */
 		if (os_event_try(stream->stop_event) == 0)
 			break;
 
-		int ret = mpegts_process_packet(stream);
+		int ret = native ? mpegts_process_native_packet(stream) : mpegts_process_packet(stream);
 		if (ret != 0) {
 			if (stream->ff_data.config.is_srt) {
 				SRTContext *s = (SRTContext *)stream->h->priv_data;
@@ -841,6 +952,69 @@ static bool get_extradata(struct ffmpeg_output *stream)
 	return true;
 }
 
+static int native_srt_send(void *param, const uint8_t *data, size_t size)
+{
+	struct ffmpeg_output *stream = param;
+	int ttl = stream->ff_data.config.latency_budget_ms;
+
+	return libsrt_write_msg(stream->h, data, (int)size, ttl > 0 ? ttl : -1);
+}
+
+static bool add_native_audio_streams(struct ffmpeg_output *stream)
+{
+	for (int i = 0; i < stream->ff_data.num_audio_streams; i++) {
+		obs_encoder_t *aencoder = obs_output_get_audio_encoder(stream->output, i);
+		const char *codec_name = obs_encoder_get_codec(aencoder);
+		audio_t *audio = obs_encoder_audio(aencoder);
+		uint8_t *extra_data = NULL;
+		size_t extra_size = 0;
+		enum mpegts_codec codec;
+
+		if (strcmp(codec_name, "aac") == 0) {
+			codec = MPEGTS_CODEC_AAC;
+		} else if (strcmp(codec_name, "opus") == 0) {
+			codec = MPEGTS_CODEC_OPUS;
+		} else {
+			error("Unsupported audio codec '%s'", codec_name);
+			return false;
+		}
+
+		obs_encoder_get_extra_data(aencoder, &extra_data, &extra_size);
+		if (!mpegts_packetizer_add_audio(stream->packetizer, codec, i, extra_data, extra_size,
+						 obs_encoder_get_sample_rate(aencoder),
+						 (uint32_t)audio_output_get_channels(audio)))
+			return false;
+	}
+
+	return true;
+}
+
+static bool init_native_streams(struct ffmpeg_output *stream)
+{
+	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
+	const char *codec_name = obs_encoder_get_codec(vencoder);
+	uint8_t *extra_data = NULL;
+	size_t extra_size = 0;
+	enum mpegts_codec codec;
+
+	if (strcmp(codec_name, "h264") == 0) {
+		codec = MPEGTS_CODEC_H264;
+	} else if (strcmp(codec_name, "hevc") == 0) {
+		codec = MPEGTS_CODEC_HEVC;
+	} else {
+		error("Unsupported video codec '%s'", codec_name);
+		return false;
+	}
+
+	stream->packetizer = mpegts_packetizer_create(stream->h->max_packet_size, native_srt_send, stream);
+
+	obs_encoder_get_extra_data(vencoder, &extra_data, &extra_size);
+	if (!mpegts_packetizer_add_video(stream->packetizer, codec, extra_data, extra_size))
+		return false;
+
+	return add_native_audio_streams(stream);
+}
+
 static bool fetch_service_info(struct ffmpeg_output *stream, struct ffmpeg_cfg *config, int *code)
 {
 	obs_service_t *service = obs_output_get_service(stream->output);
@@ -982,6 +1156,17 @@ static bool setup_muxer_settings(struct ffmpeg_output *stream, struct ffmpeg_cfg
 	obs_data_t *settings = obs_output_get_settings(stream->output);
 	obs_data_set_default_string(settings, "muxer_settings", "");
 	config->muxer_settings = obs_data_get_string(settings, "muxer_settings");
+
+	/* SRT is packetized natively unless explicitly disabled; the latency
+	 * budget (in ms) is used as SRT latency if the url doesn't set one and
+	 * as time-to-live for each sent message. */
+	obs_data_set_default_bool(settings, "native_srt", true);
+	obs_data_set_default_int(settings, "latency_budget_ms", 0);
+	config->native_srt = config->is_srt && obs_data_get_bool(settings, "native_srt");
+	config->latency_budget_ms = (int)obs_data_get_int(settings, "latency_budget_ms");
+	if (config->native_srt && *config->muxer_settings)
+		info("Muxer settings are ignored by the native SRT output");
+
 	obs_data_release(settings);
 	config->protocol_settings = "";
 	return true;
@@ -1000,7 +1185,7 @@ static bool ffmpeg_mpegts_finalize(struct ffmpeg_output *stream, struct ffmpeg_c
 	}
 	struct ffmpeg_data *ff_data = &stream->ff_data;
 	if (!stream->got_headers) {
-		if (!init_streams(stream, ff_data)) {
+		if (!config->native_srt && !init_streams(stream, ff_data)) {
 			error("mpegts avstream failed to be created");
 			*code = OBS_OUTPUT_ERROR;
 			return false;
@@ -1010,7 +1195,8 @@ static bool ffmpeg_mpegts_finalize(struct ffmpeg_output *stream, struct ffmpeg_c
 			error("Failed to open the url");
 			return false;
 		}
-		av_dump_format(ff_data->output, 0, NULL, 1);
+		if (!config->native_srt)
+			av_dump_format(ff_data->output, 0, NULL, 1);
 	}
 	os_event_reset(stream->stop_event);
 	int ret = pthread_create(&stream->write_thread, NULL, write_thread, stream);
@@ -1188,6 +1374,7 @@ static bool ffmpeg_mpegts_start(void *data)
 	stream->video_start_ts = 0;
 	stream->total_bytes = 0;
 	stream->got_headers = false;
+	spsc_ring_overflow_reset(&stream->packet_ring_overflow);
 
 	pthread_create(&stream->start_stop_thread, NULL, start_stop_thread_fn, cmd);
 	os_atomic_set_bool(&stream->start_stop_thread_active, true);
@@ -1205,14 +1392,7 @@ static void ffmpeg_mpegts_deactivate(struct ffmpeg_output *stream)
 		stream->write_thread_active = false;
 	}
 
-	pthread_mutex_lock(&stream->write_mutex);
-
-	for (size_t i = 0; i < stream->packets.num; i++)
-		av_packet_free(stream->packets.array + i);
-
-	da_free(stream->packets);
-
-	pthread_mutex_unlock(&stream->write_mutex);
+	free_packets(stream);
 }
 
 static uint64_t ffmpeg_mpegts_total_bytes(void *data)
@@ -1221,54 +1401,28 @@ static uint64_t ffmpeg_mpegts_total_bytes(void *data)
 	return stream->total_bytes;
 }
 
-static inline int64_t rescale_ts2(AVStream *stream, AVRational codec_time_base, int64_t val)
-{
-	return av_rescale_q_rnd(val / codec_time_base.num, codec_time_base, stream->time_base,
-				AV_ROUND_NEAR_INF | AV_ROUND_PASS_MINMAX);
-}
-
-/* Convert obs encoder_packet to FFmpeg AVPacket and write to circular buffer
- * where it will be processed in the write_thread by process_packet.
+/* Reference obs encoder_packet (no copy) and queue it for the write_thread,
+ * which converts it to an AVPacket or packetizes it natively.
  */
 void mpegts_write_packet(struct ffmpeg_output *stream, struct encoder_packet *encpacket)
 {
-	if (stopping(stream) || !stream->ff_data.video || !stream->ff_data.video_ctx || !stream->ff_data.audio_infos)
-		return;
-	bool is_video = encpacket->type == OBS_ENCODER_VIDEO;
-	if (!is_video) {
-		if (!stream->ff_data.audio_infos[encpacket->track_idx].stream)
-			return;
-	}
-
-	AVStream *avstream = is_video ? stream->ff_data.video
-				      : stream->ff_data.audio_infos[encpacket->track_idx].stream;
-	AVPacket *packet = NULL;
+	struct encoder_packet packet;
 
-	const AVRational codec_time_base = is_video ? stream->ff_data.video_ctx->time_base
-						    : stream->ff_data.audio_infos[encpacket->track_idx].ctx->time_base;
+	if (stopping(stream))
+		return;
+	if (stream->ff_data.config.native_srt ? !stream->packetizer : !stream->ff_data.video)
+		return;
 
-	packet = av_packet_alloc();
+	obs_encoder_packet_ref(&packet, encpacket);
 
-	packet->data = av_memdup(encpacket->data, (int)encpacket->size);
-	if (packet->data == NULL) {
-		error("Couldn't allocate packet data");
-		goto fail;
+	if (!spsc_ring_push_packet(&stream->packet_ring, &stream->packet_ring_overflow,
+				   obs_output_get_name(stream->output), &packet, 0,
+				   packet.type == OBS_ENCODER_VIDEO, packet.keyframe)) {
+		obs_encoder_packet_release(&packet);
+		return;
 	}
-	packet->size = (int)encpacket->size;
-	packet->stream_index = avstream->id;
-	packet->pts = rescale_ts2(avstream, codec_time_base, encpacket->pts);
-	packet->dts = rescale_ts2(avstream, codec_time_base, encpacket->dts);
-
-	if (encpacket->keyframe)
-		packet->flags = AV_PKT_FLAG_KEY;
 
-	pthread_mutex_lock(&stream->write_mutex);
-	da_push_back(stream->packets, &packet);
-	pthread_mutex_unlock(&stream->write_mutex);
 	os_sem_post(stream->write_sem);
-	return;
-fail:
-	av_packet_free(&packet);
 }
 
 static bool write_header(struct ffmpeg_output *stream, struct ffmpeg_data *data)
@@ -1324,7 +1478,15 @@ static void ffmpeg_mpegts_data(void *data, struct encoder_packet *packet)
 	struct ffmpeg_output *stream = data;
 	struct ffmpeg_data *ff_data = &stream->ff_data;
 	int code;
-	if (!stream->got_headers) {
+	if (!stream->got_headers && ff_data->config.native_srt) {
+		if (!init_native_streams(stream)) {
+			error("Failed to initialize native SRT streams");
+			code = OBS_OUTPUT_INVALID_STREAM;
+			goto fail;
+		}
+		stream->got_headers = true;
+		ff_data->initialized = true;
+	} else if (!stream->got_headers) {
 		if (get_extradata(stream)) {
 			stream->got_headers = true;
 		} else {
@@ -49,6 +49,7 @@ static inline void replay_buffer_clear(struct ffmpeg_muxer *stream)
 	while (stream->packets.size > 0) {
 		struct encoder_packet pkt;
 		deque_pop_front(&stream->packets, &pkt, sizeof(pkt));
+		obs_output_memory_remove(stream->output, pkt.size);
 		obs_encoder_packet_release(&pkt);
 	}
 
@@ -483,13 +484,14 @@ int deactivate(struct ffmpeg_muxer *stream, int code)
 	}
 
 	if (stream->is_hls) {
+		struct encoder_packet packet;
+
+		/* deactivate can be reached from both the write thread and the
+		 * encoder callback, only one of them may drain the ring */
 		pthread_mutex_lock(&stream->write_mutex);
 
-		while (stream->packets.size) {
-			struct encoder_packet packet;
-			deque_pop_front(&stream->packets, &packet, sizeof(packet));
+		while (spsc_ring_pop(&stream->packet_ring, &packet, NULL))
 			obs_encoder_packet_release(&packet);
-		}
 
 		pthread_mutex_unlock(&stream->write_mutex);
 	}
@@ -1005,6 +1007,7 @@ static bool purge_front(struct ffmpeg_muxer *stream)
 		return false;
 
 	deque_pop_front(&stream->packets, &pkt, sizeof(pkt));
+	obs_output_memory_remove(stream->output, pkt.size);
 
 	keyframe = pkt.type == OBS_ENCODER_VIDEO && pkt.keyframe;
 
@@ -1228,6 +1231,7 @@ static void replay_buffer_data(void *data, struct encoder_packet *packet)
 	stream->cur_size += pkt.size;
 
 	deque_push_back(&stream->packets, packet, sizeof(*packet));
+	obs_output_memory_add(stream->output, pkt.size);
 
 	if (packet->type == OBS_ENCODER_VIDEO && packet->keyframe)
 		stream->keyframes++;
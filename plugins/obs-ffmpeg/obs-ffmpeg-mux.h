@@ -3,6 +3,7 @@
 #include <obs-module.h>
 #include <obs-hotkey.h>
 #include <util/deque.h>
+#include <util/spsc-ring.h>
 #include <util/darray.h>
 #include <util/dstr.h>
 #include <util/pipe.h>
@@ -53,11 +54,13 @@ struct ffmpeg_muxer {
 
 	/* HLS only */
 	int keyint_sec;
+	struct spsc_ring packet_ring;
+	struct spsc_ring_overflow packet_ring_overflow;
 	pthread_mutex_t write_mutex;
 	os_sem_t *write_sem;
 	os_event_t *stop_event;
 	bool is_hls;
-	int dropped_frames;
+	volatile long dropped_frames;
 	int min_priority;
 	int64_t last_dts_usec;
 
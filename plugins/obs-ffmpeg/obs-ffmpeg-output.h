@@ -6,6 +6,7 @@
 #include <libavformat/avformat.h>
 #include <libswscale/swscale.h>
 #ifdef NEW_MPEGTS_OUTPUT
+#include <util/spsc-ring.h>
 #include "obs-ffmpeg-url.h"
 #endif
 
@@ -46,6 +47,8 @@ struct ffmpeg_cfg {
 	bool is_srt;
 	bool is_rist;
 	int srt_pkt_size;
+	bool native_srt;
+	int latency_budget_ms;
 };
 
 struct ffmpeg_audio_info {
@@ -122,6 +125,15 @@ struct ffmpeg_output {
 	pthread_mutex_t start_stop_mutex;
 	volatile bool start_stop_thread_active;
 	bool has_connected;
+
+	/* referenced encoder packets, handed from the encoder callback to the
+	 * write thread */
+	struct spsc_ring packet_ring;
+	struct spsc_ring_overflow packet_ring_overflow;
+
+	/* native SRT path: encoder packets are packetized straight into SRT
+	 * messages, bypassing avformat */
+	struct mpegts_packetizer *packetizer;
 #endif
 };
 
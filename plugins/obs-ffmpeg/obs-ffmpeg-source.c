@@ -46,6 +46,7 @@ struct ffmpeg_source {
 	bool is_local_file;
 	bool is_hw_decoding;
 	bool full_decode;
+	bool loop_cache;
 	bool is_clear_on_media_end;
 	bool restart_on_activate;
 	bool close_when_inactive;
@@ -54,6 +55,12 @@ struct ffmpeg_source {
 	bool is_track_matte;
 	bool log_changes;
 
+	volatile bool frame_preloaded;
+	volatile bool awaiting_first_frame;
+	volatile bool start_latency_valid;
+	uint64_t start_ts;
+	int64_t start_latency;
+
 	pthread_t reconnect_thread;
 	pthread_mutex_t reconnect_mutex;
 	bool reconnect_thread_valid;
@@ -98,6 +105,7 @@ static bool is_local_file_modified(obs_properties_t *props, obs_property_t *prop
 	obs_property_t *input_format = obs_properties_get(props, "input_format");
 	obs_property_t *local_file = obs_properties_get(props, "local_file");
 	obs_property_t *looping = obs_properties_get(props, "looping");
+	obs_property_t *loop_cache = obs_properties_get(props, "loop_cache");
 	obs_property_t *buffering = obs_properties_get(props, "buffering_mb");
 	obs_property_t *seekable = obs_properties_get(props, "seekable");
 	obs_property_t *speed = obs_properties_get(props, "speed_percent");
@@ -107,6 +115,7 @@ static bool is_local_file_modified(obs_properties_t *props, obs_property_t *prop
 	obs_property_set_visible(buffering, !enabled);
 	obs_property_set_visible(local_file, enabled);
 	obs_property_set_visible(looping, enabled);
+	obs_property_set_visible(loop_cache, enabled);
 	obs_property_set_visible(speed, enabled);
 	obs_property_set_visible(seekable, !enabled);
 	obs_property_set_visible(reconnect_delay_sec, !enabled);
@@ -174,6 +183,9 @@ static obs_properties_t *ffmpeg_source_getproperties(void *data)
 
 	obs_properties_add_bool(props, "looping", obs_module_text("Looping"));
 
+	prop = obs_properties_add_bool(props, "loop_cache", obs_module_text("LoopCache"));
+	obs_property_set_long_description(prop, obs_module_text("LoopCache.ToolTip"));
+
 	obs_properties_add_bool(props, "restart_on_activate", obs_module_text("RestartWhenActivated"));
 
 	prop = obs_properties_add_int_slider(props, "buffering_mb", obs_module_text("BufferingMB"), 0, 16, 1);
@@ -230,17 +242,24 @@ static void dump_source_info(struct ffmpeg_source *s, const char *input, const c
 		"\trestart_on_activate:     %s\n"
 		"\tclose_when_inactive:     %s\n"
 		"\tfull_decode:             %s\n"
+		"\tloop_cache:              %s\n"
 		"\tffmpeg_options:          %s",
 		input ? input : "(null)", input_format ? input_format : "(null)", s->speed_percent,
 		s->is_looping ? "yes" : "no", s->is_linear_alpha ? "yes" : "no", s->is_hw_decoding ? "yes" : "no",
 		s->is_clear_on_media_end ? "yes" : "no", s->restart_on_activate ? "yes" : "no",
-		s->close_when_inactive ? "yes" : "no", s->full_decode ? "yes" : "no", s->ffmpeg_options);
+		s->close_when_inactive ? "yes" : "no", s->full_decode ? "yes" : "no", s->loop_cache ? "yes" : "no",
+		s->ffmpeg_options);
 }
 
 static void get_frame(void *opaque, struct obs_source_frame *f)
 {
 	struct ffmpeg_source *s = opaque;
 	obs_source_output_video(s->source, f);
+
+	if (os_atomic_set_bool(&s->awaiting_first_frame, false)) {
+		s->start_latency = (int64_t)(os_gettime_ns() - s->start_ts);
+		os_atomic_set_bool(&s->start_latency_valid, true);
+	}
 }
 
 static void preload_frame(void *opaque, struct obs_source_frame *f)
@@ -249,8 +268,10 @@ static void preload_frame(void *opaque, struct obs_source_frame *f)
 	if (s->close_when_inactive)
 		return;
 
-	if (s->is_clear_on_media_end || s->is_looping)
+	if (s->is_clear_on_media_end || s->is_looping) {
 		obs_source_preload_video(s->source, f);
+		os_atomic_set_bool(&s->frame_preloaded, true);
+	}
 
 	if (!s->is_local_file && os_atomic_set_bool(&s->reconnecting, false))
 		FF_BLOG(LOG_INFO, "Reconnected.");
@@ -309,9 +330,12 @@ static void ffmpeg_source_open(struct ffmpeg_source *s)
 			.reconnecting = s->reconnecting,
 			.request_preload = s->is_stinger,
 			.full_decode = s->full_decode,
+			.loop_cache = s->loop_cache && s->is_local_file,
+			.low_latency = s->is_stinger || !s->is_local_file,
 		};
 
 		s->media = media_playback_create(&info);
+		media_playback_set_visible(s->media, obs_source_showing(s->source));
 	}
 }
 
@@ -323,11 +347,25 @@ static void ffmpeg_source_start(struct ffmpeg_source *s)
 	if (!s->media)
 		return;
 
+	bool preloaded = false;
+
+	os_atomic_set_bool(&s->start_latency_valid, false);
+	s->start_ts = os_gettime_ns();
+	os_atomic_set_bool(&s->awaiting_first_frame, true);
+
 	media_playback_play(s->media, s->is_looping, s->reconnecting);
-	if (s->is_local_file && media_playback_has_video(s->media) && (s->is_clear_on_media_end || s->is_looping))
+	if (s->is_local_file && media_playback_has_video(s->media) && (s->is_clear_on_media_end || s->is_looping)) {
 		obs_source_show_preloaded_video(s->source);
-	else
+		preloaded = os_atomic_load_bool(&s->frame_preloaded);
+	} else {
 		obs_source_output_video(s->source, NULL);
+	}
+
+	/* a preloaded first frame is shown without waiting for the decoder */
+	if (preloaded && os_atomic_set_bool(&s->awaiting_first_frame, false)) {
+		s->start_latency = 0;
+		os_atomic_set_bool(&s->start_latency_valid, true);
+	}
 	set_media_state(s, OBS_MEDIA_STATE_PLAYING);
 	obs_source_media_started(s->source);
 }
@@ -437,7 +475,8 @@ static void ffmpeg_source_update(void *data, obs_data_t *settings)
 
 	/* Restart media source if these properties are changed */
 	if (s->is_hw_decoding != is_hw_decoding || s->range != range || s->speed_percent != speed_percent ||
-	    (s->ffmpeg_options && strcmp(s->ffmpeg_options, ffmpeg_options) != 0))
+	    (s->ffmpeg_options && strcmp(s->ffmpeg_options, ffmpeg_options) != 0) ||
+	    s->loop_cache != obs_data_get_bool(settings, "loop_cache"))
 		should_restart_media = true;
 
 	/* If media has ended and user enables looping, user expects that it restarts.
@@ -456,6 +495,7 @@ static void ffmpeg_source_update(void *data, obs_data_t *settings)
 	s->input_format = input_format ? bstrdup(input_format) : NULL;
 	s->is_hw_decoding = is_hw_decoding;
 	s->full_decode = obs_data_get_bool(settings, "full_decode");
+	s->loop_cache = obs_data_get_bool(settings, "loop_cache");
 	s->is_clear_on_media_end = obs_data_get_bool(settings, "clear_on_media_end");
 	s->restart_on_activate = !astrcmpi_n(input, RIST_PROTO, sizeof(RIST_PROTO) - 1)
 					 ? false
@@ -478,6 +518,7 @@ static void ffmpeg_source_update(void *data, obs_data_t *settings)
 	if (s->media && should_restart_media) {
 		media_playback_destroy(s->media);
 		s->media = NULL;
+		os_atomic_set_bool(&s->frame_preloaded, false);
 	}
 
 	/* directly set options if media is playing */
@@ -544,6 +585,39 @@ static void get_nb_frames(void *data, calldata_t *cd)
 	calldata_set_int(cd, "num_frames", frames);
 }
 
+static void get_memory_usage(void *data, calldata_t *cd)
+{
+	struct ffmpeg_source *s = data;
+	int64_t bytes = media_playback_get_memory_usage(s->media);
+	calldata_set_int(cd, "bytes", bytes);
+}
+
+static void get_start_latency(void *data, calldata_t *cd)
+{
+	struct ffmpeg_source *s = data;
+	int64_t latency = -1;
+
+	/* start_latency is written before the flag is set, so it is never
+	 * read half-written or left over from a previous start */
+	if (os_atomic_load_bool(&s->start_latency_valid))
+		latency = s->start_latency;
+
+	calldata_set_int(cd, "latency", latency);
+}
+
+static void get_decode_stats(void *data, calldata_t *cd)
+{
+	struct ffmpeg_source *s = data;
+	struct mp_decode_stats stats;
+	media_playback_get_decode_stats(s->media, &stats);
+
+	calldata_set_int(cd, "frames", (long long)stats.frames);
+	calldata_set_int(cd, "decode_time", (long long)stats.total_decode_ns);
+	calldata_set_int(cd, "max_decode_time", (long long)stats.max_decode_ns);
+	calldata_set_int(cd, "wait_time", (long long)stats.total_wait_ns);
+	calldata_set_int(cd, "threads", stats.threads);
+}
+
 static bool ffmpeg_source_play_hotkey(void *data, obs_hotkey_pair_id id, obs_hotkey_t *hotkey, bool pressed)
 {
 	UNUSED_PARAMETER(id);
@@ -627,6 +701,12 @@ static void *ffmpeg_source_create(obs_data_t *settings, obs_source_t *source)
 	proc_handler_add(ph, "void preload_first_frame()", preload_first_frame_proc, s);
 	proc_handler_add(ph, "void get_duration(out int duration)", get_duration, s);
 	proc_handler_add(ph, "void get_nb_frames(out int num_frames)", get_nb_frames, s);
+	proc_handler_add(ph, "void get_memory_usage(out int bytes)", get_memory_usage, s);
+	proc_handler_add(ph, "void get_start_latency(out int latency)", get_start_latency, s);
+	proc_handler_add(ph,
+			 "void get_decode_stats(out int frames, out int decode_time, out int max_decode_time, "
+			 "out int wait_time, out int threads)",
+			 get_decode_stats, s);
 
 	ffmpeg_source_update(s, settings);
 	return s;
@@ -673,6 +753,18 @@ static void ffmpeg_source_deactivate(void *data)
 	}
 }
 
+static void ffmpeg_source_show(void *data)
+{
+	struct ffmpeg_source *s = data;
+	media_playback_set_visible(s->media, true);
+}
+
+static void ffmpeg_source_hide(void *data)
+{
+	struct ffmpeg_source *s = data;
+	media_playback_set_visible(s->media, false);
+}
+
 static void ffmpeg_source_play_pause(void *data, bool pause)
 {
 	struct ffmpeg_source *s = data;
@@ -785,7 +877,7 @@ struct obs_source_info ffmpeg_source = {
 	.id = "ffmpeg_source",
 	.type = OBS_SOURCE_TYPE_INPUT,
 	.output_flags = OBS_SOURCE_ASYNC_VIDEO | OBS_SOURCE_AUDIO | OBS_SOURCE_DO_NOT_DUPLICATE |
-			OBS_SOURCE_CONTROLLABLE_MEDIA,
+			OBS_SOURCE_CONTROLLABLE_MEDIA | OBS_SOURCE_PARALLEL_CREATE,
 	.get_name = ffmpeg_source_getname,
 	.create = ffmpeg_source_create,
 	.destroy = ffmpeg_source_destroy,
@@ -793,6 +885,8 @@ struct obs_source_info ffmpeg_source = {
 	.get_properties = ffmpeg_source_getproperties,
 	.activate = ffmpeg_source_activate,
 	.deactivate = ffmpeg_source_deactivate,
+	.show = ffmpeg_source_show,
+	.hide = ffmpeg_source_hide,
 	.video_tick = ffmpeg_source_tick,
 	.missing_files = ffmpeg_source_missingfiles,
 	.update = ffmpeg_source_update,
@@ -83,6 +83,7 @@ typedef struct SRTContext {
 	int tsbpd;
 	double time; // time in s in order to post logs at definite intervals
 	struct srt_err last_error;
+	int64_t latency_budget; // default for latency (in us) if the url doesn't set one
 } SRTContext;
 
 #define OBS_OUTPUT_TIMEDOUT -10
@@ -805,6 +806,9 @@ static int libsrt_open(URLContext *h, const char *uri)
 			s->localport = av_strndup(buf, strlen(buf));
 		}
 	}
+	if (s->latency < 0 && s->latency_budget > 0)
+		s->latency = s->latency_budget;
+
 	ret = libsrt_setup(h, uri);
 	if (ret < 0) {
 		ret = s->last_error.obs_output_error_number;
@@ -843,7 +847,9 @@ err:
 	return ret;
 }
 
-static int libsrt_write(URLContext *h, const uint8_t *buf, int size)
+/* Sends buf as a single SRT message. A positive ttl (in ms) lets libsrt drop
+ * the message if it couldn't be sent in time, -1 means no limit. */
+static int libsrt_write_msg(URLContext *h, const uint8_t *buf, int size, int ttl)
 {
 	SRTContext *s = (SRTContext *)h->priv_data;
 	int ret;
@@ -853,7 +859,7 @@ static int libsrt_write(URLContext *h, const uint8_t *buf, int size)
 	if (ret)
 		return ret;
 
-	ret = srt_send(s->fd, (char *)buf, size);
+	ret = srt_sendmsg(s->fd, (const char *)buf, size, ttl, 0);
 	if (ret < 0) {
 		ret = libsrt_neterrno(h);
 	} else {
@@ -881,6 +887,11 @@ static int libsrt_write(URLContext *h, const uint8_t *buf, int size)
 	return ret;
 }
 
+static int libsrt_write(URLContext *h, const uint8_t *buf, int size)
+{
+	return libsrt_write_msg(h, buf, size, -1);
+}
+
 static int libsrt_close(URLContext *h)
 {
 	SRTContext *s = (SRTContext *)h->priv_data;
@@ -39,10 +39,8 @@
 #endif
 
 /* dynamic bitrate coefficients */
-#define DBR_INC_TIMER (4ULL * SEC_TO_NSEC)
-#define DBR_TRIGGER_USEC (200ULL * MSEC_TO_USEC)
-#define MIN_ESTIMATE_DURATION_MS 1000
-#define MAX_ESTIMATE_DURATION_MS 2000
+#define DBR_MIN_BITRATE 50
+#define PACKET_RING_SIZE 4096
 
 static const char *rtmp_stream_getname(void *unused)
 {
@@ -60,22 +58,18 @@ static void log_rtmp(int level, const char *format, va_list args)
 
 static inline size_t num_buffered_packets(struct rtmp_stream *stream);
 
+/* only called while the encoder callback and send thread are not running */
 static inline void free_packets(struct rtmp_stream *stream)
 {
+	struct encoder_packet packet;
 	size_t num_packets;
 
-	pthread_mutex_lock(&stream->packets_mutex);
-
 	num_packets = num_buffered_packets(stream);
 	if (num_packets)
 		info("Freeing %d remaining packets", (int)num_packets);
 
-	while (stream->packets.size) {
-		struct encoder_packet packet;
-		deque_pop_front(&stream->packets, &packet, sizeof(packet));
+	while (spsc_ring_pop(&stream->packets, &packet, NULL))
 		obs_encoder_packet_release(&packet);
-	}
-	pthread_mutex_unlock(&stream->packets_mutex);
 }
 
 static inline bool stopping(struct rtmp_stream *stream)
@@ -129,13 +123,11 @@ static void rtmp_stream_destroy(void *data)
 	dstr_free(&stream->bind_ip);
 	os_event_destroy(stream->stop_event);
 	os_sem_destroy(stream->send_sem);
-	pthread_mutex_destroy(&stream->packets_mutex);
-	deque_free(&stream->packets);
+	spsc_ring_free(&stream->packets);
 #ifdef TEST_FRAMEDROPS
 	deque_free(&stream->droptest_info);
 #endif
-	deque_free(&stream->dbr_frames);
-	pthread_mutex_destroy(&stream->dbr_mutex);
+	obs_bitrate_controller_destroy(stream->dbr);
 
 	os_event_destroy(stream->buffer_space_available_event);
 	os_event_destroy(stream->buffer_has_data_event);
@@ -152,13 +144,11 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 {
 	struct rtmp_stream *stream = bzalloc(sizeof(struct rtmp_stream));
 	stream->output = output;
-	pthread_mutex_init_value(&stream->packets_mutex);
+	spsc_ring_init(&stream->packets, sizeof(struct encoder_packet), PACKET_RING_SIZE);
 
 	RTMP_LogSetCallback(log_rtmp);
 	RTMP_LogSetLevel(RTMP_LOGWARNING);
 
-	if (pthread_mutex_init(&stream->packets_mutex, NULL) != 0)
-		goto fail;
 	if (os_event_init(&stream->stop_event, OS_EVENT_TYPE_MANUAL) != 0)
 		goto fail;
 
@@ -167,11 +157,6 @@ static void *rtmp_stream_create(obs_data_t *settings, obs_output_t *output)
 		goto fail;
 	}
 
-	if (pthread_mutex_init(&stream->dbr_mutex, NULL) != 0) {
-		warn("Failed to initialize dbr mutex");
-		goto fail;
-	}
-
 	if (os_event_init(&stream->buffer_space_available_event, OS_EVENT_TYPE_AUTO) != 0) {
 		warn("Failed to initialize write buffer event");
 		goto fail;
@@ -230,16 +215,18 @@ static inline void set_rtmp_dstr(AVal *val, struct dstr *str)
 
 static inline bool get_next_packet(struct rtmp_stream *stream, struct encoder_packet *packet)
 {
-	bool new_packet = false;
+	bool dropped;
+
+	while (spsc_ring_pop(&stream->packets, packet, &dropped)) {
+		if (!dropped)
+			return true;
 
-	pthread_mutex_lock(&stream->packets_mutex);
-	if (stream->packets.size) {
-		deque_pop_front(&stream->packets, packet, sizeof(struct encoder_packet));
-		new_packet = true;
+		/* dropped by the encoder callback while it was queued */
+		os_atomic_inc_long(&stream->dropped_frames);
+		obs_encoder_packet_release(packet);
 	}
-	pthread_mutex_unlock(&stream->packets_mutex);
 
-	return new_packet;
+	return false;
 }
 
 static bool process_recv_data(struct rtmp_stream *stream, size_t size)
@@ -582,36 +569,6 @@ static void set_output_error(struct rtmp_stream *stream)
 		obs_output_set_last_error(stream->output, msg);
 }
 
-static void dbr_add_frame(struct rtmp_stream *stream, struct dbr_frame *back)
-{
-	struct dbr_frame front;
-	uint64_t dur;
-
-	deque_push_back(&stream->dbr_frames, back, sizeof(*back));
-	deque_peek_front(&stream->dbr_frames, &front, sizeof(front));
-
-	stream->dbr_data_size += back->size;
-
-	dur = (back->send_end - front.send_beg) / 1000000;
-
-	if (dur >= MAX_ESTIMATE_DURATION_MS) {
-		stream->dbr_data_size -= front.size;
-		deque_pop_front(&stream->dbr_frames, NULL, sizeof(front));
-	}
-
-	stream->dbr_est_bitrate = (dur >= MIN_ESTIMATE_DURATION_MS) ? (long)(stream->dbr_data_size * 1000 / dur) : 0;
-	stream->dbr_est_bitrate *= 8;
-	stream->dbr_est_bitrate /= 1000;
-
-	if (stream->dbr_est_bitrate) {
-		stream->dbr_est_bitrate -= stream->audio_bitrate;
-		if (stream->dbr_est_bitrate < 50)
-			stream->dbr_est_bitrate = 50;
-	}
-}
-
-static void dbr_set_bitrate(struct rtmp_stream *stream);
-
 #ifdef _WIN32
 #define socklen_t int
 
@@ -638,7 +595,7 @@ static void *send_thread(void *data)
 
 	while (os_sem_wait(stream->send_sem) == 0) {
 		struct encoder_packet packet;
-		struct dbr_frame dbr_frame;
+		uint64_t send_beg = 0;
 
 		if (stopping(stream) && stream->stop_ts == 0) {
 			break;
@@ -662,10 +619,13 @@ static void *send_thread(void *data)
 		}
 
 		if (stream->dbr_enabled) {
-			dbr_frame.send_beg = os_gettime_ns();
-			dbr_frame.size = packet.size;
+			send_beg = os_gettime_ns();
+			obs_bitrate_controller_on_send(stream->dbr, send_beg, packet.size);
 		}
 
+		/* sending releases the packet */
+		struct encoder_packet sent_packet = packet;
+
 		int sent;
 		if (packet.type == OBS_ENCODER_VIDEO &&
 		    (stream->video_codec[packet.track_idx] != CODEC_H264 ||
@@ -682,13 +642,12 @@ static void *send_thread(void *data)
 			break;
 		}
 
-		if (stream->dbr_enabled) {
-			dbr_frame.send_end = os_gettime_ns();
+		obs_output_packet_sent(stream->output, &sent_packet);
 
-			pthread_mutex_lock(&stream->dbr_mutex);
-			dbr_add_frame(stream, &dbr_frame);
-			pthread_mutex_unlock(&stream->dbr_mutex);
-		}
+		/* a blocking send completing is the closest thing to an ack
+		 * that is available over a plain TCP socket */
+		if (stream->dbr_enabled)
+			obs_bitrate_controller_on_ack(stream->dbr, send_beg, os_gettime_ns(), packet.size);
 	}
 
 	bool encode_error = os_atomic_load_bool(&stream->encode_error);
@@ -720,12 +679,8 @@ static void *send_thread(void *data)
 	RTMP_Close(&stream->rtmp);
 
 	/* reset bitrate on stop */
-	if (stream->dbr_enabled) {
-		if (stream->dbr_cur_bitrate != stream->dbr_orig_bitrate) {
-			stream->dbr_cur_bitrate = stream->dbr_orig_bitrate;
-			dbr_set_bitrate(stream);
-		}
-	}
+	if (stream->dbr_enabled)
+		obs_bitrate_controller_reset(stream->dbr);
 
 	if (!stopping(stream)) {
 		pthread_detach(stream->send_thread);
@@ -1251,8 +1206,9 @@ static bool init_connect(struct rtmp_stream *stream)
 	os_atomic_set_bool(&stream->disconnected, false);
 	os_atomic_set_bool(&stream->encode_error, false);
 	stream->total_bytes_sent = 0;
-	stream->dropped_frames = 0;
+	os_atomic_set_long(&stream->dropped_frames, 0);
 	stream->min_priority = 0;
+	spsc_ring_overflow_reset(&stream->packets_overflow);
 	stream->got_first_packet = false;
 
 	settings = obs_output_get_settings(stream->output);
@@ -1287,14 +1243,9 @@ static bool init_connect(struct rtmp_stream *stream)
 		}
 	}
 
-	deque_free(&stream->dbr_frames);
+	obs_bitrate_controller_destroy(stream->dbr);
+	stream->dbr = NULL;
 	stream->audio_bitrate = (long)obs_data_get_int(asettings, "bitrate");
-	stream->dbr_data_size = 0;
-	stream->dbr_orig_bitrate = (long)obs_data_get_int(vsettings, "bitrate");
-	stream->dbr_cur_bitrate = stream->dbr_orig_bitrate;
-	stream->dbr_est_bitrate = 0;
-	stream->dbr_inc_bitrate = stream->dbr_orig_bitrate / 10;
-	stream->dbr_inc_timeout = 0;
 	stream->dbr_enabled = obs_data_get_bool(settings, OPT_DYN_BITRATE);
 
 	caps = obs_encoder_get_caps(venc);
@@ -1309,7 +1260,12 @@ static bool init_connect(struct rtmp_stream *stream)
 	}
 
 	if (stream->dbr_enabled) {
-		info("Dynamic bitrate enabled.  Dropped frames begone!");
+		const char *estimator = obs_data_get_string(settings, OPT_DYN_BITRATE_ESTIMATOR);
+		uint32_t bitrate = (uint32_t)obs_data_get_int(vsettings, "bitrate");
+
+		stream->dbr = obs_bitrate_controller_create(estimator, venc, DBR_MIN_BITRATE, bitrate);
+		obs_bitrate_controller_set_overhead(stream->dbr, (uint32_t)stream->audio_bitrate);
+		info("Dynamic bitrate enabled (estimator: %s).  Dropped frames begone!", estimator);
 	}
 
 	obs_data_release(vsettings);
@@ -1409,66 +1365,46 @@ static bool rtmp_stream_start(void *data)
 
 static inline bool add_packet(struct rtmp_stream *stream, struct encoder_packet *packet)
 {
-	deque_push_back(&stream->packets, packet, sizeof(struct encoder_packet));
-	return true;
+	bool video = packet->type == OBS_ENCODER_VIDEO;
+	int priority = video ? packet->drop_priority : OBS_NAL_PRIORITY_HIGHEST;
+
+	if (spsc_ring_push_packet(&stream->packets, &stream->packets_overflow, obs_output_get_name(stream->output),
+				  packet, priority, video, packet->keyframe))
+		return true;
+
+	if (video)
+		os_atomic_inc_long(&stream->dropped_frames);
+	return false;
 }
 
 static inline size_t num_buffered_packets(struct rtmp_stream *stream)
 {
-	return stream->packets.size / sizeof(struct encoder_packet);
+	return spsc_ring_size(&stream->packets);
 }
 
 static void drop_frames(struct rtmp_stream *stream, const char *name, int highest_priority, bool pframes)
 {
 	UNUSED_PARAMETER(pframes);
 
-	struct deque new_buf = {0};
-	int num_frames_dropped = 0;
-
-#ifdef _DEBUG
-	int start_packets = (int)num_buffered_packets(stream);
-#else
-	UNUSED_PARAMETER(name);
-#endif
-
-	deque_reserve(&new_buf, sizeof(struct encoder_packet) * 8);
-
-	while (stream->packets.size) {
-		struct encoder_packet packet;
-		deque_pop_front(&stream->packets, &packet, sizeof(packet));
-
-		/* do not drop audio data or video keyframes */
-		if (packet.type == OBS_ENCODER_AUDIO || packet.drop_priority >= highest_priority) {
-			deque_push_back(&new_buf, &packet, sizeof(packet));
-
-		} else {
-			num_frames_dropped++;
-			obs_encoder_packet_release(&packet);
-		}
-	}
-
-	deque_free(&stream->packets);
-	stream->packets = new_buf;
+	/* audio and video keyframes are queued with a priority that is never
+	 * dropped; the send thread releases the dropped packets */
+	size_t num_frames_dropped = spsc_ring_drop(&stream->packets, highest_priority);
 
 	if (stream->min_priority < highest_priority)
 		stream->min_priority = highest_priority;
 	if (!num_frames_dropped)
 		return;
 
-	stream->dropped_frames += num_frames_dropped;
-#ifdef _DEBUG
-	debug("Dropped %s, prev packet count: %d, new packet count: %d", name, start_packets,
-	      (int)num_buffered_packets(stream));
-#endif
+	debug("Dropping %d %s", (int)num_frames_dropped, name);
 }
 
 static bool find_first_video_packet(struct rtmp_stream *stream, struct encoder_packet *first)
 {
-	size_t count = stream->packets.size / sizeof(*first);
+	unsigned long end = spsc_ring_head(&stream->packets);
 
-	for (size_t i = 0; i < count; i++) {
-		struct encoder_packet *cur = deque_data(&stream->packets, i * sizeof(*first));
-		if (cur->type == OBS_ENCODER_VIDEO && !cur->keyframe) {
+	for (unsigned long pos = spsc_ring_tail(&stream->packets); pos != end; pos++) {
+		struct encoder_packet *cur = spsc_ring_at(&stream->packets, pos);
+		if (cur->type == OBS_ENCODER_VIDEO && !cur->keyframe && !spsc_ring_dropped(&stream->packets, pos)) {
 			*first = *cur;
 			return true;
 		}
@@ -1477,89 +1413,15 @@ static bool find_first_video_packet(struct rtmp_stream *stream, struct encoder_p
 	return false;
 }
 
-static bool dbr_bitrate_lowered(struct rtmp_stream *stream)
+static void dbr_update(struct rtmp_stream *stream, int64_t buffer_duration_usec)
 {
-	long prev_bitrate = stream->dbr_prev_bitrate;
-	long est_bitrate = 0;
-	long new_bitrate;
-
-	if (stream->dbr_est_bitrate && stream->dbr_est_bitrate < stream->dbr_cur_bitrate) {
-		stream->dbr_data_size = 0;
-		deque_pop_front(&stream->dbr_frames, NULL, stream->dbr_frames.size);
-		est_bitrate = stream->dbr_est_bitrate / 100 * 100;
-		if (est_bitrate < 50) {
-			est_bitrate = 50;
-		}
-	}
-
-#if 0
-	if (prev_bitrate && est_bitrate) {
-		if (prev_bitrate < est_bitrate) {
-			blog(LOG_INFO, "going back to prev bitrate: "
-					"prev_bitrate (%d) < est_bitrate (%d)",
-					prev_bitrate,
-					est_bitrate);
-			new_bitrate = prev_bitrate;
-		} else {
-			new_bitrate = est_bitrate;
-		}
-		new_bitrate = est_bitrate;
-	} else if (prev_bitrate) {
-		new_bitrate = prev_bitrate;
-		info("going back to prev bitrate");
-
-	} else if (est_bitrate) {
-		new_bitrate = est_bitrate;
-
-	} else {
-		return false;
-	}
-#else
-	if (est_bitrate) {
-		new_bitrate = est_bitrate;
+	uint64_t now = os_gettime_ns();
 
-	} else if (prev_bitrate) {
-		new_bitrate = prev_bitrate;
-		info("going back to prev bitrate");
+	obs_bitrate_controller_on_queue(stream->dbr, now, buffer_duration_usec);
 
-	} else {
-		return false;
-	}
-
-	if (new_bitrate == stream->dbr_cur_bitrate) {
-		return false;
-	}
-#endif
-
-	stream->dbr_prev_bitrate = 0;
-	stream->dbr_cur_bitrate = new_bitrate;
-	stream->dbr_inc_timeout = os_gettime_ns() + DBR_INC_TIMER;
-	info("bitrate decreased to: %ld", stream->dbr_cur_bitrate);
-	return true;
-}
-
-static void dbr_set_bitrate(struct rtmp_stream *stream)
-{
-	obs_encoder_t *vencoder = obs_output_get_video_encoder(stream->output);
-	obs_data_t *settings = obs_encoder_get_settings(vencoder);
-
-	obs_data_set_int(settings, "bitrate", stream->dbr_cur_bitrate);
-	obs_encoder_update(vencoder, settings);
-
-	obs_data_release(settings);
-}
-
-static void dbr_inc_bitrate(struct rtmp_stream *stream)
-{
-	stream->dbr_prev_bitrate = stream->dbr_cur_bitrate;
-	stream->dbr_cur_bitrate += stream->dbr_inc_bitrate;
-
-	if (stream->dbr_cur_bitrate >= stream->dbr_orig_bitrate) {
-		stream->dbr_cur_bitrate = stream->dbr_orig_bitrate;
-		info("bitrate increased to: %ld, done", stream->dbr_cur_bitrate);
-	} else if (stream->dbr_cur_bitrate < stream->dbr_orig_bitrate) {
-		stream->dbr_inc_timeout = os_gettime_ns() + DBR_INC_TIMER;
-		info("bitrate increased to: %ld, waiting", stream->dbr_cur_bitrate);
+	if (obs_bitrate_controller_update(stream->dbr, now)) {
+		debug("buffer_duration_msec: %" PRId64, buffer_duration_usec / 1000);
+		info("bitrate changed to: %" PRIu32, obs_bitrate_controller_get_bitrate(stream->dbr));
 	}
 }
 
@@ -1572,21 +1434,12 @@ static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 	int priority = pframes ? OBS_NAL_PRIORITY_HIGHEST : OBS_NAL_PRIORITY_HIGH;
 	int64_t drop_threshold = pframes ? stream->pframe_drop_threshold_usec : stream->drop_threshold_usec;
 
-	if (!pframes && stream->dbr_enabled) {
-		if (stream->dbr_inc_timeout) {
-			uint64_t t = os_gettime_ns();
-
-			if (t >= stream->dbr_inc_timeout) {
-				stream->dbr_inc_timeout = 0;
-				dbr_inc_bitrate(stream);
-				dbr_set_bitrate(stream);
-			}
-		}
-	}
-
 	if (num_packets < 5) {
-		if (!pframes)
+		if (!pframes) {
 			stream->congestion = 0.0f;
+			if (stream->dbr_enabled)
+				dbr_update(stream, 0);
+		}
 		return;
 	}
 
@@ -1606,22 +1459,8 @@ static void check_to_drop_frames(struct rtmp_stream *stream, bool pframes)
 	 * but let's test without dropping frames
 	 * at all first */
 	if (stream->dbr_enabled) {
-		bool bitrate_changed = false;
-
-		if (pframes) {
-			return;
-		}
-
-		if ((uint64_t)buffer_duration_usec >= DBR_TRIGGER_USEC) {
-			pthread_mutex_lock(&stream->dbr_mutex);
-			bitrate_changed = dbr_bitrate_lowered(stream);
-			pthread_mutex_unlock(&stream->dbr_mutex);
-		}
-
-		if (bitrate_changed) {
-			debug("buffer_duration_msec: %" PRId64, buffer_duration_usec / 1000);
-			dbr_set_bitrate(stream);
-		}
+		if (!pframes)
+			dbr_update(stream, buffer_duration_usec);
 		return;
 	}
 
@@ -1639,7 +1478,7 @@ static bool add_video_packet(struct rtmp_stream *stream, struct encoder_packet *
 	/* if currently dropping frames, drop packets until it reaches the
 	 * desired priority */
 	if (packet->drop_priority < stream->min_priority) {
-		stream->dropped_frames++;
+		os_atomic_inc_long(&stream->dropped_frames);
 		return false;
 	} else {
 		stream->min_priority = 0;
@@ -1699,15 +1538,11 @@ static void rtmp_stream_data(void *data, struct encoder_packet *packet)
 		obs_encoder_packet_ref(&new_packet, packet);
 	}
 
-	pthread_mutex_lock(&stream->packets_mutex);
-
 	if (!disconnected(stream)) {
 		added_packet = (packet->type == OBS_ENCODER_VIDEO) ? add_video_packet(stream, &new_packet)
 								   : add_packet(stream, &new_packet);
 	}
 
-	pthread_mutex_unlock(&stream->packets_mutex);
-
 	if (added_packet)
 		os_sem_post(stream->send_sem);
 	else
@@ -1716,6 +1551,7 @@ static void rtmp_stream_data(void *data, struct encoder_packet *packet)
 
 static void rtmp_stream_defaults(obs_data_t *defaults)
 {
+	obs_data_set_default_string(defaults, OPT_DYN_BITRATE_ESTIMATOR, "delivery_rate");
 	obs_data_set_default_int(defaults, OPT_DROP_THRESHOLD, 700);
 	obs_data_set_default_int(defaults, OPT_PFRAME_DROP_THRESHOLD, 900);
 	obs_data_set_default_int(defaults, OPT_MAX_SHUTDOWN_TIME_SEC, 30);
@@ -1774,7 +1610,7 @@ static uint64_t rtmp_stream_total_bytes_sent(void *data)
 static int rtmp_stream_dropped_frames(void *data)
 {
 	struct rtmp_stream *stream = data;
-	return stream->dropped_frames;
+	return (int)os_atomic_load_long(&stream->dropped_frames);
 }
 
 static float rtmp_stream_congestion(void *data)
@@ -1,6 +1,7 @@
 #include <obs-module.h>
 #include <util/platform.h>
 #include <util/deque.h>
+#include <util/spsc-ring.h>
 #include <util/dstr.h>
 #include <util/threading.h>
 #include <inttypes.h>
@@ -23,6 +24,7 @@
 #define debug(format, ...) do_log(LOG_DEBUG, format, ##__VA_ARGS__)
 
 #define OPT_DYN_BITRATE "dyn_bitrate"
+#define OPT_DYN_BITRATE_ESTIMATOR "dyn_bitrate_estimator"
 #define OPT_DROP_THRESHOLD "drop_threshold_ms"
 #define OPT_PFRAME_DROP_THRESHOLD "pframe_drop_threshold_ms"
 #define OPT_MAX_SHUTDOWN_TIME_SEC "max_shutdown_time_sec"
@@ -46,17 +48,11 @@ struct droptest_info {
 };
 #endif
 
-struct dbr_frame {
-	uint64_t send_beg;
-	uint64_t send_end;
-	size_t size;
-};
-
 struct rtmp_stream {
 	obs_output_t *output;
 
-	pthread_mutex_t packets_mutex;
-	struct deque packets;
+	struct spsc_ring packets;
+	struct spsc_ring_overflow packets_overflow;
 	bool sent_headers;
 
 	bool got_first_packet;
@@ -92,7 +88,7 @@ struct rtmp_stream {
 	int64_t last_dts_usec;
 
 	uint64_t total_bytes_sent;
-	int dropped_frames;
+	volatile long dropped_frames;
 
 #ifdef TEST_FRAMEDROPS
 	struct deque droptest_info;
@@ -101,16 +97,8 @@ struct rtmp_stream {
 	size_t droptest_size;
 #endif
 
-	pthread_mutex_t dbr_mutex;
-	struct deque dbr_frames;
-	size_t dbr_data_size;
-	uint64_t dbr_inc_timeout;
+	obs_bitrate_controller_t *dbr;
 	long audio_bitrate;
-	long dbr_est_bitrate;
-	long dbr_orig_bitrate;
-	long dbr_prev_bitrate;
-	long dbr_cur_bitrate;
-	long dbr_inc_bitrate;
 	bool dbr_enabled;
 
 	enum audio_id_t audio_codec[MAX_OUTPUT_AUDIO_ENCODERS];
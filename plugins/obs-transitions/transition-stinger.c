@@ -29,6 +29,7 @@ struct stinger_info {
 	float transition_b_mul;
 	bool transitioning;
 	bool transition_point_is_frame;
+	int64_t start_latency;
 	int monitoring_type;
 	enum fade_style fade_style;
 
@@ -76,6 +77,7 @@ static void stinger_update(void *data, obs_data_t *settings)
 	obs_data_set_bool(media_settings, "hw_decode", hw_decode);
 	obs_data_set_bool(media_settings, "looping", false);
 	obs_data_set_bool(media_settings, "full_decode", preload);
+	obs_data_set_bool(media_settings, "loop_cache", !preload);
 	obs_data_set_bool(media_settings, "is_stinger", true);
 	obs_data_set_bool(media_settings, "is_track_matte", s->track_matte_enabled);
 
@@ -93,6 +95,15 @@ static void stinger_update(void *data, obs_data_t *settings)
 	if (s->media_source && s->transitioning)
 		obs_source_add_active_child(s->source, s->media_source);
 
+	/* have the first frame ready before the stinger is used the first
+	 * time, later uses preload it again when the transition stops */
+	if (s->media_source && !s->transitioning) {
+		calldata_t cd = {0};
+		proc_handler_t *ph = obs_source_get_proc_handler(s->media_source);
+		proc_handler_call(ph, "preload_first_frame", &cd);
+		calldata_free(&cd);
+	}
+
 	int64_t point = obs_data_get_int(settings, "transition_point");
 
 	s->transition_point_is_frame = obs_data_get_int(settings, "tp_type") == TIMING_FRAME;
@@ -126,6 +137,7 @@ static void stinger_update(void *data, obs_data_t *settings)
 		obs_data_t *tm_media_settings = obs_data_create();
 		obs_data_set_string(tm_media_settings, "local_file", tm_path);
 		obs_data_set_bool(tm_media_settings, "looping", false);
+		obs_data_set_bool(tm_media_settings, "loop_cache", true);
 
 		s->matte_source = obs_source_create_private("ffmpeg_source", NULL, tm_media_settings);
 		obs_data_release(tm_media_settings);
@@ -170,6 +182,12 @@ static void stinger_update(void *data, obs_data_t *settings)
 	}
 }
 
+static void stinger_get_start_latency(void *data, calldata_t *cd)
+{
+	struct stinger_info *s = data;
+	calldata_set_int(cd, "latency", s->start_latency);
+}
+
 static void *stinger_create(obs_data_t *settings, obs_source_t *source)
 {
 	struct stinger_info *s = bzalloc(sizeof(*s));
@@ -198,6 +216,11 @@ static void *stinger_create(obs_data_t *settings, obs_source_t *source)
 	s->ep_matte_tex = gs_effect_get_param_by_name(s->matte_effect, "matte_tex");
 	s->ep_invert_matte = gs_effect_get_param_by_name(s->matte_effect, "invert_matte");
 
+	s->start_latency = -1;
+
+	proc_handler_t *ph = obs_source_get_proc_handler(source);
+	proc_handler_add(ph, "void get_start_latency(out int latency)", stinger_get_start_latency, s);
+
 	obs_transition_enable_fixed(s->source, true, 0);
 	obs_source_update(source, settings);
 	return s;
@@ -593,7 +616,17 @@ static void stinger_transition_stop(void *data)
 	proc_handler_t *ph = obs_source_get_proc_handler(s->media_source);
 
 	calldata_t cd = {0};
+	if (proc_handler_call(ph, "get_start_latency", &cd)) {
+		int64_t latency = calldata_int(&cd, "latency");
+		if (latency >= 0) {
+			s->start_latency = latency;
+			blog(LOG_DEBUG, "Stinger '%s' showed its first frame after %.2f ms",
+			     obs_source_get_name(s->source), (double)latency / 1000000.0);
+		}
+	}
+
 	proc_handler_call(ph, "preload_first_frame", &cd);
+	calldata_free(&cd);
 
 	s->transitioning = false;
 }
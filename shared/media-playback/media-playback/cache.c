@@ -15,6 +15,7 @@
  */
 
 #include <media-io/audio-io.h>
+#include <media-io/video-frame.h>
 #include <util/platform.h>
 
 #include "media-playback.h"
@@ -135,6 +136,14 @@ bool mp_cache_decode(mp_cache_t *c)
 	if (c->start_time == AV_NOPTS_VALUE)
 		c->start_time = 0;
 
+	pthread_mutex_lock(&c->mutex);
+	c->memory_usage = c->decoded_size;
+	mp_decode_get_stats(&m->v, &c->decode_stats);
+	pthread_mutex_unlock(&c->mutex);
+
+	blog(LOG_INFO, "MP: Decoded %zu video frames and %zu audio segments (%.1f MiB) of '%s'", c->video_frames.num,
+	     c->audio_segments.num, (double)c->decoded_size / (1024.0 * 1024.0), c->path);
+
 fail:
 	mp_media_free(m);
 	return success;
@@ -475,6 +484,11 @@ static void fill_video(void *data, struct obs_source_frame *frame)
 
 	dup.timestamp = frame->timestamp;
 
+	uint32_t heights[MAX_AV_PLANES];
+	video_frame_get_plane_heights(heights, dup.format, dup.height);
+	for (size_t i = 0; i < MAX_AV_PLANES; i++)
+		c->decoded_size += (size_t)dup.linesize[i] * heights[i];
+
 	c->final_v_duration = c->m.v.last_duration;
 
 	da_push_back(c->video_frames, &dup);
@@ -504,6 +518,7 @@ static void fill_audio(void *data, struct obs_source_audio *audio)
 		memcpy((uint8_t *)dup.data[0], audio->data[0], size);
 	}
 
+	c->decoded_size += get_total_audio_size(dup.format, dup.speakers, dup.frames);
 	c->final_a_duration = c->m.a.last_duration;
 
 	da_push_back(c->audio_segments, &dup);
@@ -543,6 +558,8 @@ bool mp_cache_init(mp_cache_t *c, const struct mp_media_info *info)
 	info2.v_seek_cb = NULL;
 	info2.stop_cb = NULL;
 	info2.full_decode = true;
+	info2.loop_cache = false;
+	info2.low_latency = false;
 
 	mp_media_t *m = &c->m;
 
@@ -552,6 +569,11 @@ bool mp_cache_init(mp_cache_t *c, const struct mp_media_info *info)
 		mp_cache_free(c);
 		return false;
 	}
+
+	/* decoding the whole file is background work, so it gives way to
+	 * sources that are showing */
+	mp_media_set_visible(m, false);
+
 	if (!mp_media_init2(m)) {
 		mp_cache_free(c);
 		return false;
@@ -699,3 +721,21 @@ int64_t mp_cache_get_duration(mp_cache_t *c)
 {
 	return c->media_duration;
 }
+
+int64_t mp_cache_get_memory_usage(mp_cache_t *c)
+{
+	int64_t size;
+
+	pthread_mutex_lock(&c->mutex);
+	size = (int64_t)c->memory_usage;
+	pthread_mutex_unlock(&c->mutex);
+
+	return size;
+}
+
+void mp_cache_get_decode_stats(mp_cache_t *c, struct mp_decode_stats *stats)
+{
+	pthread_mutex_lock(&c->mutex);
+	*stats = c->decode_stats;
+	pthread_mutex_unlock(&c->mutex);
+}
@@ -64,6 +64,10 @@ struct mp_cache {
 	int64_t final_v_duration;
 	int64_t final_a_duration;
 
+	size_t decoded_size;
+	size_t memory_usage;
+	struct mp_decode_stats decode_stats;
+
 	int64_t play_sys_ts;
 	int64_t next_pts_ns;
 	uint64_t next_ns;
@@ -95,3 +99,5 @@ extern int64_t mp_cache_get_current_time(mp_cache_t *c);
 extern void mp_cache_seek(mp_cache_t *c, int64_t pos);
 extern int64_t mp_cache_get_frames(mp_cache_t *c);
 extern int64_t mp_cache_get_duration(mp_cache_t *c);
+extern int64_t mp_cache_get_memory_usage(mp_cache_t *c);
+extern void mp_cache_get_decode_stats(mp_cache_t *c, struct mp_decode_stats *stats);
@@ -18,8 +18,120 @@
 
 #include "media-playback.h"
 #include "media.h"
+#include <util/platform.h>
 #include <libavutil/mastering_display_metadata.h>
 
+/* Video decoders of all media sources share a budget of decoder threads,
+ * one per logical core.  Each decoder is opened with a share of the budget.
+ * Frame threads keep running between decode calls, so a frame threaded
+ * decoder holds its threads for as long as it is open; a slice threaded
+ * decoder only runs while its threads fit in what is left of the budget.
+ * Shares are recomputed whenever a decoder is flushed, and decoders of
+ * sources that are not showing wait for those that are. */
+#define MAX_DECODER_THREADS 16
+
+static pthread_mutex_t budget_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t budget_cond = PTHREAD_COND_INITIALIZER;
+static int budget_threads = 0;
+static int held_threads = 0;
+static int busy_threads = 0;
+static int visible_waiting = 0;
+static int budget_decoders = 0;
+
+/* share of the budget for a decoder that is not counted in it yet */
+static int get_decoder_share(bool frame_threading)
+{
+	int threads;
+
+	pthread_mutex_lock(&budget_mutex);
+	if (!budget_threads) {
+		budget_threads = os_get_logical_cores();
+		if (budget_threads < 1)
+			budget_threads = 1;
+	}
+
+	threads = budget_threads / (budget_decoders + 1);
+	if (frame_threading && threads > budget_threads - held_threads)
+		threads = budget_threads - held_threads;
+	pthread_mutex_unlock(&budget_mutex);
+
+	if (threads < 1)
+		threads = 1;
+	else if (threads > MAX_DECODER_THREADS)
+		threads = MAX_DECODER_THREADS;
+	return threads;
+}
+
+static void add_budget_decoder(struct mp_decode *d)
+{
+	pthread_mutex_lock(&budget_mutex);
+	budget_decoders++;
+	if (d->frame_threading)
+		held_threads += d->threads;
+	pthread_mutex_unlock(&budget_mutex);
+
+	d->budgeted = true;
+}
+
+static void remove_budget_decoder(struct mp_decode *d)
+{
+	pthread_mutex_lock(&budget_mutex);
+	budget_decoders--;
+	if (d->frame_threading)
+		held_threads -= d->threads;
+	pthread_cond_broadcast(&budget_cond);
+	pthread_mutex_unlock(&budget_mutex);
+
+	d->budgeted = false;
+}
+
+static void begin_decode(struct mp_decode *d)
+{
+	bool visible = os_atomic_load_bool(&d->m->visible);
+	int threads = d->frame_threading ? 0 : d->threads;
+	uint64_t wait_start = os_gettime_ns();
+
+	pthread_mutex_lock(&budget_mutex);
+	if (visible)
+		visible_waiting++;
+
+	while (busy_threads > 0 && ((threads && held_threads + busy_threads + threads > budget_threads) ||
+				    (!visible && visible_waiting > 0)))
+		pthread_cond_wait(&budget_cond, &budget_mutex);
+
+	if (visible)
+		visible_waiting--;
+	busy_threads += threads;
+
+	d->decode_start = os_gettime_ns();
+	d->stats.total_wait_ns += d->decode_start - wait_start;
+	pthread_mutex_unlock(&budget_mutex);
+}
+
+static void end_decode(struct mp_decode *d, bool got_frame)
+{
+	uint64_t decode_time = os_gettime_ns() - d->decode_start;
+
+	pthread_mutex_lock(&budget_mutex);
+	busy_threads -= d->frame_threading ? 0 : d->threads;
+
+	d->stats.total_decode_ns += decode_time;
+	if (decode_time > d->stats.max_decode_ns)
+		d->stats.max_decode_ns = decode_time;
+	if (got_frame)
+		d->stats.frames++;
+
+	pthread_cond_broadcast(&budget_cond);
+	pthread_mutex_unlock(&budget_mutex);
+}
+
+void mp_decode_get_stats(struct mp_decode *d, struct mp_decode_stats *stats)
+{
+	pthread_mutex_lock(&budget_mutex);
+	*stats = d->stats;
+	pthread_mutex_unlock(&budget_mutex);
+}
+
 enum AVHWDeviceType hw_priority[] = {
 	AV_HWDEVICE_TYPE_CUDA,  AV_HWDEVICE_TYPE_D3D11VA, AV_HWDEVICE_TYPE_DXVA2,        AV_HWDEVICE_TYPE_VAAPI,
 	AV_HWDEVICE_TYPE_VDPAU, AV_HWDEVICE_TYPE_QSV,     AV_HWDEVICE_TYPE_VIDEOTOOLBOX, AV_HWDEVICE_TYPE_NONE,
@@ -85,14 +197,32 @@ static int mp_open_codec(struct mp_decode *d, bool hw)
 	if (hw)
 		init_hw_decoder(d, c);
 
-	if (c->thread_count == 1 && c->codec_id != AV_CODEC_ID_PNG && c->codec_id != AV_CODEC_ID_TIFF &&
-	    c->codec_id != AV_CODEC_ID_JPEG2000 && c->codec_id != AV_CODEC_ID_MPEG4 && c->codec_id != AV_CODEC_ID_WEBP)
+	bool threaded = c->thread_count == 1 && c->codec_id != AV_CODEC_ID_PNG && c->codec_id != AV_CODEC_ID_TIFF &&
+			c->codec_id != AV_CODEC_ID_JPEG2000 && c->codec_id != AV_CODEC_ID_MPEG4 &&
+			c->codec_id != AV_CODEC_ID_WEBP;
+
+	if (threaded && d->audio) {
 		c->thread_count = 0;
 
+	} else if (threaded) {
+		/* frame threading delays output by a frame per thread, so
+		 * sources that need their frames right away use slices */
+		c->thread_count = get_decoder_share(!d->m->low_latency);
+		c->thread_type = d->m->low_latency ? FF_THREAD_SLICE : FF_THREAD_FRAME | FF_THREAD_SLICE;
+	}
+
 	ret = avcodec_open2(c, d->codec, NULL);
 	if (ret < 0)
 		goto fail;
 
+	if (threaded && !d->audio) {
+		d->threads = c->thread_count > 0 ? c->thread_count : 1;
+		d->frame_threading = (c->active_thread_type & FF_THREAD_FRAME) != 0;
+		d->stats.threads = d->threads;
+		d->stats.slice_threading = (c->active_thread_type & FF_THREAD_SLICE) != 0;
+		add_budget_decoder(d);
+	}
+
 	d->decoder = c;
 	return ret;
 
@@ -217,6 +347,19 @@ void mp_decode_clear_packets(struct mp_decode *d)
 
 void mp_decode_free(struct mp_decode *d)
 {
+	if (d->budgeted) {
+		remove_budget_decoder(d);
+
+		if (d->stats.frames) {
+			blog(LOG_INFO,
+			     "MP: Decoded %" PRIu64 " video frames of '%s' with %d thread(s) (%s): "
+			     "%.2f ms average, %.2f ms max, %.2f ms waiting for other decoders",
+			     d->stats.frames, d->m->path, d->stats.threads, d->stats.slice_threading ? "slice" : "frame",
+			     (double)d->stats.total_decode_ns / (double)d->stats.frames / 1000000.0,
+			     (double)d->stats.max_decode_ns / 1000000.0, (double)d->stats.total_wait_ns / 1000000.0);
+		}
+	}
+
 	mp_decode_clear_packets(d);
 	deque_free(&d->packets);
 
@@ -348,8 +491,14 @@ bool mp_decode_next(struct mp_decode *d)
 			}
 		}
 
+		if (d->budgeted)
+			begin_decode(d);
+
 		ret = decode_packet(d, &got_frame);
 
+		if (d->budgeted)
+			end_decode(d, ret >= 0 && got_frame);
+
 		if (!got_frame && ret == 0) {
 			d->eof = true;
 			return true;
@@ -410,8 +559,35 @@ bool mp_decode_next(struct mp_decode *d)
 	return true;
 }
 
+/* reopens a software decoder whose share of the thread budget changed since
+ * it was opened; only done on flush, when no frames are pending */
+static void rebalance_decoder(struct mp_decode *d)
+{
+	AVCodecContext *old_decoder = d->decoder;
+
+	if (!d->budgeted || d->hw)
+		return;
+
+	remove_budget_decoder(d);
+
+	if (get_decoder_share(!d->m->low_latency) == d->threads) {
+		add_budget_decoder(d);
+		return;
+	}
+
+	d->decoder = NULL;
+	if (mp_open_codec(d, false) < 0) {
+		d->decoder = old_decoder;
+		add_budget_decoder(d);
+		return;
+	}
+
+	avcodec_free_context(&old_decoder);
+}
+
 void mp_decode_flush(struct mp_decode *d)
 {
+	rebalance_decoder(d);
 	avcodec_flush_buffers(d->decoder);
 	mp_decode_clear_packets(d);
 	d->eof = false;
@@ -21,6 +21,7 @@ extern "C" {
 #endif
 
 #include <util/deque.h>
+#include "media-playback.h"
 
 #ifdef _MSC_VER
 #pragma warning(push)
@@ -65,6 +66,13 @@ struct mp_decode {
 	AVPacket *pkt;
 	bool packet_pending;
 	struct deque packets;
+
+	/* shared thread budget, see decode.c */
+	bool budgeted;
+	bool frame_threading;
+	int threads;
+	uint64_t decode_start;
+	struct mp_decode_stats stats;
 };
 
 extern bool mp_decode_init(struct mp_media *media, enum AVMediaType type, bool hw);
@@ -75,6 +83,7 @@ extern void mp_decode_clear_packets(struct mp_decode *decode);
 extern void mp_decode_push_packet(struct mp_decode *decode, AVPacket *pkt);
 extern bool mp_decode_next(struct mp_decode *decode);
 extern void mp_decode_flush(struct mp_decode *decode);
+extern void mp_decode_get_stats(struct mp_decode *decode, struct mp_decode_stats *stats);
 
 #ifdef __cplusplus
 }
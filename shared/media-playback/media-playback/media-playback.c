@@ -153,6 +153,40 @@ int64_t media_playback_get_duration(media_playback_t *mp)
 		return mp_media_get_duration(&mp->media);
 }
 
+int64_t media_playback_get_memory_usage(media_playback_t *mp)
+{
+	if (!mp)
+		return 0;
+
+	if (mp->is_cached)
+		return mp_cache_get_memory_usage(&mp->cache);
+	else
+		return mp_media_get_memory_usage(&mp->media);
+}
+
+void media_playback_get_decode_stats(media_playback_t *mp, struct mp_decode_stats *stats)
+{
+	if (!mp) {
+		memset(stats, 0, sizeof(*stats));
+		return;
+	}
+
+	if (mp->is_cached)
+		mp_cache_get_decode_stats(&mp->cache, stats);
+	else
+		mp_media_get_decode_stats(&mp->media, stats);
+}
+
+void media_playback_set_visible(media_playback_t *mp, bool visible)
+{
+	if (!mp)
+		return;
+
+	/* a cached file only decodes while it is being loaded */
+	if (!mp->is_cached)
+		mp_media_set_visible(&mp->media, visible);
+}
+
 bool media_playback_has_video(media_playback_t *mp)
 {
 	if (!mp)
@@ -46,6 +46,17 @@ struct mp_media_info {
 	bool reconnecting;
 	bool request_preload;
 	bool full_decode;
+	bool loop_cache;
+	bool low_latency;
+};
+
+struct mp_decode_stats {
+	uint64_t frames;
+	uint64_t total_decode_ns;
+	uint64_t max_decode_ns;
+	uint64_t total_wait_ns;
+	int threads;
+	bool slice_threading;
 };
 
 extern media_playback_t *media_playback_create(const struct mp_media_info *info);
@@ -61,5 +72,8 @@ extern int64_t media_playback_get_current_time(media_playback_t *mp);
 extern void media_playback_seek(media_playback_t *mp, int64_t pos);
 extern int64_t media_playback_get_frames(media_playback_t *mp);
 extern int64_t media_playback_get_duration(media_playback_t *mp);
+extern int64_t media_playback_get_memory_usage(media_playback_t *mp);
+extern void media_playback_get_decode_stats(media_playback_t *mp, struct mp_decode_stats *stats);
+extern void media_playback_set_visible(media_playback_t *mp, bool visible);
 extern bool media_playback_has_video(media_playback_t *mp);
 extern bool media_playback_has_audio(media_playback_t *mp);
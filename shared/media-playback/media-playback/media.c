@@ -27,6 +27,13 @@
 
 static int64_t base_sys_ts = 0;
 
+/* With loop_cache, the compressed packets of a local file are kept in memory
+ * as they are read the first time, and later loops are decoded from memory
+ * without reading or seeking the file.  Only packets read in order from the
+ * start of the file are cached, and files larger than this are read from
+ * disk as usual. */
+#define MAX_LOOP_CACHE_SIZE (512 * 1024 * 1024)
+
 static inline enum video_format convert_pixel_format(int f)
 {
 	switch (f) {
@@ -164,6 +171,71 @@ void mp_media_free_packet(struct mp_media *media, AVPacket *pkt)
 	da_push_back(media->packet_pool, &pkt);
 }
 
+static void mp_media_clear_loop_cache(mp_media_t *m)
+{
+	for (size_t i = 0; i < m->cached_packets.num; i++)
+		av_packet_free(&m->cached_packets.array[i]);
+	da_free(m->cached_packets);
+
+	m->cache_pos = 0;
+	m->cache_complete = false;
+	os_atomic_set_long(&m->cache_size, 0);
+}
+
+static void mp_media_cache_packet(mp_media_t *m, const AVPacket *pkt)
+{
+	long size = os_atomic_load_long(&m->cache_size) + pkt->size + (long)sizeof(AVPacket);
+	AVPacket *cached;
+
+	if (size > MAX_LOOP_CACHE_SIZE) {
+		blog(LOG_INFO, "MP: '%s' is too large to be cached for looping", m->path);
+		mp_media_clear_loop_cache(m);
+		m->loop_cache = false;
+		m->caching = false;
+		return;
+	}
+
+	/* shares the buffer of the demuxed packet */
+	cached = av_packet_clone(pkt);
+	if (!cached) {
+		mp_media_clear_loop_cache(m);
+		m->caching = false;
+		return;
+	}
+
+	da_push_back(m->cached_packets, &cached);
+	os_atomic_set_long(&m->cache_size, size);
+}
+
+static int mp_media_read_packet(mp_media_t *m, AVPacket *pkt)
+{
+	if (m->cache_complete) {
+		if (m->cache_pos == m->cached_packets.num)
+			return AVERROR_EOF;
+
+		return av_packet_ref(pkt, m->cached_packets.array[m->cache_pos++]);
+	}
+
+	int ret = av_read_frame(m->fmt, pkt);
+
+	if (m->caching) {
+		if (ret == AVERROR_EOF) {
+			m->caching = false;
+			m->cache_complete = m->cached_packets.num > 0;
+
+			blog(LOG_INFO, "MP: Cached %zu packets (%.1f MiB) of '%s' for looping", m->cached_packets.num,
+			     (double)os_atomic_load_long(&m->cache_size) / (1024.0 * 1024.0), m->path);
+		} else if (ret < 0) {
+			mp_media_clear_loop_cache(m);
+			m->caching = false;
+		} else if (pkt->size && get_packet_decoder(m, pkt)) {
+			mp_media_cache_packet(m, pkt);
+		}
+	}
+
+	return ret;
+}
+
 static int mp_media_next_packet(mp_media_t *media)
 {
 	AVPacket *pkt;
@@ -175,7 +247,7 @@ static int mp_media_next_packet(mp_media_t *media)
 		pkt = av_packet_alloc();
 	}
 
-	int ret = av_read_frame(media->fmt, pkt);
+	int ret = mp_media_read_packet(media, pkt);
 	if (ret < 0) {
 		if (ret != AVERROR_EOF && ret != AVERROR_EXIT)
 			blog(LOG_WARNING, "MP: av_read_frame failed: %s (%d)", av_err2str(ret), ret);
@@ -517,6 +589,30 @@ static void mp_media_calc_next_ns(mp_media_t *m)
 	m->next_pts_ns = min_next_ns;
 }
 
+/* seeks to the last keyframe at or before pos */
+static void seek_cached(mp_media_t *m, int64_t pos, int64_t start_time)
+{
+	struct mp_decode *d = m->has_video ? &m->v : &m->a;
+	size_t idx = 0;
+
+	if (pos > start_time) {
+		for (size_t i = 0; i < m->cached_packets.num; i++) {
+			AVPacket *pkt = m->cached_packets.array[i];
+			int64_t ts = pkt->pts != AV_NOPTS_VALUE ? pkt->pts : pkt->dts;
+
+			if (pkt->stream_index != d->stream->index || !(pkt->flags & AV_PKT_FLAG_KEY) ||
+			    ts == AV_NOPTS_VALUE)
+				continue;
+			if (av_rescale_q(ts, d->stream->time_base, AV_TIME_BASE_Q) > pos)
+				break;
+
+			idx = i;
+		}
+	}
+
+	m->cache_pos = idx;
+}
+
 static void seek_to(mp_media_t *m, int64_t pos)
 {
 	AVStream *stream = m->fmt->streams[0];
@@ -532,11 +628,22 @@ static void seek_to(mp_media_t *m, int64_t pos)
 				      ? av_rescale_q(seek_pos, AV_TIME_BASE_Q, stream->time_base)
 				      : seek_pos;
 
-	if (m->is_local_file) {
+	if (m->is_local_file && m->cache_complete) {
+		int64_t start_time = m->fmt->start_time == AV_NOPTS_VALUE ? 0 : m->fmt->start_time;
+		seek_cached(m, pos, start_time);
+
+	} else if (m->is_local_file) {
 		int ret = av_seek_frame(m->fmt, 0, seek_target, seek_flags);
 		if (ret < 0) {
 			blog(LOG_WARNING, "MP: Failed to seek: %s", av_err2str(ret));
 		}
+
+		if (m->loop_cache) {
+			int64_t start_time = m->fmt->start_time == AV_NOPTS_VALUE ? 0 : m->fmt->start_time;
+
+			mp_media_clear_loop_cache(m);
+			m->caching = ret >= 0 && pos <= start_time;
+		}
 	}
 
 	if (m->has_video && m->is_local_file) {
@@ -889,6 +996,9 @@ bool mp_media_init(mp_media_t *media, const struct mp_media_info *info)
 	media->speed = info->speed;
 	media->request_preload = info->request_preload;
 	media->is_local_file = info->is_local_file;
+	media->loop_cache = info->loop_cache && info->is_local_file;
+	media->low_latency = info->low_latency;
+	media->visible = true;
 	da_init(media->packet_pool);
 
 	if (!info->is_local_file || media->speed < 1 || media->speed > 200)
@@ -936,6 +1046,7 @@ void mp_media_free(mp_media_t *media)
 	for (size_t i = 0; i < media->packet_pool.num; i++)
 		av_packet_free(&media->packet_pool.array[i]);
 	da_free(media->packet_pool);
+	mp_media_clear_loop_cache(media);
 	avformat_close_input(&media->fmt);
 	pthread_mutex_destroy(&media->mutex);
 	os_sem_destroy(media->sem);
@@ -1039,6 +1150,21 @@ int64_t mp_media_get_duration(mp_media_t *m)
 	return m->fmt ? m->fmt->duration : 0;
 }
 
+int64_t mp_media_get_memory_usage(mp_media_t *m)
+{
+	return os_atomic_load_long(&m->cache_size);
+}
+
+void mp_media_get_decode_stats(mp_media_t *m, struct mp_decode_stats *stats)
+{
+	mp_decode_get_stats(&m->v, stats);
+}
+
+void mp_media_set_visible(mp_media_t *m, bool visible)
+{
+	os_atomic_set_bool(&m->visible, visible);
+}
+
 void mp_media_seek(mp_media_t *m, int64_t pos)
 {
 	pthread_mutex_lock(&m->mutex);
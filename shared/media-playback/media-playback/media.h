@@ -76,6 +76,8 @@ struct mp_media {
 	enum video_range_type cur_range;
 	enum video_range_type force_range;
 	bool is_linear_alpha;
+	bool low_latency;
+	volatile bool visible;
 
 	int64_t play_sys_ts;
 	int64_t next_pts_ns;
@@ -84,6 +86,14 @@ struct mp_media {
 	int64_t base_ts;
 	bool full_decode;
 
+	/* compressed packets of a local file, kept for looping */
+	DARRAY(AVPacket *) cached_packets;
+	size_t cache_pos;
+	volatile long cache_size;
+	bool loop_cache;
+	bool caching;
+	bool cache_complete;
+
 	uint64_t interrupt_poll_ts;
 
 	pthread_mutex_t mutex;
@@ -118,6 +128,9 @@ extern int64_t mp_media_get_current_time(mp_media_t *m);
 extern int64_t mp_media_get_frames(mp_media_t *m);
 extern int64_t mp_media_get_duration(mp_media_t *m);
 extern void mp_media_seek(mp_media_t *m, int64_t pos);
+extern int64_t mp_media_get_memory_usage(mp_media_t *m);
+extern void mp_media_get_decode_stats(mp_media_t *m, struct mp_decode_stats *stats);
+extern void mp_media_set_visible(mp_media_t *m, bool visible);
 
 /* #define DETAILED_DEBUG_INFO */
 
@@ -0,0 +1,230 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs.h>
+
+/* Deterministic link simulation: an encoder producing frames at the
+ * controller's bitrate, an output queue, and a blocking socket with a fixed
+ * send window in front of a shaped link with propagation delay.  Sends block
+ * while the window is full, like RTMP over TCP. */
+
+#define TICK_NS 1000000ULL
+#define FPS 30
+#define PROP_DELAY_TICKS 40
+#define SEND_WINDOW 262144
+#define MAX_FRAMES 1024
+
+#define MAX_KBPS 5000
+#define MIN_KBPS 50
+
+struct sim_frame {
+	uint64_t dts_ns;
+	size_t size;
+};
+
+struct sim_phase {
+	uint64_t until_ms;
+	uint32_t capacity_kbps;
+};
+
+struct sim_link {
+	obs_bitrate_controller_t *controller;
+	const struct sim_phase *phases;
+
+	struct sim_frame queue[MAX_FRAMES];
+	size_t queue_head;
+	size_t queue_count;
+
+	/* packet currently being written to the socket */
+	bool sending;
+	uint64_t send_beg;
+	size_t send_size;
+	size_t send_left;
+
+	double link_queue;
+	size_t unacked;
+	size_t in_flight[PROP_DELAY_TICKS];
+
+	uint64_t next_frame_ns;
+	int64_t max_buffered_usec;
+};
+
+static uint32_t capacity_at(const struct sim_link *link, uint64_t ms)
+{
+	const struct sim_phase *phase = link->phases;
+	while (phase->until_ms && ms >= phase->until_ms)
+		phase++;
+	return phase->capacity_kbps;
+}
+
+static int64_t buffered_usec(const struct sim_link *link)
+{
+	if (!link->queue_count)
+		return 0;
+
+	const struct sim_frame *first = &link->queue[link->queue_head];
+	const struct sim_frame *last = &link->queue[(link->queue_head + link->queue_count - 1) % MAX_FRAMES];
+	return (int64_t)(last->dts_ns - first->dts_ns) / 1000;
+}
+
+static void sim_tick(struct sim_link *link, uint64_t tick)
+{
+	uint64_t now = tick * TICK_NS;
+
+	/* encoder */
+	if (now >= link->next_frame_ns) {
+		uint32_t kbps = obs_bitrate_controller_get_bitrate(link->controller);
+		size_t size = kbps * 1000 / 8 / FPS;
+
+		/* keyframe every two seconds */
+		if ((link->next_frame_ns / TICK_NS) % 2000 < 1000 / FPS)
+			size *= 3;
+
+		assert_true(link->queue_count < MAX_FRAMES);
+		struct sim_frame *frame = &link->queue[(link->queue_head + link->queue_count) % MAX_FRAMES];
+		frame->dts_ns = now;
+		frame->size = size;
+		link->queue_count++;
+		link->next_frame_ns += 1000000000ULL / FPS;
+	}
+
+	/* acknowledgements arriving after the propagation delay */
+	size_t slot = tick % PROP_DELAY_TICKS;
+	link->unacked -= link->in_flight[slot];
+	link->in_flight[slot] = 0;
+
+	/* shaped link draining the bottleneck queue */
+	double budget = (double)capacity_at(link, tick) * 1000.0 / 8.0 / 1000.0;
+	double departed = link->link_queue < budget ? link->link_queue : budget;
+	link->link_queue -= departed;
+	link->in_flight[slot] = (size_t)departed;
+
+	/* sender */
+	if (!link->sending && link->queue_count) {
+		struct sim_frame *frame = &link->queue[link->queue_head];
+		link->queue_head = (link->queue_head + 1) % MAX_FRAMES;
+		link->queue_count--;
+
+		link->sending = true;
+		link->send_beg = now;
+		link->send_size = frame->size;
+		link->send_left = frame->size;
+		obs_bitrate_controller_on_send(link->controller, now, frame->size);
+	}
+
+	if (link->sending) {
+		size_t room = link->unacked < SEND_WINDOW ? SEND_WINDOW - link->unacked : 0;
+		size_t n = room < link->send_left ? room : link->send_left;
+
+		link->send_left -= n;
+		link->unacked += n;
+		link->link_queue += (double)n;
+
+		if (!link->send_left) {
+			link->sending = false;
+			obs_bitrate_controller_on_ack(link->controller, link->send_beg, now, link->send_size);
+		}
+	}
+
+	int64_t buffered = buffered_usec(link);
+	if (buffered > link->max_buffered_usec)
+		link->max_buffered_usec = buffered;
+
+	obs_bitrate_controller_on_queue(link->controller, now, buffered);
+	obs_bitrate_controller_update(link->controller, now);
+}
+
+/* runs until `until_ms`, returning the average bitrate from `settled_ms` on */
+static uint32_t sim_run(struct sim_link *link, uint64_t *tick, uint64_t settled_ms, uint64_t until_ms)
+{
+	uint64_t sum = 0;
+	uint64_t count = 0;
+
+	for (; *tick < until_ms; (*tick)++) {
+		sim_tick(link, *tick);
+
+		if (*tick >= settled_ms) {
+			sum += obs_bitrate_controller_get_bitrate(link->controller);
+			count++;
+		}
+	}
+
+	return (uint32_t)(sum / count);
+}
+
+static const struct sim_phase capacity_drop[] = {
+	{20000, 8000},
+	{50000, 2000},
+	{0, 8000},
+};
+
+static void run_capacity_drop(const char *estimator)
+{
+	struct sim_link *link = bzalloc(sizeof(*link));
+	uint64_t tick = 1;
+
+	link->phases = capacity_drop;
+	link->controller = obs_bitrate_controller_create(estimator, NULL, MIN_KBPS, MAX_KBPS);
+	assert_non_null(link->controller);
+
+	uint32_t start = sim_run(link, &tick, 10000, 20000);
+	link->max_buffered_usec = 0;
+	uint32_t congested = sim_run(link, &tick, 30000, 50000);
+	int64_t congested_buffered = link->max_buffered_usec;
+	link->max_buffered_usec = 0;
+	uint32_t recovered = sim_run(link, &tick, 80000, 90000);
+
+	print_message("%-14s start %4u kbps, congested %4u kbps (peak queue %4d ms), recovered %4u kbps\n",
+		      estimator, start, congested, (int)(congested_buffered / 1000), recovered);
+
+	/* link has headroom: stays at the configured bitrate */
+	assert_int_equal(start, MAX_KBPS);
+
+	/* settles around the 2000 kbps bottleneck without starving, and the
+	 * output queue never builds up to the point of dropping frames */
+	assert_true(congested < 2200);
+	assert_true(congested > 1400);
+	assert_true(congested_buffered < 1000000);
+	assert_true(link->max_buffered_usec < 200000);
+
+	/* recovers once the capacity comes back */
+	assert_true(recovered > 4000);
+
+	obs_bitrate_controller_destroy(link->controller);
+	bfree(link);
+}
+
+static void delivery_rate_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	run_capacity_drop("delivery_rate");
+}
+
+static void delay_gradient_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	run_capacity_drop("delay_gradient");
+}
+
+static void unknown_estimator_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	obs_bitrate_controller_t *controller = obs_bitrate_controller_create("does_not_exist", NULL, 100, 1000);
+	assert_non_null(controller);
+	assert_int_equal(obs_bitrate_controller_get_bitrate(controller), 1000);
+	obs_bitrate_controller_destroy(controller);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(delivery_rate_test),
+		cmocka_unit_test(delay_gradient_test),
+		cmocka_unit_test(unknown_estimator_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,142 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/bmem.h>
+#include <util/threading.h>
+
+#include <string.h>
+
+#define THREAD_ALLOCS 1000
+
+static const char *alloc_thread_name = "pool allocs";
+
+struct find_stats {
+	const char *name;
+	struct bmem_pool_stats stats;
+	bool found;
+};
+
+static bool find_stats(void *param, const struct bmem_pool_stats *stats)
+{
+	struct find_stats *data = param;
+
+	if (strcmp(stats->name, data->name) != 0)
+		return true;
+
+	data->stats = *stats;
+	data->found = true;
+	return false;
+}
+
+static void bmem_pool_alloc_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	long start_allocs = bnum_allocs();
+
+	assert_true(bmem_pool_enabled());
+
+	/* pool sizes and a size above the largest size class */
+	static const size_t sizes[] = {1, 32, 33, 100, 200, 1000, 4096, 4097, 100000};
+	void *ptrs[sizeof(sizes) / sizeof(sizes[0])];
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		ptrs[i] = bmalloc(sizes[i]);
+		assert_int_equal((uintptr_t)ptrs[i] % base_get_alignment(), 0);
+		memset(ptrs[i], (int)i, sizes[i]);
+	}
+
+	assert_int_equal(bnum_allocs(), start_allocs + 9);
+
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++)
+		bfree(ptrs[i]);
+
+	assert_int_equal(bnum_allocs(), start_allocs);
+}
+
+static void bmem_pool_realloc_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	long start_allocs = bnum_allocs();
+
+	/* grow through the size classes and out of the pool, and back */
+	unsigned char *ptr = brealloc(NULL, 16);
+	for (size_t i = 0; i < 16; i++)
+		ptr[i] = (unsigned char)i;
+
+	static const size_t sizes[] = {24, 100, 3000, 8000, 40, 8};
+	for (size_t i = 0; i < sizeof(sizes) / sizeof(sizes[0]); i++) {
+		ptr = brealloc(ptr, sizes[i]);
+		for (size_t j = 0; j < 8; j++)
+			assert_int_equal(ptr[j], j);
+	}
+
+	assert_int_equal(bnum_allocs(), start_allocs + 1);
+	bfree(ptr);
+	assert_int_equal(bnum_allocs(), start_allocs);
+}
+
+static void *alloc_thread(void *data)
+{
+	void **ptrs = data;
+
+	os_set_thread_name(alloc_thread_name);
+
+	for (size_t i = 0; i < THREAD_ALLOCS; i++)
+		ptrs[i] = bmalloc(64 + i % 512);
+
+	return NULL;
+}
+
+static void bmem_pool_cross_thread_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	long start_allocs = bnum_allocs();
+	void *ptrs[THREAD_ALLOCS];
+	pthread_t thread;
+
+	assert_int_equal(pthread_create(&thread, NULL, alloc_thread, ptrs), 0);
+	pthread_join(thread, NULL);
+
+	assert_int_equal(bnum_allocs(), start_allocs + THREAD_ALLOCS);
+
+	/* statistics of exited threads are kept */
+	struct find_stats data = {alloc_thread_name};
+	bmem_pool_enum_stats(find_stats, &data);
+	assert_true(data.found);
+	assert_int_equal(data.stats.allocs, THREAD_ALLOCS);
+	assert_int_equal(data.stats.frees, 0);
+	assert_true(data.stats.bytes_allocated >= data.stats.bytes_requested);
+
+	size_t reserved, in_use;
+	bmem_pool_get_memory(&reserved, &in_use);
+	assert_true(reserved >= in_use);
+	assert_true(in_use >= data.stats.bytes_requested);
+
+	/* blocks freed here go back to the shared lists and are reused */
+	for (size_t i = 0; i < THREAD_ALLOCS; i++)
+		bfree(ptrs[i]);
+
+	assert_int_equal(bnum_allocs(), start_allocs);
+
+	size_t reserved_after;
+	for (size_t i = 0; i < THREAD_ALLOCS; i++)
+		ptrs[i] = bmalloc(64 + i % 512);
+	bmem_pool_get_memory(&reserved_after, NULL);
+	assert_int_equal(reserved_after, reserved);
+
+	for (size_t i = 0; i < THREAD_ALLOCS; i++)
+		bfree(ptrs[i]);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(bmem_pool_alloc_test),
+		cmocka_unit_test(bmem_pool_realloc_test),
+		cmocka_unit_test(bmem_pool_cross_thread_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
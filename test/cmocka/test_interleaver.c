@@ -0,0 +1,242 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <obs-interleaver.h>
+#include <util/darray.h>
+
+/* Property test: the per-track interleaver must produce exactly the same
+ * packet order as the sorted array the output interleaver used before, for
+ * random multi-track streams arriving in random order. */
+
+#define ITERATIONS 500
+#define MAX_STEPS 2000
+
+/* reference: sorted insertion into a single array */
+
+struct reference {
+	DARRAY(struct encoder_packet) packets;
+};
+
+static void reference_insert(struct reference *ref, struct encoder_packet *out)
+{
+	size_t idx;
+	for (idx = 0; idx < ref->packets.num; idx++) {
+		struct encoder_packet *cur_packet = ref->packets.array + idx;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO &&
+		    cur_packet->type == OBS_ENCODER_VIDEO && out->track_idx > cur_packet->track_idx)
+			continue;
+
+		if (out->dts_usec == cur_packet->dts_usec && out->type == OBS_ENCODER_VIDEO) {
+			break;
+		} else if (out->dts_usec < cur_packet->dts_usec) {
+			break;
+		}
+	}
+
+	da_insert(ref->packets, idx, out);
+}
+
+static void reference_resort(struct reference *ref)
+{
+	DARRAY(struct encoder_packet) old_array;
+
+	old_array.da = ref->packets.da;
+	memset(&ref->packets, 0, sizeof(ref->packets));
+
+	for (size_t i = 0; i < old_array.num; i++)
+		reference_insert(ref, &old_array.array[i]);
+
+	da_free(old_array);
+}
+
+/* random streams */
+
+static uint64_t rand_state;
+
+static uint32_t rand_u32(void)
+{
+	rand_state = rand_state * 6364136223846793005ULL + 1442695040888963407ULL;
+	return (uint32_t)(rand_state >> 33);
+}
+
+static uint32_t rand_range(uint32_t max)
+{
+	return rand_u32() % max;
+}
+
+struct track {
+	enum obs_encoder_type type;
+	size_t idx;
+	int64_t next_dts;
+	int64_t interval;
+	int64_t offset;
+};
+
+static void assert_same_order(struct interleaver *il, struct reference *ref)
+{
+	struct interleaver_cursor cursor = {0};
+	struct encoder_packet *packet;
+	size_t i = 0;
+
+	assert_int_equal(il->num, ref->packets.num);
+
+	while ((packet = interleaver_next(il, &cursor)) != NULL) {
+		assert_true(i < ref->packets.num);
+		/* size is used as a unique packet id */
+		assert_int_equal(packet->size, ref->packets.array[i].size);
+		i++;
+	}
+
+	assert_int_equal(i, ref->packets.num);
+}
+
+static void run_iteration(void)
+{
+	struct interleaver il = {0};
+	struct reference ref = {0};
+	struct track tracks[INTERLEAVER_TRACKS];
+	size_t num_tracks = 0;
+	size_t next_id = 1;
+	bool started = false;
+
+	size_t video_tracks = 1 + rand_range(3);
+	size_t audio_tracks = 1 + rand_range(MAX_OUTPUT_AUDIO_ENCODERS);
+
+	/* coarse timestamp grids so that equal DTS across tracks are common */
+	for (size_t i = 0; i < video_tracks + audio_tracks; i++) {
+		struct track *track = &tracks[num_tracks++];
+		track->type = i < video_tracks ? OBS_ENCODER_VIDEO : OBS_ENCODER_AUDIO;
+		track->idx = i < video_tracks ? i : i - video_tracks;
+		track->interval = (1 + rand_range(4)) * 10;
+		track->next_dts = (int64_t)rand_range(8) * 10 - 20;
+		track->offset = (int64_t)rand_range(4) * 10;
+	}
+
+	size_t steps = rand_range(MAX_STEPS);
+	for (size_t step = 0; step < steps; step++) {
+		uint32_t op = rand_range(100);
+
+		if (op < 70) {
+			struct track *track = &tracks[rand_range((uint32_t)num_tracks)];
+			struct encoder_packet packet = {0};
+
+			packet.type = track->type;
+			packet.track_idx = track->idx;
+			packet.size = next_id++;
+			packet.dts_usec = track->next_dts;
+			if (started)
+				packet.dts_usec -= track->offset;
+
+			/* occasionally skip ahead, like an encoder stalling */
+			track->next_dts += track->interval * (rand_range(10) ? 1 : 1 + rand_range(5));
+
+			interleaver_push(&il, &packet);
+			reference_insert(&ref, &packet);
+
+		} else if (op < 95) {
+			struct encoder_packet packet;
+
+			if (interleaver_pop(&il, &packet)) {
+				assert_true(ref.packets.num > 0);
+				assert_int_equal(packet.size, ref.packets.array[0].size);
+				da_erase(ref.packets, 0);
+			} else {
+				assert_int_equal(ref.packets.num, 0);
+			}
+
+		} else if (op < 98) {
+			/* discard everything before a timestamp */
+			struct encoder_packet *first = interleaver_peek(&il);
+			int64_t dts = first ? first->dts_usec + (int64_t)rand_range(60) : 0;
+			size_t idx = 0;
+
+			while ((first = interleaver_peek(&il)) != NULL && first->dts_usec < dts) {
+				struct encoder_packet packet;
+				interleaver_pop(&il, &packet);
+			}
+
+			while (idx < ref.packets.num && ref.packets.array[idx].dts_usec < dts)
+				idx++;
+			if (idx)
+				da_erase_range(ref.packets, 0, idx);
+
+		} else if (!started) {
+			/* output starts: per-track offsets are applied to all
+			 * queued packets, which then get resorted */
+			struct interleaver_cursor cursor = {0};
+			struct encoder_packet *packet;
+
+			interleaver_resequence(&il);
+			while ((packet = interleaver_next(&il, &cursor)) != NULL) {
+				for (size_t i = 0; i < num_tracks; i++) {
+					if (tracks[i].type == packet->type && tracks[i].idx == packet->track_idx)
+						packet->dts_usec -= tracks[i].offset;
+				}
+			}
+
+			for (size_t i = 0; i < ref.packets.num; i++) {
+				struct encoder_packet *p = &ref.packets.array[i];
+				for (size_t j = 0; j < num_tracks; j++) {
+					if (tracks[j].type == p->type && tracks[j].idx == p->track_idx)
+						p->dts_usec -= tracks[j].offset;
+				}
+			}
+			reference_resort(&ref);
+
+			started = true;
+		}
+
+		assert_same_order(&il, &ref);
+	}
+
+	/* first/last packets of every track */
+	for (size_t i = 0; i < num_tracks; i++) {
+		struct encoder_packet *first = interleaver_first(&il, tracks[i].type, tracks[i].idx);
+		struct encoder_packet *last = interleaver_last(&il, tracks[i].type, tracks[i].idx);
+		int first_idx = interleaver_first_idx(&il, tracks[i].type, tracks[i].idx);
+		int ref_first = -1;
+		int ref_last = -1;
+
+		for (size_t j = 0; j < ref.packets.num; j++) {
+			struct encoder_packet *p = &ref.packets.array[j];
+			if (p->type == tracks[i].type && p->track_idx == tracks[i].idx) {
+				if (ref_first == -1)
+					ref_first = (int)j;
+				ref_last = (int)j;
+			}
+		}
+
+		assert_int_equal(first_idx, ref_first);
+		if (ref_first == -1) {
+			assert_null(first);
+			assert_null(last);
+		} else {
+			assert_int_equal(first->size, ref.packets.array[ref_first].size);
+			assert_int_equal(last->size, ref.packets.array[ref_last].size);
+		}
+	}
+
+	interleaver_free(&il);
+	da_free(ref.packets);
+}
+
+static void interleaver_order_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	rand_state = 0x5eed;
+	for (size_t i = 0; i < ITERATIONS; i++)
+		run_iteration();
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(interleaver_order_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
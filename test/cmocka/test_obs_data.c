@@ -0,0 +1,220 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <math.h>
+#include <cmocka.h>
+
+#include <obs-data.h>
+
+/* The JSON output must stay byte for byte the same as what libobs produced
+ * with jansson, so existing files and protocols are not affected. */
+
+static void json_write_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	obs_data_t *data = obs_data_create();
+	obs_data_t *obj = obs_data_create();
+	obs_data_t *empty = obs_data_create();
+	obs_data_array_t *array = obs_data_array_create();
+
+	obs_data_set_string(data, "str", "a\"b\\c/\n\t\x01\x1f\xc3\xa9");
+	obs_data_set_int(data, "int", -9223372036854775807LL - 1);
+	obs_data_set_double(data, "real", 1.0);
+	obs_data_set_double(data, "frac", 0.1);
+	obs_data_set_double(data, "big", 1e300);
+	obs_data_set_double(data, "small", -2.5e-10);
+	obs_data_set_bool(data, "bool", false);
+	obs_data_set_default_int(data, "default", 5);
+
+	obs_data_set_int(obj, "x", 1);
+	obs_data_set_obj(data, "obj", obj);
+	obs_data_array_push_back(array, obj);
+	obs_data_array_push_back(array, empty);
+	obs_data_set_array(data, "array", array);
+	obs_data_set_obj(data, "empty", empty);
+
+	/* values jansson could not represent are left out */
+	obs_data_set_double(data, "nan", NAN);
+	obs_data_set_double(data, "inf", INFINITY);
+	obs_data_set_string(data, "bad_utf8", "\xc0\xaf");
+	obs_data_set_int(data, "bad_key_\xff", 1);
+
+	assert_string_equal(obs_data_get_json(data),
+			    "{\"str\":\"a\\\"b\\\\c/\\n\\t\\u0001\\u001F\xc3\xa9\","
+			    "\"int\":-9223372036854775808,\"real\":1.0,\"frac\":0.10000000000000001,"
+			    "\"big\":1.0000000000000001e300,\"small\":-2.5000000000000002e-10,"
+			    "\"bool\":false,\"obj\":{\"x\":1},\"array\":[{\"x\":1},{}],\"empty\":{}}");
+
+	obs_data_erase(data, "str");
+	obs_data_erase(data, "big");
+	obs_data_erase(data, "small");
+
+	assert_string_equal(obs_data_get_json_pretty(data), "{\n"
+							    "    \"int\": -9223372036854775808,\n"
+							    "    \"real\": 1.0,\n"
+							    "    \"frac\": 0.10000000000000001,\n"
+							    "    \"bool\": false,\n"
+							    "    \"obj\": {\n"
+							    "        \"x\": 1\n"
+							    "    },\n"
+							    "    \"array\": [\n"
+							    "        {\n"
+							    "            \"x\": 1\n"
+							    "        },\n"
+							    "        {}\n"
+							    "    ],\n"
+							    "    \"empty\": {}\n"
+							    "}");
+
+	obs_data_clear(obj);
+	obs_data_set_default_bool(obj, "d", true);
+	assert_string_equal(obs_data_get_json(obj), "{}");
+
+	obs_data_array_release(array);
+	obs_data_release(empty);
+	obs_data_release(obj);
+	obs_data_release(data);
+}
+
+static void json_read_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	obs_data_t *data = obs_data_create_from_json(" {\"s\": \"\\u00e9\\uD83D\\uDE00\\/\", \"i\": -12, \"r\": 1e2,"
+						     "\"t\": true, \"n\": null, \"o\": {\"a\": [1, {\"b\": 2}, [{}]]},"
+						     "\"big\": 123456789012345678901234567890.5}\r\n");
+	assert_non_null(data);
+
+	assert_string_equal(obs_data_get_string(data, "s"), "\xc3\xa9\xf0\x9f\x98\x80/");
+	assert_int_equal(obs_data_get_int(data, "i"), -12);
+	obs_data_item_t *item = obs_data_item_byname(data, "r");
+	assert_true(obs_data_item_numtype(item) == OBS_DATA_NUM_DOUBLE);
+	obs_data_item_release(&item);
+	assert_true(obs_data_get_double(data, "r") == 100.0);
+	assert_true(obs_data_get_bool(data, "t"));
+	assert_false(obs_data_has_user_value(data, "n"));
+
+	/* arrays only keep objects */
+	obs_data_t *obj = obs_data_get_obj(data, "o");
+	obs_data_array_t *array = obs_data_get_array(obj, "a");
+	assert_int_equal(obs_data_array_count(array), 1);
+	obs_data_array_release(array);
+	obs_data_release(obj);
+
+	assert_string_equal(obs_data_get_json(data), "{\"s\":\"\xc3\xa9\xf0\x9f\x98\x80/\",\"i\":-12,\"r\":100.0,"
+						     "\"t\":true,\"o\":{\"a\":[{\"b\":2}]},"
+						     "\"big\":1.2345678901234568e29}");
+	obs_data_release(data);
+
+	/* a top level array is valid but has no data */
+	data = obs_data_create_from_json("[1, 2]");
+	assert_non_null(data);
+	assert_null(obs_data_first(data));
+	obs_data_release(data);
+}
+
+static void json_read_invalid_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	static const char *invalid[] = {
+		"",
+		"1",
+		"{",
+		"{} x",
+		"{\"a\": 1,}",
+		"{\"a\": 1, \"a\": 2}",
+		"{\"a\": null, \"a\": 2}",
+		"[[{\"a\": 1, \"a\": 2}]]",
+		"{\"a\": 01}",
+		"{\"a\": 1.}",
+		"{\"a\": -}",
+		"{\"a\": 9223372036854775808}",
+		"{\"a\": 1e400}",
+		"{\"a\": tru}",
+		"{\"a\": \"\\u0000\"}",
+		"{\"a\": \"\\uD83D\"}",
+		"{\"a\": \"\\x\"}",
+		"{\"a\": \"\t\"}",
+		"{\"a\": \"\xc0\xaf\"}",
+		"{'a': 1}",
+	};
+
+	for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++)
+		assert_null(obs_data_create_from_json(invalid[i]));
+	assert_null(obs_data_create_from_json(NULL));
+}
+
+static obs_data_t *data_with_obj(const char *name, obs_data_t *obj)
+{
+	obs_data_t *data = obs_data_create();
+	obs_data_set_obj(data, name, obj);
+	return data;
+}
+
+/* structurally different data must not hash the same */
+static void hash_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	/* {"a":{"b":1},"c":2} and {"a":{"b":1,"c":2}} */
+	obs_data_t *inner1 = obs_data_create();
+	obs_data_set_int(inner1, "b", 1);
+	obs_data_t *data1 = data_with_obj("a", inner1);
+	obs_data_set_int(data1, "c", 2);
+
+	obs_data_t *inner2 = obs_data_create();
+	obs_data_set_int(inner2, "b", 1);
+	obs_data_set_int(inner2, "c", 2);
+	obs_data_t *data2 = data_with_obj("a", inner2);
+
+	assert_true(obs_data_get_hash(data1) != obs_data_get_hash(data2));
+
+	/* [{"x":1},{}] and [{},{"x":1}] */
+	obs_data_t *x = obs_data_create();
+	obs_data_t *empty = obs_data_create();
+	obs_data_array_t *array1 = obs_data_array_create();
+	obs_data_array_t *array2 = obs_data_array_create();
+	obs_data_set_int(x, "x", 1);
+	obs_data_array_push_back(array1, x);
+	obs_data_array_push_back(array1, empty);
+	obs_data_array_push_back(array2, empty);
+	obs_data_array_push_back(array2, x);
+
+	obs_data_t *data3 = obs_data_create();
+	obs_data_t *data4 = obs_data_create();
+	obs_data_set_array(data3, "array", array1);
+	obs_data_set_array(data4, "array", array2);
+
+	assert_true(obs_data_get_hash(data3) != obs_data_get_hash(data4));
+
+	/* equal values hash the same, defaults are not included */
+	obs_data_t *data5 = obs_data_create_from_json(obs_data_get_json(data1));
+	obs_data_set_default_int(data5, "d", 3);
+	assert_true(obs_data_get_hash(data1) == obs_data_get_hash(data5));
+
+	obs_data_set_int(data5, "c", 3);
+	assert_true(obs_data_get_hash(data1) != obs_data_get_hash(data5));
+
+	obs_data_release(data5);
+	obs_data_release(data4);
+	obs_data_release(data3);
+	obs_data_array_release(array2);
+	obs_data_array_release(array1);
+	obs_data_release(empty);
+	obs_data_release(x);
+	obs_data_release(data2);
+	obs_data_release(inner2);
+	obs_data_release(data1);
+	obs_data_release(inner1);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(json_write_test),
+		cmocka_unit_test(json_read_test),
+		cmocka_unit_test(json_read_invalid_test),
+		cmocka_unit_test(hash_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}
@@ -0,0 +1,186 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/profiler.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+#include <stdio.h>
+#include <string.h>
+
+static const char *root_name = "root";
+static const char *child_name = "child";
+static const char *grandchild_name = "grandchild";
+static const char *thread_root_name = "thread root";
+static const char *mismatch_root_name = "mismatch root";
+static const char *mismatch_child_name = "mismatch child";
+static const char *trace_root_name = "trace root";
+
+static void profile_tree(const char *name, int children)
+{
+	profile_start(name);
+	for (int i = 0; i < children; i++) {
+		profile_start(child_name);
+		profile_start(grandchild_name);
+		profile_end(grandchild_name);
+		profile_end(child_name);
+	}
+	profile_end(name);
+}
+
+static void *profile_thread(void *data)
+{
+	UNUSED_PARAMETER(data);
+
+	for (int i = 0; i < 10; i++)
+		profile_tree(thread_root_name, 1);
+
+	return NULL;
+}
+
+struct find_data {
+	const char *name;
+	profiler_snapshot_entry_t *entry;
+};
+
+static bool find_entry(void *context, profiler_snapshot_entry_t *entry)
+{
+	struct find_data *data = context;
+
+	if (profiler_snapshot_entry_name(entry) != data->name)
+		return true;
+
+	data->entry = entry;
+	return false;
+}
+
+static profiler_snapshot_entry_t *find_root(profiler_snapshot_t *snap, const char *name)
+{
+	struct find_data data = {name, NULL};
+	profiler_snapshot_enumerate_roots(snap, find_entry, &data);
+	return data.entry;
+}
+
+static profiler_snapshot_entry_t *find_child(profiler_snapshot_entry_t *entry, const char *name)
+{
+	struct find_data data = {name, NULL};
+	profiler_snapshot_enumerate_children(entry, find_entry, &data);
+	return data.entry;
+}
+
+static void profiler_snapshot_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	pthread_t thread;
+
+	profiler_start();
+
+	for (int i = 0; i < 5; i++)
+		profile_tree(root_name, 3);
+
+	assert_int_equal(pthread_create(&thread, NULL, profile_thread, NULL), 0);
+	pthread_join(thread, NULL);
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+	assert_int_equal(profiler_snapshot_num_roots(snap), 2);
+
+	profiler_snapshot_entry_t *root = find_root(snap, root_name);
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), 5);
+	assert_int_equal(profiler_snapshot_num_children(root), 1);
+
+	profiler_snapshot_entry_t *child = find_child(root, child_name);
+	assert_non_null(child);
+	assert_int_equal(profiler_snapshot_entry_overall_count(child), 15);
+
+	profiler_snapshot_entry_t *grandchild = find_child(child, grandchild_name);
+	assert_non_null(grandchild);
+	assert_int_equal(profiler_snapshot_entry_overall_count(grandchild), 15);
+
+	root = find_root(snap, thread_root_name);
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), 10);
+
+	profile_snapshot_free(snap);
+
+	profiler_stop();
+}
+
+static void profiler_mismatch_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	profiler_start();
+
+	/* ending the root ends the unterminated child too */
+	profile_start(mismatch_root_name);
+	profile_start(mismatch_child_name);
+	profile_end(mismatch_root_name);
+
+	profiler_snapshot_t *snap = profile_snapshot_create();
+
+	profiler_snapshot_entry_t *root = find_root(snap, mismatch_root_name);
+	assert_non_null(root);
+	assert_int_equal(profiler_snapshot_entry_overall_count(root), 1);
+
+	profiler_snapshot_entry_t *child = find_child(root, mismatch_child_name);
+	assert_non_null(child);
+	assert_int_equal(profiler_snapshot_entry_overall_count(child), 1);
+
+	profile_snapshot_free(snap);
+
+	profiler_stop();
+}
+
+static void profiler_trace_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	char path[] = "test_profiler_trace.json";
+
+	profiler_start();
+	profiler_trace_start(4);
+
+	for (int i = 0; i < 3; i++)
+		profile_tree(trace_root_name, 1);
+
+	profiler_trace_stop();
+	assert_true(profiler_trace_dump_json(path));
+
+	char *json = os_quick_read_utf8_file(path);
+	assert_non_null(json);
+
+	/* only the newest four of nine calls are kept */
+	size_t events = 0;
+	for (const char *pos = json; (pos = strstr(pos, "\"ph\":\"X\"")) != NULL; pos++)
+		events++;
+	assert_int_equal(events, 4);
+
+	assert_non_null(strstr(json, "\"traceEvents\":["));
+	assert_non_null(strstr(json, "\"name\":\"trace root\""));
+
+	bfree(json);
+	os_unlink(path);
+
+	profiler_stop();
+}
+
+static int teardown(void **state)
+{
+	UNUSED_PARAMETER(state);
+
+	profiler_free();
+	return 0;
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(profiler_snapshot_test),
+		cmocka_unit_test(profiler_mismatch_test),
+		cmocka_unit_test(profiler_trace_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, teardown);
+}
@@ -0,0 +1,155 @@
+#include <stdarg.h>
+#include <stddef.h>
+#include <setjmp.h>
+#include <cmocka.h>
+
+#include <util/spsc-ring.h>
+#include <util/platform.h>
+#include <util/threading.h>
+
+static void spsc_ring_push_pop_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	struct spsc_ring ring;
+	bool dropped;
+	int val;
+
+	spsc_ring_init(&ring, sizeof(int), 3);
+	assert_int_equal(spsc_ring_capacity(&ring), 4);
+	assert_false(spsc_ring_pop(&ring, &val, &dropped));
+
+	for (int i = 0; i < 4; i++)
+		assert_true(spsc_ring_push(&ring, &i, 0));
+
+	val = 4;
+	assert_false(spsc_ring_push(&ring, &val, 0));
+	assert_int_equal(spsc_ring_size(&ring), 4);
+
+	for (int i = 0; i < 4; i++) {
+		assert_true(spsc_ring_pop(&ring, &val, &dropped));
+		assert_int_equal(val, i);
+		assert_false(dropped);
+	}
+
+	assert_int_equal(spsc_ring_size(&ring), 0);
+	spsc_ring_free(&ring);
+}
+
+static void spsc_ring_drop_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	struct spsc_ring ring;
+	bool dropped;
+	int val;
+
+	spsc_ring_init(&ring, sizeof(int), 8);
+
+	/* value doubles as priority */
+	for (int i = 0; i < 6; i++)
+		assert_true(spsc_ring_push(&ring, &i, i % 3));
+
+	assert_int_equal(spsc_ring_drop(&ring, 2), 4);
+	/* already dropped items are not counted twice */
+	assert_int_equal(spsc_ring_drop(&ring, 1), 0);
+
+	for (int i = 0; i < 6; i++) {
+		assert_true(spsc_ring_pop(&ring, &val, &dropped));
+		assert_int_equal(val, i);
+		assert_true(dropped == (i % 3 < 2));
+	}
+
+	/* reused slots are no longer marked */
+	val = 0;
+	assert_true(spsc_ring_push(&ring, &val, 0));
+	assert_true(spsc_ring_pop(&ring, &val, &dropped));
+	assert_false(dropped);
+
+	spsc_ring_free(&ring);
+}
+
+static void spsc_ring_push_packet_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	struct spsc_ring_overflow overflow = {0};
+	struct spsc_ring ring;
+	int val = 0;
+
+	spsc_ring_init(&ring, sizeof(int), 2);
+
+	/* video keyframe, then a video packet that fills the ring */
+	assert_true(spsc_ring_push_packet(&ring, &overflow, "test", &val, 1, true, true));
+	assert_true(spsc_ring_push_packet(&ring, &overflow, "test", &val, 0, true, false));
+	assert_false(spsc_ring_push_packet(&ring, &overflow, "test", &val, 0, true, false));
+	assert_true(overflow.full);
+	assert_true(overflow.skip_video);
+
+	/* once there is room, audio is queued but video waits for a keyframe */
+	assert_true(spsc_ring_pop(&ring, &val, NULL));
+	assert_true(spsc_ring_push_packet(&ring, &overflow, "test", &val, 1, false, false));
+	assert_true(spsc_ring_pop(&ring, &val, NULL));
+	assert_false(spsc_ring_push_packet(&ring, &overflow, "test", &val, 0, true, false));
+	assert_true(overflow.full);
+	assert_int_equal(overflow.dropped, 2);
+
+	assert_true(spsc_ring_push_packet(&ring, &overflow, "test", &val, 1, true, true));
+	assert_false(overflow.full);
+	assert_false(overflow.skip_video);
+	assert_int_equal(overflow.dropped, 0);
+
+	spsc_ring_free(&ring);
+}
+
+#define STRESS_COUNT 200000
+
+static void *stress_consumer(void *data)
+{
+	struct spsc_ring *ring = data;
+	long expected = 0;
+
+	while (expected < STRESS_COUNT) {
+		long val;
+		if (!spsc_ring_pop(ring, &val, NULL)) {
+			os_sleep_ms(0);
+			continue;
+		}
+		if (val != expected)
+			return (void *)1;
+		expected++;
+	}
+
+	return NULL;
+}
+
+static void spsc_ring_threaded_test(void **state)
+{
+	UNUSED_PARAMETER(state);
+	struct spsc_ring ring;
+	pthread_t thread;
+	void *result;
+
+	spsc_ring_init(&ring, sizeof(long), 64);
+	assert_int_equal(pthread_create(&thread, NULL, stress_consumer, &ring), 0);
+
+	for (long i = 0; i < STRESS_COUNT; i++) {
+		while (!spsc_ring_push(&ring, &i, 0))
+			os_sleep_ms(0);
+	}
+
+	pthread_join(thread, &result);
+	assert_null(result);
+	assert_int_equal(spsc_ring_size(&ring), 0);
+
+	spsc_ring_free(&ring);
+}
+
+int main()
+{
+	const struct CMUnitTest tests[] = {
+		cmocka_unit_test(spsc_ring_push_pop_test),
+		cmocka_unit_test(spsc_ring_drop_test),
+		cmocka_unit_test(spsc_ring_push_packet_test),
+		cmocka_unit_test(spsc_ring_threaded_test),
+	};
+
+	return cmocka_run_group_tests(tests, NULL, NULL);
+}